@@ -0,0 +1,653 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+/* Benchmarks the execution functions of fftset over a sweep of lengths. For
+ * every modulation, operation and length the time per call is measured over
+ * a number of samples and reported along with an estimated throughput and
+ * latency percentiles. Results may be written as a text table (default), CSV
+ * or JSON so that they can be compared between builds. With --resample, the
+ * fftset_resampler is instead compared against a direct polyphase filter
+ * for a number of ratios and filter lengths. Run with --help for the
+ * available options. */
+
+#include "fftset/fftset.h"
+#include "fftset/src/fftset_timer.h"
+#include "cop/cop_alloc.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum bench_format {
+	BENCH_FORMAT_TEXT,
+	BENCH_FORMAT_CSV,
+	BENCH_FORMAT_JSON
+};
+
+enum bench_op {
+	BENCH_OP_FORWARD,
+	BENCH_OP_INVERSE,
+	BENCH_OP_GET_KERNEL,
+	BENCH_OP_CONV,
+
+	BENCH_OP_COUNT
+};
+
+static const char *const BENCH_OP_NAMES[BENCH_OP_COUNT] =
+{"forward", "inverse", "get_kernel", "conv"};
+
+static const char *const BENCH_ISA_NAMES[] =
+{"auto", "baseline", "avx", "avx2_fma", "avx512"};
+
+struct bench_options {
+	size_t            min_bins;
+	size_t            max_bins;
+	unsigned          nb_samples;
+	double            time_per_length;
+	enum fftset_isa   isa;
+	enum bench_format format;
+	const char       *output;
+	int               all_lengths;
+	int               resample;
+};
+
+struct bench_result {
+	const char *modulation;
+	const char *operation;
+	size_t      complex_bins;
+	unsigned    calls_per_sample;
+	double      mean_ns;
+	double      min_ns;
+	double      p50_ns;
+	double      p90_ns;
+	double      p99_ns;
+	double      gflops;
+};
+
+struct bench_buffers {
+	float *input;
+	float *output;
+	float *kernel;
+	float *work;
+};
+
+/* Largest prime factor of a 5-smooth number greater than one. Used to group
+ * the lengths as powers of two, 3-smooth and 5-smooth. */
+static unsigned largest_factor(size_t n)
+{
+	if (n % 5 == 0)
+		return 5;
+	while (n % 2 == 0)
+		n /= 2;
+	return (n % 3 == 0) ? 3 : 2;
+}
+
+static int cmp_size(const void *a, const void *b)
+{
+	size_t x = *(const size_t *)a;
+	size_t y = *(const size_t *)b;
+	return (x > y) - (x < y);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/* Fills lengths with the 5-smooth numbers in [min_bins, max_bins] and
+ * returns how many were found. Unless all is set, only the smallest length
+ * of each group (power of two, 3-smooth, 5-smooth) in each octave is kept
+ * which gives about three lengths per octave. */
+static size_t
+get_lengths
+	(size_t       *lengths
+	,size_t        max_lengths
+	,size_t        min_bins
+	,size_t        max_bins
+	,int           all
+	)
+{
+	size_t p2, p3, p5;
+	size_t nb = 0;
+	size_t i, j;
+
+	for (p5 = 1; p5 <= max_bins; p5 *= 5)
+		for (p3 = p5; p3 <= max_bins; p3 *= 3)
+			for (p2 = p3; p2 <= max_bins; p2 *= 2)
+				if (p2 >= min_bins && nb < max_lengths)
+					lengths[nb++] = p2;
+
+	qsort(lengths, nb, sizeof(lengths[0]), cmp_size);
+
+	if (all)
+		return nb;
+
+	for (i = 0, j = 0; i < nb; i++) {
+		size_t k;
+		for (k = 0; k < j; k++) {
+			if  (   largest_factor(lengths[k]) == largest_factor(lengths[i])
+			    &&  lengths[k] * 2 > lengths[i]
+			    )
+				break;
+		}
+		if (k == j)
+			lengths[j++] = lengths[i];
+	}
+
+	return j;
+}
+
+/* Conventional flop counts (5 N log2(N) for N complex points and half that
+ * for N real points) used to normalise the timings into a throughput. These
+ * are not the number of operations actually performed. */
+static double estimated_flops(int is_real, enum bench_op op, size_t complex_bins)
+{
+	double n  = (double)complex_bins * (is_real ? 2.0 : 1.0);
+	double tf = (is_real ? 2.5 : 5.0) * n * log(n) / log(2.0);
+	switch (op) {
+	case BENCH_OP_CONV:
+		return 2.0 * tf + 6.0 * complex_bins;
+	default:
+		return tf;
+	}
+}
+
+static void run_op(const struct fftset_fft *fft, enum bench_op op, const struct bench_buffers *b)
+{
+	switch (op) {
+	case BENCH_OP_FORWARD:
+		fftset_fft_forward(fft, b->output, b->input, b->work);
+		break;
+	case BENCH_OP_INVERSE:
+		fftset_fft_inverse(fft, b->output, b->input, b->work);
+		break;
+	case BENCH_OP_GET_KERNEL:
+		fftset_fft_conv_get_kernel(fft, b->output, b->input);
+		break;
+	default:
+		fftset_fft_conv(fft, b->output, b->input, b->kernel, b->work);
+		break;
+	}
+}
+
+/* Times the operation. The number of calls in each sample is chosen so that a
+ * sample lasts for at least time_per_sample seconds (and is well above the
+ * timer resolution). Each sample gives the average time of the calls within
+ * it so the percentiles describe the variation between samples. */
+static void
+bench_op
+	(struct bench_result        *result
+	,const struct fftset_fft    *fft
+	,enum bench_op               op
+	,const struct bench_buffers *bufs
+	,unsigned                    nb_samples
+	,double                      time_per_sample
+	,double                     *samples
+	)
+{
+	unsigned reps = 1;
+	unsigned i, j;
+	double total = 0.0;
+
+	if (time_per_sample < 20e-6)
+		time_per_sample = 20e-6;
+
+	/* Warm up and find the number of calls per sample. */
+	for (;;) {
+		double start = fftset_timer_now();
+		double elapsed;
+		for (j = 0; j < reps; j++)
+			run_op(fft, op, bufs);
+		elapsed = fftset_timer_now() - start;
+		if (elapsed >= time_per_sample || reps >= (1u << 30))
+			break;
+		if (elapsed * 16.0 < time_per_sample)
+			reps *= 8;
+		else
+			reps *= 2;
+	}
+
+	for (i = 0; i < nb_samples; i++) {
+		double start = fftset_timer_now();
+		double elapsed;
+		for (j = 0; j < reps; j++)
+			run_op(fft, op, bufs);
+		elapsed = fftset_timer_now() - start;
+		total += elapsed;
+		samples[i] = elapsed * 1e9 / reps;
+	}
+
+	qsort(samples, nb_samples, sizeof(samples[0]), cmp_double);
+
+	result->calls_per_sample = reps;
+	result->mean_ns          = total * 1e9 / ((double)reps * nb_samples);
+	result->min_ns           = samples[0];
+	result->p50_ns           = samples[(nb_samples - 1) * 50 / 100];
+	result->p90_ns           = samples[(nb_samples - 1) * 90 / 100];
+	result->p99_ns           = samples[(nb_samples - 1) * 99 / 100];
+}
+
+static void print_header(FILE *f, enum bench_format format, const struct bench_options *opts, enum fftset_isa isa)
+{
+	switch (format) {
+	case BENCH_FORMAT_TEXT:
+		fprintf(f, "isa: %s, samples: %u\n", BENCH_ISA_NAMES[isa], opts->nb_samples);
+		fprintf(f, "%-18s %-10s %10s %8s %12s %12s %12s %12s %12s %9s\n", "modulation", "operation", "bins", "calls", "mean_ns", "min_ns", "p50_ns", "p90_ns", "p99_ns", "gflops");
+		break;
+	case BENCH_FORMAT_CSV:
+		fprintf(f, "isa,modulation,operation,complex_bins,calls_per_sample,samples,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,gflops\n");
+		break;
+	default:
+		fprintf(f, "{\n\t\"isa\": \"%s\",\n\t\"samples\": %u,\n\t\"results\": [", BENCH_ISA_NAMES[isa], opts->nb_samples);
+		break;
+	}
+}
+
+static void print_result(FILE *f, enum bench_format format, const struct bench_options *opts, enum fftset_isa isa, const struct bench_result *r, int first)
+{
+	switch (format) {
+	case BENCH_FORMAT_TEXT:
+		fprintf(f, "%-18s %-10s %10lu %8u %12.1f %12.1f %12.1f %12.1f %12.1f %9.3f\n", r->modulation, r->operation, (unsigned long)r->complex_bins, r->calls_per_sample, r->mean_ns, r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->gflops);
+		break;
+	case BENCH_FORMAT_CSV:
+		fprintf(f, "%s,%s,%s,%lu,%u,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%.3f\n", BENCH_ISA_NAMES[isa], r->modulation, r->operation, (unsigned long)r->complex_bins, r->calls_per_sample, opts->nb_samples, r->mean_ns, r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->gflops);
+		break;
+	default:
+		fprintf(f, "%s\n\t\t{\"modulation\": \"%s\", \"operation\": \"%s\", \"complex_bins\": %lu, \"calls_per_sample\": %u, \"mean_ns\": %.1f, \"min_ns\": %.1f, \"p50_ns\": %.1f, \"p90_ns\": %.1f, \"p99_ns\": %.1f, \"gflops\": %.3f}", first ? "" : ",", r->modulation, r->operation, (unsigned long)r->complex_bins, r->calls_per_sample, r->mean_ns, r->min_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->gflops);
+		break;
+	}
+	fflush(f);
+}
+
+static void print_footer(FILE *f, enum bench_format format)
+{
+	if (format == BENCH_FORMAT_JSON)
+		fprintf(f, "\n\t]\n}\n");
+}
+
+static void usage(const char *name)
+{
+	printf
+		("usage: %s [options]\n"
+		 "  --min=N          smallest number of complex bins (default 16)\n"
+		 "  --max=N          largest number of complex bins (default 65536)\n"
+		 "  --all-lengths    benchmark every 5-smooth length in the range\n"
+		 "  --samples=N      number of timed samples per length (default 51)\n"
+		 "  --time=S         approximate seconds per length and operation (default 0.05)\n"
+		 "  --isa=L          auto, baseline, avx, avx2_fma or avx512 (default auto)\n"
+		 "  --format=F       text, csv or json (default text)\n"
+		 "  --output=FILE    write the results to FILE rather than stdout\n"
+		 "  --resample       compare fftset_resampler with a direct polyphase filter\n"
+		,name
+		);
+}
+
+static int parse_args(struct bench_options *opts, int argc, char *argv[])
+{
+	int i;
+
+	opts->min_bins        = 16;
+	opts->max_bins        = 65536;
+	opts->nb_samples      = 51;
+	opts->time_per_length = 0.05;
+	opts->isa             = FFTSET_ISA_AUTO;
+	opts->format          = BENCH_FORMAT_TEXT;
+	opts->output          = NULL;
+	opts->all_lengths     = 0;
+	opts->resample        = 0;
+
+	for (i = 1; i < argc; i++) {
+		const char *a = argv[i];
+		if (!strncmp(a, "--min=", 6)) {
+			opts->min_bins = strtoul(a + 6, NULL, 10);
+		} else if (!strncmp(a, "--max=", 6)) {
+			opts->max_bins = strtoul(a + 6, NULL, 10);
+		} else if (!strcmp(a, "--all-lengths")) {
+			opts->all_lengths = 1;
+		} else if (!strncmp(a, "--samples=", 10)) {
+			opts->nb_samples = (unsigned)strtoul(a + 10, NULL, 10);
+		} else if (!strncmp(a, "--time=", 7)) {
+			opts->time_per_length = strtod(a + 7, NULL);
+		} else if (!strncmp(a, "--isa=", 6)) {
+			unsigned j;
+			for (j = 0; j < sizeof(BENCH_ISA_NAMES) / sizeof(BENCH_ISA_NAMES[0]); j++)
+				if (!strcmp(a + 6, BENCH_ISA_NAMES[j]))
+					break;
+			if (j == sizeof(BENCH_ISA_NAMES) / sizeof(BENCH_ISA_NAMES[0])) {
+				fprintf(stderr, "unknown isa '%s'\n", a + 6);
+				return 1;
+			}
+			opts->isa = (enum fftset_isa)j;
+		} else if (!strcmp(a, "--format=text")) {
+			opts->format = BENCH_FORMAT_TEXT;
+		} else if (!strcmp(a, "--format=csv")) {
+			opts->format = BENCH_FORMAT_CSV;
+		} else if (!strcmp(a, "--format=json")) {
+			opts->format = BENCH_FORMAT_JSON;
+		} else if (!strncmp(a, "--output=", 9)) {
+			opts->output = a + 9;
+		} else if (!strcmp(a, "--resample")) {
+			opts->resample = 1;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (opts->min_bins < 1)
+		opts->min_bins = 1;
+	if (opts->nb_samples < 1)
+		opts->nb_samples = 1;
+	if (opts->max_bins < opts->min_bins) {
+		fprintf(stderr, "--max must not be less than --min\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Resampling comparisons. Both methods are given the same input and the
+ * time per output sample is reported. The direct method is a polyphase
+ * filter which only evaluates the taps which meet non-zero samples of the
+ * upsampled stream (nb_taps / up multiplies per output). */
+#define RESAMPLE_BLOCK (4096)
+
+struct resample_case {
+	unsigned up;
+	unsigned down;
+	unsigned nb_taps;
+};
+
+static const struct resample_case RESAMPLE_CASES[] =
+{   {1,   2,   255}
+,   {1,   2,   4095}
+,   {1,   8,   16383}
+,   {2,   1,   511}
+,   {2,   1,   8191}
+,   {3,   2,   12287}
+,   {160, 147, 16383}
+};
+
+/* Computes the outputs of the direct polyphase filter which only depend on
+ * input[0, nb_input). input[-(nb_taps / up + 1), 0) must be readable. */
+static size_t
+resample_direct
+	(float       *output
+	,const float *input
+	,size_t       nb_input
+	,const float *filter
+	,unsigned     nb_taps
+	,unsigned     up
+	,unsigned     down
+	)
+{
+	size_t nb_out = 0;
+	size_t j;
+
+	for (j = 0; j < nb_input * up; j += down) {
+		const float *x   = input + j / up;
+		float        acc = 0.0f;
+		unsigned     k;
+		for (k = (unsigned)(j % up); k < nb_taps; k += up, x--)
+			acc += filter[k] * x[0];
+		output[nb_out++] = up * acc;
+	}
+
+	return nb_out;
+}
+
+/* Times the resampler and the direct filter for every case and returns the
+ * number of failures. */
+static int bench_resample(FILE *f, const struct bench_options *opts, enum fftset_isa isa, struct fftset *fftset)
+{
+	const unsigned max_taps  = 16383;
+	const size_t   nb_output = 8 * RESAMPLE_BLOCK;
+	float         *input     = malloc(sizeof(float) * (RESAMPLE_BLOCK + max_taps + 1));
+	float         *filter    = malloc(sizeof(float) * max_taps);
+	unsigned       c, i;
+	int            first     = 1;
+	int            errors    = 0;
+
+	if (input == NULL || filter == NULL) {
+		free(input);
+		free(filter);
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < RESAMPLE_BLOCK + max_taps + 1; i++)
+		input[i] = (float)(rand() - RAND_MAX / 2) / (float)RAND_MAX;
+	for (i = 0; i < max_taps; i++)
+		filter[i] = (float)(rand() - RAND_MAX / 2) / ((float)RAND_MAX * max_taps);
+
+	switch (opts->format) {
+	case BENCH_FORMAT_TEXT:
+		fprintf(f, "isa: %s\n", BENCH_ISA_NAMES[isa]);
+		fprintf(f, "%5s %5s %8s %10s %15s %15s %9s\n", "up", "down", "taps", "bins", "fft_ns_per_out", "direct_ns_per_out", "speedup");
+		break;
+	case BENCH_FORMAT_CSV:
+		fprintf(f, "isa,up,down,taps,complex_bins,fft_ns_per_output,direct_ns_per_output,speedup\n");
+		break;
+	default:
+		fprintf(f, "{\n\t\"isa\": \"%s\",\n\t\"results\": [", BENCH_ISA_NAMES[isa]);
+		break;
+	}
+
+	for (c = 0; c < sizeof(RESAMPLE_CASES) / sizeof(RESAMPLE_CASES[0]); c++) {
+		const struct resample_case *rc     = &RESAMPLE_CASES[c];
+		const size_t                bins   = fftset_recommend_conv_length(rc->nb_taps, 0);
+		const struct fftset_fft    *fft    = fftset_create_fft(fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, bins);
+		const float                *x      = input + max_taps + 1 - (rc->nb_taps / rc->up + 1);
+		/* Enough for one read of the resampler or one block of the direct
+		 * filter. */
+		const size_t                nb_max = ((2 * bins > (size_t)RESAMPLE_BLOCK * rc->up) ? 2 * bins : (size_t)RESAMPLE_BLOCK * rc->up) / rc->down + 1;
+		float                      *output = malloc(sizeof(float) * nb_max);
+		struct fftset_resampler     resampler;
+		double                      start, fft_ns, direct_ns;
+		size_t                      nb_fft, nb_direct;
+
+		if (output == NULL || fft == NULL || fftset_resampler_init(&resampler, fft, filter, rc->nb_taps, rc->up, rc->down)) {
+			fprintf(stderr, "could not create resampler for %u/%u with %u taps\n", rc->up, rc->down, rc->nb_taps);
+			free(output);
+			errors++;
+			continue;
+		}
+
+		/* The input is fed repeatedly until enough time has passed. */
+		for (nb_fft = 0, start = fftset_timer_now(); nb_fft < nb_output || fftset_timer_now() - start < opts->time_per_length; ) {
+			size_t nb_in = 0;
+			while (nb_in < RESAMPLE_BLOCK) {
+				nb_in  += fftset_resampler_write(&resampler, x + nb_in, RESAMPLE_BLOCK - nb_in);
+				nb_fft += fftset_resampler_read(&resampler, output);
+			}
+		}
+		fft_ns = (fftset_timer_now() - start) * 1e9 / nb_fft;
+
+		for (nb_direct = 0, start = fftset_timer_now(); nb_direct < nb_output || fftset_timer_now() - start < opts->time_per_length; )
+			nb_direct += resample_direct(output, x + rc->nb_taps / rc->up + 1, RESAMPLE_BLOCK, filter, rc->nb_taps, rc->up, rc->down);
+		direct_ns = (fftset_timer_now() - start) * 1e9 / nb_direct;
+
+		switch (opts->format) {
+		case BENCH_FORMAT_TEXT:
+			fprintf(f, "%5u %5u %8u %10lu %15.2f %15.2f %9.2f\n", rc->up, rc->down, rc->nb_taps, (unsigned long)bins, fft_ns, direct_ns, direct_ns / fft_ns);
+			break;
+		case BENCH_FORMAT_CSV:
+			fprintf(f, "%s,%u,%u,%u,%lu,%.2f,%.2f,%.2f\n", BENCH_ISA_NAMES[isa], rc->up, rc->down, rc->nb_taps, (unsigned long)bins, fft_ns, direct_ns, direct_ns / fft_ns);
+			break;
+		default:
+			fprintf(f, "%s\n\t\t{\"up\": %u, \"down\": %u, \"taps\": %u, \"complex_bins\": %lu, \"fft_ns_per_output\": %.2f, \"direct_ns_per_output\": %.2f, \"speedup\": %.2f}", first ? "" : ",", rc->up, rc->down, rc->nb_taps, (unsigned long)bins, fft_ns, direct_ns, direct_ns / fft_ns);
+			break;
+		}
+		fflush(f);
+		first = 0;
+
+		fftset_resampler_destroy(&resampler);
+		free(output);
+	}
+
+	print_footer(f, opts->format);
+
+	free(input);
+	free(filter);
+	return errors;
+}
+
+#define MAX_LENGTHS (1024)
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		const char *name;
+		int         is_real;
+	} MODULATIONS[] =
+	{   {"freq_offset_real", 1}
+	,   {"complex",          0}
+	};
+
+	struct bench_options        opts;
+	struct fftset_init_options  init_opts;
+	struct fftset               fftset;
+	struct cop_salloc_iface     mem;
+	struct cop_alloc_grp_temps  mem_impl;
+	struct bench_buffers        bufs;
+	size_t                      lengths[MAX_LENGTHS];
+	size_t                      nb_lengths;
+	size_t                      buf_floats;
+	size_t                      i;
+	double                     *samples;
+	enum fftset_isa             isa;
+	FILE                       *out = stdout;
+	unsigned                    m;
+	unsigned                    skipped = 0;
+	int                         first = 1;
+	int                         errors = 0;
+
+	if (parse_args(&opts, argc, argv))
+		return 1;
+
+	nb_lengths = get_lengths(lengths, MAX_LENGTHS, opts.min_bins, opts.max_bins, opts.all_lengths);
+	if (nb_lengths == 0) {
+		fprintf(stderr, "no lengths to benchmark\n");
+		return 1;
+	}
+
+	memset(&init_opts, 0, sizeof(init_opts));
+	init_opts.isa = opts.isa;
+	if (fftset_init_ex(&fftset, &init_opts)) {
+		fprintf(stderr, "could not create fftset object\n");
+		return 1;
+	}
+	isa = fftset_get_isa(&fftset);
+
+	/* The work buffer size is not known until the FFTs have been created so
+	 * all of the buffers are given twice the storage of the data. */
+	buf_floats = 2 * lengths[nb_lengths - 1];
+	if (cop_alloc_grp_temps_init(&mem_impl, &mem, sizeof(float) * buf_floats * 5 + 1024, 0, 64)) {
+		fftset_destroy(&fftset);
+		fprintf(stderr, "could not create memory allocator\n");
+		return 1;
+	}
+
+	bufs.input  = cop_salloc(&mem, sizeof(float) * buf_floats, 64);
+	bufs.output = cop_salloc(&mem, sizeof(float) * buf_floats, 64);
+	bufs.kernel = cop_salloc(&mem, sizeof(float) * buf_floats, 64);
+	bufs.work   = cop_salloc(&mem, sizeof(float) * buf_floats * 2, 64);
+	samples     = malloc(sizeof(double) * opts.nb_samples);
+
+	if (bufs.input == NULL || bufs.output == NULL || bufs.kernel == NULL || bufs.work == NULL || samples == NULL) {
+		free(samples);
+		cop_alloc_grp_temps_free(&mem_impl);
+		fftset_destroy(&fftset);
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < buf_floats; i++)
+		bufs.input[i] = (float)(rand() - RAND_MAX / 2) / (float)RAND_MAX;
+
+	if (opts.output != NULL && (out = fopen(opts.output, "w")) == NULL) {
+		free(samples);
+		cop_alloc_grp_temps_free(&mem_impl);
+		fftset_destroy(&fftset);
+		fprintf(stderr, "could not open '%s'\n", opts.output);
+		return 1;
+	}
+
+	if (opts.resample) {
+		errors = bench_resample(out, &opts, isa, &fftset);
+		if (out != stdout)
+			fclose(out);
+		free(samples);
+		cop_alloc_grp_temps_free(&mem_impl);
+		fftset_destroy(&fftset);
+		return errors ? 1 : 0;
+	}
+
+	print_header(out, opts.format, &opts, isa);
+
+	for (m = 0; m < sizeof(MODULATIONS) / sizeof(MODULATIONS[0]); m++) {
+		const struct fftset_modulation *modulation = MODULATIONS[m].is_real ? FFTSET_MODULATION_FREQ_OFFSET_REAL : FFTSET_MODULATION_COMPLEX;
+		for (i = 0; i < nb_lengths; i++) {
+			const struct fftset_fft *fft = fftset_create_fft(&fftset, modulation, lengths[i]);
+			unsigned op;
+
+			/* Not all modulations support all lengths. */
+			if (fft == NULL) {
+				skipped++;
+				continue;
+			}
+
+			if (fftset_fft_work_size(fft) > sizeof(float) * buf_floats * 2) {
+				fprintf(stderr, "work buffer too small for %lu bins\n", (unsigned long)lengths[i]);
+				errors++;
+				continue;
+			}
+
+			fftset_fft_conv_get_kernel(fft, bufs.kernel, bufs.input);
+
+			for (op = 0; op < BENCH_OP_COUNT; op++) {
+				struct bench_result r;
+				r.modulation   = MODULATIONS[m].name;
+				r.operation    = BENCH_OP_NAMES[op];
+				r.complex_bins = lengths[i];
+				bench_op(&r, fft, (enum bench_op)op, &bufs, opts.nb_samples, opts.time_per_length / opts.nb_samples, samples);
+				r.gflops = estimated_flops(MODULATIONS[m].is_real, (enum bench_op)op, lengths[i]) / r.mean_ns;
+				print_result(out, opts.format, &opts, isa, &r, first);
+				first = 0;
+			}
+		}
+	}
+
+	print_footer(out, opts.format);
+
+	if (skipped)
+		fprintf(stderr, "%u unsupported modulation and length combinations were skipped\n", skipped);
+
+	if (out != stdout)
+		fclose(out);
+
+	free(samples);
+	cop_alloc_grp_temps_free(&mem_impl);
+	fftset_destroy(&fftset);
+
+	return errors ? 1 : 0;
+}
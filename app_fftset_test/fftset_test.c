@@ -22,7 +22,11 @@
 #include "cop/cop_vec.h"
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 static const unsigned primes[] =
 {0, 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67,
@@ -221,6 +225,80 @@ int convolution_test(struct fftset *fftset, unsigned length, float *buf1, float
 	return 0;
 }
 
+int compact_convolution_test(struct fftset *fftset, unsigned length, const struct fftset_modulation *modulation, enum fftset_kernel_format format, float *buf1, float *buf2, float *buf3)
+{
+	const char              *name   = (modulation == FFTSET_MODULATION_COMPLEX) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+	/* Complex signals hold the primes in their real parts. */
+	const unsigned           stride = (modulation == FFTSET_MODULATION_COMPLEX) ? 2 : 1;
+	const struct fftset_fft *fft;
+	unsigned pidx;
+	unsigned i, j;
+	unsigned nb_samples;
+	float acc;
+	float ref;
+	float tolerance;
+
+	length    *= 2;
+	nb_samples = length / stride;
+
+	fft = fftset_create_fft(fftset, modulation, length / 2);
+	if (fft == NULL) {
+		printf("could not create %s fft\n", name);
+		return 1;
+	}
+
+	if (fftset_fft_conv_kernel_size(fft, format) != ((format == FFTSET_KERNEL_FORMAT_F32) ? 4 : 2) * length) {
+		printf("l=%u,f=%d) unexpected compact kernel size for %s\n", length, (int)format, name);
+		return 1;
+	}
+
+	/* Same signals as the convolution test. */
+	memset(buf1, 0, sizeof(float) * length);
+	for (pidx = 0, i = 0; i < nb_samples; i++) {
+		if (i == primes[pidx] && i < nb_samples / 4) {
+			buf1[i*stride] = 2.0f / length;
+			pidx++;
+		}
+	}
+
+	/* The compact kernel is stored in buf2 and buf3 is used as scratch. */
+	fftset_fft_conv_get_kernel_compact(fft, buf2, buf1, buf3, format);
+
+	memset(buf1, 0, sizeof(float) * length);
+	for (pidx = 0, i = 0; i < nb_samples; i++) {
+		if (i == primes[pidx] && i < (nb_samples * 3) / 4) {
+			buf1[i*stride] = 1.0f;
+			pidx++;
+		}
+	}
+
+	fftset_fft_conv_compact(fft, buf1, buf1, buf2, format, buf3);
+
+	for (i = 0; i < length; i++)
+		buf3[i] = 0.0f;
+	for (i = 0; primes[i] < (nb_samples * 3) / 4; i++) {
+		for (j = 0; primes[j] < nb_samples / 4; j++) {
+			buf3[(primes[i]+primes[j])*stride] += 1.0f;
+		}
+	}
+
+	/* The error is measured relative to the energy of the expected output as
+	 * the compact formats have a fixed relative precision. */
+	for (acc = 0.0f, ref = 0.0f, j = 0; j < length; j++) {
+		float re = buf3[j] - buf1[j];
+		acc += re * re;
+		ref += buf3[j] * buf3[j];
+	}
+	acc       = (ref > 0.0f) ? sqrtf(acc / ref) : sqrtf(acc);
+	tolerance = (format == FFTSET_KERNEL_FORMAT_F16) ? 0.002f : (format == FFTSET_KERNEL_FORMAT_BF16) ? 0.02f : 0.00001f;
+	if (acc > tolerance) {
+		printf("l=%u,f=%d) the %s compact convolution test failed with a relative RMS error of %f\n", length, (int)format, name, acc);
+		return 1;
+	}
+
+	return 0;
+}
+
 int prime_impulse_test_complex(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
 {
 	const struct fftset_fft *fft = fftset_create_fft(fftset, FFTSET_MODULATION_COMPLEX, length);
@@ -313,70 +391,1859 @@ int prime_impulse_test_complex(struct fftset *fftset, unsigned length, float *bu
 	return 0;
 }
 
-int main(int argc, char *argv[])
+int memory_test(float *buf1, float *buf2, float *buf3)
 {
 	struct fftset              fftset;
-	struct cop_salloc_iface    mem;
-	struct cop_alloc_grp_temps mem_impl;
+	struct fftset_init_options options;
+	struct fftset_memory_stats stats;
+	size_t used;
 	int errors = 0;
+
+	/* A large FFT requires more memory than a single default chunk. */
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+	if (fftset_create_fft(&fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, 1u << 20) == NULL) {
+		printf("could not create a large FFT\n");
+		errors++;
+	}
+	fftset_destroy(&fftset);
+
+	/* Tiny chunks so that FFT creation spans many of them. */
+	memset(&options, 0, sizeof(options));
+	options.chunk_size = 4096;
+	options.max_size   = 0;
+	if (fftset_init_ex(&fftset, &options)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+	errors += prime_impulse_test(&fftset, 5*4*4*2, buf1, buf2, buf3);
+	errors += convolution_test(&fftset, 3*3*4*4, buf1, buf2, buf3);
+	errors += prime_impulse_test_complex(&fftset, 5*4*4*2, buf1, buf2, buf3);
+	fftset_get_memory_stats(&fftset, &stats);
+	used = stats.twiddle_bytes + stats.pass_bytes + stats.overhead_bytes;
+	if (stats.nb_chunks < 2 || stats.twiddle_bytes == 0 || stats.pass_bytes == 0 || stats.overhead_bytes == 0 || used > stats.reserved_bytes) {
+		printf("unexpected memory statistics\n");
+		errors++;
+	}
+	fftset_destroy(&fftset);
+
+	/* Creation must fail rather than exceed the maximum size. */
+	options.chunk_size = 16384;
+	options.max_size   = 65536;
+	if (fftset_init_ex(&fftset, &options)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+	if (fftset_create_fft(&fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, 16) == NULL) {
+		printf("could not create a small FFT in a bounded fftset\n");
+		errors++;
+	}
+	if (fftset_create_fft(&fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, 65536) != NULL) {
+		printf("FFT creation exceeded the maximum fftset size\n");
+		errors++;
+	}
+	fftset_get_memory_stats(&fftset, &stats);
+	if (stats.reserved_bytes > options.max_size) {
+		printf("fftset reserved more than the maximum size\n");
+		errors++;
+	}
+	fftset_destroy(&fftset);
+
+	return errors;
+}
+
+int shared_twiddle_test(float *buf1, float *buf2, float *buf3)
+{
+	static const unsigned LENGTHS[] = {4*4*2, 3*4*4, 4*4*4, 4*4*4*2, 3*4*4*4, 4*4*4*4, 3*4*4*4*2, 4*4*4*4*2};
+	struct fftset              fftset;
+	struct fftset_memory_stats stats;
+	size_t separate_bytes = 0;
 	unsigned i;
-	float *tmp1;
-	float *tmp2;
-	float *tmp3;
+	int errors = 0;
 
-	static const unsigned TEST_LENGTHS[] =
-	{ /* Inner passes only */
-	  2, 3, 4, 5, 6, 8
-	  /* Outer r3 pass. */
-	, 3*3, 5*3
-	  /* 2 Outer r3 passes (mainly to test graph builder). */
-	, 3*3*3, 5*3*3
-	  /* Outer r4 passes and tests for vectorised passes. */
-	, 3*4,     4*4,     5*4
-	, 3*4*2,   4*4*2,   5*4*2
-	, 3*4*4,   4*4*4,   5*4*4
-	, 3*4*4*2, 4*4*4*2, 5*4*4*2
-	  /* Vectorised r3 outer passes. */
-	, 3*3*2
-	, 3*3*4
-	, 3*3*4*2
-	, 3*3*4*4
-	, 3*3*4*4*2
-	, 3*3*4*4*4
-	};
+	/* Twiddle memory required when each FFT has an fftset of its own. */
+	for (i = 0; i < sizeof(LENGTHS)/sizeof(LENGTHS[0]); i++) {
+		if (fftset_init(&fftset)) {
+			printf("could not create fftset object\n");
+			return 1;
+		}
+		if (fftset_create_fft(&fftset, FFTSET_MODULATION_COMPLEX, LENGTHS[i]) == NULL) {
+			printf("l=%u) could not create fft\n", LENGTHS[i]);
+			errors++;
+		}
+		fftset_get_memory_stats(&fftset, &stats);
+		separate_bytes += stats.twiddle_bytes;
+		fftset_destroy(&fftset);
+	}
 
 	if (fftset_init(&fftset)) {
 		printf("could not create fftset object\n");
 		return 1;
 	}
 
-	if (cop_alloc_grp_temps_init(&mem_impl, &mem, sizeof(float) * 16384 * 4, 0, 16)) {
+	/* Create them all in the one fftset (largest first so that the first
+	 * tables can be reused by the others) and make sure they still work. */
+	for (i = sizeof(LENGTHS)/sizeof(LENGTHS[0]); i--;)
+		if (fftset_create_fft(&fftset, FFTSET_MODULATION_COMPLEX, LENGTHS[i]) == NULL)
+			errors++;
+	for (i = 0; i < sizeof(LENGTHS)/sizeof(LENGTHS[0]); i++)
+		errors += prime_impulse_test_complex(&fftset, LENGTHS[i], buf1, buf2, buf3);
+
+	fftset_get_memory_stats(&fftset, &stats);
+	if (stats.twiddle_bytes >= separate_bytes) {
+		printf("twiddle tables are not being shared (%lu shared bytes vs %lu separate bytes)\n", (unsigned long)stats.twiddle_bytes, (unsigned long)separate_bytes);
+		errors++;
+	}
+
+	fftset_destroy(&fftset);
+	return errors;
+}
+
+int wisdom_test(enum fftset_planner planner, const unsigned *lengths, unsigned nb_lengths, float *buf1, float *buf2, float *buf3)
+{
+	static const char *WISDOM_FILENAME = "fftset_test_wisdom.bin";
+	struct fftset              fftset_a;
+	struct fftset              fftset_b;
+	struct fftset_init_options options;
+	struct fftset_memory_stats stats;
+	unsigned i, j, m;
+	int errors = 0;
+
+	memset(&options, 0, sizeof(options));
+	options.planner = planner;
+	if (fftset_init_ex(&fftset_a, &options)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+	if (fftset_init(&fftset_b)) {
+		fftset_destroy(&fftset_a);
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	for (i = 0; i < nb_lengths; i++) {
+		fftset_create_fft(&fftset_a, FFTSET_MODULATION_FREQ_OFFSET_REAL, lengths[i]);
+		fftset_create_fft(&fftset_a, FFTSET_MODULATION_COMPLEX, lengths[i]);
+	}
+
+	if (fftset_export(&fftset_a, WISDOM_FILENAME) || fftset_import(&fftset_b, WISDOM_FILENAME)) {
+		printf("could not export and import plans\n");
+		fftset_destroy(&fftset_b);
+		fftset_destroy(&fftset_a);
+		remove(WISDOM_FILENAME);
+		return 1;
+	}
+
+	/* Imported FFTs must produce exactly the same output as the originals
+	 * and must not have needed any new twiddles. */
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		for (i = 0; i < nb_lengths; i++) {
+			const struct fftset_fft *fft_a = fftset_create_fft(&fftset_a, modulation, lengths[i]);
+			const struct fftset_fft *fft_b = fftset_create_fft(&fftset_b, modulation, lengths[i]);
+			if (fft_a == NULL || fft_b == NULL) {
+				printf("l=%u) could not create fft\n", lengths[i]);
+				errors++;
+				continue;
+			}
+			for (j = 0; j < 2 * lengths[i]; j++)
+				buf1[j] = (float)((j * 7919u) % 211u) - 105.0f;
+			fftset_fft_forward(fft_a, buf2, buf1, buf3);
+			fftset_fft_forward(fft_b, buf2 + 8192, buf1, buf3);
+			if (memcmp(buf2, buf2 + 8192, sizeof(float) * 2 * lengths[i])) {
+				printf("l=%u) imported fft produced different output\n", lengths[i]);
+				errors++;
+			}
+		}
+	}
+
+	fftset_get_memory_stats(&fftset_b, &stats);
+	if (stats.twiddle_bytes != 0 || stats.mapped_bytes == 0) {
+		printf("imported plans computed twiddles\n");
+		errors++;
+	}
+
+	/* Newly created FFTs can still be added after an import. */
+	errors += convolution_test(&fftset_b, 3*3*4*4*4*2, buf1, buf2, buf3);
+
+	fftset_destroy(&fftset_b);
+	fftset_destroy(&fftset_a);
+
+	/* Damaged files must be rejected. */
+	{
+		FILE *f = fopen(WISDOM_FILENAME, "r+b");
+		if (f != NULL) {
+			fputc('X', f);
+			fclose(f);
+		}
+		if (fftset_init(&fftset_b) == 0) {
+			if (fftset_import(&fftset_b, WISDOM_FILENAME) == 0) {
+				printf("a damaged plan file was imported\n");
+				errors++;
+			}
+			fftset_destroy(&fftset_b);
+		}
+	}
+
+	remove(WISDOM_FILENAME);
+	return errors;
+}
+
+int measure_planner_test(const unsigned *lengths, unsigned nb_lengths, float *buf1, float *buf2, float *buf3)
+{
+	struct fftset              fftset;
+	struct fftset_init_options options;
+	unsigned i;
+	int errors = 0;
+
+	memset(&options, 0, sizeof(options));
+	options.planner = FFTSET_PLANNER_MEASURE;
+	if (fftset_init_ex(&fftset, &options)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	/* Whatever the timings, every measured plan must compute the same
+	 * transforms as the estimated ones. */
+	for (i = 0; i < nb_lengths; i++) {
+		errors += prime_impulse_test_complex(&fftset, lengths[i], buf1, buf2, buf3);
+		errors += prime_impulse_test(&fftset, lengths[i], buf1, buf2, buf3);
+		errors += convolution_test(&fftset, lengths[i], buf1, buf2, buf3);
+	}
+
+	fftset_destroy(&fftset);
+	return errors;
+}
+
+/* Transforms a single impulse using an FFT which is too large for the test
+ * buffers and checks every output bin against the closed form result. At
+ * the default lengths, the twiddles of the real transform are larger than
+ * the default fftset chunk size. */
+int large_transform_test(int is_complex, size_t length)
+{
+	const struct fftset_modulation *modulation = (is_complex) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+	const char                     *name       = (is_complex) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+	const struct fftset_fft        *fft;
+	struct fftset                   fftset;
+	struct fftset_memory_stats      stats;
+	const size_t                    pos = length / 3 + 1;
+	float  *mem;
+	float  *in;
+	float  *out;
+	float  *work;
+	double  acc;
+	size_t  j;
+	int     errors = 0;
+
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	fft = fftset_create_fft(&fftset, modulation, length);
+	if (fft == NULL) {
+		printf("l=%lu) could not create large %s fft\n", (unsigned long)length, name);
 		fftset_destroy(&fftset);
-		printf("could not create memory allocator\n");
 		return 1;
 	}
 
-	tmp1 = cop_salloc(&mem, sizeof(float) * 16384, 0);
-	tmp2 = cop_salloc(&mem, sizeof(float) * 16384, 0);
-	tmp3 = cop_salloc(&mem, sizeof(float) * 16384, 0);
+	fftset_get_memory_stats(&fftset, &stats);
+	if (stats.twiddle_bytes == 0 || stats.twiddle_bytes > stats.reserved_bytes) {
+		printf("l=%lu) unexpected memory statistics for a large fft\n", (unsigned long)length);
+		errors++;
+	}
 
-	if (tmp1 == NULL || tmp2 == NULL || tmp3 == NULL) {
-		cop_alloc_grp_temps_free(&mem_impl);
+	mem = malloc(sizeof(float) * (6 * length + 16));
+	if (mem == NULL) {
+		printf("l=%lu) not enough memory to run the large fft test\n", (unsigned long)length);
+		fftset_destroy(&fftset);
+		return 1;
+	}
+	in   = (float *)(((size_t)mem + 63) & ~(size_t)63);
+	out  = in + 2 * length;
+	work = out + 2 * length;
+
+	/* A unit impulse (in the real part for the complex transform). */
+	memset(in, 0, sizeof(float) * 2 * length);
+	in[(is_complex) ? 2 * pos : pos] = 1.0f;
+
+	fftset_fft_forward(fft, out, in, work);
+
+	/* The phase is computed exactly using integers so that the reference is
+	 * accurate for very long transforms. */
+	for (acc = 0.0, j = 0; j < length; j++) {
+		unsigned long long period = (is_complex) ? length : 4ull * length;
+		unsigned long long step   = (is_complex) ? (unsigned long long)pos * j : (unsigned long long)pos * (2 * j + 1);
+		double             angle  = (double)(step % period) * -(2.0 * M_PI) / (double)period;
+		double             re     = out[2*j+0] - cos(angle);
+		double             im     = out[2*j+1] - sin(angle);
+		acc += re * re + im * im;
+	}
+	acc = sqrt(acc / length);
+	if (acc > 0.0001) {
+		printf("l=%lu) large %s impulse test failed with an RMS error of %f\n", (unsigned long)length, name, acc);
+		errors++;
+	}
+
+	fftset_fft_inverse(fft, out, out, work);
+	for (acc = 0.0, j = 0; j < 2 * length; j++) {
+		double re = out[j] / (double)length - in[j];
+		acc += re * re;
+	}
+	acc = sqrt(acc / length);
+	if (acc > 0.00001) {
+		printf("l=%lu) large %s inverse test failed with an RMS error of %f\n", (unsigned long)length, name, acc);
+		errors++;
+	}
+
+	free(mem);
+	fftset_destroy(&fftset);
+	return errors;
+}
+
+/* Runs forward, inverse and convolution transforms using a thread pool and
+ * checks the results are identical to the single-threaded results. */
+int threaded_execution_test(unsigned nb_threads, size_t length)
+{
+	struct fftset          fftset;
+	struct fftset_threads  threads;
+	float   *mem;
+	float   *in;
+	float   *kern;
+	float   *ref;
+	float   *out;
+	float   *work;
+	unsigned m;
+	size_t   j;
+	int      errors = 0;
+
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	if (fftset_threads_init(&threads, nb_threads)) {
+		printf("could not create thread pool\n");
+		fftset_destroy(&fftset);
+		return 1;
+	}
+
+	mem = malloc(sizeof(float) * (10 * length + 16));
+	if (mem == NULL) {
+		printf("l=%lu) not enough memory to run the threaded test\n", (unsigned long)length);
+		fftset_threads_destroy(&threads);
 		fftset_destroy(&fftset);
+		return 1;
+	}
+	in   = (float *)(((size_t)mem + 63) & ~(size_t)63);
+	kern = in + 2 * length;
+	ref  = kern + 2 * length;
+	out  = ref + 2 * length;
+	work = out + 2 * length;
+
+	for (j = 0; j < 2 * length; j++)
+		in[j] = (float)((j * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(&fftset, modulation, length);
+
+		if (fft == NULL) {
+			printf("l=%lu) could not create %s fft\n", (unsigned long)length, name);
+			errors++;
+			continue;
+		}
+
+		fftset_fft_forward(fft, ref, in, work);
+		fftset_fft_forward_mt(fft, &threads, out, in, work);
+		if (memcmp(ref, out, sizeof(float) * 2 * length)) {
+			printf("l=%lu,t=%u) threaded %s forward differs\n", (unsigned long)length, nb_threads, name);
+			errors++;
+		}
+
+		fftset_fft_inverse(fft, ref, in, work);
+		fftset_fft_inverse_mt(fft, &threads, out, in, work);
+		if (memcmp(ref, out, sizeof(float) * 2 * length)) {
+			printf("l=%lu,t=%u) threaded %s inverse differs\n", (unsigned long)length, nb_threads, name);
+			errors++;
+		}
+
+		fftset_fft_conv_get_kernel(fft, kern, in);
+		fftset_fft_conv(fft, ref, in, kern, work);
+		fftset_fft_conv_mt(fft, &threads, out, in, kern, work);
+		if (memcmp(ref, out, sizeof(float) * 2 * length)) {
+			printf("l=%lu,t=%u) threaded %s convolution differs\n", (unsigned long)length, nb_threads, name);
+			errors++;
+		}
+	}
+
+	free(mem);
+	fftset_threads_destroy(&threads);
+	fftset_destroy(&fftset);
+	return errors;
+}
+
+/* Checks that the in-place transforms produce exactly the same output as the
+ * out-of-place transforms when given a work buffer of the reported size. */
+int inplace_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, i;
+	int errors = 0;
+
+	for (i = 0; i < 2 * length; i++)
+		buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		float                          *work;
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		/* Allocated with exactly the reported size so that overruns can be
+		 * found by memory checkers. */
+		work = malloc(fftset_fft_work_size(fft));
+		if (work == NULL) {
+			printf("out of memory\n");
+			errors++;
+			continue;
+		}
+
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+		memcpy(buf3, buf1, sizeof(float) * 2 * length);
+		fftset_fft_forward_inplace(fft, buf3, work);
+		if (memcmp(buf2, buf3, sizeof(float) * 2 * length)) {
+			printf("l=%u) in-place %s forward differs\n", length, name);
+			errors++;
+		}
+
+		fftset_fft_inverse(fft, buf2, buf1, buf3);
+		memcpy(buf3, buf1, sizeof(float) * 2 * length);
+		fftset_fft_inverse_inplace(fft, buf3, work);
+		if (memcmp(buf2, buf3, sizeof(float) * 2 * length)) {
+			printf("l=%u) in-place %s inverse differs\n", length, name);
+			errors++;
+		}
+
+		free(work);
+	}
+
+	return errors;
+}
+
+/* Checks that the pruned forward, kernel and convolution functions give the
+ * same results as the full transforms for inputs with zero tails of various
+ * lengths. */
+int pruned_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, i, j, k;
+	int errors = 0;
+	float *out  = malloc(sizeof(float) * 2 * length);
+	float *kern = malloc(sizeof(float) * 2 * length);
+
+	if (out == NULL || kern == NULL) {
 		printf("out of memory\n");
+		free(out);
+		free(kern);
 		return 1;
 	}
 
-	/* Complex modulator tests. */
-	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
-		errors += prime_impulse_test_complex(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		const unsigned                  nb_values  = (m) ? length : 2 * length;
+		const unsigned                  scale      = (m) ? 2 : 1;
+		const unsigned                  nb_nonzero[] =
+			{0, 1, 3, nb_values / 4, nb_values / 4 + 1, nb_values / 2, 3 * nb_values / 4, nb_values - 1, nb_values};
 
-	/* Real shifted modulator tests. */
-	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++) {
-		errors += prime_impulse_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
-		errors += convolution_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		for (j = 0; j < sizeof(nb_nonzero) / sizeof(nb_nonzero[0]); j++) {
+			const unsigned nz = (nb_nonzero[j] < nb_values) ? nb_nonzero[j] : nb_values;
+			double maxerr[3] = {0.0, 0.0, 0.0};
+
+			for (i = 0; i < 2 * length; i++)
+				buf1[i] = (i < nz * scale) ? (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f : 0.0f;
+
+			/* Forward. */
+			fftset_fft_forward(fft, buf2, buf1, buf3);
+			fftset_fft_forward_pruned(fft, out, buf1, nz, buf3);
+			for (i = 0; i < 2 * length; i++) {
+				double e = fabs(out[i] - buf2[i]);
+				if (e > maxerr[0])
+					maxerr[0] = e;
+			}
+
+			/* Kernel. */
+			fftset_fft_conv_get_kernel(fft, buf2, buf1);
+			fftset_fft_conv_get_kernel_pruned(fft, kern, buf1, nz);
+			for (i = 0; i < 2 * length; i++) {
+				double e = fabs(kern[i] - buf2[i]);
+				if (e > maxerr[1])
+					maxerr[1] = e;
+			}
+
+			/* Convolution of the input with itself. */
+			fftset_fft_conv(fft, buf2, buf1, kern, buf3);
+			fftset_fft_conv_pruned(fft, out, buf1, nz, kern, buf3);
+			for (i = 0; i < 2 * length; i++) {
+				double e = fabs(out[i] - buf2[i]);
+				if (e > maxerr[2])
+					maxerr[2] = e;
+			}
+
+			for (k = 0; k < 3; k++) {
+				static const char *ops[3] = {"forward", "kernel", "conv"};
+				if (maxerr[k] > 1e-5 * length) {
+					printf("l=%u,nz=%u) pruned %s %s error %f\n", length, nz, name, ops[k], maxerr[k]);
+					errors++;
+				}
+			}
+		}
 	}
 
+	free(kern);
+	free(out);
+	return errors;
+}
+
+/* Checks that the windowed inverse and convolution functions give the same
+ * outputs in the window as the full transforms. */
+int window_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, i, j;
+	int errors = 0;
+	float *out  = malloc(sizeof(float) * 2 * length);
+	float *kern = malloc(sizeof(float) * 2 * length);
+
+	if (out == NULL || kern == NULL) {
+		printf("out of memory\n");
+		free(out);
+		free(kern);
+		return 1;
+	}
+
+	for (i = 0; i < 2 * length; i++)
+		buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		const unsigned                  nb_values  = (m) ? length : 2 * length;
+		const unsigned                  scale      = (m) ? 2 : 1;
+		const unsigned                  windows[][2] =
+			{{0, nb_values}
+			,{1, nb_values - 1}
+			,{nb_values / 3, nb_values / 2}
+			,{nb_values / 8, nb_values / 16 + 1}
+			,{nb_values / 4 - 1, 3}
+			,{(nb_values > 5) ? nb_values - 5 : 0, 5}
+			,{nb_values / 2, 0}
+			,{2, ~0u}
+			};
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		fftset_fft_conv_get_kernel(fft, kern, buf1);
+
+		for (j = 0; j < sizeof(windows) / sizeof(windows[0]); j++) {
+			const unsigned first = (windows[j][0] < nb_values) ? windows[j][0] : 0;
+			const unsigned count = (windows[j][1] < nb_values - first) ? windows[j][1] : nb_values - first;
+			const unsigned bfirst = first % length;
+			const unsigned bcount = (windows[j][1] < length - bfirst) ? windows[j][1] : length - bfirst;
+
+			fftset_fft_forward(fft, buf2, buf1, buf3);
+			fftset_fft_forward_window(fft, out, bfirst, windows[j][1], buf1, buf3);
+			if (memcmp(out + bfirst * 2, buf2 + bfirst * 2, sizeof(float) * bcount * 2)) {
+				printf("l=%u,first=%u,count=%u) windowed %s forward differs\n", length, bfirst, bcount, name);
+				errors++;
+			}
+
+			fftset_fft_inverse(fft, buf2, buf1, buf3);
+			fftset_fft_inverse_window(fft, out, first, windows[j][1], buf1, buf3);
+			if (memcmp(out + first * scale, buf2 + first * scale, sizeof(float) * count * scale)) {
+				printf("l=%u,first=%u,count=%u) windowed %s inverse differs\n", length, first, count, name);
+				errors++;
+			}
+
+			fftset_fft_conv(fft, buf2, buf1, kern, buf3);
+			fftset_fft_conv_window(fft, out, first, windows[j][1], buf1, kern, buf3);
+			if (memcmp(out + first * scale, buf2 + first * scale, sizeof(float) * count * scale)) {
+				printf("l=%u,first=%u,count=%u) windowed %s conv differs\n", length, first, count, name);
+				errors++;
+			}
+		}
+	}
+
+	free(kern);
+	free(out);
+	return errors;
+}
+
+/* Checks that the spectra given by fftset_fft_forward_pair() match those of
+ * complex transforms of each of the signals. */
+int pair_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	const struct fftset_fft *fft = fftset_create_fft(fftset, FFTSET_MODULATION_COMPLEX, length);
+	const unsigned nb_bins = length / 2 + 1;
+	float *in_a = malloc(sizeof(float) * length);
+	float *in_b = malloc(sizeof(float) * length);
+	float *out  = malloc(sizeof(float) * FFTSET_PAIR_OUTPUT_LEN(length));
+	unsigned i, s;
+	int errors = 0;
+
+	if (fft == NULL || in_a == NULL || in_b == NULL || out == NULL) {
+		printf("could not create FFTSET_MODULATION_COMPLEX fft or out of memory\n");
+		free(in_a);
+		free(in_b);
+		free(out);
+		return 1;
+	}
+
+	for (i = 0; i < length; i++) {
+		in_a[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+		in_b[i] = (float)((i * 104729u) % 997u) / 997.0f - 0.5f;
+	}
+
+	fftset_fft_forward_pair(fft, out, in_a, in_b, buf3);
+
+	for (s = 0; s < 2; s++) {
+		const float *in  = (s) ? in_b : in_a;
+		const float *res = out + s * 2 * nb_bins;
+		double worst = 0.0;
+
+		for (i = 0; i < length; i++) {
+			buf1[2*i+0] = in[i];
+			buf1[2*i+1] = 0.0f;
+		}
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+
+		for (i = 0; i < 2 * nb_bins; i++) {
+			double e = fabs(res[i] - buf2[i]);
+			if (e > worst)
+				worst = e;
+		}
+		if (worst > 1e-5 * length) {
+			printf("l=%u) pair forward of signal %u has an error of %f\n", length, s, worst);
+			errors++;
+		}
+	}
+
+	free(in_a);
+	free(in_b);
+	free(out);
+	return errors;
+}
+
+/* Streams a signal through an fftset_stft in uneven blocks and checks every
+ * frame against the forward transform of the frame windowed by hand. */
+int stft_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, h, i;
+	int errors = 0;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation  = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name        = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft         = fftset_create_fft(fftset, modulation, length);
+		const unsigned                  sample_size = (m) ? 2 : 1;
+		const unsigned                  frame_len   = 2 * length / sample_size;
+		const unsigned                  hops[]      = {1, 3, 4, frame_len / 2 + 1, frame_len, frame_len + 5};
+		float                          *window      = malloc(sizeof(float) * frame_len);
+		float                          *out         = malloc(sizeof(float) * 2 * length);
+
+		if (fft == NULL || window == NULL || out == NULL) {
+			printf("could not create %s fft or out of memory\n", name);
+			free(window);
+			free(out);
+			errors++;
+			continue;
+		}
+
+		for (i = 0; i < frame_len; i++)
+			window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * (i + 0.5f) / frame_len);
+
+		for (h = 0; h < sizeof(hops) / sizeof(hops[0]); h++) {
+			const unsigned     hop       = hops[h];
+			const unsigned     nb_total  = frame_len + 3 * hop + 5;
+			const unsigned     nb_frames = (nb_total - frame_len) / hop + 1;
+			float             *signal    = malloc(sizeof(float) * nb_total * sample_size);
+			struct fftset_stft stft;
+			unsigned           nb_written, frame, chunk;
+
+			if (signal == NULL || fftset_stft_init(&stft, fft, (h & 1) ? window : NULL, hop)) {
+				printf("out of memory\n");
+				free(signal);
+				errors++;
+				continue;
+			}
+
+			for (i = 0; i < nb_total * sample_size; i++)
+				signal[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+			for (nb_written = 0, frame = 0, chunk = 1; nb_written < nb_total; chunk = (chunk * 5) % 17 + 1) {
+				size_t nb_in = (chunk < nb_total - nb_written) ? chunk : nb_total - nb_written;
+				nb_written += (unsigned)fftset_stft_write(&stft, signal + nb_written * sample_size, nb_in);
+				if (fftset_stft_read(&stft, out)) {
+					const float *in    = signal + frame * hop * sample_size;
+					double       worst = 0.0;
+
+					for (i = 0; i < 2 * length; i++)
+						buf1[i] = (h & 1) ? in[i] * window[i / sample_size] : in[i];
+					fftset_fft_forward(fft, buf2, buf1, buf3);
+
+					for (i = 0; i < 2 * length; i++) {
+						double e = fabs(out[i] - buf2[i]);
+						if (e > worst)
+							worst = e;
+					}
+					if (worst > 1e-5 * length) {
+						printf("l=%u,hop=%u) %s STFT frame %u has an error of %f\n", length, hop, name, frame, worst);
+						errors++;
+					}
+					frame++;
+				}
+			}
+
+			if (frame != nb_frames) {
+				printf("l=%u,hop=%u) %s STFT gave %u frames but %u were expected\n", length, hop, name, frame, nb_frames);
+				errors++;
+			}
+
+			fftset_stft_destroy(&stft);
+			free(signal);
+		}
+
+		free(window);
+		free(out);
+	}
+
+	return errors;
+}
+
+/* Analyses a signal with an fftset_stft, resynthesises it with an
+ * fftset_istft and checks that the fully overlapped part of the output
+ * matches the signal. */
+int istft_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, h, i;
+	int errors = 0;
+
+	(void)buf2;
+	(void)buf3;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation  = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name        = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft         = fftset_create_fft(fftset, modulation, length);
+		const unsigned                  sample_size = (m) ? 2 : 1;
+		const unsigned                  frame_len   = 2 * length / sample_size;
+		const unsigned                  hops[]      = {frame_len, 3, (frame_len + 3) / 4, frame_len / 2 + 1, frame_len + 5};
+		float                          *window      = malloc(sizeof(float) * frame_len);
+
+		if (fft == NULL || window == NULL) {
+			printf("could not create %s fft or out of memory\n", name);
+			free(window);
+			errors++;
+			continue;
+		}
+
+		for (i = 0; i < frame_len; i++)
+			window[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * (i + 0.5f) / frame_len);
+
+		for (h = 0; h < sizeof(hops) / sizeof(hops[0]); h++) {
+			const unsigned      hop       = hops[h];
+			const int           windowed  = hop < frame_len;
+			const unsigned      nb_frames = frame_len / hop + 4;
+			const unsigned      nb_total  = frame_len + (nb_frames - 1) * hop;
+			float              *signal    = malloc(sizeof(float) * nb_total * sample_size);
+			float              *recon     = malloc(sizeof(float) * nb_frames * hop * sample_size);
+			struct fftset_stft  stft;
+			struct fftset_istft istft;
+			unsigned            nb_written, frame;
+			double              worst;
+
+			if (signal == NULL || recon == NULL) {
+				printf("out of memory\n");
+				free(signal);
+				free(recon);
+				errors++;
+				continue;
+			}
+			if (fftset_stft_init(&stft, fft, (windowed) ? window : NULL, hop)) {
+				printf("out of memory\n");
+				free(signal);
+				free(recon);
+				errors++;
+				continue;
+			}
+			if (fftset_istft_init(&istft, fft, (windowed) ? window : NULL, (windowed) ? window : NULL, hop)) {
+				printf("out of memory\n");
+				fftset_stft_destroy(&stft);
+				free(signal);
+				free(recon);
+				errors++;
+				continue;
+			}
+
+			for (i = 0; i < nb_total * sample_size; i++)
+				signal[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+			for (nb_written = 0, frame = 0; frame < nb_frames; ) {
+				nb_written += (unsigned)fftset_stft_write(&stft, signal + nb_written * sample_size, nb_total - nb_written);
+				if (fftset_stft_read(&stft, buf1)) {
+					fftset_istft_process(&istft, recon + frame * hop * sample_size, buf1);
+					frame++;
+				}
+			}
+
+			/* Samples between frames (when the hop is longer than a frame)
+			 * are not covered and must be zero. */
+			for (worst = 0.0, i = frame_len * sample_size; i < nb_frames * hop * sample_size; i++) {
+				double expected = ((i / sample_size) % hop < frame_len) ? signal[i] : 0.0;
+				double e        = fabs(recon[i] - expected);
+				if (e > worst)
+					worst = e;
+			}
+			if (worst > 1e-4) {
+				printf("l=%u,hop=%u) %s ISTFT has an error of %f\n", length, hop, name, worst);
+				errors++;
+			}
+
+			fftset_istft_destroy(&istft);
+			fftset_stft_destroy(&stft);
+			free(signal);
+			free(recon);
+		}
+
+		free(window);
+	}
+
+	return errors;
+}
+
+/* Checks that the scaled inverse and kernel variants match the unscaled
+ * functions with the outputs scaled afterwards. */
+int scaled_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, i;
+	int errors = 0;
+	float *out  = malloc(sizeof(float) * 2 * length);
+	float *kern = malloc(sizeof(float) * 2 * length);
+
+	if (out == NULL || kern == NULL) {
+		printf("out of memory\n");
+		free(out);
+		free(kern);
+		return 1;
+	}
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		const float                     scale      = 1.0f / length;
+		double                          worst_inv  = 0.0;
+		double                          worst_conv = 0.0;
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		for (i = 0; i < 2 * length; i++)
+			buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+		/* The scaled inverse of the forward transform is the input. */
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+		fftset_fft_inverse_scaled(fft, out, buf2, scale, buf3);
+		for (i = 0; i < 2 * length; i++) {
+			double e = fabs(out[i] - buf1[i]);
+			if (e > worst_inv)
+				worst_inv = e;
+		}
+
+		/* A scaled kernel gives scaled convolution outputs. */
+		if (m == 0) {
+			for (i = 0; i < 2 * length; i++)
+				buf2[i] = (float)((i * 104729u) % 997u) / 997.0f - 0.5f;
+			fftset_fft_conv_get_kernel_scaled(fft, kern, buf2, scale);
+			fftset_fft_conv(fft, out, buf1, kern, buf3);
+			fftset_fft_conv_get_kernel(fft, kern, buf2);
+			fftset_fft_conv(fft, buf2, buf1, kern, buf3);
+			for (i = 0; i < 2 * length; i++) {
+				double e = fabs(out[i] - buf2[i] * scale);
+				if (e > worst_conv)
+					worst_conv = e;
+			}
+		}
+
+		if (worst_inv > 1e-5 || worst_conv > 1e-5 * length) {
+			printf("l=%u) %s scaled outputs have errors of %f (inverse) and %f (convolution)\n", length, name, worst_inv, worst_conv);
+			errors++;
+		}
+	}
+
+	free(out);
+	free(kern);
+	return errors;
+}
+
+/* Checks the analytic signal against the spectrum of the signal computed
+ * directly with the negative frequencies removed. */
+int analytic_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	const struct fftset_fft *fft    = fftset_create_fft(fftset, FFTSET_MODULATION_COMPLEX, length);
+	double                  *spec   = malloc(sizeof(double) * 2 * length);
+	float                   *kern   = malloc(sizeof(float) * 2 * length);
+	double                   worst  = 0.0;
+	unsigned                 i, k;
+	int                      errors = 0;
+
+	if (fft == NULL || spec == NULL || kern == NULL) {
+		printf("could not create FFTSET_MODULATION_COMPLEX fft or out of memory\n");
+		free(spec);
+		free(kern);
+		return 1;
+	}
+
+	for (i = 0; i < length; i++)
+		buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+	/* One-sided spectrum. */
+	for (k = 0; k < length; k++) {
+		const double gain = (k == 0 || 2 * k == length) ? 1.0 : (2 * k < length) ? 2.0 : 0.0;
+		double re = 0.0, im = 0.0;
+		for (i = 0; i < length; i++) {
+			double a = -2.0 * M_PI * (double)((k * i) % length) / length;
+			re += buf1[i] * cos(a);
+			im += buf1[i] * sin(a);
+		}
+		spec[2*k+0] = gain * re;
+		spec[2*k+1] = gain * im;
+	}
+
+	fftset_fft_analytic_get_kernel(fft, kern, buf3);
+	fftset_fft_analytic(fft, buf2, buf1, kern, buf3);
+
+	for (i = 0; i < length; i++) {
+		double re = 0.0, im = 0.0;
+		for (k = 0; k < length; k++) {
+			double a = 2.0 * M_PI * (double)((k * i) % length) / length;
+			re += spec[2*k+0] * cos(a) - spec[2*k+1] * sin(a);
+			im += spec[2*k+0] * sin(a) + spec[2*k+1] * cos(a);
+		}
+		re = fabs(buf2[2*i+0] - re / length);
+		im = fabs(buf2[2*i+1] - im / length);
+		if (re > worst)
+			worst = re;
+		if (im > worst)
+			worst = im;
+	}
+
+	if (worst > 1e-5 * length) {
+		printf("l=%u) analytic signal has an error of %f\n", length, worst);
+		errors++;
+	}
+
+	free(spec);
+	free(kern);
+	return errors;
+}
+
+/* Checks the spectrum outputs (converted back to powers) against the band
+ * powers of the output of the forward transform. */
+int spectrum_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	static const enum fftset_spectrum_format formats[] = {FFTSET_SPECTRUM_POWER, FFTSET_SPECTRUM_MAGNITUDE, FFTSET_SPECTRUM_LOG_POWER};
+	unsigned m, b, f, i;
+	int errors = 0;
+	float *out = malloc(sizeof(float) * 2 * length);
+
+	if (out == NULL) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		const unsigned                  bands[]    = {1, 3, 8, length};
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		for (i = 0; i < 2 * length; i++)
+			buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+
+		for (b = 0; b < sizeof(bands) / sizeof(bands[0]); b++) {
+			const unsigned band_size = bands[b];
+			const unsigned nb_bands  = (length + band_size - 1) / band_size;
+			for (f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+				double worst = 0.0;
+				fftset_fft_forward_spectrum(fft, out, buf1, formats[f], band_size, buf3);
+				for (i = 0; i < nb_bands; i++) {
+					double   expected = 0.0;
+					double   actual   = out[i];
+					double   e;
+					unsigned k;
+					for (k = i * band_size; k < (i + 1) * band_size && k < length; k++)
+						expected += (double)buf2[2*k+0] * buf2[2*k+0] + (double)buf2[2*k+1] * buf2[2*k+1];
+					if (formats[f] == FFTSET_SPECTRUM_MAGNITUDE)
+						actual = actual * actual;
+					else if (formats[f] == FFTSET_SPECTRUM_LOG_POWER)
+						actual = pow(10.0, actual / 10.0);
+					e = fabs(actual - expected) / (expected + 1e-2);
+					if (e > worst)
+						worst = e;
+				}
+				if (worst > 1e-4) {
+					printf("l=%u,band=%u,format=%u) %s spectrum has a relative error of %f\n", length, band_size, (unsigned)formats[f], name, worst);
+					errors++;
+				}
+			}
+		}
+	}
+
+	free(out);
+	return errors;
+}
+
+/* Evaluates several lists of bins with every method and checks them against
+ * the corresponding bins of the full forward transform. */
+int bins_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	static const enum fftset_bins_method methods[] = {FFTSET_BINS_AUTO, FFTSET_BINS_GOERTZEL, FFTSET_BINS_TRANSFORM};
+	unsigned m, l, t, i;
+	int errors = 0;
+	float *out = malloc(sizeof(float) * 2 * (length + 3));
+
+	if (out == NULL) {
+		printf("out of memory\n");
+		return 1;
+	}
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		size_t                          bins[3][64];
+		size_t                          nb_bins[3];
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		/* A single bin, the last and first bins with a repeat and a
+		 * scattered list (every bin for short transforms). */
+		bins[0][0] = length / 2;
+		nb_bins[0] = 1;
+		bins[1][0] = length - 1;
+		bins[1][1] = 0;
+		bins[1][2] = length - 1;
+		nb_bins[1] = 3;
+		nb_bins[2] = (length < 64) ? length : 64;
+		for (i = 0; i < nb_bins[2]; i++)
+			bins[2][i] = (i * 37u + 5u) % length;
+
+		for (i = 0; i < 2 * length; i++)
+			buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+
+		for (l = 0; l < 3; l++) {
+			for (t = 0; t < sizeof(methods) / sizeof(methods[0]); t++) {
+				struct fftset_bins b;
+				double             worst = 0.0;
+				size_t             work_size;
+				float             *work;
+
+				if (fftset_bins_init(&b, fft, bins[l], nb_bins[l], methods[t])) {
+					printf("out of memory\n");
+					errors++;
+					continue;
+				}
+
+				if (methods[t] != FFTSET_BINS_AUTO && fftset_bins_get_method(&b) != methods[t]) {
+					printf("l=%u,method=%u) %s bins ignored the requested method\n", length, (unsigned)methods[t], name);
+					errors++;
+				}
+
+				/* Allocated with exactly the reported size so that
+				 * overruns can be found by memory checkers (the Goertzel
+				 * bank needs none). */
+				work_size = fftset_bins_work_size(&b);
+				if ((work_size == 0) != (fftset_bins_get_method(&b) == FFTSET_BINS_GOERTZEL)) {
+					printf("l=%u,method=%u) %s bins gave a work size of %u\n", length, (unsigned)methods[t], name, (unsigned)work_size);
+					errors++;
+				}
+				work = (work_size) ? malloc(work_size) : NULL;
+				if (work_size && work == NULL) {
+					printf("out of memory\n");
+					errors++;
+					fftset_bins_destroy(&b);
+					continue;
+				}
+
+				/* The output need not be aligned and must not be written
+				 * beyond nb_bins. */
+				out[1 + 2 * nb_bins[l]] = 1234.0f;
+				fftset_bins_forward(&b, out + 1, buf1, work);
+				fftset_bins_destroy(&b);
+				free(work);
+				if (out[1 + 2 * nb_bins[l]] != 1234.0f) {
+					printf("l=%u,method=%u) %s bins wrote beyond the output\n", length, (unsigned)methods[t], name);
+					errors++;
+				}
+
+				for (i = 0; i < nb_bins[l]; i++) {
+					double re = fabs(out[1+2*i+0] - buf2[2*bins[l][i]+0]);
+					double im = fabs(out[1+2*i+1] - buf2[2*bins[l][i]+1]);
+					if (re > worst)
+						worst = re;
+					if (im > worst)
+						worst = im;
+				}
+
+				if (worst > 1e-4 * length) {
+					printf("l=%u,method=%u,nb_bins=%u) %s bins have an error of %f\n", length, (unsigned)methods[t], (unsigned)nb_bins[l], name, worst);
+					errors++;
+				}
+			}
+		}
+	}
+
+	free(out);
+	return errors;
+}
+
+/* Checks the relative error of the Goertzel bank next to DC and Nyquist of
+ * a long transform (4096 input values for the real modulation), where a
+ * single precision resonator is least accurate. */
+int bins_accuracy_test(struct fftset *fftset, float *buf1, float *buf2, float *buf3)
+{
+	const unsigned length = 2048;
+	const size_t   bins[] = {0, 1, 2, 3, 2047};
+	float          out[2 * sizeof(bins) / sizeof(bins[0])];
+	unsigned       m, i;
+	int            errors = 0;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const unsigned                  nb_floats  = 2 * length;
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+		struct fftset_bins              b;
+		double                          worst      = 0.0;
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		if (fftset_bins_init(&b, fft, bins, sizeof(bins) / sizeof(bins[0]), FFTSET_BINS_GOERTZEL)) {
+			printf("out of memory\n");
+			errors++;
+			continue;
+		}
+
+		/* A smooth signal: most of its energy is close to DC. */
+		for (i = 0; i < nb_floats; i++) {
+			double t = (double)i / nb_floats;
+			buf1[i] = (float)(0.3 + sin(2.0 * M_PI * 1.7 * t) + 0.5 * cos(2.0 * M_PI * 5.2 * t) + 0.1 * t * t);
+		}
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+		fftset_bins_forward(&b, out, buf1, buf3);
+		fftset_bins_destroy(&b);
+
+		for (i = 0; i < sizeof(bins) / sizeof(bins[0]); i++) {
+			double xr = buf2[2*bins[i]+0];
+			double xi = buf2[2*bins[i]+1];
+			double e  = sqrt(((out[2*i+0] - xr) * (out[2*i+0] - xr) + (out[2*i+1] - xi) * (out[2*i+1] - xi)) / (xr * xr + xi * xi));
+			if (e > worst)
+				worst = e;
+		}
+
+		if (worst > 5e-4) {
+			printf("l=%u) %s Goertzel bins have a relative error of %f\n", length, name, worst);
+			errors++;
+		}
+	}
+
+	return errors;
+}
+
+/* Channelizes a complex signal in two batches and checks every frame
+ * against the definition of the filter bank evaluated directly. */
+int channelizer_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	const struct fftset_fft *fft           = fftset_create_fft(fftset, FFTSET_MODULATION_COMPLEX, length);
+	const unsigned           nb_taps       = 3 * length - 1;
+	const unsigned           nb_frames     = 5;
+	const unsigned           decimations[] = {length, (length + 1) / 2, 3, 3 * length + 2};
+	float                   *prototype     = malloc(sizeof(float) * nb_taps);
+	float                   *out           = malloc(sizeof(float) * 2 * length * nb_frames);
+	unsigned                 d, i;
+	int                      errors        = 0;
+
+	(void)buf1;
+	(void)buf2;
+	(void)buf3;
+
+	if (fft == NULL || prototype == NULL || out == NULL) {
+		printf("could not create FFTSET_MODULATION_COMPLEX fft or out of memory\n");
+		free(prototype);
+		free(out);
+		return 1;
+	}
+
+	for (i = 0; i < nb_taps; i++)
+		prototype[i] = (float)((i * 4721u) % 977u) / 977.0f - 0.5f;
+
+	for (d = 0; d < sizeof(decimations) / sizeof(decimations[0]); d++) {
+		const unsigned            decimation = decimations[d];
+		const unsigned            nb_total   = nb_frames * decimation;
+		float                    *signal     = malloc(sizeof(float) * 2 * nb_total);
+		struct fftset_channelizer channelizer;
+		unsigned                  n, k;
+		double                    worst = 0.0;
+
+		if (signal == NULL || fftset_channelizer_init(&channelizer, fft, prototype, nb_taps, decimation)) {
+			printf("out of memory\n");
+			free(signal);
+			errors++;
+			continue;
+		}
+
+		for (i = 0; i < 2 * nb_total; i++)
+			signal[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+		/* Two batches of frames. */
+		fftset_channelizer_process(&channelizer, out, signal, 2);
+		fftset_channelizer_process(&channelizer, out + 4 * length, signal + 4 * decimation, nb_frames - 2);
+
+		for (n = 0; n < nb_frames; n++) {
+			const long t = (long)((n + 1) * decimation) - (long)nb_taps;
+			for (k = 0; k < length; k++) {
+				double re = 0.0, im = 0.0;
+				for (i = 0; i < nb_taps; i++) {
+					const long s = t + (long)i;
+					double     a;
+					if (s < 0)
+						continue;
+					a   = -2.0 * M_PI * (double)((k * (unsigned long)(s % length)) % length) / length;
+					re += prototype[i] * (signal[2*s+0] * cos(a) - signal[2*s+1] * sin(a));
+					im += prototype[i] * (signal[2*s+0] * sin(a) + signal[2*s+1] * cos(a));
+				}
+				re = fabs(out[2*(n*length+k)+0] - re);
+				im = fabs(out[2*(n*length+k)+1] - im);
+				if (re > worst)
+					worst = re;
+				if (im > worst)
+					worst = im;
+			}
+		}
+		if (worst > 1e-5 * nb_taps) {
+			printf("l=%u,decimation=%u) channelizer has an error of %f\n", length, decimation, worst);
+			errors++;
+		}
+
+		fftset_channelizer_destroy(&channelizer);
+		free(signal);
+	}
+
+	free(prototype);
+	free(out);
+	return errors;
+}
+
+/* Streams a signal through an fftset_resampler in uneven blocks and checks
+ * the output against the upsample, filter and decimate definition evaluated
+ * directly. */
+int resampler_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	const struct fftset_fft *fft        = fftset_create_fft(fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, length);
+	const unsigned           frame_len  = 2 * length;
+	const unsigned           taps[]     = {1, length + 1, frame_len};
+	const unsigned           ratios[][2] = {{1, 1}, {3, 2}, {2, 3}, {1, 4}, {5, 1}, {160, 147}};
+	const unsigned           nb_total   = 3 * frame_len + 7;
+	float                   *signal     = malloc(sizeof(float) * nb_total);
+	float                   *filter     = malloc(sizeof(float) * frame_len);
+	float                   *out        = malloc(sizeof(float) * (5 * nb_total + frame_len));
+	unsigned                 t, r, i;
+	int                      errors     = 0;
+
+	(void)buf1;
+	(void)buf2;
+	(void)buf3;
+
+	if (fft == NULL || signal == NULL || filter == NULL || out == NULL) {
+		printf("could not create FFTSET_MODULATION_FREQ_OFFSET_REAL fft or out of memory\n");
+		free(signal);
+		free(filter);
+		free(out);
+		return 1;
+	}
+
+	for (i = 0; i < nb_total; i++)
+		signal[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+	for (i = 0; i < frame_len; i++)
+		filter[i] = (float)((i * 4721u) % 977u) / (977.0f * frame_len) - 0.5f / frame_len;
+
+	for (t = 0; t < sizeof(taps) / sizeof(taps[0]); t++) {
+		for (r = 0; r < sizeof(ratios) / sizeof(ratios[0]); r++) {
+			const unsigned          nb_taps = taps[t];
+			const unsigned          up      = ratios[r][0];
+			const unsigned          down    = ratios[r][1];
+			/* Every output whose inputs have all been written must be
+			 * produced once the block after it has started. */
+			const unsigned          nb_min  = (nb_total * up - (frame_len - nb_taps + 1) - up + 1) / down;
+			struct fftset_resampler resampler;
+			unsigned                nb_written, nb_out, chunk;
+			double                  worst = 0.0;
+
+			if (fftset_resampler_init(&resampler, fft, filter, nb_taps, up, down)) {
+				printf("out of memory\n");
+				errors++;
+				continue;
+			}
+
+			for (nb_written = 0, nb_out = 0, chunk = 1; nb_written < nb_total; chunk = (chunk * 5) % 17 + 1) {
+				size_t nb_in = (chunk < nb_total - nb_written) ? chunk : nb_total - nb_written;
+				nb_written += (unsigned)fftset_resampler_write(&resampler, signal + nb_written, nb_in);
+				nb_out     += (unsigned)fftset_resampler_read(&resampler, out + nb_out);
+			}
+
+			for (i = 0; i < nb_out; i++) {
+				const unsigned long j   = (unsigned long)i * down;
+				double              acc = 0.0;
+				unsigned            k;
+				for (k = j % up; k < nb_taps && k <= j; k += up)
+					acc += filter[k] * (double)(((j - k) / up < nb_total) ? signal[(j - k) / up] : 0.0f);
+				acc = fabs(out[i] - up * acc);
+				if (acc > worst)
+					worst = acc;
+			}
+
+			if (worst > 1e-5 * up) {
+				printf("l=%u,taps=%u,ratio=%u/%u) resampler has an error of %f\n", length, nb_taps, up, down, worst);
+				errors++;
+			}
+			if (nb_out < nb_min) {
+				printf("l=%u,taps=%u,ratio=%u/%u) resampler gave %u outputs but at least %u were expected\n", length, nb_taps, up, down, nb_out, nb_min);
+				errors++;
+			}
+
+			fftset_resampler_destroy(&resampler);
+		}
+	}
+
+	free(signal);
+	free(filter);
+	free(out);
+	return errors;
+}
+
+/* Checks the records of one call made by profile_test(). */
+static int profile_check(const char *name, enum fftset_profile_event event, unsigned length)
+{
+	struct fftset_profile_record rec[64];
+	unsigned long long passes = 0;
+	unsigned nb_pass[FFTSET_PROFILE_MULCONJ + 1] = {0};
+	size_t n = fftset_profile_read(rec, 64);
+	size_t i;
+
+	if (n < 3 || n > 64) {
+		printf("l=%u) %s event %d produced %lu profile records\n", length, name, (int)event, (unsigned long)n);
+		return 1;
+	}
+
+	for (i = 0; i < n - 2; i++) {
+		if (rec[i].event < FFTSET_PROFILE_DIF || rec[i].event > FFTSET_PROFILE_MULCONJ || rec[i].vec_width == 0) {
+			printf("l=%u) %s event %d has a bad pass record\n", length, name, (int)event);
+			return 1;
+		}
+		nb_pass[rec[i].event]++;
+		passes += rec[i].ticks;
+	}
+
+	if  (   rec[n-2].event != FFTSET_PROFILE_MODULATOR
+	    ||  rec[n-1].event != event
+	    ||  rec[n-1].lfft != length
+	    ||  (rec[n-2].ticks + passes != rec[n-1].ticks && rec[n-2].ticks != 0)
+	    ) {
+		printf("l=%u) %s event %d has bad call records\n", length, name, (int)event);
+		return 1;
+	}
+
+	switch (event) {
+	case FFTSET_PROFILE_CONV:
+		if (nb_pass[FFTSET_PROFILE_MULCONJ] != 1 || nb_pass[FFTSET_PROFILE_DIF] == 0 || nb_pass[FFTSET_PROFILE_DIF] != nb_pass[FFTSET_PROFILE_DIT] || nb_pass[FFTSET_PROFILE_STOCKHAM]) {
+			printf("l=%u) %s convolution has unexpected passes\n", length, name);
+			return 1;
+		}
+		break;
+	case FFTSET_PROFILE_GET_KERNEL:
+		if (nb_pass[FFTSET_PROFILE_DIF] == 0 || nb_pass[FFTSET_PROFILE_DIT] || nb_pass[FFTSET_PROFILE_MULCONJ] || nb_pass[FFTSET_PROFILE_STOCKHAM]) {
+			printf("l=%u) %s get kernel has unexpected passes\n", length, name);
+			return 1;
+		}
+		break;
+	default:
+		if (nb_pass[FFTSET_PROFILE_DIF] + nb_pass[FFTSET_PROFILE_STOCKHAM] == 0 || nb_pass[FFTSET_PROFILE_DIF] > 1 || nb_pass[FFTSET_PROFILE_DIT] || nb_pass[FFTSET_PROFILE_MULCONJ]) {
+			printf("l=%u) %s transform has unexpected passes\n", length, name);
+			return 1;
+		}
+		break;
+	}
+
+	return 0;
+}
+
+/* Checks that the profiling records of each execution function describe
+ * the passes which were run. Nothing must be recorded if profiling was not
+ * built in. */
+int profile_test(struct fftset *fftset, unsigned length, float *buf1, float *buf2, float *buf3)
+{
+	unsigned m, i;
+	int errors = 0;
+
+	for (i = 0; i < 2 * length; i++)
+		buf1[i] = (float)((i * 7919u) % 1013u) / 1013.0f - 0.5f;
+
+	for (m = 0; m < 2; m++) {
+		const struct fftset_modulation *modulation = (m) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL;
+		const char                     *name       = (m) ? "FFTSET_MODULATION_COMPLEX" : "FFTSET_MODULATION_FREQ_OFFSET_REAL";
+		const struct fftset_fft        *fft        = fftset_create_fft(fftset, modulation, length);
+
+		if (fft == NULL) {
+			printf("could not create %s fft\n", name);
+			errors++;
+			continue;
+		}
+
+		fftset_profile_reset();
+		fftset_fft_forward(fft, buf2, buf1, buf3);
+		if (!fftset_profile_enabled()) {
+			if (fftset_profile_read(NULL, 0) != 0) {
+				printf("profile records produced when profiling is disabled\n");
+				errors++;
+			}
+			continue;
+		}
+		errors += profile_check(name, FFTSET_PROFILE_FORWARD, length);
+
+		fftset_profile_reset();
+		fftset_fft_inverse(fft, buf2, buf1, buf3);
+		errors += profile_check(name, FFTSET_PROFILE_INVERSE, length);
+
+		fftset_profile_reset();
+		fftset_fft_conv_get_kernel(fft, buf2, buf1);
+		errors += profile_check(name, FFTSET_PROFILE_GET_KERNEL, length);
+
+		fftset_profile_reset();
+		fftset_fft_conv(fft, buf3, buf1, buf2, buf3 + 2 * length);
+		errors += profile_check(name, FFTSET_PROFILE_CONV, length);
+	}
+
+	fftset_profile_reset();
+
+	return errors;
+}
+
+/* Runs the impulse and convolution tests using the kernels of every
+ * instruction set level (levels which are not available fall back to lower
+ * ones). */
+int isa_dispatch_test(const unsigned *lengths, unsigned nb_lengths, float *buf1, float *buf2, float *buf3)
+{
+	struct fftset_init_options options;
+	struct fftset              fftset;
+	enum fftset_isa            best;
+	unsigned level, i;
+	int errors = 0;
+
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+	best = fftset_get_isa(&fftset);
+	fftset_destroy(&fftset);
+
+	if (best < FFTSET_ISA_BASELINE || best > FFTSET_ISA_AVX512) {
+		printf("unexpected instruction set level %d\n", (int)best);
+		return 1;
+	}
+
+	for (level = FFTSET_ISA_BASELINE; level <= FFTSET_ISA_AVX512; level++) {
+		enum fftset_isa isa;
+
+		memset(&options, 0, sizeof(options));
+		options.isa = (enum fftset_isa)level;
+		if (fftset_init_ex(&fftset, &options)) {
+			printf("could not create fftset object\n");
+			return 1;
+		}
+
+		isa = fftset_get_isa(&fftset);
+		if (isa < FFTSET_ISA_BASELINE || isa > (enum fftset_isa)level || isa > best) {
+			printf("isa=%u) unexpected instruction set level %d\n", level, (int)isa);
+			errors++;
+		}
+
+		for (i = 0; i < nb_lengths; i++) {
+			errors += prime_impulse_test(&fftset, lengths[i], buf1, buf2, buf3);
+			errors += prime_impulse_test_complex(&fftset, lengths[i], buf1, buf2, buf3);
+			errors += convolution_test(&fftset, lengths[i], buf1, buf2, buf3);
+		}
+
+		fftset_destroy(&fftset);
+	}
+
+	return errors;
+}
+
+int lookup_index_test(void)
+{
+	static const struct fftset_fft *ffts[512];
+	struct fftset             fftset;
+	struct fftset_index_stats fft_stats;
+	struct fftset_index_stats pass_stats;
+	unsigned nb_ffts = 0;
+	unsigned i, len;
+	int errors = 0;
+
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	/* Create every supported complex length which is a multiple of 8 up to
+	 * 4096 for both modulations. */
+	for (len = 8; len <= 4096 && nb_ffts + 2 <= sizeof(ffts)/sizeof(ffts[0]); len += 8) {
+		unsigned r = len;
+		while (r % 2 == 0) r /= 2;
+		while (r % 3 == 0) r /= 3;
+		if (r % 5 == 0) r /= 5;
+		if (r != 1)
+			continue;
+		ffts[nb_ffts++] = fftset_create_fft(&fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, len);
+		ffts[nb_ffts++] = fftset_create_fft(&fftset, FFTSET_MODULATION_COMPLEX, len);
+		if (ffts[nb_ffts-1] == NULL || ffts[nb_ffts-2] == NULL) {
+			printf("l=%u) could not create fft\n", len);
+			fftset_destroy(&fftset);
+			return 1;
+		}
+	}
+
+	/* Lookups must find the same objects. */
+	for (i = 0, len = 8; i < nb_ffts; len += 8) {
+		unsigned r = len;
+		while (r % 2 == 0) r /= 2;
+		while (r % 3 == 0) r /= 3;
+		if (r % 5 == 0) r /= 5;
+		if (r != 1)
+			continue;
+		if (fftset_create_fft(&fftset, FFTSET_MODULATION_FREQ_OFFSET_REAL, len) != ffts[i] ||
+		    fftset_create_fft(&fftset, FFTSET_MODULATION_COMPLEX, len) != ffts[i+1]) {
+			printf("l=%u) lookup returned a different fft\n", len);
+			errors++;
+		}
+		i += 2;
+	}
+
+	fftset_get_lookup_stats(&fftset, &fft_stats, &pass_stats);
+	if (fft_stats.nb_entries != nb_ffts ||
+	    fft_stats.capacity < 2 * fft_stats.nb_entries ||
+	    fft_stats.max_probe_length < 1 ||
+	    fft_stats.mean_probe_length < 1.0f ||
+	    fft_stats.mean_probe_length > fft_stats.max_probe_length ||
+	    pass_stats.nb_entries == 0 ||
+	    pass_stats.capacity < 2 * pass_stats.nb_entries ||
+	    pass_stats.mean_probe_length > 2.0f) {
+		printf("unexpected lookup statistics\n");
+		errors++;
+	}
+
+	fftset_destroy(&fftset);
+	return errors;
+}
+
+#ifndef _WIN32
+#define CONCURRENT_NB_THREADS (8)
+
+struct concurrent_creation_state {
+	struct fftset           *fftset;
+	const unsigned          *lengths;
+	unsigned                 nb_lengths;
+	unsigned                 thread_idx;
+	const struct fftset_fft *ffts[64];
+};
+
+static void *concurrent_creation_thread(void *arg)
+{
+	struct concurrent_creation_state *state = arg;
+	unsigned i;
+	/* Each thread creates the same set of FFTs in a different order. */
+	for (i = 0; i < state->nb_lengths; i++) {
+		unsigned idx = (i + state->thread_idx * 7) % state->nb_lengths;
+		state->ffts[idx] = fftset_create_fft(state->fftset, (idx & 1) ? FFTSET_MODULATION_COMPLEX : FFTSET_MODULATION_FREQ_OFFSET_REAL, state->lengths[idx]);
+	}
+	return NULL;
+}
+
+int concurrent_creation_test(const unsigned *lengths, unsigned nb_lengths, float *buf1, float *buf2, float *buf3)
+{
+	struct fftset                    fftset;
+	struct concurrent_creation_state states[CONCURRENT_NB_THREADS];
+	pthread_t                        threads[CONCURRENT_NB_THREADS];
+	unsigned i, j;
+	int errors = 0;
+
+	if (nb_lengths > 64)
+		nb_lengths = 64;
+
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	for (i = 0; i < CONCURRENT_NB_THREADS; i++) {
+		states[i].fftset     = &fftset;
+		states[i].lengths    = lengths;
+		states[i].nb_lengths = nb_lengths;
+		states[i].thread_idx = i;
+		if (pthread_create(&threads[i], NULL, concurrent_creation_thread, &states[i])) {
+			printf("could not create thread\n");
+			while (i--)
+				pthread_join(threads[i], NULL);
+			fftset_destroy(&fftset);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < CONCURRENT_NB_THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	/* Every thread must have obtained the same object for each FFT. */
+	for (j = 0; j < nb_lengths; j++) {
+		if (states[0].ffts[j] == NULL) {
+			printf("l=%u) concurrent creation failed\n", lengths[j]);
+			errors++;
+			continue;
+		}
+		for (i = 1; i < CONCURRENT_NB_THREADS; i++) {
+			if (states[i].ffts[j] != states[0].ffts[j]) {
+				printf("l=%u) concurrent creation returned different objects\n", lengths[j]);
+				errors++;
+				break;
+			}
+		}
+	}
+
+	/* Make sure the objects work. */
+	for (j = 0; j < nb_lengths && !errors; j++) {
+		if (j & 1)
+			errors += prime_impulse_test_complex(&fftset, lengths[j], buf1, buf2, buf3);
+		else
+			errors += prime_impulse_test(&fftset, lengths[j], buf1, buf2, buf3);
+	}
+
+	fftset_destroy(&fftset);
+	return errors;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+	struct fftset              fftset;
+	struct cop_salloc_iface    mem;
+	struct cop_alloc_grp_temps mem_impl;
+	int errors = 0;
+	unsigned i;
+	size_t large_lengths[2];
+	float *tmp1;
+	float *tmp2;
+	float *tmp3;
+
+	static const unsigned TEST_LENGTHS[] =
+	{ /* Inner passes only */
+	  2, 3, 4, 5, 6, 8
+	  /* Outer r3 pass. */
+	, 3*3, 5*3
+	  /* 2 Outer r3 passes (mainly to test graph builder). */
+	, 3*3*3, 5*3*3
+	  /* Outer r4 passes and tests for vectorised passes. */
+	, 3*4,     4*4,     5*4
+	, 3*4*2,   4*4*2,   5*4*2
+	, 3*4*4,   4*4*4,   5*4*4
+	, 3*4*4*2, 4*4*4*2, 5*4*4*2
+	  /* Vectorised r3 outer passes. */
+	, 3*3*2
+	, 3*3*4
+	, 3*3*4*2
+	, 3*3*4*4
+	, 3*3*4*4*2
+	, 3*3*4*4*4
+	};
+
+	if (fftset_init(&fftset)) {
+		printf("could not create fftset object\n");
+		return 1;
+	}
+
+	if (cop_alloc_grp_temps_init(&mem_impl, &mem, sizeof(float) * 16384 * 4, 0, 16)) {
+		fftset_destroy(&fftset);
+		printf("could not create memory allocator\n");
+		return 1;
+	}
+
+	tmp1 = cop_salloc(&mem, sizeof(float) * 16384, 0);
+	tmp2 = cop_salloc(&mem, sizeof(float) * 16384, 0);
+	tmp3 = cop_salloc(&mem, sizeof(float) * 16384, 0);
+
+	if (tmp1 == NULL || tmp2 == NULL || tmp3 == NULL) {
+		cop_alloc_grp_temps_free(&mem_impl);
+		fftset_destroy(&fftset);
+		printf("out of memory\n");
+		return 1;
+	}
+
+	/* Complex modulator tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++) {
+		errors += prime_impulse_test_complex(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+		errors += pair_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+		errors += compact_convolution_test(&fftset, TEST_LENGTHS[i], FFTSET_MODULATION_COMPLEX, FFTSET_KERNEL_FORMAT_F16, tmp1, tmp2, tmp3);
+		errors += compact_convolution_test(&fftset, TEST_LENGTHS[i], FFTSET_MODULATION_COMPLEX, FFTSET_KERNEL_FORMAT_BF16, tmp1, tmp2, tmp3);
+	}
+
+	/* Real shifted modulator tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++) {
+		errors += prime_impulse_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+		errors += convolution_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+		errors += compact_convolution_test(&fftset, TEST_LENGTHS[i], FFTSET_MODULATION_FREQ_OFFSET_REAL, FFTSET_KERNEL_FORMAT_F16, tmp1, tmp2, tmp3);
+		errors += compact_convolution_test(&fftset, TEST_LENGTHS[i], FFTSET_MODULATION_FREQ_OFFSET_REAL, FFTSET_KERNEL_FORMAT_BF16, tmp1, tmp2, tmp3);
+	}
+
+	/* In-place execution tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += inplace_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Zero-padded input tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += pruned_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Output window tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += window_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Scaled output tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += scaled_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Analytic signal tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += analytic_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Spectrum output tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += spectrum_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Sparse bin tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += bins_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+	errors += bins_accuracy_test(&fftset, tmp1, tmp2, tmp3);
+
+	/* Short-time Fourier transform tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += stft_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Inverse short-time Fourier transform tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += istft_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Polyphase channelizer tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += channelizer_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Rational resampler tests. */
+	for (i = 0; i < sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]); i++)
+		errors += resampler_test(&fftset, TEST_LENGTHS[i], tmp1, tmp2, tmp3);
+
+	/* Memory management tests. */
+	errors += memory_test(tmp1, tmp2, tmp3);
+
+	/* Twiddle sharing tests. */
+	errors += shared_twiddle_test(tmp1, tmp2, tmp3);
+
+	/* Plan file tests. */
+	errors += wisdom_test(FFTSET_PLANNER_ESTIMATE, TEST_LENGTHS, sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]), tmp1, tmp2, tmp3);
+
+	/* Measuring planner tests. */
+	errors += measure_planner_test(TEST_LENGTHS, sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]), tmp1, tmp2, tmp3);
+	errors += wisdom_test(FFTSET_PLANNER_MEASURE, TEST_LENGTHS, sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]), tmp1, tmp2, tmp3);
+
+	/* Instruction set dispatch tests. */
+	errors += isa_dispatch_test(TEST_LENGTHS, sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]), tmp1, tmp2, tmp3);
+
+	/* Profiling tests. */
+	errors += profile_test(&fftset, 3*4*4*2, tmp1, tmp2, tmp3);
+	errors += profile_test(&fftset, 4*4*4*4*4, tmp1, tmp2, tmp3);
+
+	/* Plan cache index tests. */
+	errors += lookup_index_test();
+
+	/* Large transform tests. Larger transforms (e.g. 2^28 points) may be
+	 * tested by passing "--large <log2 length>" but require several gigabytes
+	 * of memory. */
+	large_lengths[0] = (size_t)1 << 21;
+	large_lengths[1] = (size_t)3 * 5 * (1 << 17);
+	if (argc > 2 && !strcmp(argv[1], "--large")) {
+		large_lengths[0] = (size_t)1 << atoi(argv[2]);
+		large_lengths[1] = large_lengths[0] / 4 * 3;
+	}
+	for (i = 0; i < 2; i++) {
+		errors += large_transform_test(1, large_lengths[i]);
+		errors += large_transform_test(0, large_lengths[i]);
+	}
+
+	/* Threaded execution tests. The smallest length is run entirely on the
+	 * calling thread. */
+	errors += threaded_execution_test(4, 96);
+	errors += threaded_execution_test(4, (size_t)1 << 16);
+	errors += threaded_execution_test(3, (size_t)3 * 5 * (1 << 12));
+	errors += threaded_execution_test(0, (size_t)9 << 13);
+
+#ifndef _WIN32
+	/* Concurrent creation tests. */
+	errors += concurrent_creation_test(TEST_LENGTHS, sizeof(TEST_LENGTHS)/sizeof(TEST_LENGTHS[0]), tmp1, tmp2, tmp3);
+#endif
+
 	if (errors) {
 		printf("%u tests failed\n", errors);
 	} else {
@@ -22,6 +22,7 @@
 #define FFTSET_H
 
 #include "cop/cop_alloc.h"
+#include <stddef.h>
 
 /* Types
  * ------------------------------------------------------------------------ */
@@ -43,9 +44,63 @@ struct fftset_fft;
 
 /* Initializes an fftset object which will hold all the memory required by the
  * various modulators. Returns zero on success. Returns non-zero if memory
- * was exhausted. */
+ * was exhausted. This is the same as calling fftset_init_ex() with NULL
+ * options. */
 int fftset_init(struct fftset *fc);
 
+/* Planners which may be used to select the passes of new FFTs.
+ * FFTSET_PLANNER_ESTIMATE picks passes using a fixed cost model and is fast.
+ * FFTSET_PLANNER_MEASURE times candidate pass sequences on this machine and
+ * keeps the fastest. It makes creating an FFT considerably slower (typically
+ * milliseconds per length) and the resulting plans are not deterministic.
+ * Measured plans are saved by fftset_export() so they need only be found
+ * once. */
+enum fftset_planner {
+	FFTSET_PLANNER_ESTIMATE = 0,
+	FFTSET_PLANNER_MEASURE  = 1
+};
+
+/* Instruction set levels which the kernels may be built for. Unless the
+ * library was built with FFTSET_RUNTIME_DISPATCH (the default for x86
+ * builds using CMake), only FFTSET_ISA_BASELINE is available: the kernels
+ * use whatever vector extensions the compiler targets. Otherwise the kernels
+ * are also built for each of the higher levels and the best level supported
+ * by the processor is used. No level has 16 wide vectors so the AVX-512
+ * kernels are the 8 wide kernels with AVX-512 code generation (e.g. more
+ * registers). */
+enum fftset_isa {
+	FFTSET_ISA_AUTO     = 0,
+	FFTSET_ISA_BASELINE = 1,
+	FFTSET_ISA_AVX      = 2,
+	FFTSET_ISA_AVX2_FMA = 3,
+	FFTSET_ISA_AVX512   = 4
+};
+
+/* Options which control how an fftset obtains memory and plans FFTs. Memory
+ * is reserved from the system in chunks of chunk_size bytes as FFTs are
+ * created. Allocations which are larger than half of chunk_size are given a
+ * chunk of their own. If max_size is non-zero, FFT creation will fail
+ * (returning NULL) rather than cause the total reserved memory to exceed
+ * max_size bytes. isa limits the instruction set level of the kernels which
+ * may be used (levels which the processor does not support are never used).
+ * This is mainly useful for testing. Zero values select the defaults (8 MB
+ * chunks with no maximum, the estimating planner and the best available
+ * instruction set), so zero-initialize the structure before setting the
+ * fields of interest. */
+struct fftset_init_options {
+	size_t              chunk_size;
+	size_t              max_size;
+	enum fftset_planner planner;
+	enum fftset_isa     isa;
+};
+
+/* Initializes an fftset using the given options (which may be NULL). Memory
+ * is not reserved until the first FFT is created. Returns zero on success. */
+int fftset_init_ex(struct fftset *fc, const struct fftset_init_options *options);
+
+/* Returns the instruction set level of the kernels used by the fftset. */
+enum fftset_isa fftset_get_isa(const struct fftset *fc);
+
 /* Destroys an fftset. Once this function has been called, all fftset_fft
  * objects which were created using the given fftset are invalid and it is
  * undefined to attempt to use them. */
@@ -75,7 +130,13 @@ extern const struct fftset_modulation *FFTSET_MODULATION_FREQ_OFFSET_REAL;
 /* FFTSET_MODULATION_COMPLEX describes a boring FFT. */
 extern const struct fftset_modulation *FFTSET_MODULATION_COMPLEX;
 
-const struct fftset_fft *fftset_create_fft(struct fftset *fc, const struct fftset_modulation *modulation, unsigned complex_bins);
+/* Finds or creates an FFT of the given modulation and length. Returns NULL if
+ * the modulation does not support the length or if memory was exhausted.
+ *
+ * This function may be called concurrently from multiple threads using the
+ * same fftset. Lookups of FFTs which already exist never block. Creation of
+ * new FFTs is serialised internally. */
+const struct fftset_fft *fftset_create_fft(struct fftset *fc, const struct fftset_modulation *modulation, size_t complex_bins);
 
 /* Modulator Execution
  * ------------------------------------------------------------------------
@@ -122,6 +183,33 @@ fftset_fft_inverse
 	,float                      *work_buf
 	);
 
+/* In-place variants of the above. buf holds the input on entry and the
+ * output on return. The transforms never copy the full buffer internally so
+ * these are no slower than the out-of-place functions and only need
+ * fftset_fft_work_size() bytes of memory in addition to buf. */
+void
+fftset_fft_forward_inplace
+	(const struct fftset_fft    *first_pass
+	,float                      *buf
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_inverse_inplace
+	(const struct fftset_fft    *first_pass
+	,float                      *buf
+	,float                      *work_buf
+	);
+
+/* Returns the number of bytes required by the work_buf argument of the
+ * fftset_fft_*() execution functions for the given FFT. Objects which run
+ * the FFT with their own scratch needs (e.g. fftset_bins) document or query
+ * their work buffers separately. */
+size_t
+fftset_fft_work_size
+	(const struct fftset_fft    *first_pass
+	);
+
 void
 fftset_fft_conv_get_kernel
 	(const struct fftset_fft    *first_pass
@@ -138,6 +226,648 @@ fftset_fft_conv
 	,float                      *work_buf
 	);
 
+/* Zero-Padded Inputs
+ * ------------------------------------------------------------------------
+ * When only the start of the input is non-zero (e.g. a short kernel or block
+ * of signal padded out to the convolution length, or spectral interpolation)
+ * these variants skip the loads and arithmetic which would only process
+ * zeros in the first passes of the transform. nb_nonzero is the number of
+ * leading input values which may be non-zero: real values for
+ * FFTSET_MODULATION_FREQ_OFFSET_REAL and complex values for
+ * FFTSET_MODULATION_COMPLEX. The remaining values must still be present and
+ * zero (some of them may be read). The outputs are the same as those of the
+ * corresponding functions above, which these otherwise behave identically
+ * to. The benefit grows as nb_nonzero shrinks; there is little to gain unless
+ * at most half of the input is non-zero. */
+void
+fftset_fft_forward_pruned
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_conv_get_kernel_pruned
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	);
+
+void
+fftset_fft_conv_pruned
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,const float                *kernel_buf
+	,float                      *work_buf
+	);
+
+/* Output Windows
+ * ------------------------------------------------------------------------
+ * When only part of the output is used (e.g. overlap-save, which discards
+ * the first kernel_length - 1 outputs of every convolution), these variants
+ * only compute and store outputs [out_first, out_first + out_count) in
+ * output_buf. The rest of output_buf is left undefined: it may be used as
+ * scratch space. Outputs are counted as for the nb_nonzero argument above,
+ * except that the outputs of fftset_fft_forward_window() are always complex
+ * bins. out_first must be less than the number of outputs and out_count is
+ * limited to the end of the output. The outputs in the window are the same
+ * as those of the corresponding full functions. The final passes skip
+ * columns which do not contribute to the window; as every column feeds
+ * several widely spaced outputs, most of the arithmetic is only avoided when
+ * the window is small compared with the length (the stores of the discarded
+ * outputs are always avoided). */
+void
+fftset_fft_forward_window
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *input_buf
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_inverse_window
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *input_buf
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_conv_window
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	);
+
+/* Pairs of Real Signals
+ * ------------------------------------------------------------------------
+ * Transforms two real signals of length N (e.g. the channels of a stereo
+ * frame) using one FFTSET_MODULATION_COMPLEX transform of length N: the
+ * signals are loaded as the real and imaginary parts of the input and the
+ * two spectra are separated afterwards. This costs little more than one of
+ * the two real transforms would if done as a complex transform.
+ *
+ * first_pass must have been created with FFTSET_MODULATION_COMPLEX. Bins 0
+ * to N/2 (the remaining bins are the conjugates of these) of the spectrum of
+ * input_a are written as interleaved complex values to the start of
+ * output_buf and are followed by the same bins of the spectrum of input_b.
+ * output_buf must hold FFTSET_PAIR_OUTPUT_LEN(N) floats. The output is not
+ * scaled and matches that of fftset_fft_forward() given the signal with a
+ * zero imaginary part. */
+#define FFTSET_PAIR_OUTPUT_LEN(length_) (4 * ((length_) / 2 + 1))
+
+void
+fftset_fft_forward_pair
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_a
+	,const float                *input_b
+	,float                      *work_buf
+	);
+
+/* Scaled Outputs
+ * ------------------------------------------------------------------------
+ * The transforms are not normalised: fftset_fft_inverse() of the output of
+ * fftset_fft_forward() gives the input multiplied by the number of complex
+ * bins of the transform, as does fftset_fft_conv() given a kernel holding a
+ * unit impulse. These variants multiply the outputs by scale (e.g. one over
+ * the length) without another sweep over the data: the scale is folded into
+ * the twiddles of the modulation as they are loaded by the outer pass. For
+ * convolutions, scaling the kernel once scales every output which is
+ * convolved with it. The outputs otherwise match the unscaled functions. */
+void
+fftset_fft_inverse_scaled
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                       scale
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_conv_get_kernel_scaled
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                       scale
+	);
+
+/* Analytic Signals
+ * ------------------------------------------------------------------------
+ * Computes the analytic signal x + j H{x} of a real signal x of length N
+ * (H being the Hilbert transform) using one FFTSET_MODULATION_COMPLEX
+ * convolution of length N: the negative frequencies are removed and the
+ * positive ones doubled by a kernel applied in the spectral multiply of the
+ * convolution. The real input is loaded straight into the first pass, but
+ * the forward half is still a full complex transform of length N (whose
+ * imaginary inputs happen to be zero) followed by a full inverse, so this
+ * costs the same two transforms as a forward, mask and inverse; only the
+ * separate masking sweep and the reordering of the spectrum are saved. The
+ * magnitude of the output is the envelope of x.
+ *
+ * fftset_fft_analytic_get_kernel() writes the kernel holding the one-sided
+ * mask to kernel_buf (which must hold 2N floats). It only needs to be done
+ * once for each length. work_buf must not alias kernel_buf.
+ *
+ * fftset_fft_analytic() reads N real values from input_buf and writes N
+ * interleaved complex values to output_buf. The analytic signal is circular
+ * (as the spectrum is): the signal should be padded or windowed if the ends
+ * do not meet smoothly. input_buf may alias output_buf. */
+void
+fftset_fft_analytic_get_kernel
+	(const struct fftset_fft    *first_pass
+	,float                      *kernel_buf
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_analytic
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	);
+
+/* Spectrum Outputs
+ * ------------------------------------------------------------------------
+ * Runs the forward transform and outputs the power |X[k]|^2, the magnitude
+ * |X[k]| or the log-power 10 log10(|X[k]|^2) (in decibels; zero power gives
+ * negative infinity) of the bins rather than the complex bins themselves.
+ * The powers are computed as the final pass reorders the bins, so the
+ * complex spectrum is never written out and read back.
+ *
+ * If band_size is greater than one, the powers of every band_size
+ * consecutive bins are summed before being converted, so the output holds
+ * (N + band_size - 1) / band_size values (the last band may be short) where
+ * N is the number of complex bins. output_buf must still hold 2N floats as
+ * it is used as scratch space. */
+enum fftset_spectrum_format {
+	FFTSET_SPECTRUM_POWER     = 0,
+	FFTSET_SPECTRUM_MAGNITUDE = 1,
+	FFTSET_SPECTRUM_LOG_POWER = 2
+};
+
+void
+fftset_fft_forward_spectrum
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	);
+
+/* Sparse Bins
+ * ------------------------------------------------------------------------
+ * Evaluates a handful of the output bins of the forward transform of
+ * first_pass (e.g. for tone detection) without computing the rest.
+ * fftset_bins_init() takes the indices of the bins (each less than the
+ * number of complex bins N, in any order and possibly repeated) and
+ * precomputes whatever is needed to evaluate them. The memory is owned by
+ * the fftset_bins and is released by fftset_bins_destroy(), so a detector
+ * may change its bins as often as it likes. Returns non-zero if memory could
+ * not be allocated.
+ *
+ * FFTSET_BINS_GOERTZEL evaluates the bins directly with a bank of Goertzel
+ * filters (four bins per vector), costing O(nb_bins) operations per input
+ * value. FFTSET_BINS_TRANSFORM runs the forward transform with its output
+ * window (see fftset_fft_forward_window()) limited to the span from the
+ * lowest to the highest bin and picks the bins out of it. FFTSET_BINS_AUTO uses the Goertzel bank when the number of
+ * bins (rounded up to a multiple of four) is no more than log2 of the number
+ * of input values, and the transform otherwise. The Goertzel bank runs
+ * Reinsch's modified recursion so it keeps its accuracy next to DC and
+ * Nyquist, but it is still less accurate than the transform: for 4096 input
+ * values its bins have relative errors of up to about 1e-4.
+ *
+ * fftset_bins_forward() writes the nb_bins complex bins to output_buf
+ * (2 * nb_bins floats, which need not be aligned) in the order they were
+ * given. input_buf is the same as for fftset_fft_forward(). work_buf must
+ * hold fftset_bins_work_size() bytes: 4N floats if the transform is used
+ * (the bins are picked out of a transform held in the work buffer) and
+ * none (work_buf may be NULL) for the Goertzel bank. */
+enum fftset_bins_method {
+	FFTSET_BINS_AUTO      = 0,
+	FFTSET_BINS_GOERTZEL  = 1,
+	FFTSET_BINS_TRANSFORM = 2
+};
+
+struct fftset_bins {
+	/* Private. */
+	const struct fftset_fft    *first_pass;
+	void                       *mem;
+	size_t                     *bins;
+	const float                *coefs;
+	size_t                      nb_bins;
+	size_t                      span_first;
+	size_t                      span_count;
+};
+
+int
+fftset_bins_init
+	(struct fftset_bins         *bins
+	,const struct fftset_fft    *first_pass
+	,const size_t               *indices
+	,size_t                      nb_bins
+	,enum fftset_bins_method     method
+	);
+
+void fftset_bins_destroy(struct fftset_bins *bins);
+
+void
+fftset_bins_forward
+	(const struct fftset_bins   *bins
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	);
+
+/* Returns the method chosen for the bins (never FFTSET_BINS_AUTO). */
+enum fftset_bins_method fftset_bins_get_method(const struct fftset_bins *bins);
+
+/* Returns the number of bytes required by the work_buf argument of
+ * fftset_bins_forward(). */
+size_t fftset_bins_work_size(const struct fftset_bins *bins);
+
+/* Short-Time Fourier Transforms
+ * ------------------------------------------------------------------------
+ * An fftset_stft turns a stream of samples into the forward transforms of
+ * overlapping windowed frames. A frame holds the input of one transform (2N
+ * reals for FFTSET_MODULATION_FREQ_OFFSET_REAL and N interleaved complex
+ * values for FFTSET_MODULATION_COMPLEX) and a new frame starts every hop
+ * samples. The samples are buffered so that every frame is contiguous in
+ * memory and the analysis window is applied by the first pass of the
+ * transform as it loads the frame: the frame is never copied or windowed in
+ * a separate sweep.
+ *
+ * fftset_stft_init() prepares an STFT for first_pass. window holds one
+ * coefficient per sample of a frame (or is NULL for a rectangular window)
+ * and is copied. hop must not be zero. Returns non-zero if memory could not
+ * be allocated.
+ *
+ * fftset_stft_write() consumes up to nb_samples samples (a complex sample is
+ * two floats) and returns the number consumed. It stops early once a frame
+ * is complete; fftset_stft_read() must then be called before any more
+ * samples are consumed. fftset_stft_read() writes the transform of the
+ * complete frame to output_buf (exactly as fftset_fft_forward() would given
+ * the windowed frame) and returns non-zero, or returns zero if more samples
+ * must be written first. The first frame holds the first samples of the
+ * stream. If hop is longer than a frame, the samples between frames are
+ * skipped. */
+struct fftset_stft {
+	/* Private. */
+	const struct fftset_fft    *first_pass;
+	void                       *mem;
+	float                      *window;
+	float                      *ring;
+	float                      *frame;
+	float                      *work;
+	size_t                      frame_len;
+	size_t                      hop;
+	size_t                      pos;
+	size_t                      pending;
+};
+
+int
+fftset_stft_init
+	(struct fftset_stft         *stft
+	,const struct fftset_fft    *first_pass
+	,const float                *window
+	,size_t                      hop
+	);
+
+void fftset_stft_destroy(struct fftset_stft *stft);
+
+size_t
+fftset_stft_write
+	(struct fftset_stft         *stft
+	,const float                *input
+	,size_t                      nb_samples
+	);
+
+int
+fftset_stft_read
+	(struct fftset_stft         *stft
+	,float                      *output_buf
+	);
+
+/* Inverse Short-Time Fourier Transforms
+ * ------------------------------------------------------------------------
+ * An fftset_istft resynthesises a stream from spectra laid out as the output
+ * of an fftset_stft with the same transform and hop. The final pass of every
+ * inverse transform multiplies the frame by the synthesis window and adds it
+ * directly into an overlap-add buffer. The gain of the analysis and synthesis
+ * windows summed over overlapping frames and the 1/N scale of the inverse
+ * transform are divided out of the synthesis window once when the ISTFT is
+ * created. Any hop for which every sample is covered by a frame where the
+ * product of the windows is non-zero gives perfect reconstruction (samples
+ * which are not covered are output as zero).
+ *
+ * fftset_istft_init() prepares an ISTFT for first_pass. analysis_window and
+ * synthesis_window hold one coefficient per sample of a frame (either may be
+ * NULL for a rectangular window) and are only used during the call. Returns
+ * non-zero if memory could not be allocated.
+ *
+ * fftset_istft_process() adds the inverse transform of the frame spectrum
+ * in input_buf and writes the next hop samples of the stream (the ones which
+ * no later frame overlaps) to output. The first call gives the first samples
+ * of the stream. The frame length minus the hop samples at the start of the
+ * stream are not fully overlapped and only reconstruct the signal if the
+ * windows allow it. */
+struct fftset_istft {
+	/* Private. */
+	const struct fftset_fft    *first_pass;
+	void                       *mem;
+	float                      *window;
+	float                      *acc;
+	float                      *frame;
+	float                      *work;
+	size_t                      frame_len;
+	size_t                      span;
+	size_t                      hop;
+	size_t                      pos;
+};
+
+int
+fftset_istft_init
+	(struct fftset_istft        *istft
+	,const struct fftset_fft    *first_pass
+	,const float                *analysis_window
+	,const float                *synthesis_window
+	,size_t                      hop
+	);
+
+void fftset_istft_destroy(struct fftset_istft *istft);
+
+void
+fftset_istft_process
+	(struct fftset_istft        *istft
+	,float                      *output
+	,const float                *input_buf
+	);
+
+/* Polyphase Channelizers
+ * ------------------------------------------------------------------------
+ * An fftset_channelizer splits a complex stream into M channels (M being the
+ * length of an FFTSET_MODULATION_COMPLEX transform) using a polyphase filter
+ * bank. A frame of M channel outputs is produced every decimation input
+ * samples: decimation == M gives a critically sampled channelizer and
+ * smaller values an oversampled one. Output k of frame n is
+ *
+ *   X_k[n] = \sum\limits_{i=0}^{L-1} h[i] x[t + i] e^{ \frac{-j 2 \pi k (t + i)}{M} }
+ *
+ * where h is the prototype filter of L taps (applied with the last tap on
+ * the newest sample), t = (n + 1) * decimation - L and samples before the
+ * start of the stream are zero; i.e. channel k is the stream shifted down by
+ * k/M of the sample rate, filtered and decimated. The polyphase filter sums
+ * the L / M branches with vector arithmetic and writes its output directly
+ * into the input of the transform in the (rotated) order the transform
+ * needs.
+ *
+ * fftset_channelizer_init() prepares a channelizer for first_pass (which
+ * must use FFTSET_MODULATION_COMPLEX). The prototype is copied. nb_taps and
+ * decimation must not be zero. Returns non-zero if memory could not be
+ * allocated.
+ *
+ * fftset_channelizer_process() consumes nb_frames * decimation interleaved
+ * complex samples from input and writes nb_frames frames of M interleaved
+ * complex channel outputs to output (which must be aligned like the other
+ * output buffers). Frames may be produced in batches of any size. */
+struct fftset_channelizer {
+	/* Private. */
+	const struct fftset_fft    *first_pass;
+	void                       *mem;
+	float                      *coefs;
+	float                      *ring;
+	float                      *fold;
+	float                      *work;
+	size_t                      nb_taps;
+	size_t                      decimation;
+	size_t                      pos;
+	size_t                      phase;
+};
+
+int
+fftset_channelizer_init
+	(struct fftset_channelizer  *channelizer
+	,const struct fftset_fft    *first_pass
+	,const float                *prototype
+	,size_t                      nb_taps
+	,size_t                      decimation
+	);
+
+void fftset_channelizer_destroy(struct fftset_channelizer *channelizer);
+
+void
+fftset_channelizer_process
+	(struct fftset_channelizer  *channelizer
+	,float                      *output
+	,const float                *input
+	,size_t                      nb_frames
+	);
+
+/* Rational Resamplers
+ * ------------------------------------------------------------------------
+ * An fftset_resampler changes the sample rate of a real stream by up/down
+ * (e.g. 160/147 for 44.1 kHz to 48 kHz). The stream is upsampled by
+ * inserting up - 1 zeros after every sample, filtered with the given filter
+ * (which runs at the upsampled rate and should remove everything above the
+ * lower of the two Nyquist frequencies) multiplied by up, and every down'th
+ * sample is kept:
+ *
+ *   y[m] = up \sum\limits_{k=0}^{K-1} h[k] u[m down - k]
+ *
+ * where u is the upsampled stream and samples before the start of the
+ * stream are zero. The filtering is done with overlap-save convolutions of
+ * first_pass (which must use FFTSET_MODULATION_FREQ_OFFSET_REAL) with the
+ * output window of each convolution limited to the span of the outputs
+ * which are kept. This is faster than a direct polyphase filter when the
+ * filter is long and up is small (see app_fftset_bench --resample); for
+ * ratios with a large up (such as 160/147) every convolution yields few
+ * outputs and a direct polyphase filter is usually faster.
+ *
+ * fftset_resampler_init() prepares a resampler. nb_taps must be at least one
+ * and at most 2N where N is the length of first_pass; every convolution
+ * yields 2N - nb_taps + 1 upsampled outputs. up and down must not be zero.
+ * Returns non-zero if memory could not be allocated.
+ *
+ * fftset_resampler_write() consumes up to nb_samples samples and returns how
+ * many were consumed. It stops consuming samples when a block is complete
+ * (fftset_resampler_read() must then be called).
+ *
+ * fftset_resampler_read() filters the current block if it is complete and
+ * writes the outputs to output (which need not be aligned), returning how
+ * many were written; this is at most (2N - nb_taps) / down + 1. Returns zero
+ * if the block is not complete. */
+struct fftset_resampler {
+	/* Private. */
+	const struct fftset_fft    *first_pass;
+	void                       *mem;
+	float                      *kernel;
+	float                      *history;
+	float                      *frame;
+	float                      *work;
+	size_t                      nb_taps;
+	size_t                      up;
+	size_t                      down;
+	size_t                      nb_history;
+	size_t                      next_in;
+	size_t                      next_out;
+};
+
+int
+fftset_resampler_init
+	(struct fftset_resampler    *resampler
+	,const struct fftset_fft    *first_pass
+	,const float                *filter
+	,size_t                      nb_taps
+	,size_t                      up
+	,size_t                      down
+	);
+
+void fftset_resampler_destroy(struct fftset_resampler *resampler);
+
+size_t
+fftset_resampler_write
+	(struct fftset_resampler    *resampler
+	,const float                *input
+	,size_t                      nb_samples
+	);
+
+size_t
+fftset_resampler_read
+	(struct fftset_resampler    *resampler
+	,float                      *output
+	);
+
+/* Compact Convolution Kernels
+ * ------------------------------------------------------------------------
+ * When many long kernels are held, the convolution becomes limited by the
+ * memory bandwidth required to stream the kernel spectra. These functions
+ * allow kernels to be stored using 16-bit floating point values which are
+ * converted back to single precision as they are loaded by the convolution.
+ * This halves the kernel memory requirement at the cost of precision:
+ *   - FFTSET_KERNEL_FORMAT_F16 stores IEEE half precision values. These have
+ *     11 bits of precision but a limited range (+/- 65504). Kernels should
+ *     be scaled such that the spectrum magnitudes fall well within this
+ *     range.
+ *   - FFTSET_KERNEL_FORMAT_BF16 stores the top 16 bits of a single precision
+ *     value. The range is the same as single precision, but there are only
+ *     8 bits of precision.
+ * On x86 targets built with F16C support, the conversions are performed
+ * using the hardware instructions.
+ *
+ * fftset_fft_conv_kernel_size() returns the number of bytes required to hold
+ * a kernel for the given FFT in the given format.
+ *
+ * fftset_fft_conv_get_kernel_compact() is the same as
+ * fftset_fft_conv_get_kernel() but writes a kernel of the given format into
+ * output_buf. work_buf must be a float buffer of the same size as input_buf
+ * and must not alias any other argument.
+ *
+ * fftset_fft_conv_compact() is the same as fftset_fft_conv() but takes a
+ * kernel produced by fftset_fft_conv_get_kernel_compact() using the same
+ * format. */
+enum fftset_kernel_format {
+	FFTSET_KERNEL_FORMAT_F32  = 0,
+	FFTSET_KERNEL_FORMAT_F16  = 1,
+	FFTSET_KERNEL_FORMAT_BF16 = 2
+};
+
+size_t
+fftset_fft_conv_kernel_size
+	(const struct fftset_fft    *first_pass
+	,enum fftset_kernel_format   format
+	);
+
+void
+fftset_fft_conv_get_kernel_compact
+	(const struct fftset_fft    *first_pass
+	,void                       *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	,enum fftset_kernel_format   format
+	);
+
+void
+fftset_fft_conv_compact
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const void                 *kernel_buf
+	,enum fftset_kernel_format   format
+	,float                      *work_buf
+	);
+
+/* Multi-threaded Execution
+ * ------------------------------------------------------------------------
+ * A single large transform can be split between the threads of a pool. The
+ * inner passes of the transform (and the spectral multiply of a convolution)
+ * are divided into independent blocks of rows or columns which the threads
+ * evaluate concurrently with a barrier after every pass; the O(N) pre and
+ * post processing of the modulation runs on the calling thread. Transforms
+ * which are too small to benefit are evaluated entirely on the calling
+ * thread.
+ *
+ * fftset_threads_init() starts nb_threads - 1 worker threads (the calling
+ * thread is always used as well). If nb_threads is zero, the number of online
+ * processors is used. Returns non-zero on failure. A pool may be shared by
+ * many callers but jobs submitted concurrently are run one after another.
+ *
+ * The _mt execution functions have the same requirements and produce the same
+ * output as their single-threaded counterparts. */
+struct fftset_thread_pool;
+
+struct fftset_threads {
+	/* Private. NULL if nb_threads is one. */
+	struct fftset_thread_pool  *pool;
+	unsigned                    nb_threads;
+};
+
+int fftset_threads_init(struct fftset_threads *threads, unsigned nb_threads);
+void fftset_threads_destroy(struct fftset_threads *threads);
+
+void
+fftset_fft_forward_mt
+	(const struct fftset_fft    *first_pass
+	,struct fftset_threads      *threads
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_inverse_mt
+	(const struct fftset_fft    *first_pass
+	,struct fftset_threads      *threads
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	);
+
+void
+fftset_fft_conv_mt
+	(const struct fftset_fft    *first_pass
+	,struct fftset_threads      *threads
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	);
+
 /* Helpful Routines
  * ------------------------------------------------------------------------ */
 
@@ -150,20 +880,171 @@ fftset_fft_conv
  * of this function plus one minus the kernel length. */
 unsigned fftset_recommend_conv_length(unsigned kernel_length, unsigned max_block_size);
 
+/* Cache statistics
+ * ------------------------------------------------------------------------
+ * FFTs and the vector passes they are built from are cached in hash indexes.
+ * fftset_get_lookup_stats() computes the state of these indexes at the time
+ * of the call. The probe length of an entry is the number of slots which are
+ * inspected by a successful lookup of that entry. Either pointer argument may
+ * be NULL. */
+struct fftset_index_stats {
+	unsigned nb_entries;
+	unsigned capacity;
+	unsigned max_probe_length;
+	float    mean_probe_length;
+};
+
+void
+fftset_get_lookup_stats
+	(struct fftset              *fc
+	,struct fftset_index_stats  *fft_stats
+	,struct fftset_index_stats  *pass_stats
+	);
+
+/* Plan Files
+ * ------------------------------------------------------------------------
+ * fftset_export() writes every FFT held by the fftset (the chosen pass chains
+ * along with all of their twiddle coefficients) to a file.
+ *
+ * fftset_import() maps such a file read-only and adds the FFTs it contains to
+ * the fftset. Subsequent calls to fftset_create_fft() for these FFTs will
+ * find them without doing any planning or twiddle computation. Twiddles are
+ * used directly from the mapping which stays open until the fftset is
+ * destroyed. FFTs which already exist in the fftset are kept.
+ *
+ * Files are versioned and record the vector configuration of the build which
+ * wrote them. fftset_import() fails if the file is damaged or was written by
+ * an incompatible build; the caller can then create the FFTs as usual. Both
+ * functions return zero on success. */
+int fftset_export(struct fftset *fc, const char *filename);
+int fftset_import(struct fftset *fc, const char *filename);
+
+/* Memory statistics
+ * ------------------------------------------------------------------------
+ * fftset_get_memory_stats() reports the number of bytes which have been
+ * allocated for each purpose:
+ *   - twiddle_bytes: twiddle factor tables.
+ *   - pass_bytes: the objects describing FFTs and their passes.
+ *   - overhead_bytes: hash indexes and chunk bookkeeping.
+ * reserved_bytes is the total size of all chunks obtained from the system;
+ * the difference between it and the sum of the above is alignment padding
+ * and unused space at the end of chunks. mapped_bytes is the total size of
+ * files which have been mapped by fftset_import(). */
+struct fftset_memory_stats {
+	size_t   twiddle_bytes;
+	size_t   pass_bytes;
+	size_t   overhead_bytes;
+	size_t   reserved_bytes;
+	size_t   mapped_bytes;
+	unsigned nb_chunks;
+};
+
+void
+fftset_get_memory_stats
+	(struct fftset              *fc
+	,struct fftset_memory_stats *stats
+	);
+
+/* Profiling
+ * ------------------------------------------------------------------------
+ * When the library is built with FFTSET_PROFILE defined to 1 (the
+ * FFTSET_PROFILE CMake option), every execution function records how long
+ * each part of the transform took into a buffer owned by the calling thread.
+ * Without it, nothing is recorded and there is no cost.
+ *
+ * Records are appended in the order the parts complete:
+ *   - One record for every inner pass (FFTSET_PROFILE_DIF, _DIT and
+ *     _STOCKHAM) giving the radix, vec_width, the length of the pass (lfft)
+ *     and the number of rows it was given (nb_vec_fft).
+ *   - One FFTSET_PROFILE_MULCONJ record for the spectral multiply of a
+ *     convolution where nb_vec_fft is the number of vectors multiplied.
+ *   - Once the call returns, an FFTSET_PROFILE_MODULATOR record giving the
+ *     time which was not spent in the above (the pre and post processing of
+ *     the modulation) followed by a record for the whole call
+ *     (FFTSET_PROFILE_FORWARD, _INVERSE, _GET_KERNEL or _CONV). For these,
+ *     lfft is the number of complex bins of the FFT.
+ *
+ * ticks are processor timestamp counter cycles on x86 and nanoseconds
+ * elsewhere. Passes which are split between the threads of a pool are
+ * recorded once by the calling thread using the elapsed time. Passes run by
+ * the measuring planner are not recorded. The buffer holds
+ * FFTSET_PROFILE_MAX_RECORDS records; once full, new records are discarded
+ * until fftset_profile_reset() is called.
+ *
+ * fftset_profile_enabled() returns non-zero if profiling was built in.
+ * fftset_profile_read() copies up to max_records records of the calling
+ * thread and returns the number of records held (which may be larger than
+ * max_records). */
+#define FFTSET_PROFILE_MAX_RECORDS (1024)
+
+enum fftset_profile_event {
+	FFTSET_PROFILE_FORWARD    = 0,
+	FFTSET_PROFILE_INVERSE    = 1,
+	FFTSET_PROFILE_GET_KERNEL = 2,
+	FFTSET_PROFILE_CONV       = 3,
+	FFTSET_PROFILE_MODULATOR  = 4,
+	FFTSET_PROFILE_DIF        = 5,
+	FFTSET_PROFILE_DIT        = 6,
+	FFTSET_PROFILE_STOCKHAM   = 7,
+	FFTSET_PROFILE_MULCONJ    = 8
+};
+
+struct fftset_profile_record {
+	enum fftset_profile_event event;
+	unsigned                  radix;
+	unsigned                  vec_width;
+	size_t                    lfft;
+	size_t                    nb_vec_fft;
+	unsigned long long        ticks;
+};
+
+int fftset_profile_enabled(void);
+void fftset_profile_reset(void);
+
+size_t
+fftset_profile_read
+	(struct fftset_profile_record *records
+	,size_t                        max_records
+	);
+
 /* Private Parts
  * ---------------------------------------------------------------------------
  * Don't touch them. */
 
 struct fftset_vec;
+struct fftset_index;
+struct fftset_chunk;
+struct fftset_twiddle;
+struct fftset_mapping;
+struct fftset_kernels;
 
 struct fftset {
 	/* Sorted list of all available inner vector passes. */
 	struct fftset_vec          *first_inner;
 	/* Sorted list of all available outer passes. */
 	struct fftset_fft          *first_outer;
-	/* Memory for everything! */
-	struct cop_salloc_iface     mem;
-	struct cop_alloc_grp_temps  mem_impl;
+	/* Hash indexes of the above lists. */
+	struct fftset_index        *inner_index;
+	struct fftset_index        *outer_index;
+	/* Twiddle tables shared by inner passes. */
+	struct fftset_twiddle      *twiddles;
+	/* Held while creating new passes. */
+	volatile long               create_lock;
+	/* enum fftset_planner used for new passes. */
+	unsigned                    planner;
+	/* Kernels for the instruction set level given by isa. */
+	const struct fftset_kernels *kernels;
+	unsigned                    isa;
+	/* Memory for everything! The head of the list is the chunk which is
+	 * currently being allocated from. */
+	struct fftset_chunk        *chunks;
+	size_t                      chunk_size;
+	size_t                      max_size;
+	size_t                      reserved_bytes;
+	size_t                      mem_bytes[3];
+	/* Files mapped by fftset_import(). */
+	struct fftset_mapping      *mappings;
+	size_t                      mapped_bytes;
 };
 
 #endif /* FFTSET_H */
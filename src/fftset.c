@@ -30,6 +30,12 @@
 #include "cop/cop_vec.h"
 #include "cop/cop_alloc.h"
 #include "fftset_modulation.h"
+#include "fftset_sync.h"
+#include "fftset_index.h"
+#include "fftset_alloc.h"
+#include "fftset_wisdom.h"
+#include "fftset_kernels.h"
+#include "fftset_profile.h"
 
 #define FASTCONV_REAL_LEN_MULTIPLE (32)
 
@@ -40,7 +46,7 @@ fftset_fft_conv_get_kernel
 	,const float                *input_buf
 	)
 {
-	first_pass->get_kern(first_pass, output_buf, input_buf);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_GET_KERNEL, first_pass, first_pass->get_kern(first_pass, output_buf, input_buf, FFTSET_VEC_NONZERO_ALL, 1.0f));
 }
 
 void
@@ -52,7 +58,43 @@ fftset_fft_conv
 	,float                      *work_buf
 	)
 {
-	first_pass->conv(first_pass, output_buf, input_buf, kernel_buf, work_buf);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_CONV, first_pass, first_pass->conv(first_pass, output_buf, input_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, kernel_buf, FFTSET_KERNEL_FORMAT_F32, work_buf, NULL));
+}
+
+size_t
+fftset_fft_conv_kernel_size
+	(const struct fftset_fft    *first_pass
+	,enum fftset_kernel_format   format
+	)
+{
+	size_t nb_values = 2 * (size_t)first_pass->lfft;
+	return nb_values * ((format == FFTSET_KERNEL_FORMAT_F32) ? sizeof(float) : sizeof(unsigned short));
+}
+
+void
+fftset_fft_conv_get_kernel_compact
+	(const struct fftset_fft    *first_pass
+	,void                       *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	,enum fftset_kernel_format   format
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_GET_KERNEL, first_pass, first_pass->get_kern(first_pass, work_buf, input_buf, FFTSET_VEC_NONZERO_ALL, 1.0f));
+	fftset_vec_kern_compact(output_buf, work_buf, 2 * first_pass->lfft, format);
+}
+
+void
+fftset_fft_conv_compact
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const void                 *kernel_buf
+	,enum fftset_kernel_format   format
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_CONV, first_pass, first_pass->conv(first_pass, output_buf, input_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, kernel_buf, format, work_buf, NULL));
 }
 
 void
@@ -63,7 +105,7 @@ fftset_fft_forward
 	,float                      *work_buf
 	)
 {
-	first_pass->fwd(first_pass, output_buf, input_buf, work_buf);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, output_buf, input_buf, NULL, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, work_buf, NULL));
 }
 
 void
@@ -74,14 +116,272 @@ fftset_fft_inverse
 	,float                      *work_buf
 	)
 {
-	first_pass->inv(first_pass, output_buf, input_buf, work_buf);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, output_buf, input_buf, 0, FFTSET_VEC_WINDOW_ALL, NULL, 1.0f, work_buf, NULL));
+}
+
+void
+fftset_fft_forward_inplace
+	(const struct fftset_fft    *first_pass
+	,float                      *buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, buf, buf, NULL, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, work_buf, NULL));
+}
+
+void
+fftset_fft_inverse_inplace
+	(const struct fftset_fft    *first_pass
+	,float                      *buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, buf, buf, 0, FFTSET_VEC_WINDOW_ALL, NULL, 1.0f, work_buf, NULL));
+}
+
+size_t
+fftset_fft_work_size
+	(const struct fftset_fft    *first_pass
+	)
+{
+	return 2 * first_pass->lfft * sizeof(float);
+}
+
+void
+fftset_fft_forward_mt
+	(const struct fftset_fft    *first_pass
+	,struct fftset_threads      *threads
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, output_buf, input_buf, NULL, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, work_buf, threads));
+}
+
+void
+fftset_fft_inverse_mt
+	(const struct fftset_fft    *first_pass
+	,struct fftset_threads      *threads
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, output_buf, input_buf, 0, FFTSET_VEC_WINDOW_ALL, NULL, 1.0f, work_buf, threads));
+}
+
+void
+fftset_fft_conv_mt
+	(const struct fftset_fft    *first_pass
+	,struct fftset_threads      *threads
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_CONV, first_pass, first_pass->conv(first_pass, output_buf, input_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, kernel_buf, FFTSET_KERNEL_FORMAT_F32, work_buf, threads));
+}
+
+void
+fftset_fft_forward_pruned
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, output_buf, input_buf, NULL, nb_nonzero, 0, FFTSET_VEC_WINDOW_ALL, work_buf, NULL));
+}
+
+void
+fftset_fft_conv_get_kernel_pruned
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_GET_KERNEL, first_pass, first_pass->get_kern(first_pass, output_buf, input_buf, nb_nonzero, 1.0f));
+}
+
+void
+fftset_fft_conv_pruned
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,const float                *kernel_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_CONV, first_pass, first_pass->conv(first_pass, output_buf, input_buf, nb_nonzero, 0, FFTSET_VEC_WINDOW_ALL, kernel_buf, FFTSET_KERNEL_FORMAT_F32, work_buf, NULL));
+}
+
+void
+fftset_fft_forward_window
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *input_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, output_buf, input_buf, NULL, FFTSET_VEC_NONZERO_ALL, out_first, out_count, work_buf, NULL));
+}
+
+void
+fftset_fft_inverse_window
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *input_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, output_buf, input_buf, out_first, out_count, NULL, 1.0f, work_buf, NULL));
+}
+
+void
+fftset_fft_conv_window
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_CONV, first_pass, first_pass->conv(first_pass, output_buf, input_buf, FFTSET_VEC_NONZERO_ALL, out_first, out_count, kernel_buf, FFTSET_KERNEL_FORMAT_F32, work_buf, NULL));
+}
+
+void
+fftset_fft_forward_pair
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_a
+	,const float                *input_b
+	,float                      *work_buf
+	)
+{
+	assert(first_pass->fwd_pair != NULL);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd_pair(first_pass, output_buf, input_a, input_b, work_buf, NULL));
+}
+
+void
+fftset_fft_inverse_scaled
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                       scale
+	,float                      *work_buf
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, output_buf, input_buf, 0, FFTSET_VEC_WINDOW_ALL, NULL, scale, work_buf, NULL));
+}
+
+void
+fftset_fft_conv_get_kernel_scaled
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                       scale
+	)
+{
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_GET_KERNEL, first_pass, first_pass->get_kern(first_pass, output_buf, input_buf, FFTSET_VEC_NONZERO_ALL, scale));
 }
 
+void
+fftset_fft_forward_spectrum
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	)
+{
+	assert(band_size > 0);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd_spectrum(first_pass, output_buf, input_buf, format, band_size, work_buf, NULL));
+}
+
+void
+fftset_fft_analytic_get_kernel
+	(const struct fftset_fft    *first_pass
+	,float                      *kernel_buf
+	,float                      *work_buf
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	size_t k;
+
+	assert(first_pass->conv_real != NULL);
+
+	/* The one-sided mask keeps DC (and the Nyquist bin of even lengths),
+	 * doubles the positive frequencies and removes the negative ones. It is
+	 * turned into the impulse response of the filter (normalised by the
+	 * inverse) and then into a kernel (normalised by the convolution). */
+	for (k = 0; k < lfft; k++) {
+		work_buf[2*k+0] = (k == 0 || 2 * k == lfft) ? 1.0f : (2 * k < lfft) ? 2.0f : 0.0f;
+		work_buf[2*k+1] = 0.0f;
+	}
+	fftset_fft_inverse_scaled(first_pass, work_buf, work_buf, 1.0f / lfft, kernel_buf);
+	fftset_fft_conv_get_kernel_scaled(first_pass, kernel_buf, work_buf, 1.0f / lfft);
+}
+
+void
+fftset_fft_analytic
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	)
+{
+	assert(first_pass->conv_real != NULL);
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_CONV, first_pass, first_pass->conv_real(first_pass, output_buf, input_buf, kernel_buf, work_buf, NULL));
+}
+
+#define FFTSET_DEFAULT_CHUNK_SIZE (8*1024*1024)
+
 int fftset_init(struct fftset *fc)
 {
+	return fftset_init_ex(fc, NULL);
+}
+
+int fftset_init_ex(struct fftset *fc, const struct fftset_init_options *options)
+{
+	enum fftset_isa isa;
+
 	fc->first_outer = NULL;
 	fc->first_inner = NULL;
-	return cop_alloc_grp_temps_init(&(fc->mem_impl), &(fc->mem), 8*1024*1024, 0, 16);
+	fc->inner_index = NULL;
+	fc->outer_index = NULL;
+	fc->twiddles    = NULL;
+	fc->create_lock = 0;
+	fc->chunks         = NULL;
+	fc->chunk_size     = (options != NULL && options->chunk_size) ? options->chunk_size : FFTSET_DEFAULT_CHUNK_SIZE;
+	fc->max_size       = (options != NULL) ? options->max_size : 0;
+	fc->planner        = (options != NULL) ? options->planner : FFTSET_PLANNER_ESTIMATE;
+	fc->kernels        = fftset_kernels_select((options != NULL) ? options->isa : FFTSET_ISA_AUTO, &isa);
+	fc->isa            = isa;
+	fc->reserved_bytes = 0;
+	fc->mem_bytes[FFTSET_MEM_TWIDDLE]  = 0;
+	fc->mem_bytes[FFTSET_MEM_PASS]     = 0;
+	fc->mem_bytes[FFTSET_MEM_OVERHEAD] = 0;
+	fc->mappings       = NULL;
+	fc->mapped_bytes   = 0;
+	return 0;
+}
+
+enum fftset_isa fftset_get_isa(const struct fftset *fc)
+{
+	return (enum fftset_isa)fc->isa;
 }
 
 void fftset_destroy(struct fftset *fc)
@@ -91,33 +391,55 @@ void fftset_destroy(struct fftset *fc)
 	for (pass = fc->first_inner; pass != NULL; pass = pass->next)
 		printf("len=%u; cost=%u; radix=%u\n", pass->lfft_div_radix*pass->radix, pass->cost, pass->radix);
 #endif
-	cop_alloc_grp_temps_free(&(fc->mem_impl));
+	fftset_wisdom_unmap_all(fc);
+	fftset_alloc_free(fc);
+}
+
+/* Outer passes are indexed by their modulation and length. */
+static struct fftset_fft *fftset_find_fft(struct fftset *fc, const struct fftset_modulation *modulation, size_t complex_bins)
+{
+	return fftset_index_find(&(fc->outer_index), (uintptr_t)modulation, complex_bins);
 }
 
-const struct fftset_fft *fftset_create_fft(struct fftset *fc, const struct fftset_modulation *modulation, unsigned complex_bins)
+const struct fftset_fft *fftset_create_fft(struct fftset *fc, const struct fftset_modulation *modulation, size_t complex_bins)
 {
 	struct fftset_fft *pass;
 	struct fftset_fft **ipos;
 
-	/* Find the pass. */
-	for (pass = fc->first_outer; pass != NULL; pass = pass->next) {
-		if (pass->lfft == complex_bins && pass->modulator == modulation)
-			return pass;
-		if (pass->lfft < complex_bins)
-			break;
-	}
-
-	/* Create new outer pass and insert it into the list. */
-	pass = cop_salloc(&(fc->mem), sizeof(*pass), 0);
-	if (pass == NULL)
+	if (complex_bins < 2)
 		return NULL;
 
-	if (modulation->init(pass, &(fc->first_inner), &(fc->mem), complex_bins))
+	/* Find the pass. This does not take the lock: index entries and nodes
+	 * are never modified after they have been published. */
+	pass = fftset_find_fft(fc, modulation, complex_bins);
+	if (pass != NULL)
+		return pass;
+
+	fftset_lock(&(fc->create_lock));
+
+	/* Another thread may have created it while we were waiting. */
+	pass = fftset_find_fft(fc, modulation, complex_bins);
+	if (pass != NULL) {
+		fftset_unlock(&(fc->create_lock));
+		return pass;
+	}
+
+	/* Create new outer pass and insert it into the list. The inner pass list
+	 * and the allocator are only ever touched while holding the lock. */
+	pass = fftset_alloc(fc, sizeof(*pass), 0, FFTSET_MEM_PASS);
+	if (pass == NULL || modulation->init(pass, fc, complex_bins)) {
+		fftset_unlock(&(fc->create_lock));
 		return NULL;
+	}
 
 	pass->lfft          = complex_bins;
 	pass->modulator     = modulation;
 
+	if (fftset_index_insert(&(fc->outer_index), fc, (uintptr_t)modulation, complex_bins, pass)) {
+		fftset_unlock(&(fc->create_lock));
+		return NULL;
+	}
+
 	/* Insert into list. */
 	ipos = &(fc->first_outer);
 	while (*ipos != NULL && complex_bins < (*ipos)->lfft) {
@@ -125,9 +447,42 @@ const struct fftset_fft *fftset_create_fft(struct fftset *fc, const struct fftse
 	}
 	pass->next = *ipos;
 	*ipos = pass;
+
+	fftset_unlock(&(fc->create_lock));
 	return pass;
 }
 
+void
+fftset_get_lookup_stats
+	(struct fftset              *fc
+	,struct fftset_index_stats  *fft_stats
+	,struct fftset_index_stats  *pass_stats
+	)
+{
+	fftset_lock(&(fc->create_lock));
+	if (fft_stats != NULL)
+		fftset_index_get_stats(fc->outer_index, fft_stats);
+	if (pass_stats != NULL)
+		fftset_index_get_stats(fc->inner_index, pass_stats);
+	fftset_unlock(&(fc->create_lock));
+}
+
+void
+fftset_get_memory_stats
+	(struct fftset              *fc
+	,struct fftset_memory_stats *stats
+	)
+{
+	fftset_lock(&(fc->create_lock));
+	stats->twiddle_bytes  = fc->mem_bytes[FFTSET_MEM_TWIDDLE];
+	stats->pass_bytes     = fc->mem_bytes[FFTSET_MEM_PASS];
+	stats->overhead_bytes = fc->mem_bytes[FFTSET_MEM_OVERHEAD];
+	stats->reserved_bytes = fc->reserved_bytes;
+	stats->mapped_bytes   = fc->mapped_bytes;
+	stats->nb_chunks      = fftset_alloc_count_chunks(fc);
+	fftset_unlock(&(fc->create_lock));
+}
+
 static unsigned rounduptonearestfactorisation(unsigned min)
 {
 	unsigned length = 1;
@@ -0,0 +1,127 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset_alloc.h"
+#include "cop/cop_alloc.h"
+#include <stdlib.h>
+
+struct fftset_chunk {
+	struct fftset_chunk        *next;
+	size_t                      size;
+	struct cop_salloc_iface     mem;
+	struct cop_alloc_grp_temps  mem_impl;
+};
+
+/* Additional space reserved in chunks which are created to hold a single
+ * allocation. This accounts for alignment padding. */
+#define FFTSET_CHUNK_SLACK (128)
+
+static struct fftset_chunk *fftset_chunk_create(struct fftset *fc, size_t size)
+{
+	struct fftset_chunk *chunk;
+
+	if (fc->max_size && (size > fc->max_size || fc->reserved_bytes > fc->max_size - size))
+		return NULL;
+
+	chunk = malloc(sizeof(*chunk));
+	if (chunk == NULL)
+		return NULL;
+
+	if (cop_alloc_grp_temps_init(&(chunk->mem_impl), &(chunk->mem), size, 0, 16)) {
+		free(chunk);
+		return NULL;
+	}
+
+	chunk->size         = size;
+	fc->reserved_bytes += size;
+	fc->mem_bytes[FFTSET_MEM_OVERHEAD] += sizeof(*chunk);
+	return chunk;
+}
+
+void *
+fftset_alloc
+	(struct fftset             *fc
+	,size_t                     size
+	,size_t                     align
+	,enum fftset_mem_category   category
+	)
+{
+	struct fftset_chunk *chunk;
+	void                *ptr;
+
+	if (fc->chunks != NULL && (ptr = cop_salloc(&(fc->chunks->mem), size, align)) != NULL) {
+		fc->mem_bytes[category] += size;
+		return ptr;
+	}
+
+	if (size > fc->chunk_size / 2) {
+		/* Large requests get a chunk of their own. The current chunk stays at
+		 * the head of the list so its remaining space is not wasted. */
+		chunk = fftset_chunk_create(fc, size + align + FFTSET_CHUNK_SLACK);
+		if (chunk == NULL)
+			return NULL;
+		if (fc->chunks != NULL) {
+			chunk->next      = fc->chunks->next;
+			fc->chunks->next = chunk;
+		} else {
+			chunk->next      = NULL;
+			fc->chunks       = chunk;
+		}
+	} else {
+		chunk = fftset_chunk_create(fc, fc->chunk_size);
+		if (chunk == NULL)
+			return NULL;
+		chunk->next = fc->chunks;
+		fc->chunks  = chunk;
+	}
+
+	ptr = cop_salloc(&(chunk->mem), size, align);
+	if (ptr != NULL)
+		fc->mem_bytes[category] += size;
+	return ptr;
+}
+
+unsigned
+fftset_alloc_count_chunks
+	(const struct fftset       *fc
+	)
+{
+	const struct fftset_chunk *chunk;
+	unsigned nb = 0;
+	for (chunk = fc->chunks; chunk != NULL; chunk = chunk->next)
+		nb++;
+	return nb;
+}
+
+void
+fftset_alloc_free
+	(struct fftset             *fc
+	)
+{
+	struct fftset_chunk *chunk = fc->chunks;
+	while (chunk != NULL) {
+		struct fftset_chunk *next = chunk->next;
+		cop_alloc_grp_temps_free(&(chunk->mem_impl));
+		free(chunk);
+		chunk = next;
+	}
+	fc->chunks         = NULL;
+	fc->reserved_bytes = 0;
+}
@@ -0,0 +1,60 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_ALLOC_H
+#define FFTSET_ALLOC_H
+
+#include "fftset/fftset.h"
+#include <stddef.h>
+
+/* Categories used for the memory accounting reported by
+ * fftset_get_memory_stats(). */
+enum fftset_mem_category {
+	FFTSET_MEM_TWIDDLE  = 0,
+	FFTSET_MEM_PASS     = 1,
+	FFTSET_MEM_OVERHEAD = 2
+};
+
+/* Allocates memory which lives until the fftset is destroyed. New chunks are
+ * obtained from the system when the current chunk is exhausted. Returns NULL
+ * if the system is out of memory or if the allocation would cause the fftset
+ * to exceed its configured maximum size. Must only be called while holding
+ * the fftset creation lock. */
+void *
+fftset_alloc
+	(struct fftset             *fc
+	,size_t                     size
+	,size_t                     align
+	,enum fftset_mem_category   category
+	);
+
+/* Returns the number of chunks which have been obtained from the system. */
+unsigned
+fftset_alloc_count_chunks
+	(const struct fftset       *fc
+	);
+
+/* Frees all chunks held by the fftset. */
+void
+fftset_alloc_free
+	(struct fftset             *fc
+	);
+
+#endif /* FFTSET_ALLOC_H */
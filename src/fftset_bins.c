@@ -0,0 +1,291 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifdef _MSC_VER
+#define _USE_MATH_DEFINES
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fftset/fftset.h"
+#include "cop/cop_vec.h"
+#include "fftset_modulation.h"
+#include "fftset_vec.h"
+#include "fftset_profile.h"
+
+/* The Goertzel recursion for the frequency w of a bin is
+ *
+ *   s[n] = x[n] + 2 cos(w) s[n-1] - s[n-2]
+ *
+ * and after the M inputs have been consumed the bin is
+ *
+ *   X = e^{-j w (M-1)} s[M-1] - e^{-j w M} s[M-2]
+ *
+ * (the usual final step with the phase of the last sample removed, which is
+ * needed as the bins of FFTSET_MODULATION_FREQ_OFFSET_REAL are not whole
+ * multiples of the fundamental). w M is a multiple of pi for both
+ * modulations so e^{-j w M} is always real (-1 for the real modulation and 1
+ * for the complex modulation).
+ *
+ * Near w = 0 and w = pi, 2 cos(w) rounded to single precision is too coarse
+ * to hold the frequency of the resonator (at w = 0.001 its error is several
+ * percent of w), so the recursion is run in Reinsch's form which tracks the
+ * difference d[n] = s[n] - g s[n-1] instead, where g is 1 when cos(w) >= 0
+ * and -1 otherwise:
+ *
+ *   d[n] = x[n] + k s[n-1] + g d[n-1]
+ *   s[n] = d[n] + g s[n-1]
+ *
+ * with k = 2 cos(w) - 2 g, i.e. -4 sin^2(w/2) or 4 cos^2(w/2), which holds
+ * the frequency to full relative precision. s[M-2] is recovered as
+ * g (s[M-1] - d[M-1]). Complex inputs run the recursion separately on the
+ * real and imaginary parts. The bins are processed in groups of four which
+ * each hold FFTSET_BINS_GROUP_LEN coefficients: four values each of k, g,
+ * the real and imaginary parts of e^{-j w (M-1)} and e^{-j w M}. Unused
+ * lanes of the last group have zero coefficients. */
+#define FFTSET_BINS_GROUP_LEN (20)
+
+/* Number of input values (real or complex) of the transform. */
+static size_t fftset_bins_nb_inputs(const struct fftset_fft *first_pass)
+{
+	return (first_pass->modulator->id == FFTSET_MODULATION_ID_COMPLEX) ? first_pass->lfft : 2 * first_pass->lfft;
+}
+
+/* The Goertzel bank costs a few vector operations per input value for every
+ * four bins while the transform costs a few vector operations per input
+ * value for every pass (and reads and writes the whole work buffer in each
+ * one), so the bank is used while the number of bins rounded up to a
+ * multiple of four is at most log2(nb_inputs). */
+static int fftset_bins_use_goertzel(const struct fftset_fft *first_pass, size_t nb_bins)
+{
+	size_t nb_inputs = fftset_bins_nb_inputs(first_pass);
+	size_t log2n     = 0;
+	while ((nb_inputs >>= 1) != 0)
+		log2n++;
+	return ((nb_bins + 3) & ~(size_t)3) <= log2n;
+}
+
+int
+fftset_bins_init
+	(struct fftset_bins         *bins
+	,const struct fftset_fft    *first_pass
+	,const size_t               *indices
+	,size_t                      nb_bins
+	,enum fftset_bins_method     method
+	)
+{
+	const size_t nb_inputs = fftset_bins_nb_inputs(first_pass);
+	size_t       nb_coefs;
+	float       *coefs;
+	size_t       i;
+
+	assert(nb_bins > 0);
+
+	if (method == FFTSET_BINS_AUTO)
+		method = fftset_bins_use_goertzel(first_pass, nb_bins) ? FFTSET_BINS_GOERTZEL : FFTSET_BINS_TRANSFORM;
+	nb_coefs = (method == FFTSET_BINS_GOERTZEL) ? FFTSET_BINS_GROUP_LEN * ((nb_bins + 3) / 4) : 0;
+
+	/* The coefficients (aligned to 64 bytes) followed by the indices. A
+	 * group of coefficients is 80 bytes so the indices are aligned. */
+	bins->mem = malloc(sizeof(float) * nb_coefs + sizeof(size_t) * nb_bins + 63);
+	if (bins->mem == NULL)
+		return -1;
+
+	coefs             = (float *)(((size_t)bins->mem + 63) & ~(size_t)63);
+	bins->bins        = (size_t *)(coefs + nb_coefs);
+	bins->coefs       = (nb_coefs) ? coefs : NULL;
+	bins->first_pass  = first_pass;
+	bins->nb_bins     = nb_bins;
+
+	bins->span_first  = indices[0];
+	bins->span_count  = 1;
+	for (i = 0; i < nb_bins; i++) {
+		assert(indices[i] < first_pass->lfft);
+		bins->bins[i] = indices[i];
+		if (indices[i] < bins->span_first) {
+			bins->span_count += bins->span_first - indices[i];
+			bins->span_first  = indices[i];
+		} else if (indices[i] >= bins->span_first + bins->span_count) {
+			bins->span_count  = indices[i] - bins->span_first + 1;
+		}
+	}
+
+	if (nb_coefs) {
+		memset(coefs, 0, sizeof(float) * nb_coefs);
+		for (i = 0; i < nb_bins; i++) {
+			float  *gp = coefs + (i / 4) * FFTSET_BINS_GROUP_LEN + (i % 4);
+			double  w  = (first_pass->modulator->id == FFTSET_MODULATION_ID_COMPLEX)
+			           ? 2.0 * M_PI * (double)indices[i] / first_pass->lfft
+			           : M_PI * (indices[i] + 0.5) / first_pass->lfft;
+			if (cos(w) >= 0.0) {
+				gp[0] = (float)(-4.0 * sin(w / 2) * sin(w / 2));
+				gp[4] = 1.0f;
+			} else {
+				gp[0] = (float)(4.0 * cos(w / 2) * cos(w / 2));
+				gp[4] = -1.0f;
+			}
+			gp[8]  = (float)cos(w * (nb_inputs - 1));
+			gp[12] = (float)-sin(w * (nb_inputs - 1));
+			gp[16] = (float)cos(w * nb_inputs);
+		}
+	}
+
+	return 0;
+}
+
+void fftset_bins_destroy(struct fftset_bins *bins)
+{
+	free(bins->mem);
+}
+
+#if V4F_EXISTS
+
+/* Stores the nb lanes of a group (re[4], im[4]) as interleaved bins. */
+static void fftset_bins_st(float *output, const float *re, const float *im, size_t nb)
+{
+	size_t i;
+	for (i = 0; i < nb; i++) {
+		output[2*i+0] = re[i];
+		output[2*i+1] = im[i];
+	}
+}
+
+static void fftset_bins_goertzel_real_v4f(float *output, const float *input, const float *coefs, size_t nb_bins, size_t nb_inputs)
+{
+	float VEC_ALIGN_BEST re[4];
+	float VEC_ALIGN_BEST im[4];
+	size_t g, n;
+	for (g = 0; g < nb_bins; g += 4, coefs += FFTSET_BINS_GROUP_LEN) {
+		const v4f k  = v4f_ld(coefs + 0);
+		const v4f gs = v4f_ld(coefs + 4);
+		v4f       s1 = v4f_broadcast(0.0f);
+		v4f       d1 = v4f_broadcast(0.0f);
+		v4f       s2;
+		for (n = 0; n < nb_inputs; n++) {
+			d1 = v4f_add(v4f_add(v4f_broadcast(input[n]), v4f_mul(k, s1)), v4f_mul(gs, d1));
+			s1 = v4f_add(d1, v4f_mul(gs, s1));
+		}
+		s2 = v4f_mul(gs, v4f_sub(s1, d1));
+		v4f_st(re, v4f_sub(v4f_mul(v4f_ld(coefs + 8), s1), v4f_mul(v4f_ld(coefs + 16), s2)));
+		v4f_st(im, v4f_mul(v4f_ld(coefs + 12), s1));
+		fftset_bins_st(output + 2 * g, re, im, (nb_bins - g < 4) ? nb_bins - g : 4);
+	}
+}
+
+static void fftset_bins_goertzel_cplx_v4f(float *output, const float *input, const float *coefs, size_t nb_bins, size_t nb_inputs)
+{
+	float VEC_ALIGN_BEST re[4];
+	float VEC_ALIGN_BEST im[4];
+	size_t g, n;
+	for (g = 0; g < nb_bins; g += 4, coefs += FFTSET_BINS_GROUP_LEN) {
+		const v4f k  = v4f_ld(coefs + 0);
+		const v4f gs = v4f_ld(coefs + 4);
+		v4f       a1 = v4f_broadcast(0.0f);
+		v4f       da = v4f_broadcast(0.0f);
+		v4f       b1 = v4f_broadcast(0.0f);
+		v4f       db = v4f_broadcast(0.0f);
+		v4f       a2, b2, c1r, c1i, c2;
+		for (n = 0; n < nb_inputs; n++) {
+			da = v4f_add(v4f_add(v4f_broadcast(input[2*n+0]), v4f_mul(k, a1)), v4f_mul(gs, da));
+			db = v4f_add(v4f_add(v4f_broadcast(input[2*n+1]), v4f_mul(k, b1)), v4f_mul(gs, db));
+			a1 = v4f_add(da, v4f_mul(gs, a1));
+			b1 = v4f_add(db, v4f_mul(gs, b1));
+		}
+		a2  = v4f_mul(gs, v4f_sub(a1, da));
+		b2  = v4f_mul(gs, v4f_sub(b1, db));
+		c1r = v4f_ld(coefs + 8);
+		c1i = v4f_ld(coefs + 12);
+		c2  = v4f_ld(coefs + 16);
+		v4f_st(re, v4f_sub(v4f_sub(v4f_mul(c1r, a1), v4f_mul(c1i, b1)), v4f_mul(c2, a2)));
+		v4f_st(im, v4f_sub(v4f_add(v4f_mul(c1r, b1), v4f_mul(c1i, a1)), v4f_mul(c2, b2)));
+		fftset_bins_st(output + 2 * g, re, im, (nb_bins - g < 4) ? nb_bins - g : 4);
+	}
+}
+
+#else
+
+static void fftset_bins_goertzel_v1f(float *output, const float *input, const float *coefs, size_t nb_bins, size_t nb_inputs, int is_complex)
+{
+	size_t i, n;
+	for (i = 0; i < nb_bins; i++) {
+		const float *gp = coefs + (i / 4) * FFTSET_BINS_GROUP_LEN + (i % 4);
+		const float  k  = gp[0];
+		const float  gs = gp[4];
+		float a1 = 0.0f, da = 0.0f, b1 = 0.0f, db = 0.0f;
+		float a2, b2;
+		for (n = 0; n < nb_inputs; n++) {
+			da = input[is_complex ? 2*n : n] + k * a1 + gs * da;
+			db = (is_complex ? input[2*n+1] : 0.0f) + k * b1 + gs * db;
+			a1 = da + gs * a1;
+			b1 = db + gs * b1;
+		}
+		a2 = gs * (a1 - da);
+		b2 = gs * (b1 - db);
+		output[2*i+0] = (gp[8] * a1 - gp[12] * b1) - gp[16] * a2;
+		output[2*i+1] = (gp[8] * b1 + gp[12] * a1) - gp[16] * b2;
+	}
+}
+
+#endif
+
+void
+fftset_bins_forward
+	(const struct fftset_bins   *bins
+	,float                      *output_buf
+	,const float                *input_buf
+	,float                      *work_buf
+	)
+{
+	const struct fftset_fft *first_pass = bins->first_pass;
+	const int                is_complex = (first_pass->modulator->id == FFTSET_MODULATION_ID_COMPLEX);
+	const size_t             nb_inputs  = fftset_bins_nb_inputs(first_pass);
+	size_t i;
+
+	if (bins->coefs != NULL) {
+#if V4F_EXISTS
+		if (is_complex)
+			fftset_bins_goertzel_cplx_v4f(output_buf, input_buf, bins->coefs, bins->nb_bins, nb_inputs);
+		else
+			fftset_bins_goertzel_real_v4f(output_buf, input_buf, bins->coefs, bins->nb_bins, nb_inputs);
+#else
+		fftset_bins_goertzel_v1f(output_buf, input_buf, bins->coefs, bins->nb_bins, nb_inputs, is_complex);
+#endif
+		return;
+	}
+
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, work_buf, input_buf, NULL, FFTSET_VEC_NONZERO_ALL, bins->span_first, bins->span_count, work_buf + 2 * first_pass->lfft, NULL));
+
+	for (i = 0; i < bins->nb_bins; i++) {
+		output_buf[2*i+0] = work_buf[2*bins->bins[i]+0];
+		output_buf[2*i+1] = work_buf[2*bins->bins[i]+1];
+	}
+}
+
+enum fftset_bins_method fftset_bins_get_method(const struct fftset_bins *bins)
+{
+	return (bins->coefs != NULL) ? FFTSET_BINS_GOERTZEL : FFTSET_BINS_TRANSFORM;
+}
+
+size_t fftset_bins_work_size(const struct fftset_bins *bins)
+{
+	return (bins->coefs != NULL) ? 0 : 4 * bins->first_pass->lfft * sizeof(float);
+}
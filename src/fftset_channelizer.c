@@ -0,0 +1,181 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset/fftset.h"
+#include "fftset_modulation.h"
+#include "fftset_vec.h"
+#include "fftset_profile.h"
+#include "cop/cop_vec.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The prototype is left-padded with zeros to nb_taps = P * M taps (which
+ * does not change the output as the padding lines up with the oldest
+ * samples) and stored with every tap repeated for the real and imaginary
+ * parts of a sample so it can be multiplied straight into the interleaved
+ * stream.
+ *
+ * The last nb_taps samples are held in a mirrored ring (see fftset_stft.c)
+ * so the frame which starts at the oldest sample (pos, in floats) is always
+ * contiguous. Sample i of the frame belongs in the branch (t + i) mod M of
+ * the polyphase filter, where phase = t mod M, so the P branches are summed
+ * and stored starting at fold + 2 * phase, wrapping at the end of the fold
+ * buffer. This is the circular shift which keeps the phase of the channels
+ * continuous when the channelizer is oversampled (it is always zero when
+ * decimation == M). */
+
+int
+fftset_channelizer_init
+	(struct fftset_channelizer  *channelizer
+	,const struct fftset_fft    *first_pass
+	,const float                *prototype
+	,size_t                      nb_taps
+	,size_t                      decimation
+	)
+{
+	const size_t nb_channels = first_pass->lfft;
+	const size_t nb_branches = (nb_taps + nb_channels - 1) / nb_channels;
+	const size_t padded_taps = nb_branches * nb_channels;
+	/* Keeps every buffer aligned to 64 bytes. */
+	const size_t padded_len  = (2 * padded_taps + 15) & ~(size_t)15;
+	const size_t padded_fold = (2 * nb_channels + 15) & ~(size_t)15;
+	size_t i;
+
+	assert(first_pass->modulator->id == FFTSET_MODULATION_ID_COMPLEX);
+	assert(nb_taps > 0);
+	assert(decimation > 0);
+
+	/* The coefficient, ring, fold and work buffers. */
+	channelizer->mem = malloc(sizeof(float) * (3 * padded_len + 2 * padded_fold) + 63);
+	if (channelizer->mem == NULL)
+		return -1;
+
+	channelizer->coefs      = (float *)(((size_t)channelizer->mem + 63) & ~(size_t)63);
+	channelizer->ring       = channelizer->coefs + padded_len;
+	channelizer->fold       = channelizer->ring + 2 * padded_len;
+	channelizer->work       = channelizer->fold + padded_fold;
+	channelizer->first_pass = first_pass;
+	channelizer->nb_taps    = padded_taps;
+	channelizer->decimation = decimation;
+	channelizer->pos        = 0;
+	channelizer->phase      = 0;
+
+	for (i = 0; i < padded_taps - nb_taps; i++) {
+		channelizer->coefs[2*i+0] = 0.0f;
+		channelizer->coefs[2*i+1] = 0.0f;
+	}
+	for (i = 0; i < nb_taps; i++) {
+		channelizer->coefs[2*(padded_taps-nb_taps+i)+0] = prototype[i];
+		channelizer->coefs[2*(padded_taps-nb_taps+i)+1] = prototype[i];
+	}
+
+	/* The stream is zero before the first sample. */
+	memset(channelizer->ring, 0, sizeof(float) * 4 * padded_taps);
+
+	return 0;
+}
+
+void fftset_channelizer_destroy(struct fftset_channelizer *channelizer)
+{
+	free(channelizer->mem);
+}
+
+/* Writes decimation samples into the ring. */
+static void fftset_channelizer_write(struct fftset_channelizer *channelizer, const float *input)
+{
+	const size_t ring_len = 2 * channelizer->nb_taps;
+	size_t       nb_in    = 2 * channelizer->decimation;
+	size_t       nb_first;
+
+	/* Only the last nb_taps samples can be part of a frame. */
+	if (nb_in > ring_len) {
+		channelizer->pos = (channelizer->pos + nb_in - ring_len) % ring_len;
+		input           += nb_in - ring_len;
+		nb_in            = ring_len;
+	}
+
+	nb_first = (nb_in < ring_len - channelizer->pos) ? nb_in : ring_len - channelizer->pos;
+	memcpy(channelizer->ring + channelizer->pos, input, sizeof(float) * nb_first);
+	memcpy(channelizer->ring + channelizer->pos + ring_len, input, sizeof(float) * nb_first);
+	memcpy(channelizer->ring, input + nb_first, sizeof(float) * (nb_in - nb_first));
+	memcpy(channelizer->ring + ring_len, input + nb_first, sizeof(float) * (nb_in - nb_first));
+	channelizer->pos = (channelizer->pos + nb_in) % ring_len;
+}
+
+/* Sums the branches of the polyphase filter for the frame at ring + pos into
+ * the fold buffer. */
+static void fftset_channelizer_fold(struct fftset_channelizer *channelizer)
+{
+	const size_t  fold_len    = 2 * channelizer->first_pass->lfft;
+	const size_t  nb_branches = channelizer->nb_taps / channelizer->first_pass->lfft;
+	const float  *coefs       = channelizer->coefs;
+	const float  *frame       = channelizer->ring + channelizer->pos;
+	float        *fold        = channelizer->fold;
+	size_t        dst         = 2 * channelizer->phase;
+	size_t        i, j;
+
+#if V4F_EXISTS
+	/* The stores only stay aligned (and never straddle the end of the fold
+	 * buffer) when the frame and the rotation are whole vectors. */
+	if ((channelizer->pos % 4) == 0 && (dst % 4) == 0 && (fold_len % 4) == 0) {
+		for (i = 0; i < fold_len; i += 4) {
+			v4f acc = v4f_mul(v4f_ld(coefs + i), v4f_ld(frame + i));
+			for (j = 1; j < nb_branches; j++)
+				acc = v4f_add(acc, v4f_mul(v4f_ld(coefs + j * fold_len + i), v4f_ld(frame + j * fold_len + i)));
+			v4f_st(fold + dst, acc);
+			dst = (dst + 4 == fold_len) ? 0 : dst + 4;
+		}
+		return;
+	}
+#endif
+
+	for (i = 0; i < fold_len; i++) {
+		float acc = coefs[i] * frame[i];
+		for (j = 1; j < nb_branches; j++)
+			acc += coefs[j * fold_len + i] * frame[j * fold_len + i];
+		fold[dst] = acc;
+		dst = (dst + 1 == fold_len) ? 0 : dst + 1;
+	}
+}
+
+void
+fftset_channelizer_process
+	(struct fftset_channelizer  *channelizer
+	,float                      *output
+	,const float                *input
+	,size_t                      nb_frames
+	)
+{
+	const struct fftset_fft *first_pass  = channelizer->first_pass;
+	const size_t             nb_channels = first_pass->lfft;
+	const size_t             decimation  = channelizer->decimation;
+
+	while (nb_frames--) {
+		fftset_channelizer_write(channelizer, input);
+		channelizer->phase = (channelizer->phase + decimation) % nb_channels;
+		fftset_channelizer_fold(channelizer);
+
+		FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, output, channelizer->fold, NULL, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, channelizer->work, NULL));
+
+		input  += 2 * decimation;
+		output += 2 * nb_channels;
+	}
+}
@@ -0,0 +1,116 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_F16_H
+#define FFTSET_F16_H
+
+#include "cop/cop_vec.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#include <immintrin.h>
+#define FFTSET_HAVE_F16C (1)
+#endif
+
+/* Conversions between single precision and the compact kernel formats. The
+ * single precision to half conversion rounds to nearest even. */
+static COP_ATTR_ALWAYSINLINE float fftset_f16_to_f32(unsigned short h)
+{
+	unsigned sign = ((unsigned)h & 0x8000u) << 16;
+	unsigned expo = ((unsigned)h >> 10) & 0x1Fu;
+	unsigned mant = (unsigned)h & 0x3FFu;
+	unsigned bits;
+	float    f;
+	if (expo == 0x1Fu) {
+		bits = sign | 0x7F800000u | (mant << 13);
+	} else if (expo != 0) {
+		bits = sign | ((expo + 112) << 23) | (mant << 13);
+	} else {
+		/* Zero or subnormal: mant * 2^-24 is exact in single precision. */
+		f = (float)mant * (1.0f / 16777216.0f);
+		return (sign) ? -f : f;
+	}
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static COP_ATTR_ALWAYSINLINE unsigned short fftset_f32_to_f16(float f)
+{
+	unsigned bits;
+	unsigned sign;
+	unsigned absb;
+	memcpy(&bits, &f, sizeof(bits));
+	sign = (bits >> 16) & 0x8000u;
+	absb = bits & 0x7FFFFFFFu;
+	if (absb >= 0x7F800000u)
+		return (unsigned short)(sign | 0x7C00u | ((absb > 0x7F800000u) ? 0x200u : 0u));
+	if (absb >= 0x477FF000u) /* Rounds to a value outside of the range. */
+		return (unsigned short)(sign | 0x7C00u);
+	if (absb < 0x38800000u) {
+		/* Result is subnormal. Convert by scaling into the integer range. */
+		float    a = fabsf(f) * 16777216.0f;
+		unsigned m = (unsigned)a;
+		float    r = a - (float)m;
+		if (r > 0.5f || (r == 0.5f && (m & 1)))
+			m++;
+		return (unsigned short)(sign | m);
+	}
+	absb += 0xFFFu + ((absb >> 13) & 1u) - (112u << 23);
+	return (unsigned short)(sign | (absb >> 13));
+}
+
+static COP_ATTR_ALWAYSINLINE float fftset_bf16_to_f32(unsigned short h)
+{
+	unsigned bits = (unsigned)h << 16;
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+static COP_ATTR_ALWAYSINLINE unsigned short fftset_f32_to_bf16(float f)
+{
+	unsigned bits;
+	memcpy(&bits, &f, sizeof(bits));
+	if ((bits & 0x7FFFFFFFu) > 0x7F800000u)
+		return (unsigned short)((bits >> 16) | 0x40u);
+	bits += 0x7FFFu + ((bits >> 16) & 1u);
+	return (unsigned short)(bits >> 16);
+}
+
+static COP_ATTR_ALWAYSINLINE void fftset_load_f16(float *out, const unsigned short *in, size_t n)
+{
+	size_t i = 0;
+#if FFTSET_HAVE_F16C
+	for (; i + 4 <= n; i += 4)
+		_mm_storeu_ps(out + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i *)(in + i))));
+#endif
+	for (; i < n; i++)
+		out[i] = fftset_f16_to_f32(in[i]);
+}
+
+static COP_ATTR_ALWAYSINLINE void fftset_load_bf16(float *out, const unsigned short *in, size_t n)
+{
+	size_t i;
+	for (i = 0; i < n; i++)
+		out[i] = fftset_bf16_to_f32(in[i]);
+}
+
+#endif /* FFTSET_F16_H */
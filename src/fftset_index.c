@@ -0,0 +1,158 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset_index.h"
+#include "fftset_sync.h"
+#include "fftset_alloc.h"
+#include <assert.h>
+#include <string.h>
+
+#define FFTSET_INDEX_INITIAL_SIZE (64)
+
+static unsigned fftset_index_hash(uintptr_t key_a, size_t key_b)
+{
+	/* Mix the two keys. All bits of key_a are kept: the inner pass keys hold
+	 * the vector width in the low bits, which would otherwise make passes of
+	 * the same length share a home slot. The murmur3 finaliser spreads the
+	 * always-zero low bits of pointer keys. */
+	uint32_t h = (uint32_t)key_a ^ (uint32_t)((uint64_t)key_a >> 32);
+	h ^= ((uint32_t)key_b ^ (uint32_t)((uint64_t)key_b >> 32)) * 0x9E3779B1u;
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
+void *
+fftset_index_find
+	(struct fftset_index *const *index
+	,uintptr_t                   key_a
+	,size_t                      key_b
+	)
+{
+	const struct fftset_index *table = FFTSET_LOAD_ACQUIRE(*index);
+	unsigned                   pos;
+
+	if (table == NULL)
+		return NULL;
+
+	for (pos = fftset_index_hash(key_a, key_b) & table->mask; ; pos = (pos + 1) & table->mask) {
+		const struct fftset_index_slot *slot  = &(table->slots[pos]);
+		void                           *value = FFTSET_LOAD_ACQUIRE(slot->value);
+		if (value == NULL)
+			return NULL;
+		if (slot->key_a == key_a && slot->key_b == key_b)
+			return value;
+	}
+}
+
+static void fftset_index_put(struct fftset_index *table, uintptr_t key_a, size_t key_b, void *value)
+{
+	unsigned pos = fftset_index_hash(key_a, key_b) & table->mask;
+	while (table->slots[pos].value != NULL) {
+		assert(table->slots[pos].key_a != key_a || table->slots[pos].key_b != key_b);
+		pos = (pos + 1) & table->mask;
+	}
+	table->slots[pos].key_a = key_a;
+	table->slots[pos].key_b = key_b;
+	FFTSET_STORE_RELEASE(table->slots[pos].value, value);
+	table->nb_entries++;
+}
+
+int
+fftset_index_insert
+	(struct fftset_index     **index
+	,struct fftset            *fc
+	,uintptr_t                 key_a
+	,size_t                    key_b
+	,void                     *value
+	)
+{
+	struct fftset_index *table = *index;
+
+	assert(value != NULL);
+
+	if (table == NULL || 2 * (table->nb_entries + 1) > table->mask + 1) {
+		unsigned             size = (table == NULL) ? FFTSET_INDEX_INITIAL_SIZE : 2 * (table->mask + 1);
+		struct fftset_index *grown;
+		unsigned             i;
+
+		grown = fftset_alloc(fc, sizeof(*grown), 0, FFTSET_MEM_OVERHEAD);
+		if (grown == NULL)
+			return 1;
+		grown->slots = fftset_alloc(fc, sizeof(grown->slots[0]) * size, 64, FFTSET_MEM_OVERHEAD);
+		if (grown->slots == NULL)
+			return 1;
+		memset(grown->slots, 0, sizeof(grown->slots[0]) * size);
+		grown->mask       = size - 1;
+		grown->nb_entries = 0;
+
+		if (table != NULL)
+			for (i = 0; i <= table->mask; i++)
+				if (table->slots[i].value != NULL)
+					fftset_index_put(grown, table->slots[i].key_a, table->slots[i].key_b, table->slots[i].value);
+
+		fftset_index_put(grown, key_a, key_b, value);
+		FFTSET_STORE_RELEASE(*index, grown);
+		return 0;
+	}
+
+	fftset_index_put(table, key_a, key_b, value);
+	return 0;
+}
+
+void
+fftset_index_get_stats
+	(const struct fftset_index  *index
+	,struct fftset_index_stats  *stats
+	)
+{
+	unsigned long total_probes = 0;
+	unsigned i;
+
+	stats->nb_entries        = 0;
+	stats->capacity          = 0;
+	stats->max_probe_length  = 0;
+	stats->mean_probe_length = 0.0f;
+
+	if (index == NULL)
+		return;
+
+	stats->nb_entries = index->nb_entries;
+	stats->capacity   = index->mask + 1;
+
+	/* The probe length of an entry is the number of slots which must be
+	 * inspected to find it. */
+	for (i = 0; i <= index->mask; i++) {
+		const struct fftset_index_slot *slot = &(index->slots[i]);
+		if (slot->value != NULL) {
+			unsigned home  = fftset_index_hash(slot->key_a, slot->key_b) & index->mask;
+			unsigned probe = ((i - home) & index->mask) + 1;
+			total_probes += probe;
+			if (probe > stats->max_probe_length)
+				stats->max_probe_length = probe;
+		}
+	}
+
+	if (index->nb_entries)
+		stats->mean_probe_length = (float)total_probes / index->nb_entries;
+}
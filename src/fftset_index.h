@@ -0,0 +1,79 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_INDEX_H
+#define FFTSET_INDEX_H
+
+#include "fftset/fftset.h"
+#include <stdint.h>
+
+/* Open addressing hash index used to locate cached passes without walking
+ * the sorted pass lists. Keys are a pair of a pointer-sized value and an
+ * unsigned value (e.g. a modulation and a length).
+ *
+ * Tables live in the fftset allocator and are never freed or modified in
+ * place once they are visible to readers except for filling an empty slot.
+ * A slot is filled by writing the key and then publishing the value with a
+ * release store, so fftset_index_find() may be called concurrently with a
+ * single writer. When the load factor exceeds one half, a new table of twice
+ * the size is built and published; readers still holding the old table may
+ * miss the most recent entries but will never see anything inconsistent. */
+
+struct fftset_index_slot {
+	uintptr_t  key_a;
+	size_t     key_b;
+	void      *value;
+};
+
+struct fftset_index {
+	unsigned                  mask;
+	unsigned                  nb_entries;
+	struct fftset_index_slot *slots;
+};
+
+/* Returns the value associated with the key or NULL if it does not exist.
+ * May be called without holding the fftset creation lock. */
+void *
+fftset_index_find
+	(struct fftset_index *const *index
+	,uintptr_t                   key_a
+	,size_t                      key_b
+	);
+
+/* Inserts a value which must not already exist in the index. Must only be
+ * called by one thread at a time. Returns non-zero if memory was exhausted
+ * (in which case the index is unchanged). */
+int
+fftset_index_insert
+	(struct fftset_index     **index
+	,struct fftset            *fc
+	,uintptr_t                 key_a
+	,size_t                    key_b
+	,void                     *value
+	);
+
+/* Computes occupancy and probe length statistics of the index. */
+void
+fftset_index_get_stats
+	(const struct fftset_index  *index
+	,struct fftset_index_stats  *stats
+	);
+
+#endif /* FFTSET_INDEX_H */
@@ -0,0 +1,140 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifdef _MSC_VER
+#define _USE_MATH_DEFINES
+#endif
+
+/* The kernels built with the flags used for the rest of the library. */
+#define FFTSET_KERNELS_NAME FFTSET_KERNELS_BASELINE
+#include "fftset_kernels_impl.h"
+
+#if FFTSET_RUNTIME_DISPATCH
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FFTSET_HAVE_CPUID (1)
+static void fftset_cpuid(unsigned leaf, unsigned subleaf, unsigned *regs)
+{
+	int r[4];
+	__cpuidex(r, (int)leaf, (int)subleaf);
+	regs[0] = (unsigned)r[0];
+	regs[1] = (unsigned)r[1];
+	regs[2] = (unsigned)r[2];
+	regs[3] = (unsigned)r[3];
+}
+static unsigned long long fftset_xgetbv(void)
+{
+	return _xgetbv(0);
+}
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#define FFTSET_HAVE_CPUID (1)
+static void fftset_cpuid(unsigned leaf, unsigned subleaf, unsigned *regs)
+{
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+}
+static unsigned long long fftset_xgetbv(void)
+{
+	unsigned lo, hi;
+	__asm__ __volatile__ ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+}
+#else
+#define FFTSET_HAVE_CPUID (0)
+#endif
+
+/* Finds the best level supported by both the processor and the operating
+ * system (which must save the wider registers on context switches). */
+static enum fftset_isa fftset_isa_detect(void)
+{
+#if FFTSET_HAVE_CPUID
+	unsigned           regs[4];
+	unsigned           max_leaf;
+	unsigned long long xcr0;
+	int                avx2, fma, f16c, avx512;
+
+	fftset_cpuid(0, 0, regs);
+	max_leaf = regs[0];
+	if (max_leaf < 1)
+		return FFTSET_ISA_BASELINE;
+
+	/* AVX and OSXSAVE. */
+	fftset_cpuid(1, 0, regs);
+	if ((regs[2] & (1u << 28)) == 0 || (regs[2] & (1u << 27)) == 0)
+		return FFTSET_ISA_BASELINE;
+	fma  = (regs[2] & (1u << 12)) != 0;
+	f16c = (regs[2] & (1u << 29)) != 0;
+
+	/* XMM and YMM state. */
+	xcr0 = fftset_xgetbv();
+	if ((xcr0 & 0x6u) != 0x6u)
+		return FFTSET_ISA_BASELINE;
+
+	if (max_leaf < 7)
+		return FFTSET_ISA_AVX;
+
+	/* AVX2, AVX512F and AVX512VL. */
+	fftset_cpuid(7, 0, regs);
+	avx2   = (regs[1] & (1u << 5)) != 0;
+	avx512 = (regs[1] & (1u << 16)) != 0 && (regs[1] & (1u << 31)) != 0;
+
+	if (!avx2 || !fma || !f16c)
+		return FFTSET_ISA_AVX;
+
+	/* Opmask, upper ZMM and high ZMM state. */
+	if (!avx512 || (xcr0 & 0xE0u) != 0xE0u)
+		return FFTSET_ISA_AVX2_FMA;
+
+	return FFTSET_ISA_AVX512;
+#else
+	return FFTSET_ISA_BASELINE;
+#endif
+}
+
+#endif /* FFTSET_RUNTIME_DISPATCH */
+
+const struct fftset_kernels *
+fftset_kernels_select
+	(enum fftset_isa  requested
+	,enum fftset_isa *isa
+	)
+{
+#if FFTSET_RUNTIME_DISPATCH
+	static const struct fftset_kernels *const KERNELS[] =
+	{NULL
+	,&FFTSET_KERNELS_BASELINE
+	,&FFTSET_KERNELS_AVX
+	,&FFTSET_KERNELS_AVX2_FMA
+	,&FFTSET_KERNELS_AVX512
+	};
+	enum fftset_isa best = fftset_isa_detect();
+
+	if (requested == FFTSET_ISA_AUTO || requested > best)
+		requested = best;
+
+	*isa = requested;
+	return KERNELS[requested];
+#else
+	(void)requested;
+	*isa = FFTSET_ISA_BASELINE;
+	return &FFTSET_KERNELS_BASELINE;
+#endif
+}
@@ -0,0 +1,88 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_KERNELS_H
+#define FFTSET_KERNELS_H
+
+#include "fftset/fftset.h"
+#include <stddef.h>
+
+/* Everything which depends on the instruction set used to compile it is
+ * gathered into a struct fftset_kernels. Normally there is only one set
+ * (FFTSET_KERNELS_BASELINE) which is built with whatever vector extensions
+ * the compiler was asked to use. When FFTSET_RUNTIME_DISPATCH is set, the
+ * kernels are additionally compiled for several x86 instruction set levels
+ * (each in its own translation unit built with the matching code generation
+ * flags) and fftset_init_ex() picks the best set which the processor
+ * supports. */
+
+struct fftset_fft;
+
+struct float_pass_radix {
+	unsigned   radix;
+	unsigned   fito_vec_len;
+	unsigned   foti_vec_len;
+
+	void     (*mulconj)(float *work, const float *kern, size_t nb_vec_fft);
+	void     (*mulconj_f16)(float *work, const unsigned short *kern, size_t nb_vec_fft);
+	void     (*mulconj_bf16)(float *work, const unsigned short *kern, size_t nb_vec_fft);
+	void     (*inner)(float *work, size_t nfft, size_t lfft, const float *twid, size_t twid_stride, size_t col_count);
+	void     (*inner_stock)(float *out, const float *in, const float *twid, size_t twid_stride, size_t ncol, size_t nrow_div_radix, size_t col_count, size_t row_count);
+	void     (*dif)(float *work, size_t nfft, size_t lfft, const float *twid, size_t twid_stride, size_t col_count);
+	void     (*dit)(float *work, size_t nfft, size_t lfft, const float *twid, size_t twid_stride, size_t col_count);
+	void     (*stock)(float *out, const float *in, const float *twid, size_t twid_stride, size_t ncol, size_t nrow_div_radix, size_t col_count, size_t row_count);
+};
+
+/* Upper bound on the number of pass definitions in any set of kernels. */
+#define FFTSET_KERNELS_MAX_PASSES (32)
+
+struct fftset_kernels {
+	/* Pass definitions. Sorted by fito_vec_len. */
+	const struct float_pass_radix *passes;
+	unsigned                       nb_passes;
+
+	/* The FFTSET_MODULATION_FREQ_OFFSET_REAL implementation which uses 8
+	 * wide vectors. These are all NULL if the kernels were compiled without
+	 * 8 wide vectors. */
+	void (*freqoffsetreal_v8f_get_kern)(const struct fftset_fft *fft, float *out, const float *in, size_t nb_nonzero, float scale);
+	void (*freqoffsetreal_v8f_fwd)(const struct fftset_fft *fft, float *out, const float *in, const float *window, size_t nb_nonzero, size_t out_first, size_t out_count, float *work, struct fftset_threads *threads);
+	void (*freqoffsetreal_v8f_inv)(const struct fftset_fft *fft, float *out, const float *in, size_t out_first, size_t out_count, const float *window, float scale, float *work, struct fftset_threads *threads);
+	void (*freqoffsetreal_v8f_fwd_spectrum)(const struct fftset_fft *fft, float *out, const float *in, enum fftset_spectrum_format format, size_t band_size, float *work, struct fftset_threads *threads);
+	void (*freqoffsetreal_v8f_conv)(const struct fftset_fft *fft, float *out, const float *in, size_t nb_nonzero, size_t out_first, size_t out_count, const void *kern, enum fftset_kernel_format kern_format, float *work, struct fftset_threads *threads);
+};
+
+extern const struct fftset_kernels FFTSET_KERNELS_BASELINE;
+#if FFTSET_RUNTIME_DISPATCH
+extern const struct fftset_kernels FFTSET_KERNELS_AVX;
+extern const struct fftset_kernels FFTSET_KERNELS_AVX2_FMA;
+extern const struct fftset_kernels FFTSET_KERNELS_AVX512;
+#endif
+
+/* Returns the kernels for the requested instruction set level (which may
+ * be FFTSET_ISA_AUTO). The level is reduced to the best one supported by
+ * both the processor and the build; the level which was chosen is stored in
+ * *isa. */
+const struct fftset_kernels *
+fftset_kernels_select
+	(enum fftset_isa  requested
+	,enum fftset_isa *isa
+	);
+
+#endif /* FFTSET_KERNELS_H */
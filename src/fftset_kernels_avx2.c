@@ -0,0 +1,43 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+/* The kernels built with AVX2 and FMA code generation. When FFTSET_RUNTIME_DISPATCH
+ * is set, this file must be compiled with the matching flags (e.g.
+ * -mavx2 -mfma -mf16c or /arch:AVX2). */
+
+#if FFTSET_RUNTIME_DISPATCH
+
+#if !defined(__AVX2__)
+#error "fftset_kernels_avx2.c must be compiled with AVX2 and FMA enabled"
+#endif
+
+#ifdef _MSC_VER
+#define _USE_MATH_DEFINES
+#endif
+
+#define FFTSET_KERNELS_NAME FFTSET_KERNELS_AVX2_FMA
+#include "fftset_kernels_impl.h"
+
+#else
+
+/* ISO C does not allow empty translation units. */
+typedef int fftset_kernels_avx2_unused;
+
+#endif
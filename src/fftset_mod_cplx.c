@@ -29,19 +29,87 @@
 #include <math.h>
 #include <string.h>
 
+/* Gives the end of the output window of a transform of fft_len complex
+ * values. */
+static size_t modcplx_window_end(size_t fft_len, size_t out_first, size_t out_count)
+{
+	assert(out_first < fft_len);
+	return (out_count < fft_len - out_first) ? out_first + out_count : fft_len;
+}
+
+/* Separates the spectra of two real signals which were transformed together
+ * as the real and imaginary parts of one complex signal:
+ *     A[k] = (Z[k] + conj(Z[N-k])) / 2
+ *     B[k] = (Z[k] - conj(Z[N-k])) / 2i
+ * Bins 0 to N/2 of A are written to the start of output followed by the same
+ * bins of B. Z is held in blocks of vec_width real parts followed by
+ * vec_width imaginary parts (interleaved when vec_width is 1). The mirrored
+ * bins are one element out of step with the vectors so this is done one bin
+ * at a time (as are the other outer passes of this modulation); both spectra
+ * are produced in the same pass over Z. */
+static void modcplx_separate_pair(float *output, const float *z, size_t fft_len, unsigned vec_width)
+{
+	const size_t nb_bins = fft_len / 2 + 1;
+	float       *out_a   = output;
+	float       *out_b   = output + 2 * nb_bins;
+	size_t k;
+	for (k = 0; k < nb_bins; k++) {
+		const size_t m  = (k) ? fft_len - k : 0;
+		const size_t zk = 2 * k - k % vec_width;
+		const size_t zm = 2 * m - m % vec_width;
+		float        kr = z[zk];
+		float        ki = z[zk + vec_width];
+		float        mr = z[zm];
+		float        mi = z[zm + vec_width];
+		out_a[2*k+0] = 0.5f * (kr + mr);
+		out_a[2*k+1] = 0.5f * (ki - mi);
+		out_b[2*k+0] = 0.5f * (ki + mi);
+		out_b[2*k+1] = 0.5f * (mr - kr);
+	}
+}
+
+/* Stores the conjugate of (re, im) multiplied by scale as output k or, if
+ * there is a synthesis window, adds it multiplied by the window coefficient
+ * of output k as well. */
+static COP_ATTR_ALWAYSINLINE void modcplx_st(float *output, const float *window, float scale, size_t k, float re, float im)
+{
+	if (window != NULL) {
+		output[2*k+0] += re * (window[k] * scale);
+		output[2*k+1] -= im * (window[k] * scale);
+	} else {
+		output[2*k+0] = re * scale;
+		output[2*k+1] = -im * scale;
+	}
+}
+
 #if V4F_EXISTS
-static void modcplx_forward_first(float *vec_output, const float *input, const float *coefs, unsigned fft_len)
+/* Only the first nb_nonzero complex inputs may be non-zero. Rows of the
+ * radix-4 pass which only hold zeros are not loaded and columns which only
+ * hold zeros are zeroed without being transformed. Returns the number of
+ * leading vectors of the output which may be non-zero. The real and
+ * imaginary parts of input j are re[j*stride] and im[j*stride] (zero if im
+ * is NULL) and are multiplied by window[j] if window is not NULL and by
+ * scale. */
+static size_t modcplx_forward_first(float *vec_output, const float *re, const float *im, size_t stride, const float *window, float scale, const float *coefs, size_t fft_len, size_t nb_nonzero)
 {
-	unsigned j;
-	for (j = 0; j < fft_len / 4; j++) {
-		float r0 = input[0*fft_len/2+2*j+0];
-		float i0 = input[0*fft_len/2+2*j+1];
-		float r1 = input[1*fft_len/2+2*j+0];
-		float i1 = input[1*fft_len/2+2*j+1];
-		float r2 = input[2*fft_len/2+2*j+0];
-		float i2 = input[2*fft_len/2+2*j+1];
-		float r3 = input[3*fft_len/2+2*j+0];
-		float i3 = input[3*fft_len/2+2*j+1];
+	const size_t nb_in   = (nb_nonzero < fft_len) ? nb_nonzero : fft_len;
+	const size_t nb_rows = (nb_in + fft_len / 4 - 1) / (fft_len / 4);
+	const size_t nb_cols = (nb_in < fft_len / 4) ? nb_in : fft_len / 4;
+	size_t j;
+	memset(vec_output + 8*nb_cols, 0, sizeof(float) * 8 * (fft_len / 4 - nb_cols));
+	for (j = 0; j < nb_cols; j++) {
+		float w0 = (window != NULL) ? window[0*fft_len/4+j] * scale : scale;
+		float w1 = (window != NULL && nb_rows > 1) ? window[1*fft_len/4+j] * scale : scale;
+		float w2 = (window != NULL && nb_rows > 2) ? window[2*fft_len/4+j] * scale : scale;
+		float w3 = (window != NULL && nb_rows > 3) ? window[3*fft_len/4+j] * scale : scale;
+		float r0 = re[(0*fft_len/4+j)*stride] * w0;
+		float i0 = (im != NULL) ? im[(0*fft_len/4+j)*stride] * w0 : 0.0f;
+		float r1 = (nb_rows > 1) ? re[(1*fft_len/4+j)*stride] * w1 : 0.0f;
+		float i1 = (nb_rows > 1 && im != NULL) ? im[(1*fft_len/4+j)*stride] * w1 : 0.0f;
+		float r2 = (nb_rows > 2) ? re[(2*fft_len/4+j)*stride] * w2 : 0.0f;
+		float i2 = (nb_rows > 2 && im != NULL) ? im[(2*fft_len/4+j)*stride] * w2 : 0.0f;
+		float r3 = (nb_rows > 3) ? re[(3*fft_len/4+j)*stride] * w3 : 0.0f;
+		float i3 = (nb_rows > 3 && im != NULL) ? im[(3*fft_len/4+j)*stride] * w3 : 0.0f;
 		
 		/* 4 point complex fft */
 		float yr0 = r0 + r2;
@@ -83,12 +151,18 @@ static void modcplx_forward_first(float *vec_output, const float *input, const f
 		vec_output[8*j+3] = twr * tr3 - twi * ti3;
 		vec_output[8*j+7] = twr * ti3 + twi * tr3;
 	}
+	return nb_cols;
 }
 
-static void modcplx_inverse_final(float *vec_output, const float *input, const float *coefs, unsigned fft_len)
+/* Only the columns which hold outputs [out_first, out_end) are computed and
+ * only those outputs are stored (or accumulated if window is not NULL) after
+ * being multiplied by scale. Column j of every row of fft_len / 4 outputs
+ * comes from vector j. */
+static void modcplx_inverse_final(float *vec_output, const float *input, const float *window, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
 {
-	unsigned j;
-	for (j = 0; j < fft_len / 4; j++) {
+	size_t j, col_count;
+	fftset_vec_window_cols(fft_len / 4, out_first, out_end - out_first, &j, &col_count);
+	for (; col_count; col_count--, j = (j + 1 < fft_len / 4) ? j + 1 : 0) {
 		float r0 = input[8*j+0];
 		float r1 = input[8*j+1];
 		float r2 = input[8*j+2];
@@ -140,14 +214,14 @@ static void modcplx_inverse_final(float *vec_output, const float *input, const f
 		float tr3 = yr2 - yi3;
 		float ti3 = yi2 + yr3;
 
-		vec_output[0*fft_len/2+2*j+0] = tr0;
-		vec_output[0*fft_len/2+2*j+1] = -ti0;
-		vec_output[1*fft_len/2+2*j+0] = tr1;
-		vec_output[1*fft_len/2+2*j+1] = -ti1;
-		vec_output[2*fft_len/2+2*j+0] = tr2;
-		vec_output[2*fft_len/2+2*j+1] = -ti2;
-		vec_output[3*fft_len/2+2*j+0] = tr3;
-		vec_output[3*fft_len/2+2*j+1] = -ti3;
+		if (0*fft_len/4+j >= out_first && 0*fft_len/4+j < out_end)
+			modcplx_st(vec_output, window, scale, 0*fft_len/4+j, tr0, ti0);
+		if (1*fft_len/4+j >= out_first && 1*fft_len/4+j < out_end)
+			modcplx_st(vec_output, window, scale, 1*fft_len/4+j, tr1, ti1);
+		if (2*fft_len/4+j >= out_first && 2*fft_len/4+j < out_end)
+			modcplx_st(vec_output, window, scale, 2*fft_len/4+j, tr2, ti2);
+		if (3*fft_len/4+j >= out_first && 3*fft_len/4+j < out_end)
+			modcplx_st(vec_output, window, scale, 3*fft_len/4+j, tr3, ti3);
 	}
 }
 
@@ -157,25 +231,36 @@ modcplx_get_kernel_v4f
 	(const struct fftset_fft *first_pass
 	,float                   *output_buf
 	,const float             *input_buf
+	,size_t                   nb_nonzero
+	,float                    scale
 	)
 {
-	modcplx_forward_first(output_buf, input_buf, first_pass->main_twiddle, first_pass->lfft);
-	fftset_vec_kern(first_pass->next_compat, 1, output_buf);
+	nb_nonzero = modcplx_forward_first(output_buf, input_buf, input_buf + 1, 2, NULL, scale, first_pass->main_twiddle, first_pass->lfft, nb_nonzero);
+	fftset_vec_kern(first_pass->next_compat, 1, output_buf, nb_nonzero);
 }
 
 static
 void
 modcplx_conv_v4f
-	(const struct fftset_fft *first_pass
-	,float                   *output_buf
-	,const float             *input_buf
-	,const float             *kernel_buf
-	,float                   *work_buf
+	(const struct fftset_fft   *first_pass
+	,float                     *output_buf
+	,const float               *input_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,const void                *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,float                     *work_buf
+	,struct fftset_threads     *threads
 	)
 {
-	modcplx_forward_first(work_buf, input_buf, first_pass->main_twiddle, first_pass->lfft);
-	fftset_vec_conv(first_pass->next_compat, 1, work_buf, kernel_buf);
-	modcplx_inverse_final(output_buf, work_buf, first_pass->main_twiddle, first_pass->lfft);
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modcplx_window_end(lfft, out_first, out_count);
+	size_t col_first, col_count;
+	fftset_vec_window_cols(lfft / 4, out_first, out_end - out_first, &col_first, &col_count);
+	nb_nonzero = modcplx_forward_first(work_buf, input_buf, input_buf + 1, 2, NULL, 1.0f, first_pass->main_twiddle, lfft, nb_nonzero);
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, nb_nonzero, kernel_buf, kernel_format, col_first, col_count, threads);
+	modcplx_inverse_final(output_buf, work_buf, NULL, 1.0f, first_pass->main_twiddle, lfft, out_first, out_end);
 }
 
 static
@@ -184,29 +269,67 @@ modcplx_forward_v4f
 	(const struct fftset_fft *first_pass
 	,float                   *output_buf
 	,const float             *input_buf
+	,const float             *window
+	,size_t                   nb_nonzero
+	,size_t                   out_first
+	,size_t                   out_count
 	,float                   *work_buf
+	,struct fftset_threads   *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modcplx_window_end(lfft, out_first, out_count);
+	/* Element i of the chain output holds bins 4i to 4i + 3. */
+	const size_t e_first = out_first / 4;
+	const size_t e_end   = (out_end + 3) / 4;
+	size_t i;
 
-	modcplx_forward_first(work_buf, input_buf, first_pass->main_twiddle, lfft);
+	nb_nonzero = modcplx_forward_first(work_buf, input_buf, input_buf + 1, 2, window, 1.0f, first_pass->main_twiddle, lfft, nb_nonzero);
 
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, nb_nonzero, e_first, e_end - e_first, threads);
 
-	if (input_buf == output_buf) {
-		for (i = 0; i < lfft / 4; i++) {
-			v4f a, b;
-			V4F_LD2(a, b, output_buf + 8*i + 0);
-			V4F_ST2INT(output_buf + 8*i, a, b);
-		}
-	} else {
-		for (i = 0; i < lfft / 4; i++) {
-			v4f a, b;
-			V4F_LD2(a, b, work_buf + 8*i + 0);
-			V4F_ST2INT(output_buf + 8*i, a, b);
+	for (i = e_first; i < e_end; i++) {
+		v4f a, b;
+		V4F_LD2(a, b, work_buf + 8*i + 0);
+		V4F_ST2INT(output_buf + 8*i, a, b);
+	}
+}
+
+static
+void
+modcplx_forward_spectrum_v4f
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	,struct fftset_threads       *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	float VEC_ALIGN_BEST power[4];
+	size_t i;
+
+	(void)modcplx_forward_first(work_buf, input_buf, input_buf + 1, 2, NULL, 1.0f, first_pass->main_twiddle, lfft, FFTSET_VEC_NONZERO_ALL);
+
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+
+	for (i = 0; i < lfft / 4; i++) {
+		v4f a, b, p;
+		V4F_LD2(a, b, work_buf + 8*i + 0);
+		p = v4f_add(v4f_mul(a, a), v4f_mul(b, b));
+		if (band_size == 1) {
+			v4f_st(output_buf + 4*i, p);
+			fftset_vec_spectrum_finish(output_buf + 4*i, 4, format);
+		} else {
+			v4f_st(power, p);
+			fftset_vec_spectrum_bands(output_buf, power, 4*i, 4, band_size);
 		}
 	}
+
+	if (band_size > 1)
+		fftset_vec_spectrum_finish(output_buf, (lfft + band_size - 1) / band_size, format);
 }
 
 static
@@ -215,11 +338,19 @@ modcplx_inverse_v4f
 	(const struct fftset_fft    *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *window
+	,float                       scale
 	,float                      *work_buf
+	,struct fftset_threads      *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modcplx_window_end(lfft, out_first, out_count);
+	float       *temp    = (window != NULL) ? work_buf + 2 * lfft : output_buf;
+	size_t col_first, col_count;
+	size_t i;
 
 	for (i = 0; i < lfft / 4; i++) {
 		v4f a, b;
@@ -228,44 +359,105 @@ modcplx_inverse_v4f
 		V4F_ST2(work_buf + 8*i, a, b);
 	}
 
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
+	fftset_vec_window_cols(lfft / 4, out_first, out_end - out_first, &col_first, &col_count);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, temp, FFTSET_VEC_NONZERO_ALL, col_first, col_count, threads);
 
-	if (input_buf != work_buf) {
-		assert(input_buf == output_buf);
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-	}
+	modcplx_inverse_final(output_buf, work_buf, window, scale, first_pass->main_twiddle, lfft, out_first, out_end);
+}
 
-	modcplx_inverse_final(output_buf, work_buf, first_pass->main_twiddle, lfft);
+static
+void
+modcplx_forward_pair_v4f
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_a
+	,const float                *input_b
+	,float                      *work_buf
+	,struct fftset_threads      *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	(void)modcplx_forward_first(work_buf, input_a, input_b, 1, NULL, 1.0f, first_pass->main_twiddle, lfft, FFTSET_VEC_NONZERO_ALL);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+	modcplx_separate_pair(output_buf, work_buf, lfft, 4);
+}
+
+static
+void
+modcplx_conv_real_v4f
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	,struct fftset_threads      *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	(void)modcplx_forward_first(work_buf, input_buf, NULL, 1, NULL, 1.0f, first_pass->main_twiddle, lfft, FFTSET_VEC_NONZERO_ALL);
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, FFTSET_VEC_NONZERO_ALL, kernel_buf, FFTSET_KERNEL_FORMAT_F32, 0, FFTSET_VEC_WINDOW_ALL, threads);
+	modcplx_inverse_final(output_buf, work_buf, NULL, 1.0f, first_pass->main_twiddle, lfft, 0, lfft);
 }
 #endif
 
+/* Copies the first nb_nonzero complex values of the input (multiplied by
+ * the window if it is not NULL and by scale) and zeroes the rest of the
+ * output. Returns the number of values copied. The output may only be the
+ * input if there is a window. */
+static size_t modcplx_copy_nonzero(float *output, const float *input, const float *window, float scale, size_t lfft, size_t nb_nonzero)
+{
+	const size_t nb_in = (nb_nonzero < lfft) ? nb_nonzero : lfft;
+	size_t i;
+	if (window != NULL) {
+		for (i = 0; i < nb_in; i++) {
+			output[2*i+0] = input[2*i+0] * (window[i] * scale);
+			output[2*i+1] = input[2*i+1] * (window[i] * scale);
+		}
+	} else if (scale != 1.0f) {
+		for (i = 0; i < 2 * nb_in; i++)
+			output[i] = input[i] * scale;
+	} else {
+		memcpy(output, input, sizeof(float) * nb_in * 2);
+	}
+	memset(output + 2*nb_in, 0, sizeof(float) * (lfft - nb_in) * 2);
+	return nb_in;
+}
+
 static
 void
 modcplx_get_kernel_v1f
 	(const struct fftset_fft *first_pass
 	,float                   *output_buf
 	,const float             *input_buf
+	,size_t                   nb_nonzero
+	,float                    scale
 	)
 {
-	memcpy(output_buf, input_buf, sizeof(float) * first_pass->lfft * 2);
-	fftset_vec_kern(first_pass->next_compat, 1, output_buf);
+	nb_nonzero = modcplx_copy_nonzero(output_buf, input_buf, NULL, scale, first_pass->lfft, nb_nonzero);
+	fftset_vec_kern(first_pass->next_compat, 1, output_buf, nb_nonzero);
 }
 
 static
 void
 modcplx_conv_v1f
-	(const struct fftset_fft *first_pass
-	,float                   *output_buf
-	,const float             *input_buf
-	,const float             *kernel_buf
-	,float                   *work_buf
+	(const struct fftset_fft   *first_pass
+	,float                     *output_buf
+	,const float               *input_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,const void                *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,float                     *work_buf
+	,struct fftset_threads     *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
-	memcpy(work_buf, input_buf, sizeof(float) * lfft * 2);
-	fftset_vec_conv(first_pass->next_compat, 1, work_buf, kernel_buf);
-	for (i = 0; i < lfft; i++) {
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modcplx_window_end(lfft, out_first, out_count);
+	size_t i;
+	nb_nonzero = modcplx_copy_nonzero(work_buf, input_buf, NULL, 1.0f, lfft, nb_nonzero);
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, nb_nonzero, kernel_buf, kernel_format, out_first, out_end - out_first, threads);
+	for (i = out_first; i < out_end; i++) {
 		output_buf[2*i+0] =  work_buf[2*i+0];
 		output_buf[2*i+1] = -work_buf[2*i+1];
 	}
@@ -277,77 +469,200 @@ modcplx_forward_v1f
 	(const struct fftset_fft *first_pass
 	,float                   *output_buf
 	,const float             *input_buf
+	,const float             *window
+	,size_t                   nb_nonzero
+	,size_t                   out_first
+	,size_t                   out_count
 	,float                   *work_buf
+	,struct fftset_threads   *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	memcpy(work_buf, input_buf, sizeof(float) * lfft * 2);
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
-	if (input_buf != output_buf)
-		memcpy(output_buf, work_buf, sizeof(float) * lfft * 2);
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modcplx_window_end(lfft, out_first, out_count);
+	if (output_buf != input_buf || window != NULL)
+		nb_nonzero = modcplx_copy_nonzero(output_buf, input_buf, window, 1.0f, lfft, nb_nonzero);
+	fftset_vec_stockham(first_pass->next_stockham, 1, output_buf, work_buf, nb_nonzero, out_first, out_end - out_first, threads);
 }
 
 
+/* The bins are transformed in output_buf and replaced by their powers in
+ * the same sweep (band k is always stored below the bins still to be
+ * read). */
+static
+void
+modcplx_forward_spectrum_v1f
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	,struct fftset_threads       *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	size_t i;
+	(void)modcplx_copy_nonzero(output_buf, input_buf, NULL, 1.0f, lfft, FFTSET_VEC_NONZERO_ALL);
+	fftset_vec_stockham(first_pass->next_stockham, 1, output_buf, work_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+	for (i = 0; i < lfft; i++) {
+		float power = output_buf[2*i+0] * output_buf[2*i+0] + output_buf[2*i+1] * output_buf[2*i+1];
+		fftset_vec_spectrum_bands(output_buf, &power, i, 1, band_size);
+	}
+	fftset_vec_spectrum_finish(output_buf, (lfft + band_size - 1) / band_size, format);
+}
+
 static
 void
 modcplx_inverse_v1f
 	(const struct fftset_fft    *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *window
+	,float                       scale
 	,float                      *work_buf
+	,struct fftset_threads      *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modcplx_window_end(lfft, out_first, out_count);
+	float       *temp    = (window != NULL) ? work_buf + 2 * lfft : output_buf;
+	size_t i;
 	for (i = 0; i < lfft; i++) {
 		work_buf[2*i+0] =  input_buf[2*i+0];
 		work_buf[2*i+1] = -input_buf[2*i+1];
 	}
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
-	if (input_buf == output_buf) {
-		for (i = 0; i < lfft; i++) {
-			output_buf[2*i+0] =  output_buf[2*i+0];
-			output_buf[2*i+1] = -output_buf[2*i+1];
-		}
-	} else {
-		for (i = 0; i < lfft; i++) {
-			output_buf[2*i+0] =  work_buf[2*i+0];
-			output_buf[2*i+1] = -work_buf[2*i+1];
-		}
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, temp, FFTSET_VEC_NONZERO_ALL, out_first, out_end - out_first, threads);
+	for (i = out_first; i < out_end; i++)
+		modcplx_st(output_buf, window, scale, i, work_buf[2*i+0], work_buf[2*i+1]);
+}
+
+static
+void
+modcplx_forward_pair_v1f
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_a
+	,const float                *input_b
+	,float                      *work_buf
+	,struct fftset_threads      *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	size_t i;
+	for (i = 0; i < lfft; i++) {
+		work_buf[2*i+0] = input_a[i];
+		work_buf[2*i+1] = input_b[i];
+	}
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+	modcplx_separate_pair(output_buf, work_buf, lfft, 1);
+}
+
+static
+void
+modcplx_conv_real_v1f
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *kernel_buf
+	,float                      *work_buf
+	,struct fftset_threads      *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	size_t i;
+	for (i = 0; i < lfft; i++) {
+		work_buf[2*i+0] = input_buf[i];
+		work_buf[2*i+1] = 0.0f;
+	}
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, FFTSET_VEC_NONZERO_ALL, kernel_buf, FFTSET_KERNEL_FORMAT_F32, 0, FFTSET_VEC_WINDOW_ALL, threads);
+	for (i = 0; i < lfft; i++) {
+		output_buf[2*i+0] =  work_buf[2*i+0];
+		output_buf[2*i+1] = -work_buf[2*i+1];
 	}
 }
 
-static int modcplx_init(struct fftset_fft *fft, struct fftset_vec **veclist, struct cop_salloc_iface *alloc, unsigned complex_len)
+enum modcplx_variant {
+	MODCPLX_VARIANT_V1F = 0,
+	MODCPLX_VARIANT_V4F = 1
+};
+
+static int modcplx_restore(struct fftset_fft *fft, const struct fftset *fc)
 {
+	const struct fftset_vec *inner = fft->next_compat;
+	const struct fftset_vec *stock = fft->next_stockham;
+
+	/* Both chains must compute the same transform. */
+	if (inner == NULL || stock == NULL || stock->vec_width != inner->vec_width || stock->lfft_div_radix * stock->radix != inner->lfft_div_radix * inner->radix)
+		return -1;
+	if (fft->main_twiddle_len != 0)
+		return -1;
+
+	/* All of the variants are built into the baseline kernels. */
+	(void)fc;
+
+	switch (fft->variant) {
 #if V4F_EXISTS
-	if (complex_len > 4 && (complex_len % 4) == 0) {
-		fft->next_compat = fastconv_get_inner_pass(veclist, alloc, complex_len / 4, 4);
-		if (fft->next_compat == NULL)
+	case MODCPLX_VARIANT_V4F:
+		if (fft->lfft <= 4 || (fft->lfft % 4) != 0 || inner->vec_width != 4 || inner->lfft_div_radix * inner->radix != fft->lfft / 4)
 			return -1;
-		fft->main_twiddle = NULL;
 		fft->get_kern     = modcplx_get_kernel_v4f;
 		fft->fwd          = modcplx_forward_v4f;
 		fft->inv          = modcplx_inverse_v4f;
 		fft->conv         = modcplx_conv_v4f;
-	}
-	else
+		fft->fwd_pair     = modcplx_forward_pair_v4f;
+		fft->fwd_spectrum = modcplx_forward_spectrum_v4f;
+		fft->conv_real    = modcplx_conv_real_v4f;
+		return 0;
 #endif
-	{
-		fft->next_compat = fastconv_get_inner_pass(veclist, alloc, complex_len, 1);
-		if (fft->next_compat == NULL)
+	case MODCPLX_VARIANT_V1F:
+		if (inner->vec_width != 1 || inner->lfft_div_radix * inner->radix != fft->lfft)
 			return -1;
-		fft->main_twiddle = NULL;
 		fft->get_kern     = modcplx_get_kernel_v1f;
 		fft->fwd          = modcplx_forward_v1f;
 		fft->inv          = modcplx_inverse_v1f;
 		fft->conv         = modcplx_conv_v1f;
+		fft->fwd_pair     = modcplx_forward_pair_v1f;
+		fft->fwd_spectrum = modcplx_forward_spectrum_v1f;
+		fft->conv_real    = modcplx_conv_real_v1f;
+		return 0;
+	default:
+		return -1;
 	}
+}
+
+static int modcplx_init(struct fftset_fft *fft, struct fftset *fc, size_t complex_len)
+{
+#if V4F_EXISTS
+	if (complex_len > 4 && (complex_len % 4) == 0) {
+		fft->next_compat   = fastconv_get_inner_pass(fc, complex_len / 4, 4, FFTSET_VEC_CHAIN_CONV);
+		fft->next_stockham = fastconv_get_inner_pass(fc, complex_len / 4, 4, FFTSET_VEC_CHAIN_STOCKHAM);
+		if (fft->next_compat == NULL || fft->next_stockham == NULL)
+			return -1;
+		fft->variant      = MODCPLX_VARIANT_V4F;
+	}
+	else
+#endif
+	{
+		fft->next_compat   = fastconv_get_inner_pass(fc, complex_len, 1, FFTSET_VEC_CHAIN_CONV);
+		fft->next_stockham = fastconv_get_inner_pass(fc, complex_len, 1, FFTSET_VEC_CHAIN_STOCKHAM);
+		if (fft->next_compat == NULL || fft->next_stockham == NULL)
+			return -1;
+		fft->variant      = MODCPLX_VARIANT_V1F;
+	}
+
+	fft->main_twiddle     = NULL;
+	fft->main_twiddle_len = 0;
+	fft->lfft             = complex_len;
 
-	return 0;
+	return modcplx_restore(fft, fc);
 }
 
 static const struct fftset_modulation FFTSET_MODULATION_COMPLEX_DEF =
 {   modcplx_init
+,   modcplx_restore
+,   FFTSET_MODULATION_ID_COMPLEX
 };
 
 const struct fftset_modulation *FFTSET_MODULATION_COMPLEX = &FFTSET_MODULATION_COMPLEX_DEF;
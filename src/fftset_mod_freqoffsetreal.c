@@ -24,39 +24,90 @@
 
 #include "fftset_modulation.h"
 #include "fftset_vec.h"
+#include "fftset_alloc.h"
+#include "fftset_kernels.h"
 #include "cop/cop_vec.h"
 #include <assert.h>
 #include <math.h>
 #include <string.h>
 
+/* Gives the end of the output window of a transform of fft_len complex
+ * values. */
+static size_t modfreqoffsetreal_window_end(size_t fft_len, size_t out_first, size_t out_count)
+{
+	assert(out_first < 2 * fft_len);
+	return (out_count < 2 * fft_len - out_first) ? out_first + out_count : 2 * fft_len;
+}
+
+/* Gives the blocks of block_len bins of a forward transform of fft_len bins
+ * which hold bins [out_first, out_first + out_count) and the window of the
+ * chain output of nb_elems elements which they are built from. Block i is
+ * built from element i and its mirror. */
+static void modfreqoffsetreal_forward_window(size_t fft_len, size_t block_len, size_t nb_elems, size_t out_first, size_t out_count, size_t *block_first, size_t *block_last, size_t *elem_first, size_t *elem_count)
+{
+	size_t out_end;
+	assert(out_first < fft_len);
+	out_end      = (out_count < fft_len - out_first) ? out_first + out_count : fft_len;
+	if (out_end == out_first) {
+		*block_first = 1;
+		*block_last  = 0;
+		*elem_first  = 0;
+		*elem_count  = 0;
+		return;
+	}
+	*block_first = out_first / block_len;
+	*block_last  = (out_end - 1) / block_len;
+	fftset_vec_window_mirrored(nb_elems, *block_first, *block_last, elem_first, elem_count);
+}
+
 #ifdef V4F_EXISTS
 #define VEC_V4F_WIDTH (4)
 
-#if V8F_EXISTS
-static void modfreqoffsetreal_forward_first_v8f(float *vo, const float *input, const float *coefs, unsigned fft_len)
+/* Loads the vector of input at offset and multiplies it by the analysis
+ * window (if there is one) at col + offset. */
+static COP_ATTR_ALWAYSINLINE v4f modfreqoffsetreal_ld(const float *input, const float *window, size_t col, size_t offset)
 {
-	const unsigned fft_len_4 = fft_len / 4;
-	unsigned i;
-	assert((fft_len % 32) == 0);
-
-	float *vec_output = vo;
+	v4f x = v4f_ld(input + offset);
+	return (window != NULL) ? v4f_mul(x, v4f_ld(window + col + offset)) : x;
+}
 
-	for (i = fft_len / 32
+/* The input is treated as 8 rows of fft_len / 4 values (4 rows of real
+ * parts followed by 4 rows of imaginary parts) which are transformed in
+ * blocks of 4 columns. Only the first nb_nonzero inputs may be non-zero:
+ * rows which only hold zeros are not loaded and blocks of columns which only
+ * hold zeros are not transformed (their outputs are zeroed). If window is
+ * not NULL, every input is multiplied by its coefficient as the rows are
+ * loaded. The output is multiplied by scale, which is folded into the
+ * twiddles as they are loaded. Returns the number of leading vectors of the
+ * output which may be non-zero. */
+static COP_ATTR_ALWAYSINLINE size_t modfreqoffsetreal_forward_first_body(float *vec_output, const float *input, const float *window, float scale, const float *coefs, size_t fft_len, size_t nb_nonzero)
+{
+	const size_t fft_len_4 = fft_len / 4;
+	const size_t nb_in     = (nb_nonzero < 2 * fft_len) ? nb_nonzero : 2 * fft_len;
+	const size_t nb_rows   = (nb_in + fft_len_4 - 1) / fft_len_4;
+	const size_t nb_cols   = (nb_in < fft_len_4) ? nb_in : fft_len_4;
+	const size_t nb_blocks = (nb_cols + 3) / 4;
+	const v4f    zero      = v4f_broadcast(0.0f);
+	const v4f    vscale    = v4f_broadcast(scale);
+	size_t i, col;
+	assert((fft_len % 16) == 0);
+	memset(vec_output + 32 * nb_blocks, 0, sizeof(float) * 32 * (fft_len / 16 - nb_blocks));
+	for (i = nb_blocks, col = 0
 		;i
-		;i--, coefs += 56, vec_output += 64, input += 4) {
-		v4f r1    = v4f_ld(input + 0*fft_len_4);
-		v4f r2    = v4f_ld(input + 1*fft_len_4);
-		v4f r3    = v4f_ld(input + 2*fft_len_4);
-		v4f r4    = v4f_ld(input + 3*fft_len_4);
-		v4f i1    = v4f_ld(input + 4*fft_len_4);
-		v4f i2    = v4f_ld(input + 5*fft_len_4);
-		v4f i3    = v4f_ld(input + 6*fft_len_4);
-		v4f i4    = v4f_ld(input + 7*fft_len_4);
-
-		v4f twr1  = v4f_ld(coefs + 0);
-		v4f twi1  = v4f_ld(coefs + 4);
-		v4f twr2  = v4f_ld(coefs + 8);
-		v4f twi2  = v4f_ld(coefs + 12);
+		;i--, coefs += 56, vec_output += 32, input += 4, col += 4) {
+		v4f r1    = modfreqoffsetreal_ld(input, window, col, 0*fft_len_4);
+		v4f r2    = (nb_rows > 1) ? modfreqoffsetreal_ld(input, window, col, 1*fft_len_4) : zero;
+		v4f r3    = (nb_rows > 2) ? modfreqoffsetreal_ld(input, window, col, 2*fft_len_4) : zero;
+		v4f r4    = (nb_rows > 3) ? modfreqoffsetreal_ld(input, window, col, 3*fft_len_4) : zero;
+		v4f i1    = (nb_rows > 4) ? modfreqoffsetreal_ld(input, window, col, 4*fft_len_4) : zero;
+		v4f i2    = (nb_rows > 5) ? modfreqoffsetreal_ld(input, window, col, 5*fft_len_4) : zero;
+		v4f i3    = (nb_rows > 6) ? modfreqoffsetreal_ld(input, window, col, 6*fft_len_4) : zero;
+		v4f i4    = (nb_rows > 7) ? modfreqoffsetreal_ld(input, window, col, 7*fft_len_4) : zero;
+
+		v4f twr1  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 0), vscale) : v4f_ld(coefs + 0);
+		v4f twi1  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 4), vscale) : v4f_ld(coefs + 4);
+		v4f twr2  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 8), vscale) : v4f_ld(coefs + 8);
+		v4f twi2  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 12), vscale) : v4f_ld(coefs + 12);
 		v4f or1a  = v4f_mul(twr1, r1);
 		v4f or1b  = v4f_mul(twi1, i1);
 		v4f oi1a  = v4f_mul(twi1, r1);
@@ -69,10 +120,10 @@ static void modfreqoffsetreal_forward_first_v8f(float *vo, const float *input, c
 		v4f oi1   = v4f_sub(oi1a, oi1b);
 		v4f or2   = v4f_add(or2a, or2b);
 		v4f oi2   = v4f_sub(oi2a, oi2b);
-		v4f twr3  = v4f_ld(coefs + 16);
-		v4f twi3  = v4f_ld(coefs + 20);
-		v4f twr4  = v4f_ld(coefs + 24);
-		v4f twi4  = v4f_ld(coefs + 28);
+		v4f twr3  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 16), vscale) : v4f_ld(coefs + 16);
+		v4f twi3  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 20), vscale) : v4f_ld(coefs + 20);
+		v4f twr4  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 24), vscale) : v4f_ld(coefs + 24);
+		v4f twi4  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 28), vscale) : v4f_ld(coefs + 28);
 		v4f or3a  = v4f_mul(twr3, r3);
 		v4f or3b  = v4f_mul(twi3, i3);
 		v4f oi3a  = v4f_mul(twi3, r3);
@@ -133,573 +184,94 @@ static void modfreqoffsetreal_forward_first_v8f(float *vo, const float *input, c
 
 		v4f_st(vec_output + 0,  mor0);
 		v4f_st(vec_output + 4,  moi0);
-		v4f_st(vec_output + 16, tor1);
-		v4f_st(vec_output + 20, toi1);
-		v4f_st(vec_output + 32, tor2);
-		v4f_st(vec_output + 36, toi2);
-		v4f_st(vec_output + 48, tor3);
-		v4f_st(vec_output + 52, toi3);
-	}
-
-	vec_output = vo;
-
-	for (i = fft_len / 32
-		;i
-		;i--, coefs += 56, vec_output += 64, input += 4) {
-		v4f r1    = v4f_ld(input + 0*fft_len_4);
-		v4f r2    = v4f_ld(input + 1*fft_len_4);
-		v4f r3    = v4f_ld(input + 2*fft_len_4);
-		v4f r4    = v4f_ld(input + 3*fft_len_4);
-		v4f i1    = v4f_ld(input + 4*fft_len_4);
-		v4f i2    = v4f_ld(input + 5*fft_len_4);
-		v4f i3    = v4f_ld(input + 6*fft_len_4);
-		v4f i4    = v4f_ld(input + 7*fft_len_4);
-
-		v4f twr1  = v4f_ld(coefs + 0);
-		v4f twi1  = v4f_ld(coefs + 4);
-		v4f twr2  = v4f_ld(coefs + 8);
-		v4f twi2  = v4f_ld(coefs + 12);
-		v4f or1a  = v4f_mul(twr1, r1);
-		v4f or1b  = v4f_mul(twi1, i1);
-		v4f oi1a  = v4f_mul(twi1, r1);
-		v4f oi1b  = v4f_mul(twr1, i1);
-		v4f or2a  = v4f_mul(twr2, r2);
-		v4f or2b  = v4f_mul(twi2, i2);
-		v4f oi2a  = v4f_mul(twi2, r2);
-		v4f oi2b  = v4f_mul(twr2, i2);
-		v4f or1   = v4f_add(or1a, or1b);
-		v4f oi1   = v4f_sub(oi1a, oi1b);
-		v4f or2   = v4f_add(or2a, or2b);
-		v4f oi2   = v4f_sub(oi2a, oi2b);
-		v4f twr3  = v4f_ld(coefs + 16);
-		v4f twi3  = v4f_ld(coefs + 20);
-		v4f twr4  = v4f_ld(coefs + 24);
-		v4f twi4  = v4f_ld(coefs + 28);
-		v4f or3a  = v4f_mul(twr3, r3);
-		v4f or3b  = v4f_mul(twi3, i3);
-		v4f oi3a  = v4f_mul(twi3, r3);
-		v4f oi3b  = v4f_mul(twr3, i3);
-		v4f or4a  = v4f_mul(twr4, r4);
-		v4f or4b  = v4f_mul(twi4, i4);
-		v4f oi4a  = v4f_mul(twi4, r4);
-		v4f oi4b  = v4f_mul(twr4, i4);
-		v4f or3   = v4f_add(or3a, or3b);
-		v4f oi3   = v4f_sub(oi3a, oi3b);
-		v4f or4   = v4f_add(or4a, or4b);
-		v4f oi4   = v4f_sub(oi4a, oi4b);
-
-		v4f t0ra  = v4f_add(or1, or3);
-		v4f t0rs  = v4f_sub(or1, or3);
-		v4f t1ra  = v4f_add(or2, or4);
-		v4f t1rs  = v4f_sub(or2, or4);
-		v4f t1is  = v4f_sub(oi2, oi4);
-		v4f t1ia  = v4f_add(oi2, oi4);
-		v4f t0is  = v4f_sub(oi1, oi3);
-		v4f t0ia  = v4f_add(oi1, oi3);
-		v4f mor0  = v4f_add(t0ra, t1ra);
-		v4f mor2  = v4f_sub(t0ra, t1ra);
-		v4f mor1  = v4f_add(t0rs, t1is);
-		v4f mor3  = v4f_sub(t0rs, t1is);
-		v4f moi1  = v4f_sub(t0is, t1rs);
-		v4f moi3  = v4f_add(t0is, t1rs);
-		v4f moi0  = v4f_add(t0ia, t1ia);
-		v4f moi2  = v4f_sub(t0ia, t1ia);
-
-		v4f ptwr1 = v4f_ld(coefs + 32);
-		v4f ptwi1 = v4f_ld(coefs + 36);
-		v4f ptwr2 = v4f_ld(coefs + 40);
-		v4f ptwi2 = v4f_ld(coefs + 44);
-		v4f ptwr3 = v4f_ld(coefs + 48);
-		v4f ptwi3 = v4f_ld(coefs + 52);
-		v4f tor1a = v4f_mul(mor1, ptwr1);
-		v4f toi1a = v4f_mul(mor1, ptwi1);
-		v4f tor1b = v4f_mul(moi1, ptwi1);
-		v4f toi1b = v4f_mul(moi1, ptwr1);
-		v4f tor2a = v4f_mul(mor2, ptwr2);
-		v4f toi2a = v4f_mul(mor2, ptwi2);
-		v4f tor2b = v4f_mul(moi2, ptwi2);
-		v4f toi2b = v4f_mul(moi2, ptwr2);
-		v4f tor3a = v4f_mul(mor3, ptwr3);
-		v4f toi3a = v4f_mul(mor3, ptwi3);
-		v4f tor3b = v4f_mul(moi3, ptwi3);
-		v4f toi3b = v4f_mul(moi3, ptwr3);
-		v4f tor1  = v4f_sub(tor1a, tor1b);
-		v4f toi1  = v4f_add(toi1a, toi1b);
-		v4f tor2  = v4f_sub(tor2a, tor2b);
-		v4f toi2  = v4f_add(toi2a, toi2b);
-		v4f tor3  = v4f_sub(tor3a, tor3b);
-		v4f toi3  = v4f_add(toi3a, toi3b);
-
-		V4F_TRANSPOSE_INPLACE(mor0, tor1, tor2, tor3);
-		V4F_TRANSPOSE_INPLACE(moi0, toi1, toi2, toi3);
-
-		v4f_st(vec_output + 8,  mor0);
-		v4f_st(vec_output + 12, moi0);
-		v4f_st(vec_output + 24, tor1);
-		v4f_st(vec_output + 28, toi1);
-		v4f_st(vec_output + 40, tor2);
-		v4f_st(vec_output + 44, toi2);
-		v4f_st(vec_output + 56, tor3);
-		v4f_st(vec_output + 60, toi3);
-	}
-
-	vec_output = vo;
-
-	for (i = 0
-		;i < fft_len / 8
-		;i++, vec_output += 16, coefs += 2) {
-		v4f r0, i0, r1, i1;
-		v4f twr, twi;
-		v4f r2, i2, r3, i3;
-		v4f or0, or1, oi0, oi1;
-		v4f xr1, xi1;
-		V4F_LD2(r0, i0, vec_output);
-		V4F_LD2(r1, i1, vec_output + 8);
-		twr = v4f_broadcast(coefs[0]);
-		twi = v4f_broadcast(coefs[1]);
-		xr1 = v4f_sub(r0, r1);
-		xi1 = v4f_sub(i0, i1);
-		or0 = v4f_add(r0, r1);
-		oi0 = v4f_add(i0, i1);
-		r2  = v4f_mul(xr1, twr);
-		i2  = v4f_mul(xi1, twr);
-		r3  = v4f_mul(xi1, twi);
-		i3  = v4f_mul(xr1, twi);
-		or1 = v4f_sub(r2, r3);
-		oi1 = v4f_add(i2, i3);
-		V4F_ST2(vec_output,     or0, or1);
-		V4F_ST2(vec_output + 8, oi0, oi1);
+		v4f_st(vec_output + 8,  tor1);
+		v4f_st(vec_output + 12, toi1);
+		v4f_st(vec_output + 16, tor2);
+		v4f_st(vec_output + 20, toi2);
+		v4f_st(vec_output + 24, tor3);
+		v4f_st(vec_output + 28, toi3);
 	}
+	return nb_cols;
 }
 
-static void modfreqoffsetreal_inverse_final_v8f(float *output, const float *vi, const float *coefs, unsigned fft_len)
+static size_t modfreqoffsetreal_forward_first(float *vec_output, const float *input, const float *coefs, size_t fft_len, size_t nb_nonzero)
 {
-	const unsigned fft_len_8 = fft_len / 8;
-	const unsigned fft_len_4 = fft_len / 4;
-	unsigned i;
-	const float *vec_input = vi;
-	float *vec_output = output;
-	const float *tp = coefs + 56 * fft_len / 16;
-
-	assert((fft_len % 32) == 0);
-
-	for (i = 0
-		;i < fft_len / 32
-		;i++, vec_input += 64, vec_output += 4, tp += 8) {
-		v4f r0, i0, r1, i1;
-		v4f twr0, twi0;
-		v4f twr1, twi1;
-		v4f r2, i2, r3, i3;
-		v4f or0, or1, oi0, oi1;
-		v4f or2, or3, oi2, oi3;
-
-		V4F_LD2(or0, or1, vec_input);
-		V4F_LD2(oi0, oi1, vec_input + 8);
-		V4F_LD2(or2, or3, vec_input + 16);
-		V4F_LD2(oi2, oi3, vec_input + 24);
-		twr0 = v4f_broadcast(tp[0]);
-		twi0 = v4f_broadcast(tp[1]);
-		twr1 = v4f_broadcast(tp[2]);
-		twi1 = v4f_broadcast(tp[3]);
-		r0  = v4f_mul(or1, twr0);
-		i0  = v4f_mul(oi1, twr0);
-		r1  = v4f_mul(oi1, twi0);
-		i1  = v4f_mul(or1, twi0);
-		r2  = v4f_mul(or3, twr1);
-		i2  = v4f_mul(oi3, twr1);
-		r3  = v4f_mul(oi3, twi1);
-		i3  = v4f_mul(or3, twi1);
-		or1 = v4f_sub(r0, r1);
-		oi1 = v4f_add(i0, i1);
-		or3 = v4f_sub(r2, r3);
-		oi3 = v4f_add(i2, i3);
-		r0  = v4f_add(or0, or1);
-		i0  = v4f_add(oi0, oi1);
-		r1  = v4f_sub(or0, or1);
-		i1  = v4f_sub(oi0, oi1);
-		r2  = v4f_add(or2, or3);
-		i2  = v4f_add(oi2, oi3);
-		r3  = v4f_sub(or2, or3);
-		i3  = v4f_sub(oi2, oi3);
-		v4f_st(vec_output + 0*fft_len_8, r0);
-		v4f_st(vec_output + 1*fft_len_8, r1);
-		v4f_st(vec_output + 2*fft_len_8, i0);
-		v4f_st(vec_output + 3*fft_len_8, i1);
-		v4f_st(vec_output + 4*fft_len_8, r2);
-		v4f_st(vec_output + 5*fft_len_8, r3);
-		v4f_st(vec_output + 6*fft_len_8, i2);
-		v4f_st(vec_output + 7*fft_len_8, i3);
-
-		V4F_LD2(or0, or1, vec_input + 32);
-		V4F_LD2(oi0, oi1, vec_input + 40);
-		V4F_LD2(or2, or3, vec_input + 48);
-		V4F_LD2(oi2, oi3, vec_input + 56);
-		twr0 = v4f_broadcast(tp[4]);
-		twi0 = v4f_broadcast(tp[5]);
-		twr1 = v4f_broadcast(tp[6]);
-		twi1 = v4f_broadcast(tp[7]);
-		r0  = v4f_mul(or1, twr0);
-		i0  = v4f_mul(oi1, twr0);
-		r1  = v4f_mul(oi1, twi0);
-		i1  = v4f_mul(or1, twi0);
-		r2  = v4f_mul(or3, twr1);
-		i2  = v4f_mul(oi3, twr1);
-		r3  = v4f_mul(oi3, twi1);
-		i3  = v4f_mul(or3, twi1);
-		or1 = v4f_sub(r0, r1);
-		oi1 = v4f_add(i0, i1);
-		or3 = v4f_sub(r2, r3);
-		oi3 = v4f_add(i2, i3);
-		r0  = v4f_add(or0, or1);
-		i0  = v4f_add(oi0, oi1);
-		r1  = v4f_sub(or0, or1);
-		i1  = v4f_sub(oi0, oi1);
-		r2  = v4f_add(or2, or3);
-		i2  = v4f_add(oi2, oi3);
-		r3  = v4f_sub(or2, or3);
-		i3  = v4f_sub(oi2, oi3);
-		v4f_st(vec_output + 8*fft_len_8, r0);
-		v4f_st(vec_output + 9*fft_len_8, r1);
-		v4f_st(vec_output + 10*fft_len_8, i0);
-		v4f_st(vec_output + 11*fft_len_8, i1);
-		v4f_st(vec_output + 12*fft_len_8, r2);
-		v4f_st(vec_output + 13*fft_len_8, r3);
-		v4f_st(vec_output + 14*fft_len_8, i2);
-		v4f_st(vec_output + 15*fft_len_8, i3);
-	}
-
-	for (i = fft_len / 16
-		;i
-		;i--, coefs += 56, output += 4) {
-		v4f r0   = v4f_ld(output + 0*fft_len_4);
-		v4f i0   = v4f_ld(output + 1*fft_len_4);
-		v4f r1   = v4f_ld(output + 2*fft_len_4);
-		v4f i1   = v4f_ld(output + 3*fft_len_4);
-		v4f r2   = v4f_ld(output + 4*fft_len_4);
-		v4f i2   = v4f_ld(output + 5*fft_len_4);
-		v4f r3   = v4f_ld(output + 6*fft_len_4);
-		v4f i3   = v4f_ld(output + 7*fft_len_4);
-		V4F_TRANSPOSE_INPLACE(r0, r1, r2, r3);
-		V4F_TRANSPOSE_INPLACE(i0, i1, i2, i3);
-		{
-			v4f ptwr1 = v4f_ld(coefs + 32);
-			v4f ptwi1 = v4f_ld(coefs + 36);
-			v4f ptwr2 = v4f_ld(coefs + 40);
-			v4f ptwi2 = v4f_ld(coefs + 44);
-			v4f ptwr3 = v4f_ld(coefs + 48);
-			v4f ptwi3 = v4f_ld(coefs + 52);
-			v4f tor1a = v4f_mul(r1, ptwr1);
-			v4f toi1a = v4f_mul(r1, ptwi1);
-			v4f tor1b = v4f_mul(i1, ptwi1);
-			v4f toi1b = v4f_mul(i1, ptwr1);
-			v4f tor2a = v4f_mul(r2, ptwr2);
-			v4f toi2a = v4f_mul(r2, ptwi2);
-			v4f tor2b = v4f_mul(i2, ptwi2);
-			v4f toi2b = v4f_mul(i2, ptwr2);
-			v4f tor3a = v4f_mul(r3, ptwr3);
-			v4f toi3a = v4f_mul(r3, ptwi3);
-			v4f tor3b = v4f_mul(i3, ptwi3);
-			v4f toi3b = v4f_mul(i3, ptwr3);
-			v4f tor1  = v4f_sub(tor1a, tor1b);
-			v4f toi1  = v4f_add(toi1a, toi1b);
-			v4f tor2  = v4f_sub(tor2a, tor2b);
-			v4f toi2  = v4f_add(toi2a, toi2b);
-			v4f tor3  = v4f_sub(tor3a, tor3b);
-			v4f toi3  = v4f_add(toi3a, toi3b);
-
-			v4f t0ra  = v4f_add(r0,   tor2);
-			v4f t0rs  = v4f_sub(r0,   tor2);
-			v4f t1ra  = v4f_add(tor1, tor3);
-			v4f t1rs  = v4f_sub(tor1, tor3);
-			v4f t1is  = v4f_sub(toi1, toi3);
-			v4f t1ia  = v4f_add(toi1, toi3);
-			v4f t0is  = v4f_sub(i0,   toi2);
-			v4f t0ia  = v4f_add(i0,   toi2);
-			v4f mor0  = v4f_add(t0ra, t1ra);
-			v4f mor2  = v4f_sub(t0ra, t1ra);
-			v4f mor1  = v4f_add(t0rs, t1is);
-			v4f mor3  = v4f_sub(t0rs, t1is);
-			v4f moi1  = v4f_sub(t0is, t1rs);
-			v4f moi3  = v4f_add(t0is, t1rs);
-			v4f moi0  = v4f_add(t0ia, t1ia);
-			v4f moi2  = v4f_sub(t0ia, t1ia);
-
-			v4f twr1  = v4f_ld(coefs + 0);
-			v4f twi1  = v4f_ld(coefs + 4);
-			v4f twr2  = v4f_ld(coefs + 8);
-			v4f twi2  = v4f_ld(coefs + 12);
-			v4f or0a  = v4f_mul(twr1, mor0);
-			v4f or0b  = v4f_mul(twi1, moi0);
-			v4f oi0a  = v4f_mul(twi1, mor0);
-			v4f oi0b  = v4f_mul(twr1, moi0);
-			v4f or1a  = v4f_mul(twr2, mor1);
-			v4f or1b  = v4f_mul(twi2, moi1);
-			v4f oi1a  = v4f_mul(twi2, mor1);
-			v4f oi1b  = v4f_mul(twr2, moi1);
-			v4f or0   = v4f_sub(or0a, or0b);
-			v4f oi0   = v4f_add(oi0a, oi0b);
-			v4f or1   = v4f_sub(or1a, or1b);
-			v4f oi1   = v4f_add(oi1a, oi1b);
-			v4f twr3  = v4f_ld(coefs + 16);
-			v4f twi3  = v4f_ld(coefs + 20);
-			v4f twr4  = v4f_ld(coefs + 24);
-			v4f twi4  = v4f_ld(coefs + 28);
-			v4f or2a  = v4f_mul(twr3, mor2);
-			v4f or2b  = v4f_mul(twi3, moi2);
-			v4f oi2a  = v4f_mul(twi3, mor2);
-			v4f oi2b  = v4f_mul(twr3, moi2);
-			v4f or3a  = v4f_mul(twr4, mor3);
-			v4f or3b  = v4f_mul(twi4, moi3);
-			v4f oi3a  = v4f_mul(twi4, mor3);
-			v4f oi3b  = v4f_mul(twr4, moi3);
-			v4f or2   = v4f_sub(or2a, or2b);
-			v4f oi2   = v4f_add(oi2a, oi2b);
-			v4f or3   = v4f_sub(or3a, or3b);
-			v4f oi3   = v4f_add(oi3a, oi3b);
-
-			v4f_st(output + 0*fft_len_4, or0);
-			v4f_st(output + 1*fft_len_4, or1);
-			v4f_st(output + 2*fft_len_4, or2);
-			v4f_st(output + 3*fft_len_4, or3);
-			v4f_st(output + 4*fft_len_4, oi0);
-			v4f_st(output + 5*fft_len_4, oi1);
-			v4f_st(output + 6*fft_len_4, oi2);
-			v4f_st(output + 7*fft_len_4, oi3);
-		}
-	}
+	return modfreqoffsetreal_forward_first_body(vec_output, input, NULL, 1.0f, coefs, fft_len, nb_nonzero);
 }
 
-static
-void
-modfreqoffsetreal_get_kernel_v8f
-	(const struct fftset_fft    *first_pass
-	,float                      *output_buf
-	,const float                *input_buf
-	)
+static size_t modfreqoffsetreal_forward_first_windowed(float *vec_output, const float *input, const float *window, const float *coefs, size_t fft_len, size_t nb_nonzero)
 {
-	modfreqoffsetreal_forward_first_v8f(output_buf, input_buf, first_pass->main_twiddle, first_pass->lfft);
-	fftset_vec_kern(first_pass->next_compat, 1, output_buf);
+	return modfreqoffsetreal_forward_first_body(vec_output, input, window, 1.0f, coefs, fft_len, nb_nonzero);
 }
 
-static
-void
-modfreqoffsetreal_conv_v8f
-	(const struct fftset_fft *first_pass
-	,float                      *output_buf
-	,const float                *input_buf
-	,const float                *kernel_buf
-	,float                      *work_buf
-	)
+static size_t modfreqoffsetreal_forward_first_scaled(float *vec_output, const float *input, float scale, const float *coefs, size_t fft_len, size_t nb_nonzero)
 {
-	modfreqoffsetreal_forward_first_v8f(work_buf, input_buf, first_pass->main_twiddle, first_pass->lfft);
-	fftset_vec_conv(first_pass->next_compat, 1, work_buf, kernel_buf);
-	modfreqoffsetreal_inverse_final_v8f(output_buf, work_buf, first_pass->main_twiddle, first_pass->lfft);
+	return modfreqoffsetreal_forward_first_body(vec_output, input, NULL, scale, coefs, fft_len, nb_nonzero);
 }
 
-static
-void
-modfreqoffsetreal_forward_v8f
-	(const struct fftset_fft *first_pass
-	,float                      *output_buf
-	,const float                *input_buf
-	,float                      *work_buf
-	)
+/* Gives the window of the vectors given to the inverse final pass (column c
+ * of every row of fft_len / 4 outputs comes from vector c) which is needed
+ * for outputs [out_first, out_end). */
+static void modfreqoffsetreal_window_cols(size_t fft_len, size_t out_first, size_t out_end, size_t *col_first, size_t *col_count)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
-
-	modfreqoffsetreal_forward_first_v8f(work_buf, input_buf, first_pass->main_twiddle, lfft);
-
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
-
-	if (input_buf != work_buf) {
-		assert(input_buf == output_buf);
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-	}
-
-	for (i = 0; i < lfft / 16; i++) {
-		v8f w, x, y, z;
-		v8f a, b, c, d;
-		V8F_LD2(w, x, work_buf + i*16);
-		V8F_LD2(y, z, work_buf + lfft*2 - 16 - i*16);
-		y = v8f_reverse(y);
-		z = v8f_reverse(z);
-		z = v8f_neg(z);
-		V8F_INTERLEAVE(a, b, w, y);
-		V8F_INTERLEAVE(c, d, x, z);
-		V8F_ST2X2INT(output_buf + i*32, output_buf + i*32 + 16, a, c, b, d);
-	}
+	fftset_vec_window_cols(fft_len / 4, out_first, out_end - out_first, col_first, col_count);
 }
 
-static
-void
-modfreqoffsetreal_inverse_v8f
-	(const struct fftset_fft    *first_pass
-	,float                      *output_buf
-	,const float                *input_buf
-	,float                      *work_buf
-	)
+/* Non-zero if any of the four outputs starting at pos are in the window. */
+static COP_ATTR_ALWAYSINLINE int modfreqoffsetreal_in_window(size_t pos, size_t out_first, size_t out_end)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
-
-	for (i = 0; i < lfft / 16; i++) {
-		v8f w, x, y, z;
-		v8f a, b, c, d;
-		V8F_LD2X2DINT(a, c, b, d, input_buf + i*32, input_buf + i*32 + 16);
-		V8F_DEINTERLEAVE(w, y, a, b);
-		V8F_DEINTERLEAVE(x, z, c, d);
-		x = v8f_neg(x);
-		y = v8f_reverse(y);
-		z = v8f_reverse(z);
-		V8F_ST2(work_buf + i*16,               w, x);
-		V8F_ST2(work_buf + lfft*2 - 16 - i*16, y, z);
-	}
-
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
-
-	if (input_buf == work_buf) {
-		modfreqoffsetreal_inverse_final_v8f(output_buf, work_buf, first_pass->main_twiddle, lfft);
-	} else {
-		assert(input_buf == output_buf);
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-		modfreqoffsetreal_inverse_final_v8f(output_buf, work_buf, first_pass->main_twiddle, lfft);
-	}
+	return pos < out_end && pos + 4 > out_first;
 }
 
-#endif
-
-static void modfreqoffsetreal_forward_first(float *vec_output, const float *input, const float *coefs, unsigned fft_len)
+/* Stores x to output + offset or, if there is a synthesis window, adds x
+ * multiplied by the window coefficients at offset to the output. */
+static COP_ATTR_ALWAYSINLINE void modfreqoffsetreal_st(float *output, const float *window, size_t offset, v4f x)
 {
-	const unsigned fft_len_4 = fft_len / 4;
-	unsigned i;
-	assert((fft_len % 16) == 0);
-	for (i = fft_len / 16
-		;i
-		;i--, coefs += 56, vec_output += 32, input += 4) {
-		v4f r1    = v4f_ld(input + 0*fft_len_4);
-		v4f r2    = v4f_ld(input + 1*fft_len_4);
-		v4f r3    = v4f_ld(input + 2*fft_len_4);
-		v4f r4    = v4f_ld(input + 3*fft_len_4);
-		v4f i1    = v4f_ld(input + 4*fft_len_4);
-		v4f i2    = v4f_ld(input + 5*fft_len_4);
-		v4f i3    = v4f_ld(input + 6*fft_len_4);
-		v4f i4    = v4f_ld(input + 7*fft_len_4);
-
-		v4f twr1  = v4f_ld(coefs + 0);
-		v4f twi1  = v4f_ld(coefs + 4);
-		v4f twr2  = v4f_ld(coefs + 8);
-		v4f twi2  = v4f_ld(coefs + 12);
-		v4f or1a  = v4f_mul(twr1, r1);
-		v4f or1b  = v4f_mul(twi1, i1);
-		v4f oi1a  = v4f_mul(twi1, r1);
-		v4f oi1b  = v4f_mul(twr1, i1);
-		v4f or2a  = v4f_mul(twr2, r2);
-		v4f or2b  = v4f_mul(twi2, i2);
-		v4f oi2a  = v4f_mul(twi2, r2);
-		v4f oi2b  = v4f_mul(twr2, i2);
-		v4f or1   = v4f_add(or1a, or1b);
-		v4f oi1   = v4f_sub(oi1a, oi1b);
-		v4f or2   = v4f_add(or2a, or2b);
-		v4f oi2   = v4f_sub(oi2a, oi2b);
-		v4f twr3  = v4f_ld(coefs + 16);
-		v4f twi3  = v4f_ld(coefs + 20);
-		v4f twr4  = v4f_ld(coefs + 24);
-		v4f twi4  = v4f_ld(coefs + 28);
-		v4f or3a  = v4f_mul(twr3, r3);
-		v4f or3b  = v4f_mul(twi3, i3);
-		v4f oi3a  = v4f_mul(twi3, r3);
-		v4f oi3b  = v4f_mul(twr3, i3);
-		v4f or4a  = v4f_mul(twr4, r4);
-		v4f or4b  = v4f_mul(twi4, i4);
-		v4f oi4a  = v4f_mul(twi4, r4);
-		v4f oi4b  = v4f_mul(twr4, i4);
-		v4f or3   = v4f_add(or3a, or3b);
-		v4f oi3   = v4f_sub(oi3a, oi3b);
-		v4f or4   = v4f_add(or4a, or4b);
-		v4f oi4   = v4f_sub(oi4a, oi4b);
-
-		v4f t0ra  = v4f_add(or1, or3);
-		v4f t0rs  = v4f_sub(or1, or3);
-		v4f t1ra  = v4f_add(or2, or4);
-		v4f t1rs  = v4f_sub(or2, or4);
-		v4f t1is  = v4f_sub(oi2, oi4);
-		v4f t1ia  = v4f_add(oi2, oi4);
-		v4f t0is  = v4f_sub(oi1, oi3);
-		v4f t0ia  = v4f_add(oi1, oi3);
-		v4f mor0  = v4f_add(t0ra, t1ra);
-		v4f mor2  = v4f_sub(t0ra, t1ra);
-		v4f mor1  = v4f_add(t0rs, t1is);
-		v4f mor3  = v4f_sub(t0rs, t1is);
-		v4f moi1  = v4f_sub(t0is, t1rs);
-		v4f moi3  = v4f_add(t0is, t1rs);
-		v4f moi0  = v4f_add(t0ia, t1ia);
-		v4f moi2  = v4f_sub(t0ia, t1ia);
-
-		v4f ptwr1 = v4f_ld(coefs + 32);
-		v4f ptwi1 = v4f_ld(coefs + 36);
-		v4f ptwr2 = v4f_ld(coefs + 40);
-		v4f ptwi2 = v4f_ld(coefs + 44);
-		v4f ptwr3 = v4f_ld(coefs + 48);
-		v4f ptwi3 = v4f_ld(coefs + 52);
-		v4f tor1a = v4f_mul(mor1, ptwr1);
-		v4f toi1a = v4f_mul(mor1, ptwi1);
-		v4f tor1b = v4f_mul(moi1, ptwi1);
-		v4f toi1b = v4f_mul(moi1, ptwr1);
-		v4f tor2a = v4f_mul(mor2, ptwr2);
-		v4f toi2a = v4f_mul(mor2, ptwi2);
-		v4f tor2b = v4f_mul(moi2, ptwi2);
-		v4f toi2b = v4f_mul(moi2, ptwr2);
-		v4f tor3a = v4f_mul(mor3, ptwr3);
-		v4f toi3a = v4f_mul(mor3, ptwi3);
-		v4f tor3b = v4f_mul(moi3, ptwi3);
-		v4f toi3b = v4f_mul(moi3, ptwr3);
-		v4f tor1  = v4f_sub(tor1a, tor1b);
-		v4f toi1  = v4f_add(toi1a, toi1b);
-		v4f tor2  = v4f_sub(tor2a, tor2b);
-		v4f toi2  = v4f_add(toi2a, toi2b);
-		v4f tor3  = v4f_sub(tor3a, tor3b);
-		v4f toi3  = v4f_add(toi3a, toi3b);
-
-		V4F_TRANSPOSE_INPLACE(mor0, tor1, tor2, tor3);
-		V4F_TRANSPOSE_INPLACE(moi0, toi1, toi2, toi3);
-
-		v4f_st(vec_output + 0,  mor0);
-		v4f_st(vec_output + 4,  moi0);
-		v4f_st(vec_output + 8,  tor1);
-		v4f_st(vec_output + 12, toi1);
-		v4f_st(vec_output + 16, tor2);
-		v4f_st(vec_output + 20, toi2);
-		v4f_st(vec_output + 24, tor3);
-		v4f_st(vec_output + 28, toi3);
-	}
+	if (window != NULL)
+		x = v4f_add(v4f_ld(output + offset), v4f_mul(x, v4f_ld(window + offset)));
+	v4f_st(output + offset, x);
 }
 
-static void modfreqoffsetreal_inverse_final(float *output, const float *vec_input, const float *coefs, unsigned fft_len)
+/* Only the blocks of four columns which hold outputs in [out_first, out_end)
+ * are computed and only the rows of the blocks which hold them are stored
+ * (or accumulated if window is not NULL). The outputs are multiplied by
+ * scale, which is folded into the twiddles of the modulation as they are
+ * loaded. */
+static COP_ATTR_ALWAYSINLINE void modfreqoffsetreal_inverse_final_body(float *output, const float *vec_input, const float *window, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
 {
-	const unsigned fft_len_4 = fft_len / 4;
-	unsigned i;
+	const size_t fft_len_4 = fft_len / 4;
+	const size_t nb_blocks = fft_len / 16;
+	const v4f    vscale    = v4f_broadcast(scale);
+	size_t col_first, col_count, i, b;
 	assert((fft_len % 16) == 0);
-	for (i = fft_len / 16
+	modfreqoffsetreal_window_cols(fft_len, out_first, out_end, &col_first, &col_count);
+	b = col_first / 4;
+	i = (col_first + col_count + 3) / 4 - b;
+	if (i > nb_blocks)
+		i = nb_blocks;
+	for (
 		;i
-		;i--, vec_input += 32, coefs += 56, output += 4) {
-		v4f r0   = v4f_ld(vec_input + 0);
-		v4f i0   = v4f_ld(vec_input + 4);
-		v4f r1   = v4f_ld(vec_input + 8);
-		v4f i1   = v4f_ld(vec_input + 12);
-		v4f r2   = v4f_ld(vec_input + 16);
-		v4f i2   = v4f_ld(vec_input + 20);
-		v4f r3   = v4f_ld(vec_input + 24);
-		v4f i3   = v4f_ld(vec_input + 28);
+		;i--, b = (b + 1 < nb_blocks) ? b + 1 : 0) {
+		const float *vi  = vec_input + 32 * b;
+		const float *tw  = coefs + 56 * b;
+		const size_t pos = 4 * b;
+		v4f r0   = v4f_ld(vi + 0);
+		v4f i0   = v4f_ld(vi + 4);
+		v4f r1   = v4f_ld(vi + 8);
+		v4f i1   = v4f_ld(vi + 12);
+		v4f r2   = v4f_ld(vi + 16);
+		v4f i2   = v4f_ld(vi + 20);
+		v4f r3   = v4f_ld(vi + 24);
+		v4f i3   = v4f_ld(vi + 28);
 		V4F_TRANSPOSE_INPLACE(r0, r1, r2, r3);
 		V4F_TRANSPOSE_INPLACE(i0, i1, i2, i3);
 		{
-			v4f ptwr1 = v4f_ld(coefs + 32);
-			v4f ptwi1 = v4f_ld(coefs + 36);
-			v4f ptwr2 = v4f_ld(coefs + 40);
-			v4f ptwi2 = v4f_ld(coefs + 44);
-			v4f ptwr3 = v4f_ld(coefs + 48);
-			v4f ptwi3 = v4f_ld(coefs + 52);
+			v4f ptwr1 = v4f_ld(tw + 32);
+			v4f ptwi1 = v4f_ld(tw + 36);
+			v4f ptwr2 = v4f_ld(tw + 40);
+			v4f ptwi2 = v4f_ld(tw + 44);
+			v4f ptwr3 = v4f_ld(tw + 48);
+			v4f ptwi3 = v4f_ld(tw + 52);
 			v4f tor1a = v4f_mul(r1, ptwr1);
 			v4f toi1a = v4f_mul(r1, ptwi1);
 			v4f tor1b = v4f_mul(i1, ptwi1);
@@ -736,10 +308,10 @@ static void modfreqoffsetreal_inverse_final(float *output, const float *vec_inpu
 			v4f moi0  = v4f_add(t0ia, t1ia);
 			v4f moi2  = v4f_sub(t0ia, t1ia);
 
-			v4f twr1  = v4f_ld(coefs + 0);
-			v4f twi1  = v4f_ld(coefs + 4);
-			v4f twr2  = v4f_ld(coefs + 8);
-			v4f twi2  = v4f_ld(coefs + 12);
+			v4f twr1  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 0), vscale) : v4f_ld(tw + 0);
+			v4f twi1  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 4), vscale) : v4f_ld(tw + 4);
+			v4f twr2  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 8), vscale) : v4f_ld(tw + 8);
+			v4f twi2  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 12), vscale) : v4f_ld(tw + 12);
 			v4f or0a  = v4f_mul(twr1, mor0);
 			v4f or0b  = v4f_mul(twi1, moi0);
 			v4f oi0a  = v4f_mul(twi1, mor0);
@@ -752,10 +324,10 @@ static void modfreqoffsetreal_inverse_final(float *output, const float *vec_inpu
 			v4f oi0   = v4f_add(oi0a, oi0b);
 			v4f or1   = v4f_sub(or1a, or1b);
 			v4f oi1   = v4f_add(oi1a, oi1b);
-			v4f twr3  = v4f_ld(coefs + 16);
-			v4f twi3  = v4f_ld(coefs + 20);
-			v4f twr4  = v4f_ld(coefs + 24);
-			v4f twi4  = v4f_ld(coefs + 28);
+			v4f twr3  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 16), vscale) : v4f_ld(tw + 16);
+			v4f twi3  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 20), vscale) : v4f_ld(tw + 20);
+			v4f twr4  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 24), vscale) : v4f_ld(tw + 24);
+			v4f twi4  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 28), vscale) : v4f_ld(tw + 28);
 			v4f or2a  = v4f_mul(twr3, mor2);
 			v4f or2b  = v4f_mul(twi3, moi2);
 			v4f oi2a  = v4f_mul(twi3, mor2);
@@ -769,43 +341,72 @@ static void modfreqoffsetreal_inverse_final(float *output, const float *vec_inpu
 			v4f or3   = v4f_sub(or3a, or3b);
 			v4f oi3   = v4f_add(oi3a, oi3b);
 
-			v4f_st(output + 0*fft_len_4, or0);
-			v4f_st(output + 1*fft_len_4, or1);
-			v4f_st(output + 2*fft_len_4, or2);
-			v4f_st(output + 3*fft_len_4, or3);
-			v4f_st(output + 4*fft_len_4, oi0);
-			v4f_st(output + 5*fft_len_4, oi1);
-			v4f_st(output + 6*fft_len_4, oi2);
-			v4f_st(output + 7*fft_len_4, oi3);
+			if (modfreqoffsetreal_in_window(pos + 0*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 0*fft_len_4, or0);
+			if (modfreqoffsetreal_in_window(pos + 1*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 1*fft_len_4, or1);
+			if (modfreqoffsetreal_in_window(pos + 2*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 2*fft_len_4, or2);
+			if (modfreqoffsetreal_in_window(pos + 3*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 3*fft_len_4, or3);
+			if (modfreqoffsetreal_in_window(pos + 4*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 4*fft_len_4, oi0);
+			if (modfreqoffsetreal_in_window(pos + 5*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 5*fft_len_4, oi1);
+			if (modfreqoffsetreal_in_window(pos + 6*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 6*fft_len_4, oi2);
+			if (modfreqoffsetreal_in_window(pos + 7*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st(output, window, pos + 7*fft_len_4, oi3);
 		}
 	}
 }
 
+static void modfreqoffsetreal_inverse_final(float *output, const float *vec_input, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
+{
+	modfreqoffsetreal_inverse_final_body(output, vec_input, NULL, scale, coefs, fft_len, out_first, out_end);
+}
+
+static void modfreqoffsetreal_inverse_final_windowed(float *output, const float *vec_input, const float *window, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
+{
+	modfreqoffsetreal_inverse_final_body(output, vec_input, window, scale, coefs, fft_len, out_first, out_end);
+}
+
 static
 void
 modfreqoffsetreal_get_kernel_v4f
 	(const struct fftset_fft    *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,float                       scale
 	)
 {
-	modfreqoffsetreal_forward_first(output_buf, input_buf, first_pass->main_twiddle, first_pass->lfft);
-	fftset_vec_kern(first_pass->next_compat, 1, output_buf);
+	nb_nonzero = modfreqoffsetreal_forward_first_scaled(output_buf, input_buf, scale, first_pass->main_twiddle, first_pass->lfft, nb_nonzero);
+	fftset_vec_kern(first_pass->next_compat, 1, output_buf, nb_nonzero);
 }
 
 static
 void
 modfreqoffsetreal_conv_v4f
-	(const struct fftset_fft *first_pass
-	,float                      *output_buf
-	,const float                *input_buf
-	,const float                *kernel_buf
-	,float                      *work_buf
+	(const struct fftset_fft   *first_pass
+	,float                     *output_buf
+	,const float               *input_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,const void                *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,float                     *work_buf
+	,struct fftset_threads     *threads
 	)
 {
-	modfreqoffsetreal_forward_first(work_buf, input_buf, first_pass->main_twiddle, first_pass->lfft);
-	fftset_vec_conv(first_pass->next_compat, 1, work_buf, kernel_buf);
-	modfreqoffsetreal_inverse_final(output_buf, work_buf, first_pass->main_twiddle, first_pass->lfft);
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modfreqoffsetreal_window_end(lfft, out_first, out_count);
+	size_t col_first, col_count;
+	modfreqoffsetreal_window_cols(lfft, out_first, out_end, &col_first, &col_count);
+	nb_nonzero = modfreqoffsetreal_forward_first(work_buf, input_buf, first_pass->main_twiddle, lfft, nb_nonzero);
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, nb_nonzero, kernel_buf, kernel_format, col_first, col_count, threads);
+	modfreqoffsetreal_inverse_final(output_buf, work_buf, 1.0f, first_pass->main_twiddle, lfft, out_first, out_end);
 }
 
 static
@@ -814,23 +415,28 @@ modfreqoffsetreal_forward_v4f
 	(const struct fftset_fft *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,const float                *window
+	,size_t                      nb_nonzero
+	,size_t                      out_first
+	,size_t                      out_count
 	,float                      *work_buf
+	,struct fftset_threads      *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
+	const size_t lfft = first_pass->lfft;
+	size_t i, block_first, block_last, elem_first, elem_count;
 
-	modfreqoffsetreal_forward_first(work_buf, input_buf, first_pass->main_twiddle, lfft);
+	modfreqoffsetreal_forward_window(lfft, 8, lfft / 4, out_first, out_count, &block_first, &block_last, &elem_first, &elem_count);
 
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
+	if (window != NULL)
+		nb_nonzero = modfreqoffsetreal_forward_first_windowed(work_buf, input_buf, window, first_pass->main_twiddle, lfft, nb_nonzero);
+	else
+		nb_nonzero = modfreqoffsetreal_forward_first(work_buf, input_buf, first_pass->main_twiddle, lfft, nb_nonzero);
 
-	if (input_buf != work_buf) {
-		assert(input_buf == output_buf);
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-	}
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, nb_nonzero, elem_first, elem_count, threads);
 
-	for (i = 0; i < lfft / 8; i++) {
-		v4f tor1, toi1, tor2, toi2; 
+	for (i = block_first; i <= block_last; i++) {
+		v4f tor1, toi1, tor2, toi2;
 		v4f re1 = v4f_ld(work_buf + i*8 + 0);
 		v4f im1 = v4f_ld(work_buf + i*8 + 4);
 		v4f re2 = v4f_ld(work_buf + lfft*2 - i*8 - 8);
@@ -843,17 +449,71 @@ modfreqoffsetreal_forward_v4f
 	}
 }
 
+/* The same as the above except the final sweep stores the powers of the
+ * bins (or adds them into their bands) rather than the bins. */
+static
+void
+modfreqoffsetreal_forward_spectrum_v4f
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	,struct fftset_threads       *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	float VEC_ALIGN_BEST power[8];
+	size_t i;
+
+	(void)modfreqoffsetreal_forward_first(work_buf, input_buf, first_pass->main_twiddle, lfft, FFTSET_VEC_NONZERO_ALL);
+
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+
+	for (i = 0; i < lfft / 8; i++) {
+		v4f plo, phi;
+		v4f re1 = v4f_ld(work_buf + i*8 + 0);
+		v4f im1 = v4f_ld(work_buf + i*8 + 4);
+		v4f re2 = v4f_ld(work_buf + lfft*2 - i*8 - 8);
+		v4f im2 = v4f_ld(work_buf + lfft*2 - i*8 - 4);
+		v4f p1  = v4f_add(v4f_mul(re1, re1), v4f_mul(im1, im1));
+		v4f p2  = v4f_reverse(v4f_add(v4f_mul(re2, re2), v4f_mul(im2, im2)));
+		V4F_INTERLEAVE(plo, phi, p1, p2);
+		if (band_size == 1) {
+			v4f_st(output_buf + i*8 + 0, plo);
+			v4f_st(output_buf + i*8 + 4, phi);
+			fftset_vec_spectrum_finish(output_buf + i*8, 8, format);
+		} else {
+			v4f_st(power + 0, plo);
+			v4f_st(power + 4, phi);
+			fftset_vec_spectrum_bands(output_buf, power, i*8, 8, band_size);
+		}
+	}
+
+	if (band_size > 1)
+		fftset_vec_spectrum_finish(output_buf, (lfft + band_size - 1) / band_size, format);
+}
+
 static
 void
 modfreqoffsetreal_inverse_v4f
 	(const struct fftset_fft    *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *window
+	,float                       scale
 	,float                      *work_buf
+	,struct fftset_threads      *threads
 	)
 {
-	const unsigned lfft = first_pass->lfft;
-	unsigned i;
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modfreqoffsetreal_window_end(lfft, out_first, out_count);
+	float       *temp    = (window != NULL) ? work_buf + 2 * lfft : output_buf;
+	size_t col_first, col_count;
+	size_t i;
 
 	for (i = 0; i < lfft / 8; i++) {
 		v4f tor1, toi1, tor2, toi2, re1, im1, re2, im2;
@@ -869,68 +529,96 @@ modfreqoffsetreal_inverse_v4f
 		v4f_st(work_buf + lfft*2 - i*8 - 4, im2);
 	}
 
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
+	modfreqoffsetreal_window_cols(lfft, out_first, out_end, &col_first, &col_count);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, temp, FFTSET_VEC_NONZERO_ALL, col_first, col_count, threads);
 
-	if (input_buf == work_buf) {
-		modfreqoffsetreal_inverse_final(output_buf, work_buf, first_pass->main_twiddle, lfft);
-	} else {
-		assert(input_buf == output_buf);
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-		modfreqoffsetreal_inverse_final(output_buf, work_buf, first_pass->main_twiddle, lfft);
-	}
+	if (window != NULL)
+		modfreqoffsetreal_inverse_final_windowed(output_buf, work_buf, window, scale, first_pass->main_twiddle, lfft, out_first, out_end);
+	else
+		modfreqoffsetreal_inverse_final(output_buf, work_buf, scale, first_pass->main_twiddle, lfft, out_first, out_end);
 }
 #endif
 
+/* Modulates the real input (multiplied by the analysis window if it is not
+ * NULL) into lfft complex values which are multiplied by scale. Only the
+ * first nb_nonzero inputs may be non-zero; the outputs which only depend on
+ * zeros are zeroed without being computed. Returns the number of leading
+ * outputs which may be non-zero. */
+static size_t modfreqoffsetreal_forward_first_v1f(float *output, const float *input, const float *window, float scale, size_t lfft, size_t nb_nonzero)
+{
+	const size_t nb_out = (nb_nonzero < lfft) ? nb_nonzero : lfft;
+	const size_t nb_im  = (nb_nonzero > lfft) ? nb_nonzero - lfft : 0;
+	size_t i;
+	for (i = 0; i < nb_out; i++) {
+		float re  = (window != NULL) ? input[i] * window[i] : input[i];
+		float im  = (i < nb_im) ? ((window != NULL) ? input[lfft+i] * window[lfft+i] : input[lfft+i]) : 0.0f;
+		float twr = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f)) * scale;
+		float twi = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f)) * scale;
+		output[2*i+0] = re * twr + im * twi;
+		output[2*i+1] = re * twi - im * twr;
+	}
+	memset(output + 2*nb_out, 0, sizeof(float) * 2 * (lfft - nb_out));
+	return nb_out;
+}
+
+/* Demodulates the vectors of the window of the inverse transform which is
+ * needed for outputs [out_first, out_end). Vector i gives outputs i and
+ * lfft + i. The outputs are multiplied by scale and, if window is not NULL,
+ * by the window and added to the output buffer. */
+static void modfreqoffsetreal_inverse_final_v1f(float *output, const float *input, const float *window, float scale, size_t lfft, size_t out_first, size_t out_end)
+{
+	size_t col_first, col_count, i;
+	fftset_vec_window_cols(lfft, out_first, out_end - out_first, &col_first, &col_count);
+	for (i = col_first; col_count; col_count--, i = (i + 1 < lfft) ? i + 1 : 0) {
+		float re  = input[2*i+0];
+		float im  = input[2*i+1];
+		float twr = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f)) * scale;
+		float twi = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f)) * scale;
+		float o0  = re * twr - im * twi;
+		float o1  = re * twi + im * twr;
+		if (i >= out_first && i < out_end)
+			output[i] = (window != NULL) ? output[i] + o0 * window[i] : o0;
+		if (lfft + i >= out_first && lfft + i < out_end)
+			output[lfft+i] = (window != NULL) ? output[lfft+i] + o1 * window[lfft+i] : o1;
+	}
+}
+
 static
 void
 modfreqoffsetreal_get_kernel_v1f
 	(const struct fftset_fft    *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,float                       scale
 	)
 {
-	unsigned i;
-	unsigned lfft = first_pass->lfft;
-	for (i = 0; i < lfft; i++) {
-		float re  =  input_buf[i];
-		float im  = -input_buf[lfft+i];
-		float twr = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		float twi = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		output_buf[2*i+0] = re * twr - im * twi;
-		output_buf[2*i+1] = re * twi + im * twr;
-	}
-	fftset_vec_kern(first_pass->next_compat, 1, output_buf);
+	nb_nonzero = modfreqoffsetreal_forward_first_v1f(output_buf, input_buf, NULL, scale, first_pass->lfft, nb_nonzero);
+	fftset_vec_kern(first_pass->next_compat, 1, output_buf, nb_nonzero);
 }
 
 static
 void
 modfreqoffsetreal_conv_v1f
-	(const struct fftset_fft *first_pass
-	,float                   *output_buf
-	,const float             *input_buf
-	,const float             *kernel_buf
-	,float                   *work_buf
+	(const struct fftset_fft   *first_pass
+	,float                     *output_buf
+	,const float               *input_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,const void                *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,float                     *work_buf
+	,struct fftset_threads     *threads
 	)
 {
-	unsigned i;
-	unsigned lfft = first_pass->lfft;
-	for (i = 0; i < lfft; i++) {
-		float re        = input_buf[i];
-		float im        = input_buf[lfft+i];
-		float twr       = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		float twi       = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		work_buf[2*i+0] = re * twr + im * twi;
-		work_buf[2*i+1] = re * twi - im * twr;
-	}
-	fftset_vec_conv(first_pass->next_compat, 1, work_buf, kernel_buf);
-	for (i = 0; i < lfft; i++) {
-		float re           = work_buf[2*i+0];
-		float im           = work_buf[2*i+1];
-		float twr          = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		float twi          = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		output_buf[i]      = re * twr - im * twi;
-		output_buf[lfft+i] = re * twi + im * twr;
-	}
+	size_t lfft    = first_pass->lfft;
+	size_t out_end = modfreqoffsetreal_window_end(lfft, out_first, out_count);
+	size_t col_first, col_count;
+	fftset_vec_window_cols(lfft, out_first, out_end - out_first, &col_first, &col_count);
+	nb_nonzero = modfreqoffsetreal_forward_first_v1f(work_buf, input_buf, NULL, 1.0f, lfft, nb_nonzero);
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, nb_nonzero, kernel_buf, kernel_format, col_first, col_count, threads);
+	modfreqoffsetreal_inverse_final_v1f(output_buf, work_buf, NULL, 1.0f, lfft, out_first, out_end);
 }
 
 static
@@ -939,23 +627,20 @@ modfreqoffsetreal_forward_v1f
 	(const struct fftset_fft *first_pass
 	,float                   *output_buf
 	,const float             *input_buf
+	,const float             *window
+	,size_t                   nb_nonzero
+	,size_t                   out_first
+	,size_t                   out_count
 	,float                   *work_buf
+	,struct fftset_threads   *threads
 	)
 {
-	unsigned i;
-	unsigned lfft = first_pass->lfft;
-	for (i = 0; i < lfft; i++) {
-		float re        = input_buf[i];
-		float im        = input_buf[lfft+i];
-		float twr       = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		float twi       = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		work_buf[2*i+0] = re * twr + im * twi;
-		work_buf[2*i+1] = re * twi - im * twr;
-	}
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
-	if (input_buf == output_buf)
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-	for (i = 0; i < lfft / 2; i++) {
+	size_t i, block_first, block_last, elem_first, elem_count;
+	size_t lfft = first_pass->lfft;
+	modfreqoffsetreal_forward_window(lfft, 2, lfft, out_first, out_count, &block_first, &block_last, &elem_first, &elem_count);
+	nb_nonzero = modfreqoffsetreal_forward_first_v1f(work_buf, input_buf, window, 1.0f, lfft, nb_nonzero);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, nb_nonzero, elem_first, elem_count, threads);
+	for (i = block_first; i <= block_last && i < lfft / 2; i++) {
 		float re0         = work_buf[2*i+0];
 		float im0         = work_buf[2*i+1];
 		float re1         = work_buf[2*lfft-2-2*i];
@@ -965,23 +650,60 @@ modfreqoffsetreal_forward_v1f
 		output_buf[4*i+2] = re1;
 		output_buf[4*i+3] = -im1;
 	}
-	if (lfft & 1) {
+	if ((lfft & 1) && block_last == lfft / 2) {
 		output_buf[4*i+0] = work_buf[2*i+0];
 		output_buf[4*i+1] = work_buf[2*i+1];
 	}
 }
 
+static
+void
+modfreqoffsetreal_forward_spectrum_v1f
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	,struct fftset_threads       *threads
+	)
+{
+	size_t i;
+	size_t lfft = first_pass->lfft;
+	(void)modfreqoffsetreal_forward_first_v1f(work_buf, input_buf, NULL, 1.0f, lfft, FFTSET_VEC_NONZERO_ALL);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+	for (i = 0; i < (lfft + 1) / 2; i++) {
+		float power[2];
+		float re0 = work_buf[2*i+0];
+		float im0 = work_buf[2*i+1];
+		float re1 = work_buf[2*lfft-2-2*i];
+		float im1 = work_buf[2*lfft-1-2*i];
+		power[0]  = re0 * re0 + im0 * im0;
+		power[1]  = re1 * re1 + im1 * im1;
+		fftset_vec_spectrum_bands(output_buf, power, 2*i, (2*i+1 < lfft) ? 2 : 1, band_size);
+	}
+	fftset_vec_spectrum_finish(output_buf, (lfft + band_size - 1) / band_size, format);
+}
+
 static
 void
 modfreqoffsetreal_inverse_v1f
 	(const struct fftset_fft    *first_pass
 	,float                      *output_buf
 	,const float                *input_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *window
+	,float                       scale
 	,float                      *work_buf
+	,struct fftset_threads      *threads
 	)
 {
-	unsigned i;
-	unsigned lfft = first_pass->lfft;
+	size_t i;
+	size_t lfft    = first_pass->lfft;
+	size_t out_end = modfreqoffsetreal_window_end(lfft, out_first, out_count);
+	float *temp    = (window != NULL) ? work_buf + 2 * lfft : output_buf;
+	size_t col_first, col_count;
 	for (i = 0; i < lfft / 2; i++) {
 		float re0 = input_buf[4*i+0];
 		float im0 = input_buf[4*i+1];
@@ -993,43 +715,101 @@ modfreqoffsetreal_inverse_v1f
 		work_buf[2*lfft-1-2*i] = im1;
 	}
 	if (lfft & 1) {
-		work_buf[2*i+0] = output_buf[4*i+0];
-		work_buf[2*i+1] = -output_buf[4*i+1];
+		work_buf[2*i+0] = input_buf[4*i+0];
+		work_buf[2*i+1] = -input_buf[4*i+1];
 	}
-	input_buf = fftset_vec_stockham(first_pass->next_compat, 1, work_buf, output_buf);
-	if (input_buf == output_buf)
-		memcpy(work_buf, output_buf, sizeof(float) * lfft * 2);
-	for (i = 0; i < lfft; i++) {
-		float re           = work_buf[2*i+0];
-		float im           = work_buf[2*i+1];
-		float twr          = cosf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		float twi          = sinf(-2.0f * (float)M_PI * i / (lfft * 4.0f));
-		output_buf[i]      = re * twr - im * twi;
-		output_buf[lfft+i] = re * twi + im * twr;
+	fftset_vec_window_cols(lfft, out_first, out_end - out_first, &col_first, &col_count);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, temp, FFTSET_VEC_NONZERO_ALL, col_first, col_count, threads);
+	modfreqoffsetreal_inverse_final_v1f(output_buf, work_buf, window, scale, lfft, out_first, out_end);
+}
+
+enum modfreqoffsetreal_variant {
+	MODFREQOFFSETREAL_VARIANT_V1F = 0,
+	MODFREQOFFSETREAL_VARIANT_V4F = 1,
+	MODFREQOFFSETREAL_VARIANT_V8F = 2
+};
+
+/* Number of floats in the main twiddle table of each variant. */
+#define MODFREQOFFSETREAL_V4F_TWIDDLE_LEN(complex_len_) (56 * (complex_len_) / 16)
+#define MODFREQOFFSETREAL_V8F_TWIDDLE_LEN(complex_len_) (56 * (complex_len_) / 16 + 8 * (complex_len_) / 32)
+
+static int modfreqoffsetreal_restore(struct fftset_fft *fft, const struct fftset *fc)
+{
+	const struct fftset_kernels *kernels = fc->kernels;
+	const struct fftset_vec     *inner   = fft->next_compat;
+	const struct fftset_vec     *stock   = fft->next_stockham;
+	const size_t                 lfft    = fft->lfft;
+
+	(void)kernels;
+
+	/* Both chains must compute the same transform. */
+	if (inner == NULL || stock == NULL || stock->vec_width != inner->vec_width || stock->lfft_div_radix * stock->radix != inner->lfft_div_radix * inner->radix)
+		return -1;
+
+	switch (fft->variant) {
+#if V4F_EXISTS
+	case MODFREQOFFSETREAL_VARIANT_V8F:
+		if (kernels->freqoffsetreal_v8f_fwd == NULL)
+			return -1;
+		if (lfft < 32 || lfft % 32 != 0 || inner->vec_width != 8 || inner->lfft_div_radix * inner->radix != lfft / 8)
+			return -1;
+		if (fft->main_twiddle == NULL || fft->main_twiddle_len != MODFREQOFFSETREAL_V8F_TWIDDLE_LEN(lfft))
+			return -1;
+		fft->get_kern     = kernels->freqoffsetreal_v8f_get_kern;
+		fft->fwd          = kernels->freqoffsetreal_v8f_fwd;
+		fft->inv          = kernels->freqoffsetreal_v8f_inv;
+		fft->conv         = kernels->freqoffsetreal_v8f_conv;
+		fft->fwd_spectrum = kernels->freqoffsetreal_v8f_fwd_spectrum;
+		fft->fwd_pair     = NULL;
+		fft->conv_real    = NULL;
+		return 0;
+	case MODFREQOFFSETREAL_VARIANT_V4F:
+		if (lfft < 16 || lfft % 16 != 0 || inner->vec_width != 4 || inner->lfft_div_radix * inner->radix != lfft / 4)
+			return -1;
+		if (fft->main_twiddle == NULL || fft->main_twiddle_len != MODFREQOFFSETREAL_V4F_TWIDDLE_LEN(lfft))
+			return -1;
+		fft->get_kern     = modfreqoffsetreal_get_kernel_v4f;
+		fft->fwd          = modfreqoffsetreal_forward_v4f;
+		fft->inv          = modfreqoffsetreal_inverse_v4f;
+		fft->conv         = modfreqoffsetreal_conv_v4f;
+		fft->fwd_spectrum = modfreqoffsetreal_forward_spectrum_v4f;
+		fft->fwd_pair     = NULL;
+		fft->conv_real    = NULL;
+		return 0;
+#endif
+	case MODFREQOFFSETREAL_VARIANT_V1F:
+		if (inner->vec_width != 1 || inner->lfft_div_radix * inner->radix != lfft || fft->main_twiddle_len != 0)
+			return -1;
+		fft->get_kern     = modfreqoffsetreal_get_kernel_v1f;
+		fft->fwd          = modfreqoffsetreal_forward_v1f;
+		fft->inv          = modfreqoffsetreal_inverse_v1f;
+		fft->conv         = modfreqoffsetreal_conv_v1f;
+		fft->fwd_spectrum = modfreqoffsetreal_forward_spectrum_v1f;
+		fft->fwd_pair     = NULL;
+		fft->conv_real    = NULL;
+		return 0;
+	default:
+		return -1;
 	}
 }
 
-static int modfreqoffsetreal_init(struct fftset_fft *fft, struct fftset_vec **veclist, struct cop_salloc_iface *alloc, unsigned complex_len)
+static int modfreqoffsetreal_init(struct fftset_fft *fft, struct fftset *fc, size_t complex_len)
 {
 #if V4F_EXISTS
-#if V8F_EXISTS
-	if (complex_len >= 32 && complex_len % 32 == 0) {
+	if (complex_len >= 32 && complex_len % 32 == 0 && fc->kernels->freqoffsetreal_v8f_fwd != NULL) {
 		static const float off = (float)(-M_PI * 0.125);
-		unsigned i;
+		size_t i;
 		float *twid;
 		float scale;
 
 		/* Create inner passes. */
-		fft->next_compat = fastconv_get_inner_pass(veclist, alloc, complex_len / 8, 8);
-		if (fft->next_compat == NULL)
+		fft->next_compat   = fastconv_get_inner_pass(fc, complex_len / 8, 8, FFTSET_VEC_CHAIN_CONV);
+		fft->next_stockham = fastconv_get_inner_pass(fc, complex_len / 8, 8, FFTSET_VEC_CHAIN_STOCKHAM);
+		if (fft->next_compat == NULL || fft->next_stockham == NULL)
 			return -1;
 
 		/* Create memory for twiddle coefficients. */
-#if V8F_EXISTS
-		twid = cop_salloc(alloc, sizeof(float) * (56 * complex_len / 16 + 8 * complex_len / 32), 64);
-#else
-		twid = cop_salloc(alloc, sizeof(float) * (56 * complex_len / 16), 64);
-#endif
+		twid = fftset_alloc(fc, sizeof(float) * MODFREQOFFSETREAL_V8F_TWIDDLE_LEN(complex_len), 64, FFTSET_MEM_TWIDDLE);
 		if (twid == NULL)
 			return -1;
 
@@ -1054,35 +834,30 @@ static int modfreqoffsetreal_init(struct fftset_fft *fft, struct fftset_vec **ve
 			tp[13*VEC_V4F_WIDTH] = sinf(fi * 4.0f * 3.0f);
 		}
 
-#if V8F_EXISTS
 		for (i = 0; i < 4 * complex_len / 32; i++) {
 			twid[56 * complex_len / 16 + 2*i + 0] = cosf(-2.0*i*M_PI/(complex_len/4));
 			twid[56 * complex_len / 16 + 2*i + 1] = sinf(-2.0*i*M_PI/(complex_len/4));
 		}
-#endif
 
-
-		fft->main_twiddle = twid;
-		fft->get_kern     = modfreqoffsetreal_get_kernel_v8f;
-		fft->fwd          = modfreqoffsetreal_forward_v8f;
-		fft->inv          = modfreqoffsetreal_inverse_v8f;
-		fft->conv         = modfreqoffsetreal_conv_v8f;
+		fft->main_twiddle     = twid;
+		fft->main_twiddle_len = MODFREQOFFSETREAL_V8F_TWIDDLE_LEN(complex_len);
+		fft->variant          = MODFREQOFFSETREAL_VARIANT_V8F;
 	}
 	else
-#endif
 	if (complex_len >= 16 && complex_len % 16 == 0) {
 		static const float off = (float)(-M_PI * 0.125);
-		unsigned i;
+		size_t i;
 		float *twid;
 		float scale;
 
 		/* Create inner passes. */
-		fft->next_compat = fastconv_get_inner_pass(veclist, alloc, complex_len / 4, 4);
-		if (fft->next_compat == NULL)
+		fft->next_compat   = fastconv_get_inner_pass(fc, complex_len / 4, 4, FFTSET_VEC_CHAIN_CONV);
+		fft->next_stockham = fastconv_get_inner_pass(fc, complex_len / 4, 4, FFTSET_VEC_CHAIN_STOCKHAM);
+		if (fft->next_compat == NULL || fft->next_stockham == NULL)
 			return -1;
 
 		/* Create memory for twiddle coefficients. */
-		twid = cop_salloc(alloc, sizeof(float) * 56 * complex_len / 16, 64);
+		twid = fftset_alloc(fc, sizeof(float) * MODFREQOFFSETREAL_V4F_TWIDDLE_LEN(complex_len), 64, FFTSET_MEM_TWIDDLE);
 		if (twid == NULL)
 			return -1;
 
@@ -1107,31 +882,32 @@ static int modfreqoffsetreal_init(struct fftset_fft *fft, struct fftset_vec **ve
 			tp[13*VEC_V4F_WIDTH] = sinf(fi * 4.0f * 3.0f);
 		}
 
-		fft->main_twiddle = twid;
-		fft->get_kern     = modfreqoffsetreal_get_kernel_v4f;
-		fft->fwd          = modfreqoffsetreal_forward_v4f;
-		fft->inv          = modfreqoffsetreal_inverse_v4f;
-		fft->conv         = modfreqoffsetreal_conv_v4f;
+		fft->main_twiddle     = twid;
+		fft->main_twiddle_len = MODFREQOFFSETREAL_V4F_TWIDDLE_LEN(complex_len);
+		fft->variant          = MODFREQOFFSETREAL_VARIANT_V4F;
 	}
 	else
 #endif
 	{
-		fft->next_compat = fastconv_get_inner_pass(veclist, alloc, complex_len, 1);
-		if (fft->next_compat == NULL)
+		fft->next_compat   = fastconv_get_inner_pass(fc, complex_len, 1, FFTSET_VEC_CHAIN_CONV);
+		fft->next_stockham = fastconv_get_inner_pass(fc, complex_len, 1, FFTSET_VEC_CHAIN_STOCKHAM);
+		if (fft->next_compat == NULL || fft->next_stockham == NULL)
 			return -1;
 
-		fft->main_twiddle = NULL;
-		fft->get_kern     = modfreqoffsetreal_get_kernel_v1f;
-		fft->fwd          = modfreqoffsetreal_forward_v1f;
-		fft->inv          = modfreqoffsetreal_inverse_v1f;
-		fft->conv         = modfreqoffsetreal_conv_v1f;
+		fft->main_twiddle     = NULL;
+		fft->main_twiddle_len = 0;
+		fft->variant          = MODFREQOFFSETREAL_VARIANT_V1F;
 	}
 
-	return 0;
+	fft->lfft = complex_len;
+
+	return modfreqoffsetreal_restore(fft, fc);
 }
 
 static const struct fftset_modulation FFTSET_MODULATION_FREQ_OFFSET_REAL_DEF =
 {   modfreqoffsetreal_init
+,   modfreqoffsetreal_restore
+,   FFTSET_MODULATION_ID_FREQ_OFFSET_REAL
 };
 
 const struct fftset_modulation *FFTSET_MODULATION_FREQ_OFFSET_REAL = &FFTSET_MODULATION_FREQ_OFFSET_REAL_DEF;
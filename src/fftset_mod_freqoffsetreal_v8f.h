@@ -0,0 +1,772 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_MOD_FREQOFFSETREAL_V8F_H
+#define FFTSET_MOD_FREQOFFSETREAL_V8F_H
+
+/* The FFTSET_MODULATION_FREQ_OFFSET_REAL implementation which uses 8 wide
+ * vectors. These are instantiated by fftset_kernels_impl.h so that they are
+ * compiled for the same instruction set as the passes they use. */
+
+#include "fftset_modulation.h"
+#include "fftset_vec.h"
+#include "cop/cop_vec.h"
+#include <assert.h>
+#include <string.h>
+
+#if V4F_EXISTS && V8F_EXISTS
+
+/* As modfreqoffsetreal_ld(). */
+static COP_ATTR_ALWAYSINLINE v4f modfreqoffsetreal_ld_v8f(const float *input, const float *window, size_t col, size_t offset)
+{
+	v4f x = v4f_ld(input + offset);
+	return (window != NULL) ? v4f_mul(x, v4f_ld(window + col + offset)) : x;
+}
+
+/* As modfreqoffsetreal_forward_first_body() but the columns of the first
+ * half of the rows are placed in the low lanes of the output vectors and the
+ * columns of the second half in the high lanes. These are then combined using
+ * a radix-2 pass. Returns the number of leading vectors of the output which
+ * may be non-zero. */
+static COP_ATTR_ALWAYSINLINE size_t modfreqoffsetreal_forward_first_body_v8f(float *vo, const float *input, const float *window, float scale, const float *coefs, size_t fft_len, size_t nb_nonzero)
+{
+	const size_t fft_len_4  = fft_len / 4;
+	const size_t fft_len_8  = fft_len / 8;
+	const size_t nb_in      = (nb_nonzero < 2 * fft_len) ? nb_nonzero : 2 * fft_len;
+	const size_t nb_rows    = (nb_in + fft_len_4 - 1) / fft_len_4;
+	const size_t nb_cols    = (nb_in < fft_len_4) ? nb_in : fft_len_4;
+	const size_t nb_blocks1 = ((nb_cols < fft_len_8) ? nb_cols + 3 : fft_len_8 + 3) / 4;
+	const size_t nb_blocks2 = ((nb_cols > fft_len_8) ? nb_cols - fft_len_8 + 3 : 0) / 4;
+	const float *coefs_base = coefs;
+	const float *input_base = input;
+	const v4f    zero       = v4f_broadcast(0.0f);
+	const v4f    vscale     = v4f_broadcast(scale);
+	size_t i, col;
+	assert((fft_len % 32) == 0);
+
+	float *vec_output = vo;
+
+	memset(vo + 64 * nb_blocks1, 0, sizeof(float) * 64 * (fft_len / 32 - nb_blocks1));
+	for (i = nb_blocks2; i < nb_blocks1; i++) {
+		memset(vo + 64 * i + 8,  0, sizeof(float) * 8);
+		memset(vo + 64 * i + 24, 0, sizeof(float) * 8);
+		memset(vo + 64 * i + 40, 0, sizeof(float) * 8);
+		memset(vo + 64 * i + 56, 0, sizeof(float) * 8);
+	}
+
+	for (i = nb_blocks1, col = 0
+		;i
+		;i--, coefs += 56, vec_output += 64, input += 4, col += 4) {
+		v4f r1    = modfreqoffsetreal_ld_v8f(input, window, col, 0*fft_len_4);
+		v4f r2    = (nb_rows > 1) ? modfreqoffsetreal_ld_v8f(input, window, col, 1*fft_len_4) : zero;
+		v4f r3    = (nb_rows > 2) ? modfreqoffsetreal_ld_v8f(input, window, col, 2*fft_len_4) : zero;
+		v4f r4    = (nb_rows > 3) ? modfreqoffsetreal_ld_v8f(input, window, col, 3*fft_len_4) : zero;
+		v4f i1    = (nb_rows > 4) ? modfreqoffsetreal_ld_v8f(input, window, col, 4*fft_len_4) : zero;
+		v4f i2    = (nb_rows > 5) ? modfreqoffsetreal_ld_v8f(input, window, col, 5*fft_len_4) : zero;
+		v4f i3    = (nb_rows > 6) ? modfreqoffsetreal_ld_v8f(input, window, col, 6*fft_len_4) : zero;
+		v4f i4    = (nb_rows > 7) ? modfreqoffsetreal_ld_v8f(input, window, col, 7*fft_len_4) : zero;
+
+		v4f twr1  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 0), vscale) : v4f_ld(coefs + 0);
+		v4f twi1  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 4), vscale) : v4f_ld(coefs + 4);
+		v4f twr2  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 8), vscale) : v4f_ld(coefs + 8);
+		v4f twi2  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 12), vscale) : v4f_ld(coefs + 12);
+		v4f or1a  = v4f_mul(twr1, r1);
+		v4f or1b  = v4f_mul(twi1, i1);
+		v4f oi1a  = v4f_mul(twi1, r1);
+		v4f oi1b  = v4f_mul(twr1, i1);
+		v4f or2a  = v4f_mul(twr2, r2);
+		v4f or2b  = v4f_mul(twi2, i2);
+		v4f oi2a  = v4f_mul(twi2, r2);
+		v4f oi2b  = v4f_mul(twr2, i2);
+		v4f or1   = v4f_add(or1a, or1b);
+		v4f oi1   = v4f_sub(oi1a, oi1b);
+		v4f or2   = v4f_add(or2a, or2b);
+		v4f oi2   = v4f_sub(oi2a, oi2b);
+		v4f twr3  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 16), vscale) : v4f_ld(coefs + 16);
+		v4f twi3  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 20), vscale) : v4f_ld(coefs + 20);
+		v4f twr4  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 24), vscale) : v4f_ld(coefs + 24);
+		v4f twi4  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 28), vscale) : v4f_ld(coefs + 28);
+		v4f or3a  = v4f_mul(twr3, r3);
+		v4f or3b  = v4f_mul(twi3, i3);
+		v4f oi3a  = v4f_mul(twi3, r3);
+		v4f oi3b  = v4f_mul(twr3, i3);
+		v4f or4a  = v4f_mul(twr4, r4);
+		v4f or4b  = v4f_mul(twi4, i4);
+		v4f oi4a  = v4f_mul(twi4, r4);
+		v4f oi4b  = v4f_mul(twr4, i4);
+		v4f or3   = v4f_add(or3a, or3b);
+		v4f oi3   = v4f_sub(oi3a, oi3b);
+		v4f or4   = v4f_add(or4a, or4b);
+		v4f oi4   = v4f_sub(oi4a, oi4b);
+
+		v4f t0ra  = v4f_add(or1, or3);
+		v4f t0rs  = v4f_sub(or1, or3);
+		v4f t1ra  = v4f_add(or2, or4);
+		v4f t1rs  = v4f_sub(or2, or4);
+		v4f t1is  = v4f_sub(oi2, oi4);
+		v4f t1ia  = v4f_add(oi2, oi4);
+		v4f t0is  = v4f_sub(oi1, oi3);
+		v4f t0ia  = v4f_add(oi1, oi3);
+		v4f mor0  = v4f_add(t0ra, t1ra);
+		v4f mor2  = v4f_sub(t0ra, t1ra);
+		v4f mor1  = v4f_add(t0rs, t1is);
+		v4f mor3  = v4f_sub(t0rs, t1is);
+		v4f moi1  = v4f_sub(t0is, t1rs);
+		v4f moi3  = v4f_add(t0is, t1rs);
+		v4f moi0  = v4f_add(t0ia, t1ia);
+		v4f moi2  = v4f_sub(t0ia, t1ia);
+
+		v4f ptwr1 = v4f_ld(coefs + 32);
+		v4f ptwi1 = v4f_ld(coefs + 36);
+		v4f ptwr2 = v4f_ld(coefs + 40);
+		v4f ptwi2 = v4f_ld(coefs + 44);
+		v4f ptwr3 = v4f_ld(coefs + 48);
+		v4f ptwi3 = v4f_ld(coefs + 52);
+		v4f tor1a = v4f_mul(mor1, ptwr1);
+		v4f toi1a = v4f_mul(mor1, ptwi1);
+		v4f tor1b = v4f_mul(moi1, ptwi1);
+		v4f toi1b = v4f_mul(moi1, ptwr1);
+		v4f tor2a = v4f_mul(mor2, ptwr2);
+		v4f toi2a = v4f_mul(mor2, ptwi2);
+		v4f tor2b = v4f_mul(moi2, ptwi2);
+		v4f toi2b = v4f_mul(moi2, ptwr2);
+		v4f tor3a = v4f_mul(mor3, ptwr3);
+		v4f toi3a = v4f_mul(mor3, ptwi3);
+		v4f tor3b = v4f_mul(moi3, ptwi3);
+		v4f toi3b = v4f_mul(moi3, ptwr3);
+		v4f tor1  = v4f_sub(tor1a, tor1b);
+		v4f toi1  = v4f_add(toi1a, toi1b);
+		v4f tor2  = v4f_sub(tor2a, tor2b);
+		v4f toi2  = v4f_add(toi2a, toi2b);
+		v4f tor3  = v4f_sub(tor3a, tor3b);
+		v4f toi3  = v4f_add(toi3a, toi3b);
+
+		V4F_TRANSPOSE_INPLACE(mor0, tor1, tor2, tor3);
+		V4F_TRANSPOSE_INPLACE(moi0, toi1, toi2, toi3);
+
+		v4f_st(vec_output + 0,  mor0);
+		v4f_st(vec_output + 4,  moi0);
+		v4f_st(vec_output + 16, tor1);
+		v4f_st(vec_output + 20, toi1);
+		v4f_st(vec_output + 32, tor2);
+		v4f_st(vec_output + 36, toi2);
+		v4f_st(vec_output + 48, tor3);
+		v4f_st(vec_output + 52, toi3);
+	}
+
+	vec_output = vo;
+	coefs      = coefs_base + 56 * (fft_len / 32);
+	input      = input_base + fft_len_8;
+
+	for (i = nb_blocks2, col = fft_len_8
+		;i
+		;i--, coefs += 56, vec_output += 64, input += 4, col += 4) {
+		v4f r1    = modfreqoffsetreal_ld_v8f(input, window, col, 0*fft_len_4);
+		v4f r2    = (nb_rows > 1) ? modfreqoffsetreal_ld_v8f(input, window, col, 1*fft_len_4) : zero;
+		v4f r3    = (nb_rows > 2) ? modfreqoffsetreal_ld_v8f(input, window, col, 2*fft_len_4) : zero;
+		v4f r4    = (nb_rows > 3) ? modfreqoffsetreal_ld_v8f(input, window, col, 3*fft_len_4) : zero;
+		v4f i1    = (nb_rows > 4) ? modfreqoffsetreal_ld_v8f(input, window, col, 4*fft_len_4) : zero;
+		v4f i2    = (nb_rows > 5) ? modfreqoffsetreal_ld_v8f(input, window, col, 5*fft_len_4) : zero;
+		v4f i3    = (nb_rows > 6) ? modfreqoffsetreal_ld_v8f(input, window, col, 6*fft_len_4) : zero;
+		v4f i4    = (nb_rows > 7) ? modfreqoffsetreal_ld_v8f(input, window, col, 7*fft_len_4) : zero;
+
+		v4f twr1  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 0), vscale) : v4f_ld(coefs + 0);
+		v4f twi1  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 4), vscale) : v4f_ld(coefs + 4);
+		v4f twr2  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 8), vscale) : v4f_ld(coefs + 8);
+		v4f twi2  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 12), vscale) : v4f_ld(coefs + 12);
+		v4f or1a  = v4f_mul(twr1, r1);
+		v4f or1b  = v4f_mul(twi1, i1);
+		v4f oi1a  = v4f_mul(twi1, r1);
+		v4f oi1b  = v4f_mul(twr1, i1);
+		v4f or2a  = v4f_mul(twr2, r2);
+		v4f or2b  = v4f_mul(twi2, i2);
+		v4f oi2a  = v4f_mul(twi2, r2);
+		v4f oi2b  = v4f_mul(twr2, i2);
+		v4f or1   = v4f_add(or1a, or1b);
+		v4f oi1   = v4f_sub(oi1a, oi1b);
+		v4f or2   = v4f_add(or2a, or2b);
+		v4f oi2   = v4f_sub(oi2a, oi2b);
+		v4f twr3  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 16), vscale) : v4f_ld(coefs + 16);
+		v4f twi3  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 20), vscale) : v4f_ld(coefs + 20);
+		v4f twr4  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 24), vscale) : v4f_ld(coefs + 24);
+		v4f twi4  = (scale != 1.0f) ? v4f_mul(v4f_ld(coefs + 28), vscale) : v4f_ld(coefs + 28);
+		v4f or3a  = v4f_mul(twr3, r3);
+		v4f or3b  = v4f_mul(twi3, i3);
+		v4f oi3a  = v4f_mul(twi3, r3);
+		v4f oi3b  = v4f_mul(twr3, i3);
+		v4f or4a  = v4f_mul(twr4, r4);
+		v4f or4b  = v4f_mul(twi4, i4);
+		v4f oi4a  = v4f_mul(twi4, r4);
+		v4f oi4b  = v4f_mul(twr4, i4);
+		v4f or3   = v4f_add(or3a, or3b);
+		v4f oi3   = v4f_sub(oi3a, oi3b);
+		v4f or4   = v4f_add(or4a, or4b);
+		v4f oi4   = v4f_sub(oi4a, oi4b);
+
+		v4f t0ra  = v4f_add(or1, or3);
+		v4f t0rs  = v4f_sub(or1, or3);
+		v4f t1ra  = v4f_add(or2, or4);
+		v4f t1rs  = v4f_sub(or2, or4);
+		v4f t1is  = v4f_sub(oi2, oi4);
+		v4f t1ia  = v4f_add(oi2, oi4);
+		v4f t0is  = v4f_sub(oi1, oi3);
+		v4f t0ia  = v4f_add(oi1, oi3);
+		v4f mor0  = v4f_add(t0ra, t1ra);
+		v4f mor2  = v4f_sub(t0ra, t1ra);
+		v4f mor1  = v4f_add(t0rs, t1is);
+		v4f mor3  = v4f_sub(t0rs, t1is);
+		v4f moi1  = v4f_sub(t0is, t1rs);
+		v4f moi3  = v4f_add(t0is, t1rs);
+		v4f moi0  = v4f_add(t0ia, t1ia);
+		v4f moi2  = v4f_sub(t0ia, t1ia);
+
+		v4f ptwr1 = v4f_ld(coefs + 32);
+		v4f ptwi1 = v4f_ld(coefs + 36);
+		v4f ptwr2 = v4f_ld(coefs + 40);
+		v4f ptwi2 = v4f_ld(coefs + 44);
+		v4f ptwr3 = v4f_ld(coefs + 48);
+		v4f ptwi3 = v4f_ld(coefs + 52);
+		v4f tor1a = v4f_mul(mor1, ptwr1);
+		v4f toi1a = v4f_mul(mor1, ptwi1);
+		v4f tor1b = v4f_mul(moi1, ptwi1);
+		v4f toi1b = v4f_mul(moi1, ptwr1);
+		v4f tor2a = v4f_mul(mor2, ptwr2);
+		v4f toi2a = v4f_mul(mor2, ptwi2);
+		v4f tor2b = v4f_mul(moi2, ptwi2);
+		v4f toi2b = v4f_mul(moi2, ptwr2);
+		v4f tor3a = v4f_mul(mor3, ptwr3);
+		v4f toi3a = v4f_mul(mor3, ptwi3);
+		v4f tor3b = v4f_mul(moi3, ptwi3);
+		v4f toi3b = v4f_mul(moi3, ptwr3);
+		v4f tor1  = v4f_sub(tor1a, tor1b);
+		v4f toi1  = v4f_add(toi1a, toi1b);
+		v4f tor2  = v4f_sub(tor2a, tor2b);
+		v4f toi2  = v4f_add(toi2a, toi2b);
+		v4f tor3  = v4f_sub(tor3a, tor3b);
+		v4f toi3  = v4f_add(toi3a, toi3b);
+
+		V4F_TRANSPOSE_INPLACE(mor0, tor1, tor2, tor3);
+		V4F_TRANSPOSE_INPLACE(moi0, toi1, toi2, toi3);
+
+		v4f_st(vec_output + 8,  mor0);
+		v4f_st(vec_output + 12, moi0);
+		v4f_st(vec_output + 24, tor1);
+		v4f_st(vec_output + 28, toi1);
+		v4f_st(vec_output + 40, tor2);
+		v4f_st(vec_output + 44, toi2);
+		v4f_st(vec_output + 56, tor3);
+		v4f_st(vec_output + 60, toi3);
+	}
+
+	vec_output = vo;
+	coefs      = coefs_base + 56 * (fft_len / 16);
+
+	/* Vectors which combine two zero columns stay zero. */
+	for (i = 0
+		;i < ((nb_cols < fft_len_8) ? nb_cols : fft_len_8)
+		;i++, vec_output += 16, coefs += 2) {
+		v4f r0, i0, r1, i1;
+		v4f twr, twi;
+		v4f r2, i2, r3, i3;
+		v4f or0, or1, oi0, oi1;
+		v4f xr1, xi1;
+		V4F_LD2(r0, i0, vec_output);
+		V4F_LD2(r1, i1, vec_output + 8);
+		twr = v4f_broadcast(coefs[0]);
+		twi = v4f_broadcast(coefs[1]);
+		xr1 = v4f_sub(r0, r1);
+		xi1 = v4f_sub(i0, i1);
+		or0 = v4f_add(r0, r1);
+		oi0 = v4f_add(i0, i1);
+		r2  = v4f_mul(xr1, twr);
+		i2  = v4f_mul(xi1, twr);
+		r3  = v4f_mul(xi1, twi);
+		i3  = v4f_mul(xr1, twi);
+		or1 = v4f_sub(r2, r3);
+		oi1 = v4f_add(i2, i3);
+		V4F_ST2(vec_output,     or0, or1);
+		V4F_ST2(vec_output + 8, oi0, oi1);
+	}
+
+	return (nb_cols < fft_len_8) ? nb_cols : fft_len_8;
+}
+
+static size_t modfreqoffsetreal_forward_first_v8f(float *vo, const float *input, const float *coefs, size_t fft_len, size_t nb_nonzero)
+{
+	return modfreqoffsetreal_forward_first_body_v8f(vo, input, NULL, 1.0f, coefs, fft_len, nb_nonzero);
+}
+
+static size_t modfreqoffsetreal_forward_first_windowed_v8f(float *vo, const float *input, const float *window, const float *coefs, size_t fft_len, size_t nb_nonzero)
+{
+	return modfreqoffsetreal_forward_first_body_v8f(vo, input, window, 1.0f, coefs, fft_len, nb_nonzero);
+}
+
+static size_t modfreqoffsetreal_forward_first_scaled_v8f(float *vo, const float *input, float scale, const float *coefs, size_t fft_len, size_t nb_nonzero)
+{
+	return modfreqoffsetreal_forward_first_body_v8f(vo, input, NULL, scale, coefs, fft_len, nb_nonzero);
+}
+
+/* Gives the end of the output window of a transform of fft_len complex
+ * values. */
+static size_t modfreqoffsetreal_window_end_v8f(size_t fft_len, size_t out_first, size_t out_count)
+{
+	assert(out_first < 2 * fft_len);
+	return (out_count < 2 * fft_len - out_first) ? out_first + out_count : 2 * fft_len;
+}
+
+/* Gives the blocks of four columns of the radix-2 pass which are needed for
+ * outputs [out_first, out_end). Column c of every row of fft_len / 4 outputs
+ * comes from column c % (fft_len / 8) of the radix-2 pass. All four input
+ * vectors of a block are mixed together so the window of the vectors given to
+ * the inverse final pass is the blocks multiplied by four. */
+static void modfreqoffsetreal_window_blocks_v8f(size_t fft_len, size_t out_first, size_t out_end, size_t *block_first, size_t *block_count)
+{
+	const size_t nb_blocks = fft_len / 32;
+	size_t col_first, col_count;
+	fftset_vec_window_cols(fft_len / 4, out_first, out_end - out_first, &col_first, &col_count);
+	fftset_vec_window_cols(fft_len / 8, col_first, col_count, &col_first, &col_count);
+	*block_first = col_first / 4;
+	*block_count = (col_first + col_count + 3) / 4 - *block_first;
+	if (*block_count > nb_blocks)
+		*block_count = nb_blocks;
+}
+
+/* Non-zero if any of the four outputs starting at pos are in the window. */
+static COP_ATTR_ALWAYSINLINE int modfreqoffsetreal_in_window_v8f(size_t pos, size_t out_first, size_t out_end)
+{
+	return pos < out_end && pos + 4 > out_first;
+}
+
+/* As modfreqoffsetreal_st(). */
+static COP_ATTR_ALWAYSINLINE void modfreqoffsetreal_st_v8f(float *output, const float *window, size_t offset, v4f x)
+{
+	if (window != NULL)
+		x = v4f_add(v4f_ld(output + offset), v4f_mul(x, v4f_ld(window + offset)));
+	v4f_st(output + offset, x);
+}
+
+/* The radix-2 pass is written to scratch (which may be the output buffer if
+ * window is NULL; the rest of it is then used as scratch space). The outputs
+ * are multiplied by scale (folded into the twiddles of the modulation) and,
+ * if window is not NULL, by the window and added to the output buffer. */
+static COP_ATTR_ALWAYSINLINE void modfreqoffsetreal_inverse_final_body_v8f(float *output, float *scratch, const float *vi, const float *window, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
+{
+	const size_t fft_len_8  = fft_len / 8;
+	const size_t fft_len_4  = fft_len / 4;
+	const size_t nb_blocks2 = fft_len / 32;
+	const size_t nb_blocks4 = fft_len / 16;
+	const v4f    vscale     = v4f_broadcast(scale);
+	size_t i, b, col_first, col_count;
+
+	assert((fft_len % 32) == 0);
+
+	modfreqoffsetreal_window_blocks_v8f(fft_len, out_first, out_end, &b, &i);
+	for (
+		;i
+		;i--, b = (b + 1 < nb_blocks2) ? b + 1 : 0) {
+		const float *vec_input  = vi + 64 * b;
+		float       *vec_output = scratch + 4 * b;
+		const float *tp         = coefs + 56 * fft_len / 16 + 8 * b;
+		v4f r0, i0, r1, i1;
+		v4f twr0, twi0;
+		v4f twr1, twi1;
+		v4f r2, i2, r3, i3;
+		v4f or0, or1, oi0, oi1;
+		v4f or2, or3, oi2, oi3;
+
+		V4F_LD2(or0, or1, vec_input);
+		V4F_LD2(oi0, oi1, vec_input + 8);
+		V4F_LD2(or2, or3, vec_input + 16);
+		V4F_LD2(oi2, oi3, vec_input + 24);
+		twr0 = v4f_broadcast(tp[0]);
+		twi0 = v4f_broadcast(tp[1]);
+		twr1 = v4f_broadcast(tp[2]);
+		twi1 = v4f_broadcast(tp[3]);
+		r0  = v4f_mul(or1, twr0);
+		i0  = v4f_mul(oi1, twr0);
+		r1  = v4f_mul(oi1, twi0);
+		i1  = v4f_mul(or1, twi0);
+		r2  = v4f_mul(or3, twr1);
+		i2  = v4f_mul(oi3, twr1);
+		r3  = v4f_mul(oi3, twi1);
+		i3  = v4f_mul(or3, twi1);
+		or1 = v4f_sub(r0, r1);
+		oi1 = v4f_add(i0, i1);
+		or3 = v4f_sub(r2, r3);
+		oi3 = v4f_add(i2, i3);
+		r0  = v4f_add(or0, or1);
+		i0  = v4f_add(oi0, oi1);
+		r1  = v4f_sub(or0, or1);
+		i1  = v4f_sub(oi0, oi1);
+		r2  = v4f_add(or2, or3);
+		i2  = v4f_add(oi2, oi3);
+		r3  = v4f_sub(or2, or3);
+		i3  = v4f_sub(oi2, oi3);
+		v4f_st(vec_output + 0*fft_len_8, r0);
+		v4f_st(vec_output + 1*fft_len_8, r1);
+		v4f_st(vec_output + 2*fft_len_8, i0);
+		v4f_st(vec_output + 3*fft_len_8, i1);
+		v4f_st(vec_output + 4*fft_len_8, r2);
+		v4f_st(vec_output + 5*fft_len_8, r3);
+		v4f_st(vec_output + 6*fft_len_8, i2);
+		v4f_st(vec_output + 7*fft_len_8, i3);
+
+		V4F_LD2(or0, or1, vec_input + 32);
+		V4F_LD2(oi0, oi1, vec_input + 40);
+		V4F_LD2(or2, or3, vec_input + 48);
+		V4F_LD2(oi2, oi3, vec_input + 56);
+		twr0 = v4f_broadcast(tp[4]);
+		twi0 = v4f_broadcast(tp[5]);
+		twr1 = v4f_broadcast(tp[6]);
+		twi1 = v4f_broadcast(tp[7]);
+		r0  = v4f_mul(or1, twr0);
+		i0  = v4f_mul(oi1, twr0);
+		r1  = v4f_mul(oi1, twi0);
+		i1  = v4f_mul(or1, twi0);
+		r2  = v4f_mul(or3, twr1);
+		i2  = v4f_mul(oi3, twr1);
+		r3  = v4f_mul(oi3, twi1);
+		i3  = v4f_mul(or3, twi1);
+		or1 = v4f_sub(r0, r1);
+		oi1 = v4f_add(i0, i1);
+		or3 = v4f_sub(r2, r3);
+		oi3 = v4f_add(i2, i3);
+		r0  = v4f_add(or0, or1);
+		i0  = v4f_add(oi0, oi1);
+		r1  = v4f_sub(or0, or1);
+		i1  = v4f_sub(oi0, oi1);
+		r2  = v4f_add(or2, or3);
+		i2  = v4f_add(oi2, oi3);
+		r3  = v4f_sub(or2, or3);
+		i3  = v4f_sub(oi2, oi3);
+		v4f_st(vec_output + 8*fft_len_8, r0);
+		v4f_st(vec_output + 9*fft_len_8, r1);
+		v4f_st(vec_output + 10*fft_len_8, i0);
+		v4f_st(vec_output + 11*fft_len_8, i1);
+		v4f_st(vec_output + 12*fft_len_8, r2);
+		v4f_st(vec_output + 13*fft_len_8, r3);
+		v4f_st(vec_output + 14*fft_len_8, i2);
+		v4f_st(vec_output + 15*fft_len_8, i3);
+	}
+
+	fftset_vec_window_cols(fft_len_4, out_first, out_end - out_first, &col_first, &col_count);
+	b = col_first / 4;
+	i = (col_first + col_count + 3) / 4 - b;
+	if (i > nb_blocks4)
+		i = nb_blocks4;
+	for (
+		;i
+		;i--, b = (b + 1 < nb_blocks4) ? b + 1 : 0) {
+		const float *tw  = coefs + 56 * b;
+		const size_t pos = 4 * b;
+		v4f r0   = v4f_ld(scratch + pos + 0*fft_len_4);
+		v4f i0   = v4f_ld(scratch + pos + 1*fft_len_4);
+		v4f r1   = v4f_ld(scratch + pos + 2*fft_len_4);
+		v4f i1   = v4f_ld(scratch + pos + 3*fft_len_4);
+		v4f r2   = v4f_ld(scratch + pos + 4*fft_len_4);
+		v4f i2   = v4f_ld(scratch + pos + 5*fft_len_4);
+		v4f r3   = v4f_ld(scratch + pos + 6*fft_len_4);
+		v4f i3   = v4f_ld(scratch + pos + 7*fft_len_4);
+		V4F_TRANSPOSE_INPLACE(r0, r1, r2, r3);
+		V4F_TRANSPOSE_INPLACE(i0, i1, i2, i3);
+		{
+			v4f ptwr1 = v4f_ld(tw + 32);
+			v4f ptwi1 = v4f_ld(tw + 36);
+			v4f ptwr2 = v4f_ld(tw + 40);
+			v4f ptwi2 = v4f_ld(tw + 44);
+			v4f ptwr3 = v4f_ld(tw + 48);
+			v4f ptwi3 = v4f_ld(tw + 52);
+			v4f tor1a = v4f_mul(r1, ptwr1);
+			v4f toi1a = v4f_mul(r1, ptwi1);
+			v4f tor1b = v4f_mul(i1, ptwi1);
+			v4f toi1b = v4f_mul(i1, ptwr1);
+			v4f tor2a = v4f_mul(r2, ptwr2);
+			v4f toi2a = v4f_mul(r2, ptwi2);
+			v4f tor2b = v4f_mul(i2, ptwi2);
+			v4f toi2b = v4f_mul(i2, ptwr2);
+			v4f tor3a = v4f_mul(r3, ptwr3);
+			v4f toi3a = v4f_mul(r3, ptwi3);
+			v4f tor3b = v4f_mul(i3, ptwi3);
+			v4f toi3b = v4f_mul(i3, ptwr3);
+			v4f tor1  = v4f_sub(tor1a, tor1b);
+			v4f toi1  = v4f_add(toi1a, toi1b);
+			v4f tor2  = v4f_sub(tor2a, tor2b);
+			v4f toi2  = v4f_add(toi2a, toi2b);
+			v4f tor3  = v4f_sub(tor3a, tor3b);
+			v4f toi3  = v4f_add(toi3a, toi3b);
+
+			v4f t0ra  = v4f_add(r0,   tor2);
+			v4f t0rs  = v4f_sub(r0,   tor2);
+			v4f t1ra  = v4f_add(tor1, tor3);
+			v4f t1rs  = v4f_sub(tor1, tor3);
+			v4f t1is  = v4f_sub(toi1, toi3);
+			v4f t1ia  = v4f_add(toi1, toi3);
+			v4f t0is  = v4f_sub(i0,   toi2);
+			v4f t0ia  = v4f_add(i0,   toi2);
+			v4f mor0  = v4f_add(t0ra, t1ra);
+			v4f mor2  = v4f_sub(t0ra, t1ra);
+			v4f mor1  = v4f_add(t0rs, t1is);
+			v4f mor3  = v4f_sub(t0rs, t1is);
+			v4f moi1  = v4f_sub(t0is, t1rs);
+			v4f moi3  = v4f_add(t0is, t1rs);
+			v4f moi0  = v4f_add(t0ia, t1ia);
+			v4f moi2  = v4f_sub(t0ia, t1ia);
+
+			v4f twr1  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 0), vscale) : v4f_ld(tw + 0);
+			v4f twi1  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 4), vscale) : v4f_ld(tw + 4);
+			v4f twr2  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 8), vscale) : v4f_ld(tw + 8);
+			v4f twi2  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 12), vscale) : v4f_ld(tw + 12);
+			v4f or0a  = v4f_mul(twr1, mor0);
+			v4f or0b  = v4f_mul(twi1, moi0);
+			v4f oi0a  = v4f_mul(twi1, mor0);
+			v4f oi0b  = v4f_mul(twr1, moi0);
+			v4f or1a  = v4f_mul(twr2, mor1);
+			v4f or1b  = v4f_mul(twi2, moi1);
+			v4f oi1a  = v4f_mul(twi2, mor1);
+			v4f oi1b  = v4f_mul(twr2, moi1);
+			v4f or0   = v4f_sub(or0a, or0b);
+			v4f oi0   = v4f_add(oi0a, oi0b);
+			v4f or1   = v4f_sub(or1a, or1b);
+			v4f oi1   = v4f_add(oi1a, oi1b);
+			v4f twr3  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 16), vscale) : v4f_ld(tw + 16);
+			v4f twi3  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 20), vscale) : v4f_ld(tw + 20);
+			v4f twr4  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 24), vscale) : v4f_ld(tw + 24);
+			v4f twi4  = (scale != 1.0f) ? v4f_mul(v4f_ld(tw + 28), vscale) : v4f_ld(tw + 28);
+			v4f or2a  = v4f_mul(twr3, mor2);
+			v4f or2b  = v4f_mul(twi3, moi2);
+			v4f oi2a  = v4f_mul(twi3, mor2);
+			v4f oi2b  = v4f_mul(twr3, moi2);
+			v4f or3a  = v4f_mul(twr4, mor3);
+			v4f or3b  = v4f_mul(twi4, moi3);
+			v4f oi3a  = v4f_mul(twi4, mor3);
+			v4f oi3b  = v4f_mul(twr4, moi3);
+			v4f or2   = v4f_sub(or2a, or2b);
+			v4f oi2   = v4f_add(oi2a, oi2b);
+			v4f or3   = v4f_sub(or3a, or3b);
+			v4f oi3   = v4f_add(oi3a, oi3b);
+
+			if (modfreqoffsetreal_in_window_v8f(pos + 0*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 0*fft_len_4, or0);
+			if (modfreqoffsetreal_in_window_v8f(pos + 1*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 1*fft_len_4, or1);
+			if (modfreqoffsetreal_in_window_v8f(pos + 2*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 2*fft_len_4, or2);
+			if (modfreqoffsetreal_in_window_v8f(pos + 3*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 3*fft_len_4, or3);
+			if (modfreqoffsetreal_in_window_v8f(pos + 4*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 4*fft_len_4, oi0);
+			if (modfreqoffsetreal_in_window_v8f(pos + 5*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 5*fft_len_4, oi1);
+			if (modfreqoffsetreal_in_window_v8f(pos + 6*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 6*fft_len_4, oi2);
+			if (modfreqoffsetreal_in_window_v8f(pos + 7*fft_len_4, out_first, out_end))
+				modfreqoffsetreal_st_v8f(output, window, pos + 7*fft_len_4, oi3);
+		}
+	}
+}
+
+static void modfreqoffsetreal_inverse_final_v8f(float *output, const float *vi, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
+{
+	modfreqoffsetreal_inverse_final_body_v8f(output, output, vi, NULL, scale, coefs, fft_len, out_first, out_end);
+}
+
+static void modfreqoffsetreal_inverse_final_windowed_v8f(float *output, float *scratch, const float *vi, const float *window, float scale, const float *coefs, size_t fft_len, size_t out_first, size_t out_end)
+{
+	modfreqoffsetreal_inverse_final_body_v8f(output, scratch, vi, window, scale, coefs, fft_len, out_first, out_end);
+}
+
+static
+void
+modfreqoffsetreal_get_kernel_v8f
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      nb_nonzero
+	,float                       scale
+	)
+{
+	nb_nonzero = modfreqoffsetreal_forward_first_scaled_v8f(output_buf, input_buf, scale, first_pass->main_twiddle, first_pass->lfft, nb_nonzero);
+	fftset_vec_kern(first_pass->next_compat, 1, output_buf, nb_nonzero);
+}
+
+static
+void
+modfreqoffsetreal_conv_v8f
+	(const struct fftset_fft   *first_pass
+	,float                     *output_buf
+	,const float               *input_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,const void                *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,float                     *work_buf
+	,struct fftset_threads     *threads
+	)
+{
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modfreqoffsetreal_window_end_v8f(lfft, out_first, out_count);
+	size_t block_first, block_count;
+	modfreqoffsetreal_window_blocks_v8f(lfft, out_first, out_end, &block_first, &block_count);
+	nb_nonzero = modfreqoffsetreal_forward_first_v8f(work_buf, input_buf, first_pass->main_twiddle, lfft, nb_nonzero);
+	fftset_vec_conv(first_pass->next_compat, 1, work_buf, nb_nonzero, kernel_buf, kernel_format, 4 * block_first, 4 * block_count, threads);
+	modfreqoffsetreal_inverse_final_v8f(output_buf, work_buf, 1.0f, first_pass->main_twiddle, lfft, out_first, out_end);
+}
+
+static
+void
+modfreqoffsetreal_forward_v8f
+	(const struct fftset_fft *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,const float                *window
+	,size_t                      nb_nonzero
+	,size_t                      out_first
+	,size_t                      out_count
+	,float                      *work_buf
+	,struct fftset_threads      *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	size_t i, out_end, block_first, block_last, elem_first, elem_count;
+
+	/* Block i of 16 bins is built from element i and its mirror. */
+	assert(out_first < lfft);
+	out_end     = (out_count < lfft - out_first) ? out_first + out_count : lfft;
+	block_first = out_first / 16;
+	block_last  = (out_end - 1) / 16;
+	if (out_end == out_first) {
+		block_first = 1;
+		block_last  = 0;
+		elem_first  = 0;
+		elem_count  = 0;
+	} else {
+		fftset_vec_window_mirrored(lfft / 8, block_first, block_last, &elem_first, &elem_count);
+	}
+
+	if (window != NULL)
+		nb_nonzero = modfreqoffsetreal_forward_first_windowed_v8f(work_buf, input_buf, window, first_pass->main_twiddle, lfft, nb_nonzero);
+	else
+		nb_nonzero = modfreqoffsetreal_forward_first_v8f(work_buf, input_buf, first_pass->main_twiddle, lfft, nb_nonzero);
+
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, nb_nonzero, elem_first, elem_count, threads);
+
+	for (i = block_first; i <= block_last; i++) {
+		v8f w, x, y, z;
+		v8f a, b, c, d;
+		V8F_LD2(w, x, work_buf + i*16);
+		V8F_LD2(y, z, work_buf + lfft*2 - 16 - i*16);
+		y = v8f_reverse(y);
+		z = v8f_reverse(z);
+		z = v8f_neg(z);
+		V8F_INTERLEAVE(a, b, w, y);
+		V8F_INTERLEAVE(c, d, x, z);
+		V8F_ST2X2INT(output_buf + i*32, output_buf + i*32 + 16, a, c, b, d);
+	}
+}
+
+static
+void
+modfreqoffsetreal_forward_spectrum_v8f
+	(const struct fftset_fft     *first_pass
+	,float                       *output_buf
+	,const float                 *input_buf
+	,enum fftset_spectrum_format  format
+	,size_t                       band_size
+	,float                       *work_buf
+	,struct fftset_threads       *threads
+	)
+{
+	const size_t lfft = first_pass->lfft;
+	float VEC_ALIGN_BEST power[16];
+	size_t i;
+
+	(void)modfreqoffsetreal_forward_first_v8f(work_buf, input_buf, first_pass->main_twiddle, lfft, FFTSET_VEC_NONZERO_ALL);
+
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, output_buf, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, threads);
+
+	for (i = 0; i < lfft / 16; i++) {
+		v8f w, x, y, z;
+		v8f pw, py, plo, phi;
+		V8F_LD2(w, x, work_buf + i*16);
+		V8F_LD2(y, z, work_buf + lfft*2 - 16 - i*16);
+		pw = v8f_add(v8f_mul(w, w), v8f_mul(x, x));
+		py = v8f_reverse(v8f_add(v8f_mul(y, y), v8f_mul(z, z)));
+		V8F_INTERLEAVE(plo, phi, pw, py);
+		if (band_size == 1) {
+			v8f_st(output_buf + i*16 + 0, plo);
+			v8f_st(output_buf + i*16 + 8, phi);
+			fftset_vec_spectrum_finish(output_buf + i*16, 16, format);
+		} else {
+			v8f_st(power + 0, plo);
+			v8f_st(power + 8, phi);
+			fftset_vec_spectrum_bands(output_buf, power, i*16, 16, band_size);
+		}
+	}
+
+	if (band_size > 1)
+		fftset_vec_spectrum_finish(output_buf, (lfft + band_size - 1) / band_size, format);
+}
+
+static
+void
+modfreqoffsetreal_inverse_v8f
+	(const struct fftset_fft    *first_pass
+	,float                      *output_buf
+	,const float                *input_buf
+	,size_t                      out_first
+	,size_t                      out_count
+	,const float                *window
+	,float                       scale
+	,float                      *work_buf
+	,struct fftset_threads      *threads
+	)
+{
+	const size_t lfft    = first_pass->lfft;
+	const size_t out_end = modfreqoffsetreal_window_end_v8f(lfft, out_first, out_count);
+	float       *temp    = (window != NULL) ? work_buf + 2 * lfft : output_buf;
+	size_t block_first, block_count;
+	size_t i;
+
+	for (i = 0; i < lfft / 16; i++) {
+		v8f w, x, y, z;
+		v8f a, b, c, d;
+		V8F_LD2X2DINT(a, c, b, d, input_buf + i*32, input_buf + i*32 + 16);
+		V8F_DEINTERLEAVE(w, y, a, b);
+		V8F_DEINTERLEAVE(x, z, c, d);
+		x = v8f_neg(x);
+		y = v8f_reverse(y);
+		z = v8f_reverse(z);
+		V8F_ST2(work_buf + i*16,               w, x);
+		V8F_ST2(work_buf + lfft*2 - 16 - i*16, y, z);
+	}
+
+	modfreqoffsetreal_window_blocks_v8f(lfft, out_first, out_end, &block_first, &block_count);
+	fftset_vec_stockham(first_pass->next_stockham, 1, work_buf, temp, FFTSET_VEC_NONZERO_ALL, 4 * block_first, 4 * block_count, threads);
+
+	if (window != NULL)
+		modfreqoffsetreal_inverse_final_windowed_v8f(output_buf, temp, work_buf, window, scale, first_pass->main_twiddle, lfft, out_first, out_end);
+	else
+		modfreqoffsetreal_inverse_final_v8f(output_buf, work_buf, scale, first_pass->main_twiddle, lfft, out_first, out_end);
+}
+
+#endif
+
+#endif /* FFTSET_MOD_FREQOFFSETREAL_V8F_H */
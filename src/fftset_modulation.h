@@ -25,24 +25,75 @@
 
 struct fftset_fft;
 
+/* Identifiers of the modulations. These are stored in exported plan files
+ * so must never change. */
+enum fftset_modulation_id {
+	FFTSET_MODULATION_ID_FREQ_OFFSET_REAL = 1,
+	FFTSET_MODULATION_ID_COMPLEX          = 2
+};
+
 struct fftset_modulation {
-	int          (*init)(struct fftset_fft *fft, struct fftset_vec **veclist, struct cop_salloc_iface *alloc, unsigned complex_len);
+	/* Builds the FFT. Must set next_compat, next_stockham, main_twiddle,
+	 * main_twiddle_len and variant and then call restore. */
+	int          (*init)(struct fftset_fft *fft, struct fftset *fc, size_t complex_len);
+
+	/* Given an FFT where all members other than the function pointers have
+	 * been set (e.g. from an exported plan file), verifies the members are
+	 * consistent with the variant and binds the functions. Returns non-zero
+	 * if the FFT cannot be used (including when the variant needs kernels
+	 * which the fftset does not have). */
+	int          (*restore)(struct fftset_fft *fft, const struct fftset *fc);
+
+	enum fftset_modulation_id       id;
 };
 
 struct fftset_fft {
 	/* The following members are used by fftset in searches for particular
 	 * FFTs. */
-	unsigned                        lfft;
+	size_t                          lfft;
 	const struct fftset_modulation *modulator;
 	struct fftset_fft              *next;
 
 	/* You are free to modify the rest of the members to suit your needs. */
+	/* Inner passes used for convolution and for Stockham (forward and
+	 * inverse) transforms. These are the same unless the measuring planner
+	 * found different chains to be faster. */
 	const struct fftset_vec        *next_compat;
+	const struct fftset_vec        *next_stockham;
 	const float                    *main_twiddle;
-	void                          (*get_kern)(const struct fftset_fft *fft, float *out, const float *in);
-	void                          (*fwd)(const struct fftset_fft *fft, float *out, const float *in, float *work);
-	void                          (*inv)(const struct fftset_fft *fft, float *out, const float *in, float *work);
-	void                          (*conv)(const struct fftset_fft *fft, float *out, const float *in, const float *kern, float *work);
+	/* Number of floats in main_twiddle. */
+	size_t                          main_twiddle_len;
+	/* Modulation specific identifier of the implementation being used. */
+	unsigned                        variant;
+	/* Only the first nb_nonzero input values given to get_kern, fwd and conv
+	 * may be non-zero (FFTSET_VEC_NONZERO_ALL if nothing is known). */
+	/* The outputs of get_kern and inv are multiplied by scale (which is
+	 * folded into the twiddles of the outer pass so costs no extra sweep). */
+	void                          (*get_kern)(const struct fftset_fft *fft, float *out, const float *in, size_t nb_nonzero, float scale);
+	/* If window is not NULL, every input value is multiplied by the
+	 * corresponding window coefficient as it is loaded (there is one
+	 * coefficient per real for real modulations and one per complex value
+	 * for complex modulations). */
+	void                          (*fwd)(const struct fftset_fft *fft, float *out, const float *in, const float *window, size_t nb_nonzero, size_t out_first, size_t out_count, float *work, struct fftset_threads *threads);
+	/* Only outputs [out_first, out_first + out_count) of fwd, inv and conv
+	 * are computed (out_count may be FFTSET_VEC_WINDOW_ALL); the rest of out
+	 * is left undefined. If the window given to inv is not NULL, the outputs
+	 * multiplied by the window (laid out as for fwd) are instead added to
+	 * out, the rest of out is left untouched and work must hold twice as
+	 * many floats. */
+	void                          (*inv)(const struct fftset_fft *fft, float *out, const float *in, size_t out_first, size_t out_count, const float *window, float scale, float *work, struct fftset_threads *threads);
+	void                          (*conv)(const struct fftset_fft *fft, float *out, const float *in, size_t nb_nonzero, size_t out_first, size_t out_count, const void *kern, enum fftset_kernel_format kern_format, float *work, struct fftset_threads *threads);
+	/* Transforms two real signals at once (NULL if not supported). */
+	void                          (*fwd_pair)(const struct fftset_fft *fft, float *out, const float *in_a, const float *in_b, float *work, struct fftset_threads *threads);
+	/* Forward transform which outputs the power, magnitude or log-power of
+	 * the bins summed over bands of band_size bins (see
+	 * fftset_fft_forward_spectrum()). */
+	void                          (*fwd_spectrum)(const struct fftset_fft *fft, float *out, const float *in, enum fftset_spectrum_format format, size_t band_size, float *work, struct fftset_threads *threads);
+	/* Convolves a real signal (loaded as the real parts of the input) with a
+	 * kernel from get_kern (NULL if not supported). Only the first pass knows
+	 * that the imaginary parts are zero; the inner passes are the same full
+	 * complex DIF/DIT chain as conv. */
+	void                          (*conv_real)(const struct fftset_fft *fft, float *out, const float *in, const float *kern, float *work, struct fftset_threads *threads);
 };
 
 #endif /* FFTSET_MODULATION_H */
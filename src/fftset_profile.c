@@ -0,0 +1,189 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset_profile.h"
+#include <string.h>
+
+#if FFTSET_PROFILE
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define FFTSET_PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define FFTSET_PROFILE_THREAD_LOCAL __thread
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define FFTSET_PROFILE_RDTSC() __rdtsc()
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define FFTSET_PROFILE_RDTSC() __rdtsc()
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+struct fftset_profile_buffer {
+	size_t                       nb_records;
+	int                          paused;
+	struct fftset_profile_record records[FFTSET_PROFILE_MAX_RECORDS];
+};
+
+static FFTSET_PROFILE_THREAD_LOCAL struct fftset_profile_buffer fftset_profile_buf;
+
+fftset_profile_ticks fftset_profile_now(void)
+{
+#if defined(FFTSET_PROFILE_RDTSC)
+	return FFTSET_PROFILE_RDTSC();
+#elif defined(_WIN32)
+	LARGE_INTEGER freq;
+	LARGE_INTEGER now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (fftset_profile_ticks)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (fftset_profile_ticks)ts.tv_sec * 1000000000u + (fftset_profile_ticks)ts.tv_nsec;
+#endif
+}
+
+size_t fftset_profile_mark(void)
+{
+	return fftset_profile_buf.nb_records;
+}
+
+static struct fftset_profile_record *fftset_profile_append(void)
+{
+	struct fftset_profile_buffer *buf = &fftset_profile_buf;
+	if (buf->paused || buf->nb_records >= FFTSET_PROFILE_MAX_RECORDS)
+		return NULL;
+	return &buf->records[buf->nb_records++];
+}
+
+void
+fftset_profile_pass
+	(enum fftset_profile_event  event
+	,unsigned                   radix
+	,unsigned                   vec_width
+	,size_t                     lfft
+	,size_t                     nb_vec_fft
+	,fftset_profile_ticks       start
+	)
+{
+	fftset_profile_ticks          end = fftset_profile_now();
+	struct fftset_profile_record *rec = fftset_profile_append();
+	if (rec == NULL)
+		return;
+	rec->event      = event;
+	rec->radix      = radix;
+	rec->vec_width  = vec_width;
+	rec->lfft       = lfft;
+	rec->nb_vec_fft = nb_vec_fft;
+	rec->ticks      = end - start;
+}
+
+void
+fftset_profile_call
+	(enum fftset_profile_event  event
+	,size_t                     lfft
+	,size_t                     mark
+	,fftset_profile_ticks       start
+	)
+{
+	fftset_profile_ticks          total  = fftset_profile_now() - start;
+	fftset_profile_ticks          passes = 0;
+	struct fftset_profile_record *rec;
+	size_t                        i;
+
+	for (i = mark; i < fftset_profile_buf.nb_records; i++)
+		passes += fftset_profile_buf.records[i].ticks;
+
+	if ((rec = fftset_profile_append()) == NULL)
+		return;
+	rec->event      = FFTSET_PROFILE_MODULATOR;
+	rec->radix      = 0;
+	rec->vec_width  = 0;
+	rec->lfft       = lfft;
+	rec->nb_vec_fft = 1;
+	rec->ticks      = (total > passes) ? total - passes : 0;
+
+	if ((rec = fftset_profile_append()) == NULL)
+		return;
+	rec->event      = event;
+	rec->radix      = 0;
+	rec->vec_width  = 0;
+	rec->lfft       = lfft;
+	rec->nb_vec_fft = 1;
+	rec->ticks      = total;
+}
+
+void fftset_profile_pause(int pause)
+{
+	fftset_profile_buf.paused += pause ? 1 : -1;
+}
+
+int fftset_profile_enabled(void)
+{
+	return 1;
+}
+
+void fftset_profile_reset(void)
+{
+	fftset_profile_buf.nb_records = 0;
+}
+
+size_t
+fftset_profile_read
+	(struct fftset_profile_record *records
+	,size_t                        max_records
+	)
+{
+	size_t nb = fftset_profile_buf.nb_records;
+	if (nb > 0 && max_records > 0)
+		memcpy(records, fftset_profile_buf.records, sizeof(records[0]) * ((nb < max_records) ? nb : max_records));
+	return nb;
+}
+
+#else
+
+int fftset_profile_enabled(void)
+{
+	return 0;
+}
+
+void fftset_profile_reset(void)
+{
+}
+
+size_t
+fftset_profile_read
+	(struct fftset_profile_record *records
+	,size_t                        max_records
+	)
+{
+	(void)records;
+	(void)max_records;
+	return 0;
+}
+
+#endif
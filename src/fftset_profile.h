@@ -0,0 +1,87 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_PROFILE_H
+#define FFTSET_PROFILE_H
+
+#include "fftset/fftset.h"
+
+/* Recording functions used when the library is built with FFTSET_PROFILE
+ * (see the profiling section of fftset.h). When it is not, the macros below
+ * expand to nothing (or to the profiled call) and none of these functions
+ * are referenced. */
+#ifndef FFTSET_PROFILE
+#define FFTSET_PROFILE (0)
+#endif
+
+#if FFTSET_PROFILE
+
+typedef unsigned long long fftset_profile_ticks;
+
+fftset_profile_ticks fftset_profile_now(void);
+
+/* Returns the number of records held by the calling thread. Passed to
+ * fftset_profile_call() to find the passes which belong to the call. */
+size_t fftset_profile_mark(void);
+
+/* Records a pass which started at start. */
+void
+fftset_profile_pass
+	(enum fftset_profile_event  event
+	,unsigned                   radix
+	,unsigned                   vec_width
+	,size_t                     lfft
+	,size_t                     nb_vec_fft
+	,fftset_profile_ticks       start
+	);
+
+/* Records an execution function which started at start along with the time
+ * spent in its modulation (the time not covered by the records added since
+ * mark). */
+void
+fftset_profile_call
+	(enum fftset_profile_event  event
+	,size_t                     lfft
+	,size_t                     mark
+	,fftset_profile_ticks       start
+	);
+
+/* Stops (pause non-zero) and restarts recording on the calling thread. Calls
+ * may be nested. */
+void fftset_profile_pause(int pause);
+
+#define FFTSET_PROFILE_CALL(event_, fft_, call_) \
+	do { \
+		size_t               mark_  = fftset_profile_mark(); \
+		fftset_profile_ticks start_ = fftset_profile_now(); \
+		call_; \
+		fftset_profile_call(event_, (fft_)->lfft, mark_, start_); \
+	} while (0)
+
+#define FFTSET_PROFILE_PAUSE(pause_) fftset_profile_pause(pause_)
+
+#else
+
+#define FFTSET_PROFILE_CALL(event_, fft_, call_) call_
+#define FFTSET_PROFILE_PAUSE(pause_) ((void)0)
+
+#endif
+
+#endif /* FFTSET_PROFILE_H */
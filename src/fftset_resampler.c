@@ -0,0 +1,164 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset/fftset.h"
+#include "fftset_modulation.h"
+#include "fftset_vec.h"
+#include "fftset_profile.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Positions are counted at the upsampled rate from the start of the frame
+ * of the current block. history holds the nb_history input samples which
+ * fall in the frame; the last of them is at next_in - up. The frame is full
+ * once next_in reaches the frame length. The next output to be kept is at
+ * next_out, which is never less than nb_taps - 1 (the first valid output of
+ * an overlap-save block). After every block the frame moves forward by the
+ * number of valid outputs. */
+
+int
+fftset_resampler_init
+	(struct fftset_resampler    *resampler
+	,const struct fftset_fft    *first_pass
+	,const float                *filter
+	,size_t                      nb_taps
+	,size_t                      up
+	,size_t                      down
+	)
+{
+	const size_t frame_len  = 2 * first_pass->lfft;
+	/* Keeps every buffer aligned to 64 bytes. */
+	const size_t padded_len = (frame_len + 15) & ~(size_t)15;
+
+	assert(first_pass->modulator->id == FFTSET_MODULATION_ID_FREQ_OFFSET_REAL);
+	assert(nb_taps > 0 && nb_taps <= frame_len);
+	assert(up > 0);
+	assert(down > 0);
+
+	/* The kernel, history, frame and work buffers. */
+	resampler->mem = malloc(sizeof(float) * 4 * padded_len + 63);
+	if (resampler->mem == NULL)
+		return -1;
+
+	resampler->kernel     = (float *)(((size_t)resampler->mem + 63) & ~(size_t)63);
+	resampler->history    = resampler->kernel + padded_len;
+	resampler->frame      = resampler->history + padded_len;
+	resampler->work       = resampler->frame + padded_len;
+	resampler->first_pass = first_pass;
+	resampler->nb_taps    = nb_taps;
+	resampler->up         = up;
+	resampler->down       = down;
+	resampler->nb_history = 0;
+	resampler->next_in    = nb_taps - 1;
+	resampler->next_out   = nb_taps - 1;
+
+	/* The gain of up makes up for the inserted zeros. The unnormalised
+	 * convolution also multiplies by the length of the transform. */
+	memcpy(resampler->frame, filter, sizeof(float) * nb_taps);
+	memset(resampler->frame + nb_taps, 0, sizeof(float) * (frame_len - nb_taps));
+	fftset_fft_conv_get_kernel_scaled(first_pass, resampler->kernel, resampler->frame, (float)up / first_pass->lfft);
+
+	return 0;
+}
+
+void fftset_resampler_destroy(struct fftset_resampler *resampler)
+{
+	free(resampler->mem);
+}
+
+size_t
+fftset_resampler_write
+	(struct fftset_resampler    *resampler
+	,const float                *input
+	,size_t                      nb_samples
+	)
+{
+	const size_t frame_len = 2 * resampler->first_pass->lfft;
+	const size_t up        = resampler->up;
+	size_t       nb_in;
+
+	if (resampler->next_in >= frame_len)
+		return 0;
+
+	nb_in = (frame_len - resampler->next_in + up - 1) / up;
+	if (nb_in > nb_samples)
+		nb_in = nb_samples;
+
+	memcpy(resampler->history + resampler->nb_history, input, sizeof(float) * nb_in);
+	resampler->nb_history += nb_in;
+	resampler->next_in    += nb_in * up;
+
+	return nb_in;
+}
+
+size_t
+fftset_resampler_read
+	(struct fftset_resampler    *resampler
+	,float                      *output
+	)
+{
+	const struct fftset_fft *first_pass = resampler->first_pass;
+	const size_t             frame_len  = 2 * first_pass->lfft;
+	const size_t             up         = resampler->up;
+	const size_t             down       = resampler->down;
+	const size_t             nb_valid   = frame_len - resampler->nb_taps + 1;
+	const size_t             first_in   = resampler->next_in - resampler->nb_history * up;
+	size_t                   nb_out     = 0;
+	size_t                   nb_drop, i;
+
+	if (resampler->next_in < frame_len)
+		return 0;
+
+	/* The block may not contain any of the outputs which are kept. */
+	if (resampler->next_out < frame_len) {
+		float *frame = resampler->frame;
+
+		nb_out = (frame_len - 1 - resampler->next_out) / down + 1;
+
+		if (up == 1) {
+			memset(frame, 0, sizeof(float) * first_in);
+			memcpy(frame + first_in, resampler->history, sizeof(float) * resampler->nb_history);
+		} else {
+			memset(frame, 0, sizeof(float) * frame_len);
+			for (i = 0; i < resampler->nb_history; i++)
+				frame[first_in + i * up] = resampler->history[i];
+		}
+
+		fftset_fft_conv_window(first_pass, frame, resampler->next_out, (nb_out - 1) * down + 1, frame, resampler->kernel, resampler->work);
+
+		for (i = 0; i < nb_out; i++)
+			output[i] = frame[resampler->next_out + i * down];
+
+		resampler->next_out += nb_out * down;
+	}
+
+	/* Move the frame forward and forget the samples which are now before
+	 * it. */
+	nb_drop = (first_in < nb_valid) ? (nb_valid - first_in + up - 1) / up : 0;
+	if (nb_drop > resampler->nb_history)
+		nb_drop = resampler->nb_history;
+	memmove(resampler->history, resampler->history + nb_drop, sizeof(float) * (resampler->nb_history - nb_drop));
+	resampler->nb_history -= nb_drop;
+	resampler->next_in    -= nb_valid;
+	resampler->next_out   -= nb_valid;
+
+	return nb_out;
+}
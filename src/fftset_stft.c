@@ -0,0 +1,248 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset/fftset.h"
+#include "fftset_modulation.h"
+#include "fftset_vec.h"
+#include "fftset_profile.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The stream is held in a ring of frame_len floats which is stored twice
+ * (ring[i] == ring[frame_len + i]) so the frame which starts at the oldest
+ * value (pos) is always contiguous at ring + pos. Every input value is
+ * written twice but a frame is never copied unless ring + pos is not aligned
+ * well enough for the first pass (i.e. the hop is not a multiple of four
+ * floats), in which case it is copied to frame first. pending is the number
+ * of floats which must be written before the next frame is complete. */
+
+/* Number of floats in a sample. */
+static size_t fftset_stft_sample_size(const struct fftset_fft *first_pass)
+{
+	return (first_pass->modulator->id == FFTSET_MODULATION_ID_COMPLEX) ? 2 : 1;
+}
+
+int
+fftset_stft_init
+	(struct fftset_stft         *stft
+	,const struct fftset_fft    *first_pass
+	,const float                *window
+	,size_t                      hop
+	)
+{
+	const size_t frame_len   = 2 * first_pass->lfft;
+	const size_t sample_size = fftset_stft_sample_size(first_pass);
+	const size_t window_len  = frame_len / sample_size;
+	/* Keeps every buffer aligned to 64 bytes. */
+	const size_t padded_len  = (frame_len + 15) & ~(size_t)15;
+
+	assert(hop > 0);
+
+	/* The ring, frame, work and window buffers. */
+	stft->mem = malloc(sizeof(float) * (4 * padded_len + window_len) + 63);
+	if (stft->mem == NULL)
+		return -1;
+
+	stft->ring        = (float *)(((size_t)stft->mem + 63) & ~(size_t)63);
+	stft->frame       = stft->ring + 2 * padded_len;
+	stft->work        = stft->frame + padded_len;
+	stft->window      = (window != NULL) ? stft->work + padded_len : NULL;
+	stft->first_pass  = first_pass;
+	stft->frame_len   = frame_len;
+	stft->hop         = hop * sample_size;
+	stft->pos         = 0;
+	stft->pending     = frame_len;
+
+	if (window != NULL)
+		memcpy(stft->window, window, sizeof(float) * window_len);
+
+	return 0;
+}
+
+void fftset_stft_destroy(struct fftset_stft *stft)
+{
+	free(stft->mem);
+}
+
+size_t
+fftset_stft_write
+	(struct fftset_stft         *stft
+	,const float                *input
+	,size_t                      nb_samples
+	)
+{
+	const size_t frame_len   = stft->frame_len;
+	const size_t sample_size = fftset_stft_sample_size(stft->first_pass);
+	size_t nb_in = (nb_samples * sample_size < stft->pending) ? nb_samples * sample_size : stft->pending;
+	size_t nb_written, nb_first;
+
+	stft->pending -= nb_in;
+	nb_written     = nb_in;
+
+	/* Only the last frame_len values can be part of a frame. */
+	if (nb_in > frame_len) {
+		stft->pos = (stft->pos + nb_in - frame_len) % frame_len;
+		input    += nb_in - frame_len;
+		nb_in     = frame_len;
+	}
+
+	nb_first = (nb_in < frame_len - stft->pos) ? nb_in : frame_len - stft->pos;
+	memcpy(stft->ring + stft->pos, input, sizeof(float) * nb_first);
+	memcpy(stft->ring + stft->pos + frame_len, input, sizeof(float) * nb_first);
+	memcpy(stft->ring, input + nb_first, sizeof(float) * (nb_in - nb_first));
+	memcpy(stft->ring + frame_len, input + nb_first, sizeof(float) * (nb_in - nb_first));
+	stft->pos = (stft->pos + nb_in) % frame_len;
+
+	return nb_written / sample_size;
+}
+
+int
+fftset_stft_read
+	(struct fftset_stft         *stft
+	,float                      *output_buf
+	)
+{
+	const struct fftset_fft *first_pass = stft->first_pass;
+	const float             *frame      = stft->ring + stft->pos;
+
+	if (stft->pending)
+		return 0;
+
+	if (stft->pos % 4) {
+		memcpy(stft->frame, frame, sizeof(float) * stft->frame_len);
+		frame = stft->frame;
+	}
+
+	FFTSET_PROFILE_CALL(FFTSET_PROFILE_FORWARD, first_pass, first_pass->fwd(first_pass, output_buf, frame, stft->window, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, stft->work, NULL));
+
+	stft->pending = stft->hop;
+	return 1;
+}
+
+/* The overlap-add buffer holds 2 * span floats where span is the longer of
+ * the frame and the hop. acc[pos, pos + span) holds the partial sums of the
+ * stream which has not been output yet (zero beyond the frames which have
+ * been added). Frames are added at acc + pos by the final pass of the
+ * inverse transform. Once the live region reaches the end of the buffer it
+ * is moved back to the start, which costs less than a hop per frame on
+ * average. If acc + pos is not aligned well enough for the final pass (i.e.
+ * the hop is not a multiple of four floats) the frame is accumulated in the
+ * aligned frame buffer instead. */
+
+int
+fftset_istft_init
+	(struct fftset_istft        *istft
+	,const struct fftset_fft    *first_pass
+	,const float                *analysis_window
+	,const float                *synthesis_window
+	,size_t                      hop
+	)
+{
+	const size_t frame_len   = 2 * first_pass->lfft;
+	const size_t sample_size = fftset_stft_sample_size(first_pass);
+	const size_t window_len  = frame_len / sample_size;
+	const size_t span        = (frame_len > hop * sample_size) ? frame_len : hop * sample_size;
+	const size_t padded_len  = (frame_len + 15) & ~(size_t)15;
+	const size_t padded_span = (span + 15) & ~(size_t)15;
+	const size_t nb_gains    = (hop < window_len) ? hop : window_len;
+	double *gains;
+	size_t i;
+
+	assert(hop > 0);
+
+	/* The overlap-add, frame, work (which must be twice the usual size) and
+	 * window buffers. */
+	istft->mem = malloc(sizeof(float) * (2 * padded_span + 3 * padded_len + window_len) + 63);
+	gains      = malloc(sizeof(double) * nb_gains);
+	if (istft->mem == NULL || gains == NULL) {
+		free(istft->mem);
+		free(gains);
+		return -1;
+	}
+
+	istft->acc        = (float *)(((size_t)istft->mem + 63) & ~(size_t)63);
+	istft->frame      = istft->acc + 2 * padded_span;
+	istft->work       = istft->frame + padded_len;
+	istft->window     = istft->work + 2 * padded_len;
+	istft->first_pass = first_pass;
+	istft->frame_len  = frame_len;
+	istft->span       = span;
+	istft->hop        = hop * sample_size;
+	istft->pos        = 0;
+
+	/* Every output sample is the sum of the frame samples which are a whole
+	 * number of hops apart so the gain only depends on the position in the
+	 * hop. */
+	for (i = 0; i < nb_gains; i++)
+		gains[i] = 0.0;
+	for (i = 0; i < window_len; i++) {
+		double a = (analysis_window != NULL) ? analysis_window[i] : 1.0;
+		double s = (synthesis_window != NULL) ? synthesis_window[i] : 1.0;
+		gains[i % hop] += a * s;
+	}
+	for (i = 0; i < window_len; i++) {
+		double s = (synthesis_window != NULL) ? synthesis_window[i] : 1.0;
+		double g = gains[i % hop] * first_pass->lfft;
+		istft->window[i] = (g != 0.0) ? (float)(s / g) : 0.0f;
+	}
+
+	memset(istft->acc, 0, sizeof(float) * 2 * span);
+
+	free(gains);
+	return 0;
+}
+
+void fftset_istft_destroy(struct fftset_istft *istft)
+{
+	free(istft->mem);
+}
+
+void
+fftset_istft_process
+	(struct fftset_istft        *istft
+	,float                      *output
+	,const float                *input_buf
+	)
+{
+	const struct fftset_fft *first_pass = istft->first_pass;
+	const size_t             frame_len  = istft->frame_len;
+	const size_t             span       = istft->span;
+	const size_t             hop        = istft->hop;
+	float                   *frame      = istft->acc + istft->pos;
+
+	if (istft->pos % 4) {
+		memcpy(istft->frame, frame, sizeof(float) * frame_len);
+		FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, istft->frame, input_buf, 0, FFTSET_VEC_WINDOW_ALL, istft->window, 1.0f, istft->work, NULL));
+		memcpy(frame, istft->frame, sizeof(float) * frame_len);
+	} else {
+		FFTSET_PROFILE_CALL(FFTSET_PROFILE_INVERSE, first_pass, first_pass->inv(first_pass, frame, input_buf, 0, FFTSET_VEC_WINDOW_ALL, istft->window, 1.0f, istft->work, NULL));
+	}
+
+	memcpy(output, frame, sizeof(float) * hop);
+
+	if (istft->pos + hop > span) {
+		memmove(istft->acc, frame + hop, sizeof(float) * (span - hop));
+		istft->pos = 0;
+	} else {
+		istft->pos += hop;
+	}
+	memset(istft->acc + istft->pos + span - hop, 0, sizeof(float) * hop);
+}
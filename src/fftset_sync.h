@@ -0,0 +1,123 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_SYNC_H
+#define FFTSET_SYNC_H
+
+/* Minimal synchronisation primitives used to make plan creation safe from
+ * multiple threads.
+ *
+ * Lookups go through the hash indexes of fftset_index.c without taking a
+ * lock. A node is fully initialised before it is inserted, and an index slot
+ * is filled by writing the key and then storing the value with a release;
+ * readers load the table and the value with acquire loads. A full table is
+ * never grown in place: a larger copy is built and published with a release
+ * store, so a reader holding the old table may miss the newest entries (and
+ * then retries under the lock) but never sees a partial one. The sorted plan
+ * lists are only walked and modified while holding the lock. Writers
+ * serialise on a spinlock which yields to the scheduler while it is
+ * contended; creation is expected to be rare compared to lookup so nothing
+ * fancier is needed. */
+
+/* Gives up the rest of the time slice of the calling thread while the lock
+ * is contended. This lives in fftset_threads.c so that the platform headers
+ * which provide it are not pulled into every user of this header. */
+void fftset_sync_yield(void);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+#include <intrin.h>
+
+/* The MSVC intrinsics make no ordering guarantees for plain (or volatile,
+ * under /volatile:iso) accesses. On x86 and x64 every load is an acquire and
+ * every store is a release in hardware so a compiler barrier is enough; ARM
+ * needs a data memory barrier. */
+#if defined(_M_IX86) || defined(_M_X64)
+#define FFTSET_HW_BARRIER() ((void)0)
+#elif defined(_M_ARM64)
+#define FFTSET_HW_BARRIER() __dmb(_ARM64_BARRIER_ISH)
+#elif defined(_M_ARM)
+#define FFTSET_HW_BARRIER() __dmb(_ARM_BARRIER_ISH)
+#else
+#error "fftset_sync.h does not know how to order memory on this MSVC target"
+#endif
+
+static __forceinline void *fftset_load_acquire_ptr(void *const volatile *p)
+{
+	void *v = *p;
+	_ReadWriteBarrier();
+	FFTSET_HW_BARRIER();
+	return v;
+}
+
+static __forceinline void fftset_store_release_ptr(void *volatile *p, void *v)
+{
+	FFTSET_HW_BARRIER();
+	_ReadWriteBarrier();
+	*p = v;
+}
+
+/* The unsuffixed interlocked intrinsics are full barriers on every target. */
+static __forceinline void fftset_lock(volatile long *l)
+{
+	while (_InterlockedCompareExchange(l, 1, 0) != 0) {
+		while (*l != 0)
+			fftset_sync_yield();
+	}
+}
+
+static __forceinline void fftset_unlock(volatile long *l)
+{
+	_InterlockedExchange(l, 0);
+}
+
+#elif defined(__GNUC__) || defined(__clang__)
+
+static inline void *fftset_load_acquire_ptr(void *const volatile *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void fftset_store_release_ptr(void *volatile *p, void *v)
+{
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline void fftset_lock(volatile long *l)
+{
+	while (__atomic_exchange_n(l, 1, __ATOMIC_ACQUIRE) != 0) {
+		while (__atomic_load_n(l, __ATOMIC_RELAXED) != 0)
+			fftset_sync_yield();
+	}
+}
+
+static inline void fftset_unlock(volatile long *l)
+{
+	__atomic_store_n(l, 0, __ATOMIC_RELEASE);
+}
+
+#else
+#error "fftset_sync.h does not know how to provide atomics for this compiler"
+#endif
+
+#define FFTSET_LOAD_ACQUIRE(p_)     fftset_load_acquire_ptr((void *const volatile *)&(p_))
+#define FFTSET_STORE_RELEASE(p_, v_) fftset_store_release_ptr((void *volatile *)&(p_), (v_))
+
+#endif /* FFTSET_SYNC_H */
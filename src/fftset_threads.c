@@ -0,0 +1,317 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#include "fftset/fftset.h"
+#include "fftset_threads.h"
+#include "fftset_sync.h"
+#include <stdlib.h>
+
+/* A pool of nb_threads - 1 workers which sleep on a condition variable until
+ * fftset_threads_run() publishes a new job by incrementing the generation.
+ * The calling thread runs part zero and then waits for the workers to finish
+ * their parts. Jobs from different callers are serialised. */
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+typedef SRWLOCK            fftset_mutex;
+typedef CONDITION_VARIABLE fftset_cond;
+typedef HANDLE             fftset_thread;
+
+static int  fftset_mutex_init(fftset_mutex *m)                 { InitializeSRWLock(m); return 0; }
+static void fftset_mutex_destroy(fftset_mutex *m)              { (void)m; }
+static void fftset_mutex_lock(fftset_mutex *m)                 { AcquireSRWLockExclusive(m); }
+static void fftset_mutex_unlock(fftset_mutex *m)               { ReleaseSRWLockExclusive(m); }
+static int  fftset_cond_init(fftset_cond *c)                   { InitializeConditionVariable(c); return 0; }
+static void fftset_cond_destroy(fftset_cond *c)                { (void)c; }
+static void fftset_cond_wait(fftset_cond *c, fftset_mutex *m)  { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void fftset_cond_signal(fftset_cond *c)                 { WakeConditionVariable(c); }
+static void fftset_cond_broadcast(fftset_cond *c)              { WakeAllConditionVariable(c); }
+
+static unsigned fftset_threads_nb_cpus(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0) ? (unsigned)info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+typedef pthread_mutex_t fftset_mutex;
+typedef pthread_cond_t  fftset_cond;
+typedef pthread_t       fftset_thread;
+
+static int  fftset_mutex_init(fftset_mutex *m)                 { return pthread_mutex_init(m, NULL); }
+static void fftset_mutex_destroy(fftset_mutex *m)              { pthread_mutex_destroy(m); }
+static void fftset_mutex_lock(fftset_mutex *m)                 { pthread_mutex_lock(m); }
+static void fftset_mutex_unlock(fftset_mutex *m)               { pthread_mutex_unlock(m); }
+static int  fftset_cond_init(fftset_cond *c)                   { return pthread_cond_init(c, NULL); }
+static void fftset_cond_destroy(fftset_cond *c)                { pthread_cond_destroy(c); }
+static void fftset_cond_wait(fftset_cond *c, fftset_mutex *m)  { pthread_cond_wait(c, m); }
+static void fftset_cond_signal(fftset_cond *c)                 { pthread_cond_signal(c); }
+static void fftset_cond_broadcast(fftset_cond *c)              { pthread_cond_broadcast(c); }
+
+static unsigned fftset_threads_nb_cpus(void)
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (unsigned)n : 1;
+}
+
+#endif
+
+struct fftset_thread_pool;
+
+struct fftset_thread_worker {
+	struct fftset_thread_pool *pool;
+	unsigned                   part;
+	fftset_thread              handle;
+};
+
+struct fftset_thread_pool {
+	/* Protects everything below. */
+	fftset_mutex                 lock;
+	/* Signalled when a new job is published or on shutdown. */
+	fftset_cond                  start;
+	/* Signalled when the last worker finishes its part. */
+	fftset_cond                  done;
+	/* Held for the duration of a job. */
+	fftset_mutex                 run_lock;
+
+	fftset_threads_fn            fn;
+	void                        *arg;
+	unsigned long                generation;
+	unsigned                     nb_pending;
+	unsigned                     nb_threads;
+	int                          shutdown;
+
+	/* nb_threads - 1 workers. */
+	struct fftset_thread_worker *workers;
+};
+
+static void fftset_threads_worker(struct fftset_thread_worker *worker)
+{
+	struct fftset_thread_pool *pool = worker->pool;
+	unsigned long              seen = 0;
+
+	fftset_mutex_lock(&(pool->lock));
+	for (;;) {
+		fftset_threads_fn fn;
+		void             *arg;
+
+		while (pool->generation == seen && !pool->shutdown)
+			fftset_cond_wait(&(pool->start), &(pool->lock));
+		if (pool->shutdown)
+			break;
+
+		seen = pool->generation;
+		fn   = pool->fn;
+		arg  = pool->arg;
+		fftset_mutex_unlock(&(pool->lock));
+
+		fn(arg, worker->part, pool->nb_threads);
+
+		fftset_mutex_lock(&(pool->lock));
+		if (--pool->nb_pending == 0)
+			fftset_cond_signal(&(pool->done));
+	}
+	fftset_mutex_unlock(&(pool->lock));
+}
+
+void fftset_sync_yield(void)
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI fftset_threads_entry(LPVOID arg)
+{
+	fftset_threads_worker(arg);
+	return 0;
+}
+#else
+static void *fftset_threads_entry(void *arg)
+{
+	fftset_threads_worker(arg);
+	return NULL;
+}
+#endif
+
+static int fftset_threads_start(struct fftset_thread_worker *worker)
+{
+#ifdef _WIN32
+	worker->handle = CreateThread(NULL, 0, fftset_threads_entry, worker, 0, NULL);
+	return (worker->handle == NULL) ? -1 : 0;
+#else
+	return pthread_create(&(worker->handle), NULL, fftset_threads_entry, worker);
+#endif
+}
+
+static void fftset_threads_join(struct fftset_thread_worker *worker)
+{
+#ifdef _WIN32
+	WaitForSingleObject(worker->handle, INFINITE);
+	CloseHandle(worker->handle);
+#else
+	pthread_join(worker->handle, NULL);
+#endif
+}
+
+/* Stops and joins the first nb_started workers and frees the pool. */
+static void fftset_threads_free(struct fftset_thread_pool *pool, unsigned nb_started)
+{
+	unsigned i;
+
+	fftset_mutex_lock(&(pool->lock));
+	pool->shutdown = 1;
+	fftset_cond_broadcast(&(pool->start));
+	fftset_mutex_unlock(&(pool->lock));
+
+	for (i = 0; i < nb_started; i++)
+		fftset_threads_join(pool->workers + i);
+
+	fftset_mutex_destroy(&(pool->run_lock));
+	fftset_cond_destroy(&(pool->done));
+	fftset_cond_destroy(&(pool->start));
+	fftset_mutex_destroy(&(pool->lock));
+	free(pool->workers);
+	free(pool);
+}
+
+int fftset_threads_init(struct fftset_threads *threads, unsigned nb_threads)
+{
+	struct fftset_thread_pool *pool;
+	unsigned                   i;
+
+	if (nb_threads == 0)
+		nb_threads = fftset_threads_nb_cpus();
+
+	threads->pool       = NULL;
+	threads->nb_threads = nb_threads;
+
+	/* A single thread needs no pool. */
+	if (nb_threads == 1)
+		return 0;
+
+	pool = malloc(sizeof(*pool));
+	if (pool == NULL)
+		return -1;
+	pool->workers = malloc(sizeof(pool->workers[0]) * (nb_threads - 1));
+	if (pool->workers == NULL) {
+		free(pool);
+		return -1;
+	}
+
+	if (fftset_mutex_init(&(pool->lock))) {
+		free(pool->workers);
+		free(pool);
+		return -1;
+	}
+	if (fftset_cond_init(&(pool->start))) {
+		fftset_mutex_destroy(&(pool->lock));
+		free(pool->workers);
+		free(pool);
+		return -1;
+	}
+	if (fftset_cond_init(&(pool->done))) {
+		fftset_cond_destroy(&(pool->start));
+		fftset_mutex_destroy(&(pool->lock));
+		free(pool->workers);
+		free(pool);
+		return -1;
+	}
+	if (fftset_mutex_init(&(pool->run_lock))) {
+		fftset_cond_destroy(&(pool->done));
+		fftset_cond_destroy(&(pool->start));
+		fftset_mutex_destroy(&(pool->lock));
+		free(pool->workers);
+		free(pool);
+		return -1;
+	}
+
+	pool->fn         = NULL;
+	pool->arg        = NULL;
+	pool->generation = 0;
+	pool->nb_pending = 0;
+	pool->nb_threads = nb_threads;
+	pool->shutdown   = 0;
+
+	for (i = 0; i < nb_threads - 1; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].part = i + 1;
+		if (fftset_threads_start(pool->workers + i)) {
+			fftset_threads_free(pool, i);
+			return -1;
+		}
+	}
+
+	threads->pool = pool;
+	return 0;
+}
+
+void fftset_threads_destroy(struct fftset_threads *threads)
+{
+	if (threads->pool != NULL)
+		fftset_threads_free(threads->pool, threads->nb_threads - 1);
+	threads->pool = NULL;
+}
+
+void
+fftset_threads_run
+	(struct fftset_threads   *threads
+	,fftset_threads_fn        fn
+	,void                    *arg
+	)
+{
+	struct fftset_thread_pool *pool = (threads != NULL) ? threads->pool : NULL;
+
+	if (pool == NULL) {
+		fn(arg, 0, 1);
+		return;
+	}
+
+	fftset_mutex_lock(&(pool->run_lock));
+
+	fftset_mutex_lock(&(pool->lock));
+	pool->fn         = fn;
+	pool->arg        = arg;
+	pool->nb_pending = pool->nb_threads - 1;
+	pool->generation++;
+	fftset_cond_broadcast(&(pool->start));
+	fftset_mutex_unlock(&(pool->lock));
+
+	fn(arg, 0, pool->nb_threads);
+
+	fftset_mutex_lock(&(pool->lock));
+	while (pool->nb_pending != 0)
+		fftset_cond_wait(&(pool->done), &(pool->lock));
+	fftset_mutex_unlock(&(pool->lock));
+
+	fftset_mutex_unlock(&(pool->run_lock));
+}
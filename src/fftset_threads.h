@@ -0,0 +1,41 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifndef FFTSET_THREADS_H
+#define FFTSET_THREADS_H
+
+#include "fftset/fftset.h"
+
+/* Work which is split between the threads of a pool. fn is called once for
+ * every part with part in [0, nb_parts). */
+typedef void (*fftset_threads_fn)(void *arg, unsigned part, unsigned nb_parts);
+
+/* Calls fn on every thread of the pool (including the calling thread which
+ * runs part zero) and returns once all of the calls have returned. If
+ * threads is NULL, fn is called once on the calling thread with nb_parts set
+ * to one. */
+void
+fftset_threads_run
+	(struct fftset_threads   *threads
+	,fftset_threads_fn        fn
+	,void                    *arg
+	);
+
+#endif /* FFTSET_THREADS_H */
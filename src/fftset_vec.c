@@ -23,964 +23,59 @@
 #endif
 
 #include "fftset_vec.h"
+#include "fftset_index.h"
+#include "fftset_alloc.h"
+#include "fftset_timer.h"
+#include "fftset_threads.h"
+#include "fftset_kernels.h"
+#include "fftset_f16.h"
+#include "fftset_profile.h"
 #include "cop/cop_vec.h"
 #include <assert.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
-static const float C_2C5 = 0.309016994374948f; /* 2 * PI / 5 */
-static const float C_2S5 = 0.951056516295154f; /* 2 * PI / 5 */
-
-static const float C_C3  = 0.500000000000000f; /* PI / 3 */
-static const float C_S3  = 0.866025403784440f; /* PI / 3 */
-
-static const float C_C4  = 0.707106781186548f; /* PI / 4 */
-
-static const float C_C5  = 0.809016994374947f; /* PI / 5 */
-static const float C_S5  = 0.587785252292473f; /* PI / 5 */
-
-static const float C_C8  = 0.923879532511288f; /* PI / 8 */
-static const float C_S8  = 0.382683432365086f; /* PI / 8 */
-
-#define BUILD_INNER_PASSES(vtyp_, ctyp_, vwidth_, n_) \
-static void fftset_ ## vtyp_ ## _r ## n_ ## _inner(ctyp_ *work_buf, unsigned nfft, unsigned lfft, const ctyp_ *twid) \
-{ \
-	assert(lfft == 1); \
-	do { \
-		vtyp_ ## _dif_fft ## n_ ## _offset_o(work_buf, work_buf, 2 * vwidth_); \
-		work_buf += 2 * (n_) * vwidth_; \
-	} while (--nfft); \
-} \
-static void fftset_ ## vtyp_ ## _r ## n_ ## _inner_stock(ctyp_ *out, const ctyp_ *in, const ctyp_ *twid, unsigned ncol, unsigned nrow_div_radix) \
-{ \
-	const unsigned ioffset = (2*vwidth_)*nrow_div_radix; \
-	assert(ncol == 1); \
-	do { \
-		vtyp_ ## _dif_fft ## n_ ## _offset_o(in, out, ioffset); \
-		out += 2 * vwidth_; \
-		in  += 2 * (n_) * vwidth_; \
-	} while (--nrow_div_radix); \
-}
-
-#define BUILD_STANDARD_PASSES(vtyp_, ctyp_, vwidth_, n_, ntwid_) \
-static void fftset_ ## vtyp_ ## _r ## n_ ## _dif(ctyp_ *work_buf, unsigned nfft, unsigned lfft, const ctyp_ *twid) \
-{ \
-	unsigned rinc = lfft * (2 * vwidth_); \
-	do { \
-		unsigned j; \
-		const ctyp_ *tp = twid; \
-		for (j = 0; j < lfft; j++, work_buf += 2 * vwidth_, tp += (ntwid_)) { \
-			vtyp_ ## _dif_fft ## n_ ## _offset_io(work_buf, work_buf, tp, rinc, rinc); \
-		} \
-		work_buf += ((n_) - 1)*rinc; \
-	} while (--nfft); \
-} \
-static void fftset_ ## vtyp_ ## _r ## n_ ## _dit(ctyp_ *work_buf, unsigned nfft, unsigned lfft, const ctyp_ *twid) \
-{ \
-	unsigned rinc = lfft * (2 * vwidth_); \
-	do { \
-		unsigned j; \
-		const ctyp_ *tp = twid; \
-		for (j = 0; j < lfft; j++, work_buf += 2 * vwidth_, tp += (ntwid_)) { \
-			vtyp_ ## _dit_fft ## n_ ## _offset_io(work_buf, work_buf, tp, rinc, rinc); \
-		} \
-		work_buf += ((n_) - 1)*rinc; \
-	} while (--nfft); \
-} \
-static void fftset_ ## vtyp_ ## _r ## n_ ## _stock(ctyp_ *out, const ctyp_ *in, const ctyp_ *twid, unsigned ncol, unsigned nrow_div_radix) \
-{ \
-	const unsigned ooffset = (2*vwidth_)*ncol; \
-	const unsigned ioffset = ooffset*nrow_div_radix; \
-	do { \
-		const ctyp_ *in0 = in; \
-		const ctyp_ *tp  = twid; \
-		unsigned     j   = ncol; \
-		do { \
-			vtyp_ ## _dif_fft ## n_ ## _offset_io(in0, out, tp, ooffset, ioffset); \
-			tp   += (ntwid_); \
-			out  += (2*vwidth_); \
-			in0  += (2*vwidth_); \
-		} while (--j); \
-		in = in + (n_)*ooffset; \
-	} while (--nrow_div_radix); \
-} \
-BUILD_INNER_PASSES(vtyp_, ctyp_, vwidth_, n_)
-
-#define VECRADIX2PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft2_offset_io(const ctyp_ *in, ctyp_ *out, const ctyp_ *twid, unsigned in_stride, unsigned out_stride) \
-{ \
-	vtyp_ nre   = vtyp_ ## _ld(in + 0*vwidth_); \
-	vtyp_ nim   = vtyp_ ## _ld(in + 1*vwidth_); \
-	vtyp_ fre   = vtyp_ ## _ld(in + in_stride + 0*vwidth_); \
-	vtyp_ fim   = vtyp_ ## _ld(in + in_stride + 1*vwidth_); \
-	vtyp_ tre   = vtyp_ ## _broadcast(twid[0]); \
-	vtyp_ tim   = vtyp_ ## _broadcast(twid[1]); \
-	vtyp_ onre  = vtyp_ ## _add(nre, fre); \
-	vtyp_ onim  = vtyp_ ## _add(nim, fim); \
-	vtyp_ ptre  = vtyp_ ## _sub(nre, fre); \
-	vtyp_ ptim  = vtyp_ ## _sub(nim, fim); \
-	vtyp_ ofrea = vtyp_ ## _mul(ptre, tre); \
-	vtyp_ ofreb = vtyp_ ## _mul(ptim, tim); \
-	vtyp_ ofima = vtyp_ ## _mul(ptre, tim); \
-	vtyp_ ofimb = vtyp_ ## _mul(ptim, tre); \
-	vtyp_ ofre  = vtyp_ ## _sub(ofrea, ofreb); \
-	vtyp_ ofim  = vtyp_ ## _add(ofima, ofimb); \
-	vtyp_ ## _st(out + 0*vwidth_, onre); \
-	vtyp_ ## _st(out + 1*vwidth_, onim); \
-	vtyp_ ## _st(out + out_stride + 0*vwidth_, ofre); \
-	vtyp_ ## _st(out + out_stride + 1*vwidth_, ofim); \
-} \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft2_offset_o(const ctyp_ *in, ctyp_ *out, unsigned out_stride) \
-{ \
-	vtyp_ nre, nim, fre, fim; \
-	vtyp_ onre, onim, ofre, ofim; \
-	vtyp_mac_ ## _LD2(nre, nim, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(fre, fim, in + 2*vwidth_); \
-	onre = vtyp_ ## _add(nre, fre); \
-	onim = vtyp_ ## _add(nim, fim); \
-	ofre = vtyp_ ## _sub(nre, fre); \
-	ofim = vtyp_ ## _sub(nim, fim); \
-	vtyp_mac_ ## _ST2(out + 0, onre, onim); \
-	vtyp_mac_ ## _ST2(out + out_stride, ofre, ofim); \
-} \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dit_fft2_offset_io(const ctyp_ *in, ctyp_ *out, const ctyp_ *twid, unsigned in_stride, unsigned out_stride) \
-{ \
-	vtyp_ nre  = vtyp_ ## _ld(in + 0*vwidth_); \
-	vtyp_ nim  = vtyp_ ## _ld(in + 1*vwidth_); \
-	vtyp_ ptre = vtyp_ ## _ld(in + in_stride + 0*vwidth_); \
-	vtyp_ ptim = vtyp_ ## _ld(in + in_stride + 1*vwidth_); \
-	vtyp_ tre  = vtyp_ ## _broadcast(twid[0]); \
-	vtyp_ tim  = vtyp_ ## _broadcast(twid[1]); \
-	vtyp_ frea = vtyp_ ## _mul(ptre, tre); \
-	vtyp_ freb = vtyp_ ## _mul(ptim, tim); \
-	vtyp_ fima = vtyp_ ## _mul(ptre, tim); \
-	vtyp_ fimb = vtyp_ ## _mul(ptim, tre); \
-	vtyp_ fre  = vtyp_ ## _sub(frea, freb); \
-	vtyp_ fim  = vtyp_ ## _add(fima, fimb); \
-	vtyp_ onre = vtyp_ ## _add(nre, fre); \
-	vtyp_ onim = vtyp_ ## _add(nim, fim); \
-	vtyp_ ofre = vtyp_ ## _sub(nre, fre); \
-	vtyp_ ofim = vtyp_ ## _sub(nim, fim); \
-	vtyp_ ## _st(out + 0*vwidth_, onre); \
-	vtyp_ ## _st(out + 1*vwidth_, onim); \
-	vtyp_ ## _st(out + out_stride + 0*vwidth_, ofre); \
-	vtyp_ ## _st(out + out_stride + 1*vwidth_, ofim); \
-} \
-BUILD_STANDARD_PASSES(vtyp_, ctyp_, vwidth_, 2, 2)
-
-#define VECRADIX3PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft3_offset_io(const ctyp_ *in, ctyp_ *out, const ctyp_ *twid, unsigned in_stride, unsigned out_stride) \
-{ \
-	vtyp_ r0, i0, r1, i1, r2, i2; \
-	vtyp_ or0, oi0, or1, oi1, or2, oi2; \
-	vtyp_ ar1, ai1, ar2, ai2; \
-	vtyp_ cr1, ci1, cr2, ci2; \
-	vtyp_ dr1, di1, dr2, di2; \
-	vtyp_ er1, ei1, er2, ei2; \
-	vtyp_ tr1, ti1, tr2, ti2; \
-	vtyp_ tr3, ti3, tr4, ti4; \
-	vtyp_ tr5, ti5; \
-	const vtyp_ coef0 = vtyp_ ## _broadcast(C_C3); \
-	const vtyp_ coef1 = vtyp_ ## _broadcast(C_S3); \
-	vtyp_mac_ ## _LD2(r0, i0, in + 0*in_stride); \
-	vtyp_mac_ ## _LD2(r1, i1, in + 1*in_stride); \
-	vtyp_mac_ ## _LD2(r2, i2, in + 2*in_stride); \
-	tr1 = vtyp_ ## _add(r2, r1); \
-	ti1 = vtyp_ ## _add(i2, i1); \
-	tr2 = vtyp_ ## _sub(i2, i1); \
-	ti2 = vtyp_ ## _sub(r2, r1); \
-	tr5 = vtyp_ ## _mul(tr1, coef0); \
-	ti5 = vtyp_ ## _mul(ti1, coef0); \
-	tr3 = vtyp_ ## _mul(tr2, coef1); \
-	ti3 = vtyp_ ## _mul(ti2, coef1); \
-	tr4 = vtyp_ ## _sub(r0, tr5); \
-	ti4 = vtyp_ ## _sub(i0, ti5); \
-	or0 = vtyp_ ## _add(r0, tr1); \
-	oi0 = vtyp_ ## _add(i0, ti1); \
-	ar1 = vtyp_ ## _sub(tr4, tr3); \
-	ai1 = vtyp_ ## _add(ti4, ti3); \
-	ar2 = vtyp_ ## _add(tr4, tr3); \
-	ai2 = vtyp_ ## _sub(ti4, ti3); \
-	cr1 = vtyp_ ## _broadcast(twid[0]); \
-	ci1 = vtyp_ ## _broadcast(twid[1]); \
-	cr2 = vtyp_ ## _broadcast(twid[2]); \
-	ci2 = vtyp_ ## _broadcast(twid[3]); \
-	dr1 = vtyp_ ## _mul(ar1, cr1); \
-	er1 = vtyp_ ## _mul(ai1, ci1); \
-	di1 = vtyp_ ## _mul(ar1, ci1); \
-	ei1 = vtyp_ ## _mul(ai1, cr1); \
-	dr2 = vtyp_ ## _mul(ar2, cr2); \
-	er2 = vtyp_ ## _mul(ai2, ci2); \
-	di2 = vtyp_ ## _mul(ar2, ci2); \
-	ei2 = vtyp_ ## _mul(ai2, cr2); \
-	or1 = vtyp_ ## _sub(dr1, er1); \
-	oi1 = vtyp_ ## _add(di1, ei1); \
-	or2 = vtyp_ ## _sub(dr2, er2); \
-	oi2 = vtyp_ ## _add(di2, ei2); \
-	vtyp_mac_ ## _ST2(out + 0*out_stride, or0, oi0); \
-	vtyp_mac_ ## _ST2(out + 1*out_stride, or1, oi1); \
-	vtyp_mac_ ## _ST2(out + 2*out_stride, or2, oi2); \
-} \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft3_offset_o(const ctyp_ *in, ctyp_ *out, unsigned out_stride) \
-{ \
-	vtyp_ r0, i0, r1, i1, r2, i2; \
-	vtyp_ or0, oi0, or1, oi1, or2, oi2; \
-	vtyp_ tr1, ti1, tr2, ti2; \
-	vtyp_ tr3, ti3, tr4, ti4; \
-	vtyp_ tr5, ti5; \
-	const vtyp_ coef0 = vtyp_ ## _broadcast(C_C3); \
-	const vtyp_ coef1 = vtyp_ ## _broadcast(C_S3); \
-	vtyp_mac_ ## _LD2(r0, i0, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(r1, i1, in + 2*vwidth_); \
-	vtyp_mac_ ## _LD2(r2, i2, in + 4*vwidth_); \
-	tr1 = vtyp_ ## _add(r2, r1); \
-	ti1 = vtyp_ ## _add(i2, i1); \
-	tr2 = vtyp_ ## _sub(i2, i1); \
-	ti2 = vtyp_ ## _sub(r2, r1); \
-	tr5 = vtyp_ ## _mul(tr1, coef0); \
-	ti5 = vtyp_ ## _mul(ti1, coef0); \
-	tr3 = vtyp_ ## _mul(tr2, coef1); \
-	ti3 = vtyp_ ## _mul(ti2, coef1); \
-	tr4 = vtyp_ ## _sub(r0, tr5); \
-	ti4 = vtyp_ ## _sub(i0, ti5); \
-	or0 = vtyp_ ## _add(r0, tr1); \
-	oi0 = vtyp_ ## _add(i0, ti1); \
-	or1 = vtyp_ ## _sub(tr4, tr3); \
-	oi1 = vtyp_ ## _add(ti4, ti3); \
-	or2 = vtyp_ ## _add(tr4, tr3); \
-	oi2 = vtyp_ ## _sub(ti4, ti3); \
-	vtyp_mac_ ## _ST2(out + 0*out_stride, or0, oi0); \
-	vtyp_mac_ ## _ST2(out + 1*out_stride, or1, oi1); \
-	vtyp_mac_ ## _ST2(out + 2*out_stride, or2, oi2); \
-} \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dit_fft3_offset_io(const ctyp_ *in, ctyp_ *out, const ctyp_ *twid, unsigned in_stride, unsigned out_stride) \
-{ \
-	vtyp_ r0, i0, r1, i1, r2, i2; \
-	vtyp_ or0, oi0, or1, oi1, or2, oi2; \
-	vtyp_ ar1, ai1, ar2, ai2; \
-	vtyp_ cr1, ci1, cr2, ci2; \
-	vtyp_ dr1, di1, dr2, di2; \
-	vtyp_ er1, ei1, er2, ei2; \
-	vtyp_ tr1, ti1, tr2, ti2; \
-	vtyp_ tr3, ti3, tr4, ti4; \
-	vtyp_ tr5, ti5; \
-	const vtyp_ coef0 = vtyp_ ## _broadcast(C_C3); \
-	const vtyp_ coef1 = vtyp_ ## _broadcast(C_S3); \
-	vtyp_mac_ ## _LD2(r0, i0, in + 0*in_stride); \
-	vtyp_mac_ ## _LD2(r1, i1, in + 1*in_stride); \
-	vtyp_mac_ ## _LD2(r2, i2, in + 2*in_stride); \
-	cr1 = vtyp_ ## _broadcast(twid[0]); \
-	ci1 = vtyp_ ## _broadcast(twid[1]); \
-	cr2 = vtyp_ ## _broadcast(twid[2]); \
-	ci2 = vtyp_ ## _broadcast(twid[3]); \
-	dr1 = vtyp_ ## _mul(r1, cr1); \
-	er1 = vtyp_ ## _mul(i1, ci1); \
-	di1 = vtyp_ ## _mul(r1, ci1); \
-	ei1 = vtyp_ ## _mul(i1, cr1); \
-	dr2 = vtyp_ ## _mul(r2, cr2); \
-	er2 = vtyp_ ## _mul(i2, ci2); \
-	di2 = vtyp_ ## _mul(r2, ci2); \
-	ei2 = vtyp_ ## _mul(i2, cr2); \
-	ar1 = vtyp_ ## _sub(dr1, er1); \
-	ai1 = vtyp_ ## _add(di1, ei1); \
-	ar2 = vtyp_ ## _sub(dr2, er2); \
-	ai2 = vtyp_ ## _add(di2, ei2); \
-	tr1 = vtyp_ ## _add(ar2, ar1); \
-	ti1 = vtyp_ ## _add(ai2, ai1); \
-	tr2 = vtyp_ ## _sub(ai2, ai1); \
-	ti2 = vtyp_ ## _sub(ar2, ar1); \
-	tr5 = vtyp_ ## _mul(tr1, coef0); \
-	ti5 = vtyp_ ## _mul(ti1, coef0); \
-	tr3 = vtyp_ ## _mul(tr2, coef1); \
-	ti3 = vtyp_ ## _mul(ti2, coef1); \
-	tr4 = vtyp_ ## _sub(r0, tr5); \
-	ti4 = vtyp_ ## _sub(i0, ti5); \
-	or0 = vtyp_ ## _add(r0, tr1); \
-	oi0 = vtyp_ ## _add(i0, ti1); \
-	or1 = vtyp_ ## _sub(tr4, tr3); \
-	oi1 = vtyp_ ## _add(ti4, ti3); \
-	or2 = vtyp_ ## _add(tr4, tr3); \
-	oi2 = vtyp_ ## _sub(ti4, ti3); \
-	vtyp_mac_ ## _ST2(out + 0*out_stride, or0, oi0); \
-	vtyp_mac_ ## _ST2(out + 1*out_stride, or1, oi1); \
-	vtyp_mac_ ## _ST2(out + 2*out_stride, or2, oi2); \
-} \
-BUILD_STANDARD_PASSES(vtyp_, ctyp_, vwidth_, 3, 4)
-
-#define VECRADIX4PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft4_offset_io(const ctyp_ *in, ctyp_ *out, const ctyp_ *twid, unsigned in_stride, unsigned out_stride) \
-{ \
-	vtyp_ b0r   = vtyp_ ## _ld(in + 0*in_stride + 0*vwidth_); \
-	vtyp_ b0i   = vtyp_ ## _ld(in + 0*in_stride + 1*vwidth_); \
-	vtyp_ b1r   = vtyp_ ## _ld(in + 1*in_stride + 0*vwidth_); \
-	vtyp_ b1i   = vtyp_ ## _ld(in + 1*in_stride + 1*vwidth_); \
-	vtyp_ b2r   = vtyp_ ## _ld(in + 2*in_stride + 0*vwidth_); \
-	vtyp_ b2i   = vtyp_ ## _ld(in + 2*in_stride + 1*vwidth_); \
-	vtyp_ b3r   = vtyp_ ## _ld(in + 3*in_stride + 0*vwidth_); \
-	vtyp_ b3i   = vtyp_ ## _ld(in + 3*in_stride + 1*vwidth_); \
-	vtyp_ yr0   = vtyp_ ## _add(b0r, b2r); \
-	vtyp_ yi0   = vtyp_ ## _add(b0i, b2i); \
-	vtyp_ yr2   = vtyp_ ## _sub(b0r, b2r); \
-	vtyp_ yi2   = vtyp_ ## _sub(b0i, b2i); \
-	vtyp_ yr1   = vtyp_ ## _add(b1r, b3r); \
-	vtyp_ yi1   = vtyp_ ## _add(b1i, b3i); \
-	vtyp_ yr3   = vtyp_ ## _sub(b1r, b3r); \
-	vtyp_ yi3   = vtyp_ ## _sub(b1i, b3i); \
-	vtyp_ tr0   = vtyp_ ## _add(yr0, yr1); \
-	vtyp_ ti0   = vtyp_ ## _add(yi0, yi1); \
-	vtyp_ tr2   = vtyp_ ## _sub(yr0, yr1); \
-	vtyp_ ti2   = vtyp_ ## _sub(yi0, yi1); \
-	vtyp_ tr1   = vtyp_ ## _add(yr2, yi3); \
-	vtyp_ ti1   = vtyp_ ## _sub(yi2, yr3); \
-	vtyp_ tr3   = vtyp_ ## _sub(yr2, yi3); \
-	vtyp_ ti3   = vtyp_ ## _add(yi2, yr3); \
-	vtyp_ c1r   = vtyp_ ## _broadcast(twid[0]); \
-	vtyp_ c1i   = vtyp_ ## _broadcast(twid[1]); \
-	vtyp_ c2r   = vtyp_ ## _broadcast(twid[2]); \
-	vtyp_ c2i   = vtyp_ ## _broadcast(twid[3]); \
-	vtyp_ c3r   = vtyp_ ## _broadcast(twid[4]); \
-	vtyp_ c3i   = vtyp_ ## _broadcast(twid[5]); \
-	vtyp_ o1ra  = vtyp_ ## _mul(tr1, c1r); \
-	vtyp_ o1rb  = vtyp_ ## _mul(ti1, c1i); \
-	vtyp_ o1ia  = vtyp_ ## _mul(tr1, c1i); \
-	vtyp_ o1ib  = vtyp_ ## _mul(ti1, c1r); \
-	vtyp_ o2ra  = vtyp_ ## _mul(tr2, c2r); \
-	vtyp_ o2rb  = vtyp_ ## _mul(ti2, c2i); \
-	vtyp_ o2ia  = vtyp_ ## _mul(tr2, c2i); \
-	vtyp_ o2ib  = vtyp_ ## _mul(ti2, c2r); \
-	vtyp_ o3ra  = vtyp_ ## _mul(tr3, c3r); \
-	vtyp_ o3rb  = vtyp_ ## _mul(ti3, c3i); \
-	vtyp_ o3ia  = vtyp_ ## _mul(tr3, c3i); \
-	vtyp_ o3ib  = vtyp_ ## _mul(ti3, c3r); \
-	vtyp_ o1r   = vtyp_ ## _sub(o1ra, o1rb); \
-	vtyp_ o1i   = vtyp_ ## _add(o1ia, o1ib); \
-	vtyp_ o2r   = vtyp_ ## _sub(o2ra, o2rb); \
-	vtyp_ o2i   = vtyp_ ## _add(o2ia, o2ib); \
-	vtyp_ o3r   = vtyp_ ## _sub(o3ra, o3rb); \
-	vtyp_ o3i   = vtyp_ ## _add(o3ia, o3ib); \
-	vtyp_ ## _st(out + 0*out_stride + 0*vwidth_, tr0); \
-	vtyp_ ## _st(out + 0*out_stride + 1*vwidth_, ti0); \
-	vtyp_ ## _st(out + 1*out_stride + 0*vwidth_, o1r); \
-	vtyp_ ## _st(out + 1*out_stride + 1*vwidth_, o1i); \
-	vtyp_ ## _st(out + 2*out_stride + 0*vwidth_, o2r); \
-	vtyp_ ## _st(out + 2*out_stride + 1*vwidth_, o2i); \
-	vtyp_ ## _st(out + 3*out_stride + 0*vwidth_, o3r); \
-	vtyp_ ## _st(out + 3*out_stride + 1*vwidth_, o3i); \
-} \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft4_offset_o(const ctyp_ *in, ctyp_ *out, unsigned outoffset) \
-{ \
-	vtyp_ b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i; \
-	vtyp_ y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i; \
-	vtyp_ z0r, z0i, z1r, z1i, z2r, z2i, z3r, z3i; \
-	vtyp_mac_ ## _LD2(b0r, b0i, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(b1r, b1i, in + 2*vwidth_); \
-	vtyp_mac_ ## _LD2(b2r, b2i, in + 4*vwidth_); \
-	vtyp_mac_ ## _LD2(b3r, b3i, in + 6*vwidth_); \
-	y0r  = vtyp_ ## _add(b0r, b2r); \
-	y0i  = vtyp_ ## _add(b0i, b2i); \
-	y2r  = vtyp_ ## _sub(b0r, b2r); \
-	y2i  = vtyp_ ## _sub(b0i, b2i); \
-	y1r  = vtyp_ ## _add(b1r, b3r); \
-	y1i  = vtyp_ ## _add(b1i, b3i); \
-	y3r  = vtyp_ ## _sub(b1r, b3r); \
-	y3i  = vtyp_ ## _sub(b1i, b3i); \
-	z0r  = vtyp_ ## _add(y0r, y1r); \
-	z0i  = vtyp_ ## _add(y0i, y1i); \
-	z2r  = vtyp_ ## _sub(y0r, y1r); \
-	z2i  = vtyp_ ## _sub(y0i, y1i); \
-	z1r  = vtyp_ ## _add(y2r, y3i); \
-	z1i  = vtyp_ ## _sub(y2i, y3r); \
-	z3r  = vtyp_ ## _sub(y2r, y3i); \
-	z3i  = vtyp_ ## _add(y2i, y3r); \
-	vtyp_mac_ ## _ST2(out + 0*outoffset, z0r, z0i); \
-	vtyp_mac_ ## _ST2(out + 1*outoffset, z1r, z1i); \
-	vtyp_mac_ ## _ST2(out + 2*outoffset, z2r, z2i); \
-	vtyp_mac_ ## _ST2(out + 3*outoffset, z3r, z3i); \
-} \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dit_fft4_offset_io(const ctyp_ *in, ctyp_ *out, const ctyp_ *twid, unsigned in_stride, unsigned out_stride) \
-{ \
-	vtyp_ b0r  = vtyp_ ## _ld(in + 0*in_stride + 0*vwidth_); \
-	vtyp_ b0i  = vtyp_ ## _ld(in + 0*in_stride + 1*vwidth_); \
-	vtyp_ b1r  = vtyp_ ## _ld(in + 1*in_stride + 0*vwidth_); \
-	vtyp_ b1i  = vtyp_ ## _ld(in + 1*in_stride + 1*vwidth_); \
-	vtyp_ b2r  = vtyp_ ## _ld(in + 2*in_stride + 0*vwidth_); \
-	vtyp_ b2i  = vtyp_ ## _ld(in + 2*in_stride + 1*vwidth_); \
-	vtyp_ b3r  = vtyp_ ## _ld(in + 3*in_stride + 0*vwidth_); \
-	vtyp_ b3i  = vtyp_ ## _ld(in + 3*in_stride + 1*vwidth_); \
-	vtyp_ c1r  = vtyp_ ## _broadcast(twid[0]); \
-	vtyp_ c1i  = vtyp_ ## _broadcast(twid[1]); \
-	vtyp_ c2r  = vtyp_ ## _broadcast(twid[2]); \
-	vtyp_ c2i  = vtyp_ ## _broadcast(twid[3]); \
-	vtyp_ c3r  = vtyp_ ## _broadcast(twid[4]); \
-	vtyp_ c3i  = vtyp_ ## _broadcast(twid[5]); \
-	vtyp_ x1ra = vtyp_ ## _mul(b1r, c1r); \
-	vtyp_ x1rb = vtyp_ ## _mul(b1i, c1i); \
-	vtyp_ x1ia = vtyp_ ## _mul(b1r, c1i); \
-	vtyp_ x1ib = vtyp_ ## _mul(b1i, c1r); \
-	vtyp_ x2ra = vtyp_ ## _mul(b2r, c2r); \
-	vtyp_ x2rb = vtyp_ ## _mul(b2i, c2i); \
-	vtyp_ x2ia = vtyp_ ## _mul(b2r, c2i); \
-	vtyp_ x2ib = vtyp_ ## _mul(b2i, c2r); \
-	vtyp_ x3ra = vtyp_ ## _mul(b3r, c3r); \
-	vtyp_ x3rb = vtyp_ ## _mul(b3i, c3i); \
-	vtyp_ x3ia = vtyp_ ## _mul(b3r, c3i); \
-	vtyp_ x3ib = vtyp_ ## _mul(b3i, c3r); \
-	vtyp_ x1r  = vtyp_ ## _sub(x1ra, x1rb); \
-	vtyp_ x1i  = vtyp_ ## _add(x1ia, x1ib); \
-	vtyp_ x2r  = vtyp_ ## _sub(x2ra, x2rb); \
-	vtyp_ x2i  = vtyp_ ## _add(x2ia, x2ib); \
-	vtyp_ x3r  = vtyp_ ## _sub(x3ra, x3rb); \
-	vtyp_ x3i  = vtyp_ ## _add(x3ia, x3ib); \
-	vtyp_ yr0  = vtyp_ ## _add(b0r, x2r); \
-	vtyp_ yi0  = vtyp_ ## _add(b0i, x2i); \
-	vtyp_ yr2  = vtyp_ ## _sub(b0r, x2r); \
-	vtyp_ yi2  = vtyp_ ## _sub(b0i, x2i); \
-	vtyp_ yr1  = vtyp_ ## _add(x1r, x3r); \
-	vtyp_ yi1  = vtyp_ ## _add(x1i, x3i); \
-	vtyp_ yr3  = vtyp_ ## _sub(x1r, x3r); \
-	vtyp_ yi3  = vtyp_ ## _sub(x1i, x3i); \
-	vtyp_ o0r  = vtyp_ ## _add(yr0, yr1); \
-	vtyp_ o0i  = vtyp_ ## _add(yi0, yi1); \
-	vtyp_ o2r  = vtyp_ ## _sub(yr0, yr1); \
-	vtyp_ o2i  = vtyp_ ## _sub(yi0, yi1); \
-	vtyp_ o1r  = vtyp_ ## _add(yr2, yi3); \
-	vtyp_ o1i  = vtyp_ ## _sub(yi2, yr3); \
-	vtyp_ o3r  = vtyp_ ## _sub(yr2, yi3); \
-	vtyp_ o3i  = vtyp_ ## _add(yi2, yr3); \
-	vtyp_ ## _st(out + 0*out_stride + 0*vwidth_, o0r); \
-	vtyp_ ## _st(out + 0*out_stride + 1*vwidth_, o0i); \
-	vtyp_ ## _st(out + 1*out_stride + 0*vwidth_, o1r); \
-	vtyp_ ## _st(out + 1*out_stride + 1*vwidth_, o1i); \
-	vtyp_ ## _st(out + 2*out_stride + 0*vwidth_, o2r); \
-	vtyp_ ## _st(out + 2*out_stride + 1*vwidth_, o2i); \
-	vtyp_ ## _st(out + 3*out_stride + 0*vwidth_, o3r); \
-	vtyp_ ## _st(out + 3*out_stride + 1*vwidth_, o3i); \
-} \
-BUILD_STANDARD_PASSES(vtyp_, ctyp_, vwidth_, 4, 6)
-
-#define VECRADIX5PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft5_offset_o(const ctyp_ *in, ctyp_ *out, unsigned outoffset) \
-{ \
-	const vtyp_ c0r = vtyp_ ## _broadcast(C_2C5); \
-	const vtyp_ c0i = vtyp_ ## _broadcast(C_2S5); \
-	const vtyp_ c1r = vtyp_ ## _broadcast(C_C5); \
-	const vtyp_ c1i = vtyp_ ## _broadcast(C_S5); \
-	vtyp_ r0, i0, r1, r2, r3, r4, i1, i2, i3, i4; \
-	vtyp_ a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i; \
-	vtyp_ b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i; \
-	vtyp_ d0r, d0i, d1r, d1i, d2r, d2i, d3r, d3i; \
-	vtyp_ e0r, e0i, e1r, e1i, e2r, e2i, e3r, e3i; \
-	vtyp_ y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i, y4r, y4i; \
-	vtyp_ z0r, z0i, z1r, z1i, z2r, z2i; \
-	vtyp_mac_ ## _LD2(r0, i0, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(r1, i1, in + 2*vwidth_); \
-	vtyp_mac_ ## _LD2(r2, i2, in + 4*vwidth_); \
-	vtyp_mac_ ## _LD2(r3, i3, in + 6*vwidth_); \
-	vtyp_mac_ ## _LD2(r4, i4, in + 8*vwidth_); \
-	a0r = vtyp_ ## _add(r2, r3); \
-	a2r = vtyp_ ## _sub(r2, r3); \
-	a1r = vtyp_ ## _add(r1, r4); \
-	a3r = vtyp_ ## _sub(r1, r4); \
-	a0i = vtyp_ ## _add(i2, i3); \
-	a2i = vtyp_ ## _sub(i2, i3); \
-	a1i = vtyp_ ## _add(i1, i4); \
-	a3i = vtyp_ ## _sub(i1, i4); \
-	z1r = vtyp_ ## _add(a0r, a1r); \
-	z1i = vtyp_ ## _add(a0i, a1i); \
-	y0r = vtyp_ ## _add(r0, z1r); \
-	y0i = vtyp_ ## _add(i0, z1i); \
-	vtyp_mac_ ## _ST2(out, y0r, y0i); \
-	d0r = vtyp_ ## _mul(a3r, c0i); \
-	e0r = vtyp_ ## _mul(a2r, c1i); \
-	d0i = vtyp_ ## _mul(a3r, c1i); \
-	e0i = vtyp_ ## _mul(a2r, c0i); \
-	b1i = vtyp_ ## _add(d0r, e0r); \
-	b3i = vtyp_ ## _sub(e0i, d0i); \
-	d1r = vtyp_ ## _mul(a1r, c0r); \
-	e1r = vtyp_ ## _mul(a0r, c1r); \
-	d1i = vtyp_ ## _mul(a1r, c1r); \
-	e1i = vtyp_ ## _mul(a0r, c0r); \
-	b0r = vtyp_ ## _sub(d1r, e1r); \
-	b2r = vtyp_ ## _sub(e1i, d1i); \
-	d2r = vtyp_ ## _mul(a3i, c0i); \
-	e2r = vtyp_ ## _mul(a2i, c1i); \
-	d2i = vtyp_ ## _mul(a3i, c1i); \
-	e2i = vtyp_ ## _mul(a2i, c0i); \
-	b1r = vtyp_ ## _add(d2r, e2r); \
-	b3r = vtyp_ ## _sub(e2i, d2i); \
-	d3r = vtyp_ ## _mul(a1i, c0r); \
-	e3r = vtyp_ ## _mul(a0i, c1r); \
-	d3i = vtyp_ ## _mul(a1i, c1r); \
-	e3i = vtyp_ ## _mul(a0i, c0r); \
-	b0i = vtyp_ ## _sub(d3r, e3r); \
-	b2i = vtyp_ ## _sub(e3i, d3i); \
-	z0r = vtyp_ ## _add(b0r, r0); \
-	z2r = vtyp_ ## _add(b2r, r0); \
-	z0i = vtyp_ ## _add(b0i, i0); \
-	z2i = vtyp_ ## _add(b2i, i0); \
-	y1r = vtyp_ ## _add(z0r, b1r); \
-	y1i = vtyp_ ## _sub(z0i, b1i); \
-	y4r = vtyp_ ## _sub(z0r, b1r); \
-	y4i = vtyp_ ## _add(z0i, b1i); \
-	y2r = vtyp_ ## _sub(z2r, b3r); \
-	y2i = vtyp_ ## _add(z2i, b3i); \
-	y3r = vtyp_ ## _add(z2r, b3r); \
-	y3i = vtyp_ ## _sub(z2i, b3i); \
-	vtyp_mac_ ## _ST2(out + 1*outoffset, y1r, y1i); \
-	vtyp_mac_ ## _ST2(out + 2*outoffset, y2r, y2i); \
-	vtyp_mac_ ## _ST2(out + 3*outoffset, y3r, y3i); \
-	vtyp_mac_ ## _ST2(out + 4*outoffset, y4r, y4i); \
-} \
-BUILD_INNER_PASSES(vtyp_, ctyp_, vwidth_, 5)
-
-#define VECRADIX6PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft6_offset_o(const ctyp_ *in, ctyp_ *out, unsigned outoffset) \
-{ \
-	const vtyp_ c0r = vtyp_ ## _broadcast(C_C3); \
-	const vtyp_ c0i = vtyp_ ## _broadcast(C_S3); \
-	vtyp_ a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i, a4r, a4i, a5r, a5i; \
-	vtyp_ b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i, b4r, b4i, b5r, b5i; \
-	vtyp_ c1r, c1i, c2r, c2i, c3r, c3i, c4r, c4i; \
-	vtyp_ d1r, d1i, d2r, d2i, d3r, d3i, d4r, d4i; \
-	vtyp_ e1r, e1i, e2r, e2i; \
-	vtyp_ f0r, f0i, f1r, f1i, f2r, f2i, f3r, f3i, f4r, f4i, f5r, f5i; \
-	vtyp_mac_ ## _LD2(a0r, a0i, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(a1r, a1i, in + 2*vwidth_); \
-	vtyp_mac_ ## _LD2(a2r, a2i, in + 4*vwidth_); \
-	vtyp_mac_ ## _LD2(a3r, a3i, in + 6*vwidth_); \
-	vtyp_mac_ ## _LD2(a4r, a4i, in + 8*vwidth_); \
-	vtyp_mac_ ## _LD2(a5r, a5i, in + 10*vwidth_); \
-	b2r = vtyp_ ## _add(a1r, a5r); \
-	b2i = vtyp_ ## _add(a1i, a5i); \
-	b3r = vtyp_ ## _sub(a1r, a5r); \
-	b3i = vtyp_ ## _sub(a1i, a5i); \
-	b4r = vtyp_ ## _add(a2r, a4r); \
-	b4i = vtyp_ ## _add(a2i, a4i); \
-	b5r = vtyp_ ## _sub(a2r, a4r); \
-	b5i = vtyp_ ## _sub(a2i, a4i); \
-	c1r = vtyp_ ## _add(b2r, b4r); \
-	c1i = vtyp_ ## _add(b2i, b4i); \
-	c2r = vtyp_ ## _sub(b2r, b4r); \
-	c2i = vtyp_ ## _sub(b2i, b4i); \
-	c3r = vtyp_ ## _add(b3r, b5r); \
-	c3i = vtyp_ ## _add(b3i, b5i); \
-	c4r = vtyp_ ## _sub(b3r, b5r); \
-	c4i = vtyp_ ## _sub(b3i, b5i); \
-	d1r = vtyp_ ## _mul(c1r, c0r); \
-	d1i = vtyp_ ## _mul(c1i, c0r); \
-	d2r = vtyp_ ## _mul(c2r, c0r); \
-	d2i = vtyp_ ## _mul(c2i, c0r); \
-	d3r = vtyp_ ## _mul(c3r, c0i); \
-	d3i = vtyp_ ## _mul(c3i, c0i); \
-	d4r = vtyp_ ## _mul(c4r, c0i); \
-	d4i = vtyp_ ## _mul(c4i, c0i); \
-	b0r = vtyp_ ## _add(a0r, a3r); \
-	b0i = vtyp_ ## _add(a0i, a3i); \
-	b1r = vtyp_ ## _sub(a0r, a3r); \
-	b1i = vtyp_ ## _sub(a0i, a3i); \
-	f0r = vtyp_ ## _add(b0r, c1r); \
-	f0i = vtyp_ ## _add(b0i, c1i); \
-	e1r = vtyp_ ## _sub(b0r, d1r); \
-	e1i = vtyp_ ## _sub(b0i, d1i); \
-	f3r = vtyp_ ## _sub(b1r, c2r); \
-	f3i = vtyp_ ## _sub(b1i, c2i); \
-	e2r = vtyp_ ## _add(b1r, d2r); \
-	e2i = vtyp_ ## _add(b1i, d2i); \
-	f2r = vtyp_ ## _add(e1r, d4i); \
-	f2i = vtyp_ ## _sub(e1i, d4r); \
-	f4r = vtyp_ ## _sub(e1r, d4i); \
-	f4i = vtyp_ ## _add(e1i, d4r); \
-	f1r = vtyp_ ## _add(e2r, d3i); \
-	f1i = vtyp_ ## _sub(e2i, d3r); \
-	f5r = vtyp_ ## _sub(e2r, d3i); \
-	f5i = vtyp_ ## _add(e2i, d3r); \
-	vtyp_mac_ ## _ST2(out + 0*outoffset, f0r, f0i); \
-	vtyp_mac_ ## _ST2(out + 1*outoffset, f1r, f1i); \
-	vtyp_mac_ ## _ST2(out + 2*outoffset, f2r, f2i); \
-	vtyp_mac_ ## _ST2(out + 3*outoffset, f3r, f3i); \
-	vtyp_mac_ ## _ST2(out + 4*outoffset, f4r, f4i); \
-	vtyp_mac_ ## _ST2(out + 5*outoffset, f5r, f5i); \
-} \
-BUILD_INNER_PASSES(vtyp_, ctyp_, vwidth_, 6)
-
-#define VECRADIX8PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft8_offset_o(const ctyp_ *in, ctyp_ *out, unsigned outoffset) \
-{ \
-	const vtyp_ vec_root_half = vtyp_ ## _broadcast(C_C4); \
-	vtyp_ a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i, a4r, a4i, a5r, a5i, a6r, a6i, a7r, a7i; \
-	vtyp_ b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i, b4r, b4i, b5r, b5i, b6r, b6i, b7r, b7i; \
-	vtyp_ c0r, c0i, c1r, c1i, c2r, c2i, c3r, c3i, c4r, c4i, c5r, c5i, c6r, c6i, c7r, c7i; \
-	vtyp_ d0r, d0i, d1r, d1i, d2r, d2i, d3r, d3i, d4r, d4i, d5r, d5i, d6r, d6i, d7r, d7i; \
-	vtyp_ e0r, e0i, e2r, e2i, e3r, e3i, e4r, e4i; \
-	vtyp_mac_ ## _LD2(a0r, a0i, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(a1r, a1i, in + 2*vwidth_); \
-	vtyp_mac_ ## _LD2(a2r, a2i, in + 4*vwidth_); \
-	vtyp_mac_ ## _LD2(a3r, a3i, in + 6*vwidth_); \
-	vtyp_mac_ ## _LD2(a4r, a4i, in + 8*vwidth_); \
-	vtyp_mac_ ## _LD2(a5r, a5i, in + 10*vwidth_); \
-	vtyp_mac_ ## _LD2(a6r, a6i, in + 12*vwidth_); \
-	vtyp_mac_ ## _LD2(a7r, a7i, in + 14*vwidth_); \
-	b0r = vtyp_ ## _add(a0r, a4r); \
-	b4r = vtyp_ ## _sub(a0r, a4r); \
-	b0i = vtyp_ ## _add(a0i, a4i); \
-	b4i = vtyp_ ## _sub(a0i, a4i); \
-	b1r = vtyp_ ## _add(a1r, a5r); \
-	e0r = vtyp_ ## _sub(a1r, a5r); \
-	b1i = vtyp_ ## _add(a1i, a5i); \
-	e0i = vtyp_ ## _sub(a5i, a1i); \
-	b2r = vtyp_ ## _add(a2r, a6r); \
-	b6i = vtyp_ ## _sub(a6r, a2r); \
-	b2i = vtyp_ ## _add(a2i, a6i); \
-	b6r = vtyp_ ## _sub(a2i, a6i); \
-	b3r = vtyp_ ## _add(a3r, a7r); \
-	e2r = vtyp_ ## _sub(a3r, a7r); \
-	b3i = vtyp_ ## _add(a3i, a7i); \
-	e2i = vtyp_ ## _sub(a3i, a7i); \
-	c0r = vtyp_ ## _add(b0r, b2r); \
-	c2r = vtyp_ ## _sub(b0r, b2r); \
-	c0i = vtyp_ ## _add(b0i, b2i); \
-	c2i = vtyp_ ## _sub(b0i, b2i); \
-	c1r = vtyp_ ## _add(b1r, b3r); \
-	c3r = vtyp_ ## _sub(b1r, b3r); \
-	c1i = vtyp_ ## _add(b1i, b3i); \
-	c3i = vtyp_ ## _sub(b1i, b3i); \
-	d0r = vtyp_ ## _add(c0r, c1r); \
-	d4r = vtyp_ ## _sub(c0r, c1r); \
-	d0i = vtyp_ ## _add(c0i, c1i); \
-	d4i = vtyp_ ## _sub(c0i, c1i); \
-	vtyp_mac_ ## _ST2(out + 0*outoffset, d0r, d0i); \
-	d2r = vtyp_ ## _add(c2r, c3i); \
-	d6r = vtyp_ ## _sub(c2r, c3i); \
-	d2i = vtyp_ ## _sub(c2i, c3r); \
-	d6i = vtyp_ ## _add(c2i, c3r); \
-	e3r = vtyp_ ## _sub(e0i, e0r); \
-	e3i = vtyp_ ## _add(e0r, e0i); \
-	e4r = vtyp_ ## _sub(e2r, e2i); \
-	e4i = vtyp_ ## _add(e2r, e2i); \
-	b5r = vtyp_ ## _mul(e3r, vec_root_half); \
-	b5i = vtyp_ ## _mul(e3i, vec_root_half); \
-	b7r = vtyp_ ## _mul(e4r, vec_root_half); \
-	b7i = vtyp_ ## _mul(e4i, vec_root_half); \
-	c4r = vtyp_ ## _add(b4r, b6r); \
-	c6r = vtyp_ ## _sub(b4r, b6r); \
-	c4i = vtyp_ ## _add(b4i, b6i); \
-	c6i = vtyp_ ## _sub(b4i, b6i); \
-	c5r = vtyp_ ## _add(b5r, b7r); \
-	c7r = vtyp_ ## _sub(b7r, b5r); \
-	c5i = vtyp_ ## _add(b5i, b7i); \
-	c7i = vtyp_ ## _sub(b7i, b5i); \
-	d1r = vtyp_ ## _sub(c4r, c5r); \
-	d5r = vtyp_ ## _add(c4r, c5r); \
-	d1i = vtyp_ ## _sub(c4i, c5i); \
-	d5i = vtyp_ ## _add(c4i, c5i); \
-	d3r = vtyp_ ## _add(c6r, c7i); \
-	d7r = vtyp_ ## _sub(c6r, c7i); \
-	d3i = vtyp_ ## _sub(c6i, c7r); \
-	d7i = vtyp_ ## _add(c6i, c7r); \
-	vtyp_mac_ ## _ST2(out + 1*outoffset, d1r, d1i); \
-	vtyp_mac_ ## _ST2(out + 2*outoffset, d2r, d2i); \
-	vtyp_mac_ ## _ST2(out + 3*outoffset, d3r, d3i); \
-	vtyp_mac_ ## _ST2(out + 4*outoffset, d4r, d4i); \
-	vtyp_mac_ ## _ST2(out + 5*outoffset, d5r, d5i); \
-	vtyp_mac_ ## _ST2(out + 6*outoffset, d6r, d6i); \
-	vtyp_mac_ ## _ST2(out + 7*outoffset, d7r, d7i); \
-} \
-BUILD_INNER_PASSES(vtyp_, ctyp_, vwidth_, 8)
-
-#define VECRADIX16PASSES(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static COP_ATTR_ALWAYSINLINE void vtyp_ ## _dif_fft16_offset_o(const ctyp_ *in, ctyp_ *out, unsigned outoffset) \
-{ \
-	const vtyp_ VC_C4 = vtyp_ ## _broadcast(C_C4); \
-	const vtyp_ VC_C8 = vtyp_ ## _broadcast(C_C8); \
-	const vtyp_ VC_S8 = vtyp_ ## _broadcast(C_S8); \
-	ctyp_ VEC_ALIGN_BEST stack[vwidth_*32]; \
-	vtyp_ a0r, a0i, a1r, a1i, a2r, a2i, a3r, a3i; \
-	vtyp_ b0r, b0i, b1r, b1i, b2r, b2i, b3r, b3i; \
-	vtyp_ c0r, c0i, c1r, c1i, c2r, c2i, c3r, c3i; \
-	vtyp_ d0r, d0i, d1r, d1i, d2r, d2i, d3r, d3i; \
-	vtyp_ y0r, y0i, y1r, y1i, y2r, y2i, y3r, y3i; \
-	vtyp_ z0r, z0i, z1r, z1i, z2r, z2i, z3r, z3i; \
-	vtyp_ e1r, e1i, e2r, e2i, e3r, e3i; \
-	vtyp_mac_ ## _LD2(a0r, a0i, in + 0*vwidth_); \
-	vtyp_mac_ ## _LD2(b0r, b0i, in + 8*vwidth_); \
-	vtyp_mac_ ## _LD2(c0r, c0i, in + 16*vwidth_); \
-	vtyp_mac_ ## _LD2(d0r, d0i, in + 24*vwidth_); \
-	y0r  = vtyp_ ## _add(a0r, c0r); \
-	y0i  = vtyp_ ## _add(a0i, c0i); \
-	y2r  = vtyp_ ## _sub(a0r, c0r); \
-	y2i  = vtyp_ ## _sub(a0i, c0i); \
-	y1r  = vtyp_ ## _add(b0r, d0r); \
-	y1i  = vtyp_ ## _add(b0i, d0i); \
-	y3r  = vtyp_ ## _sub(b0r, d0r); \
-	y3i  = vtyp_ ## _sub(b0i, d0i); \
-	z0r  = vtyp_ ## _add(y0r, y1r); \
-	z0i  = vtyp_ ## _add(y0i, y1i); \
-	z2r  = vtyp_ ## _sub(y0r, y1r); \
-	z2i  = vtyp_ ## _sub(y0i, y1i); \
-	z1r  = vtyp_ ## _add(y2r, y3i); \
-	z1i  = vtyp_ ## _sub(y2i, y3r); \
-	z3r  = vtyp_ ## _sub(y2r, y3i); \
-	z3i  = vtyp_ ## _add(y2i, y3r); \
-	vtyp_mac_ ## _ST2(stack + 0*vwidth_,  z0r, z0i); \
-	vtyp_mac_ ## _ST2(stack + 8*vwidth_,  z1r, z1i); \
-	vtyp_mac_ ## _ST2(stack + 16*vwidth_, z2r, z2i); \
-	vtyp_mac_ ## _ST2(stack + 24*vwidth_, z3r, z3i); \
-	vtyp_mac_ ## _LD2(a1r, a1i, in + 2*vwidth_); \
-	vtyp_mac_ ## _LD2(b1r, b1i, in + 10*vwidth_); \
-	vtyp_mac_ ## _LD2(c1r, c1i, in + 18*vwidth_); \
-	vtyp_mac_ ## _LD2(d1r, d1i, in + 26*vwidth_); \
-	y0r  = vtyp_ ## _add(a1r, c1r); \
-	y2r  = vtyp_ ## _sub(a1r, c1r); \
-	y0i  = vtyp_ ## _add(a1i, c1i); \
-	y2i  = vtyp_ ## _sub(a1i, c1i); \
-	y1r  = vtyp_ ## _add(b1r, d1r); \
-	y3r  = vtyp_ ## _sub(b1r, d1r); \
-	y1i  = vtyp_ ## _add(b1i, d1i); \
-	y3i  = vtyp_ ## _sub(b1i, d1i); \
-	z0r  = vtyp_ ## _add(y0r, y1r); \
-	z2r  = vtyp_ ## _sub(y0r, y1r); \
-	z0i  = vtyp_ ## _add(y0i, y1i); \
-	z2i  = vtyp_ ## _sub(y0i, y1i); \
-	z1r  = vtyp_ ## _add(y2r, y3i); \
-	z3r  = vtyp_ ## _sub(y2r, y3i); \
-	z1i  = vtyp_ ## _sub(y2i, y3r); \
-	z3i  = vtyp_ ## _add(y2i, y3r); \
-	e1r  = vtyp_ ## _mul(z1r, VC_C8); \
-	e1i  = vtyp_ ## _mul(z1i, VC_C8); \
-	z1r  = vtyp_ ## _mul(z1r, VC_S8); \
-	z1i  = vtyp_ ## _mul(z1i, VC_S8); \
-	e1r  = vtyp_ ## _add(e1r, z1i); \
-	e1i  = vtyp_ ## _sub(e1i, z1r); \
-	z2r  = vtyp_ ## _mul(z2r, VC_C4); \
-	z2i  = vtyp_ ## _mul(z2i, VC_C4); \
-	e2r  = vtyp_ ## _add(z2r, z2i); \
-	e2i  = vtyp_ ## _sub(z2i, z2r); \
-	e3r  = vtyp_ ## _mul(z3r, VC_S8); \
-	e3i  = vtyp_ ## _mul(z3i, VC_S8); \
-	z3i  = vtyp_ ## _mul(z3i, VC_C8); \
-	z3r  = vtyp_ ## _mul(z3r, VC_C8); \
-	e3r  = vtyp_ ## _add(e3r, z3i); \
-	e3i  = vtyp_ ## _sub(e3i, z3r); \
-	vtyp_mac_ ## _ST2(stack + 2*vwidth_,  z0r, z0i); \
-	vtyp_mac_ ## _ST2(stack + 10*vwidth_, e1r, e1i); \
-	vtyp_mac_ ## _ST2(stack + 18*vwidth_, e2r, e2i); \
-	vtyp_mac_ ## _ST2(stack + 26*vwidth_, e3r, e3i); \
-	vtyp_mac_ ## _LD2(a2r, a2i, in + 4*vwidth_); \
-	vtyp_mac_ ## _LD2(b2r, b2i, in + 12*vwidth_); \
-	vtyp_mac_ ## _LD2(c2r, c2i, in + 20*vwidth_); \
-	vtyp_mac_ ## _LD2(d2r, d2i, in + 28*vwidth_); \
-	y0r  = vtyp_ ## _add(a2r, c2r); \
-	y2r  = vtyp_ ## _sub(a2r, c2r); \
-	y0i  = vtyp_ ## _add(a2i, c2i); \
-	y2i  = vtyp_ ## _sub(a2i, c2i); \
-	y1r  = vtyp_ ## _add(b2r, d2r); \
-	y3r  = vtyp_ ## _sub(b2r, d2r); \
-	y1i  = vtyp_ ## _add(b2i, d2i); \
-	y3i  = vtyp_ ## _sub(b2i, d2i); \
-	z0r  = vtyp_ ## _add(y1r, y0r); \
-	z2r  = vtyp_ ## _sub(y1r, y0r); \
-	z0i  = vtyp_ ## _add(y0i, y1i); \
-	z2i  = vtyp_ ## _sub(y0i, y1i); \
-	z1r  = vtyp_ ## _add(y3i, y2r); \
-	z3r  = vtyp_ ## _sub(y3i, y2r); \
-	z1i  = vtyp_ ## _sub(y2i, y3r); \
-	z3i  = vtyp_ ## _add(y2i, y3r); \
-	e1r  = vtyp_ ## _add(z1i, z1r); \
-	e1i  = vtyp_ ## _sub(z1i, z1r); \
-	e3r  = vtyp_ ## _add(z3r, z3i); \
-	e3i  = vtyp_ ## _sub(z3r, z3i); \
-	e1r  = vtyp_ ## _mul(e1r, VC_C4); \
-	e1i  = vtyp_ ## _mul(e1i, VC_C4); \
-	e3r  = vtyp_ ## _mul(e3r, VC_C4); \
-	e3i  = vtyp_ ## _mul(e3i, VC_C4); \
-	vtyp_mac_ ## _ST2(stack + 4*vwidth_,  z0r, z0i); \
-	vtyp_mac_ ## _ST2(stack + 12*vwidth_, e1r, e1i); \
-	vtyp_mac_ ## _ST2(stack + 20*vwidth_, z2i, z2r); \
-	vtyp_mac_ ## _ST2(stack + 28*vwidth_, e3r, e3i); \
-	vtyp_mac_ ## _LD2(a3r, a3i, in + 6*vwidth_); \
-	vtyp_mac_ ## _LD2(b3r, b3i, in + 14*vwidth_); \
-	vtyp_mac_ ## _LD2(c3r, c3i, in + 22*vwidth_); \
-	vtyp_mac_ ## _LD2(d3r, d3i, in + 30*vwidth_); \
-	y0r  = vtyp_ ## _add(a3r, c3r); \
-	y2r  = vtyp_ ## _sub(a3r, c3r); \
-	y0i  = vtyp_ ## _add(a3i, c3i); \
-	y2i  = vtyp_ ## _sub(a3i, c3i); \
-	y1r  = vtyp_ ## _add(b3r, d3r); \
-	y3r  = vtyp_ ## _sub(d3r, b3r); \
-	y1i  = vtyp_ ## _add(b3i, d3i); \
-	y3i  = vtyp_ ## _sub(b3i, d3i); \
-	z0r  = vtyp_ ## _add(y1r, y0r); \
-	z2r  = vtyp_ ## _sub(y1r, y0r); \
-	z0i  = vtyp_ ## _add(y0i, y1i); \
-	z2i  = vtyp_ ## _sub(y0i, y1i); \
-	z1r  = vtyp_ ## _add(y2r, y3i); \
-	z3r  = vtyp_ ## _sub(y2r, y3i); \
-	z1i  = vtyp_ ## _add(y3r, y2i); \
-	z3i  = vtyp_ ## _sub(y3r, y2i); \
-	e1r  = vtyp_ ## _mul(z1r, VC_S8); \
-	e1i  = vtyp_ ## _mul(z1i, VC_S8); \
-	z1i  = vtyp_ ## _mul(z1i, VC_C8); \
-	z1r  = vtyp_ ## _mul(z1r, VC_C8); \
-	e1r  = vtyp_ ## _add(e1r, z1i); \
-	e1i  = vtyp_ ## _sub(e1i, z1r); \
-	e2r  = vtyp_ ## _add(z2r, z2i); \
-	e2i  = vtyp_ ## _sub(z2r, z2i); \
-	e2r  = vtyp_ ## _mul(e2r, VC_C4); \
-	e2i  = vtyp_ ## _mul(e2i, VC_C4); \
-	e3r  = vtyp_ ## _mul(z3i, VC_S8); \
-	e3i  = vtyp_ ## _mul(z3r, VC_S8); \
-	z3r  = vtyp_ ## _mul(z3r, VC_C8); \
-	z3i  = vtyp_ ## _mul(z3i, VC_C8); \
-	e3r  = vtyp_ ## _sub(e3r, z3r); \
-	e3i  = vtyp_ ## _add(e3i, z3i); \
-	vtyp_mac_ ## _ST2(stack + 6*vwidth_,  z0r, z0i); \
-	vtyp_ ## _dif_fft4_offset_o(stack + 0*vwidth_,  out + 0*outoffset, 4*outoffset); \
-	vtyp_mac_ ## _ST2(stack + 14*vwidth_, e1r, e1i); \
-	vtyp_ ## _dif_fft4_offset_o(stack + 8*vwidth_,  out + 1*outoffset, 4*outoffset); \
-	vtyp_mac_ ## _ST2(stack + 22*vwidth_, e2r, e2i); \
-	vtyp_ ## _dif_fft4_offset_o(stack + 16*vwidth_, out + 2*outoffset, 4*outoffset); \
-	vtyp_mac_ ## _ST2(stack + 30*vwidth_, e3r, e3i); \
-	vtyp_ ## _dif_fft4_offset_o(stack + 24*vwidth_, out + 3*outoffset, 4*outoffset); \
-} \
-BUILD_INNER_PASSES(vtyp_, ctyp_, vwidth_, 16)
-
-#define BUILD_MULCONJ(vtyp_, vtyp_mac_, ctyp_, vwidth_) \
-static \
-void \
-fftset_vec_mulconj_ ## vtyp_(ctyp_ *work_buf, const ctyp_ *kernel_buf, unsigned nb_vec_fft) \
-{ \
-	do { \
-		vtyp_ dr, di, cr, ci, ra, rb, ia, ib, ro, io; \
-		vtyp_mac_ ## _LD2(dr, di, work_buf); \
-		vtyp_mac_ ## _LD2(cr, ci, kernel_buf); \
-		di = vtyp_ ## _neg(di); \
-		ra = vtyp_ ## _mul(dr, cr); \
-		ib = vtyp_ ## _mul(dr, ci); \
-		rb = vtyp_ ## _mul(di, ci); \
-		ia = vtyp_ ## _mul(di, cr); \
-		ro = vtyp_ ## _add(ra, rb); \
-		io = vtyp_ ## _sub(ia, ib); \
-		vtyp_mac_ ## _ST2(work_buf, ro, io); \
-		work_buf   += (vwidth_)*2; \
-		kernel_buf += (vwidth_)*2; \
-	} while (--nb_vec_fft); \
-}
-
-VECRADIX2PASSES(v1f, V1F, float, 1)
-VECRADIX3PASSES(v1f, V1F, float, 1)
-VECRADIX4PASSES(v1f, V1F, float, 1)
-VECRADIX5PASSES(v1f, V1F, float, 1)
-VECRADIX6PASSES(v1f, V1F, float, 1)
-VECRADIX8PASSES(v1f, V1F, float, 1)
-VECRADIX16PASSES(v1f, V1F, float, 1)
-BUILD_MULCONJ(v1f, V1F, float, 1)
-#if V4F_EXISTS
-VECRADIX2PASSES(v4f, V4F, float, 4)
-VECRADIX3PASSES(v4f, V4F, float, 4)
-VECRADIX4PASSES(v4f, V4F, float, 4)
-VECRADIX5PASSES(v4f, V4F, float, 4)
-VECRADIX6PASSES(v4f, V4F, float, 4)
-VECRADIX8PASSES(v4f, V4F, float, 4)
-VECRADIX16PASSES(v4f, V4F, float, 4)
-BUILD_MULCONJ(v4f, V4F, float, 4)
-#endif
-#if V8F_EXISTS
-VECRADIX2PASSES(v8f, V8F, float, 8)
-VECRADIX3PASSES(v8f, V8F, float, 8)
-VECRADIX4PASSES(v8f, V8F, float, 8)
-VECRADIX5PASSES(v8f, V8F, float, 8)
-VECRADIX6PASSES(v8f, V8F, float, 8)
-VECRADIX8PASSES(v8f, V8F, float, 8)
-VECRADIX16PASSES(v8f, V8F, float, 8)
-BUILD_MULCONJ(v8f, V8F, float, 8)
-#endif
-
-#if 0
-VECRADIX2PASSES(v1d, V1D, double, 1)
-VECRADIX3PASSES(v1d, V1D, double, 1)
-VECRADIX4PASSES(v1d, V1D, double, 1)
-VECRADIX5PASSES(v1d, V1D, double, 1)
-VECRADIX6PASSES(v1d, V1D, double, 1)
-VECRADIX8PASSES(v1d, V1D, double, 1)
-VECRADIX16PASSES(v1d, V1D, double, 1)
+void
+fftset_vec_kern_compact
+	(void                      *output_buf
+	,const float               *input_buf
+	,size_t                     nb_values
+	,enum fftset_kernel_format  kernel_format
+	)
+{
+	unsigned short *out = output_buf;
+	size_t i = 0;
+
+	switch (kernel_format) {
+	case FFTSET_KERNEL_FORMAT_F16:
+#if FFTSET_HAVE_F16C
+		for (; i + 4 <= nb_values; i += 4)
+			_mm_storel_epi64((__m128i *)(out + i), _mm_cvtps_ph(_mm_loadu_ps(input_buf + i), 0));
 #endif
-
-struct float_pass_radix {
-	unsigned   radix;
-	unsigned   fito_vec_len;
-	unsigned   foti_vec_len;
-
-	void     (*mulconj)(float *work, const float *kern, unsigned nb_vec_fft);
-	void     (*inner)(float *work, unsigned nfft, unsigned lfft, const float *twid);
-	void     (*inner_stock)(float *out, const float *in, const float *twid, unsigned ncol, unsigned nrow_div_radix);
-	void     (*dif)(float *work, unsigned nfft, unsigned lfft, const float *twid);
-	void     (*dit)(float *work, unsigned nfft, unsigned lfft, const float *twid);
-	void     (*stock)(float *out, const float *in, const float *twid, unsigned ncol, unsigned nrow_div_radix);
-};
-
-#define FLOAT_PASS_EVERY(vtyp_, radix_, vwidth_, foti_width_) \
-{   radix_ \
-,   vwidth_ \
-,   foti_width_ \
-,   fftset_vec_mulconj_ ## vtyp_ \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _inner \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _inner_stock \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _dif \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _dit \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _stock \
-}
-#define FLOAT_PASS_INNER(vtyp_, radix_, vwidth_, foti_width_) \
-{   radix_ \
-,   vwidth_ \
-,   foti_width_ \
-,   fftset_vec_mulconj_ ## vtyp_ \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _inner \
-,   fftset_ ## vtyp_ ## _r ## radix_ ## _inner_stock \
-,   NULL \
-,   NULL \
-,   NULL \
+		for (; i < nb_values; i++)
+			out[i] = fftset_f32_to_f16(input_buf[i]);
+		break;
+	case FFTSET_KERNEL_FORMAT_BF16:
+		for (; i < nb_values; i++)
+			out[i] = fftset_f32_to_bf16(input_buf[i]);
+		break;
+	default:
+		memcpy(output_buf, input_buf, sizeof(float) * nb_values);
+		break;
+	}
 }
 
-/* This list must be sorted by fito_vec_len. */
-const struct float_pass_radix FFTSET_FLOAT_PASSES[] =
-{FLOAT_PASS_EVERY(v1f, 2,  1, 1)
-,FLOAT_PASS_EVERY(v1f, 3,  1, 1)
-,FLOAT_PASS_EVERY(v1f, 4,  1, 1)
-,FLOAT_PASS_INNER(v1f, 5,  1, 1)
-,FLOAT_PASS_INNER(v1f, 6,  1, 1)
-,FLOAT_PASS_INNER(v1f, 8,  1, 1)
-,FLOAT_PASS_INNER(v1f, 16, 1, 1)
-#if V4F_EXISTS
-,FLOAT_PASS_EVERY(v4f, 2,  4, 4)
-,FLOAT_PASS_EVERY(v4f, 3,  4, 4)
-,FLOAT_PASS_EVERY(v4f, 4,  4, 4)
-,FLOAT_PASS_INNER(v4f, 5,  4, 4)
-,FLOAT_PASS_INNER(v4f, 6,  4, 4)
-,FLOAT_PASS_INNER(v4f, 8,  4, 4)
-,FLOAT_PASS_INNER(v4f, 16, 4, 4)
-#endif
-#if V8F_EXISTS
-,FLOAT_PASS_EVERY(v8f, 2,  8, 8)
-,FLOAT_PASS_EVERY(v8f, 3,  8, 8)
-,FLOAT_PASS_EVERY(v8f, 4,  8, 8)
-,FLOAT_PASS_INNER(v8f, 5,  8, 8)
-,FLOAT_PASS_INNER(v8f, 6,  8, 8)
-,FLOAT_PASS_INNER(v8f, 8,  8, 8)
-,FLOAT_PASS_INNER(v8f, 16, 8, 8)
-#endif
-};
-
-#define NB_PASSES (sizeof(FFTSET_FLOAT_PASSES) / sizeof(FFTSET_FLOAT_PASSES[0]))
 
 struct fft_graph_node {
 	/* Number of vector FFTs that will be executed in this pass. */
-	unsigned                       nb_vec;
+	size_t                         nb_vec;
 
 	/* Vector width of this pass. */
 	unsigned                       vec_width;
 
 	/* The length of the vector FFTs. */
-	unsigned                       length;
+	size_t                         length;
 
 	/* The pass definition. */
 	const struct float_pass_radix *pass;
@@ -990,261 +85,1177 @@ struct fft_graph_node {
 	unsigned                       cost; /* zero indicates the cost is not set. */
 };
 
-static const struct fftset_vec *fastconv_find_pass(const struct fftset_vec *pass, unsigned length, unsigned vec_width)
+/* Inner passes are indexed by their length, vector width and the kind of
+ * chain they begin. */
+#define FASTCONV_PASS_KEY(vec_width_, chain_) ((uintptr_t)(vec_width_) | ((uintptr_t)(chain_) << 16))
+
+static struct fftset_vec *fastconv_find_pass(struct fftset *fc, size_t length, unsigned vec_width, unsigned chain)
 {
-	for (; pass != NULL; pass = pass->next) {
-		if (pass->lfft_div_radix*pass->radix == length && pass->vec_width == vec_width)
-			return pass;
-		if (pass->lfft_div_radix*pass->radix < length)
-			break;
+	return fftset_index_find(&(fc->inner_index), FASTCONV_PASS_KEY(vec_width, chain), length);
+}
+
+/* The cost of a chain only depends on the length and vector width it starts
+ * with, so the best chain for every (divisor of the length, vector width)
+ * pair is found once in order of increasing length. Every pass divides the
+ * length so the remainder of any chain is always a smaller divisor which has
+ * already been solved. Ties are resolved in favour of the pass which appears
+ * first in the kernel's pass list. */
+
+struct fft_graph_state {
+	/* Cost of the best chain. Zero indicates there is no chain. */
+	unsigned cost;
+
+	/* Index into the pass definitions of the first pass of the chain. */
+	unsigned pass;
+};
+
+#define FFT_GRAPH_MAX_WIDTHS (4)
+
+static unsigned build_float_graph_widths(const struct fftset_kernels *kernels, unsigned *widths)
+{
+	unsigned i, j, nb_widths = 0;
+	for (i = 0; i < kernels->nb_passes; i++) {
+		for (j = 0; j < nb_widths && widths[j] != kernels->passes[i].fito_vec_len; j++);
+		if (j == nb_widths) {
+			assert(nb_widths < FFT_GRAPH_MAX_WIDTHS);
+			widths[nb_widths++] = kernels->passes[i].fito_vec_len;
+		}
 	}
-	return NULL;
+	return nb_widths;
 }
 
-int
+static unsigned build_float_graph_width_index(const unsigned *widths, unsigned nb_widths, unsigned vec_width)
+{
+	unsigned i;
+	for (i = 0; i < nb_widths && widths[i] != vec_width; i++);
+	return i;
+}
+
+/* Returns the divisors of length which can be reached by dividing it by pass
+ * radices (i.e. every divisor which differs from length only by factors of
+ * 2, 3 and 5) in increasing order. The array must be freed by the caller.
+ * Returns NULL if memory was exhausted. */
+static size_t *build_float_graph_divisors(size_t length, size_t *nb_divisors)
+{
+	static const unsigned factors[3] = {2, 3, 5};
+	size_t   *divisors;
+	size_t    base  = length;
+	size_t    count = 1;
+	size_t    n, i, j;
+	unsigned  f;
+
+	/* Remove the part of the length which no pass can remove and count the
+	 * combinations of the remaining factors. */
+	for (f = 0; f < 3; f++) {
+		size_t multiplicity = 0;
+		while (base % factors[f] == 0) {
+			base /= factors[f];
+			multiplicity++;
+		}
+		count *= multiplicity + 1;
+	}
+
+	divisors = malloc(sizeof(divisors[0]) * count);
+	if (divisors == NULL)
+		return NULL;
+
+	divisors[0] = base;
+	n           = 1;
+	for (f = 0; f < 3; f++) {
+		size_t nb_prev = n;
+		for (i = 0; i < nb_prev; i++) {
+			size_t d = divisors[i];
+			while ((length / d) % factors[f] == 0) {
+				d *= factors[f];
+				divisors[n++] = d;
+			}
+		}
+	}
+	assert(n == count);
+
+	/* Insertion sort - there are only ever a few thousand at most. */
+	for (i = 1; i < n; i++) {
+		size_t d = divisors[i];
+		for (j = i; j > 0 && divisors[j - 1] > d; j--)
+			divisors[j] = divisors[j - 1];
+		divisors[j] = d;
+	}
+
+	*nb_divisors = n;
+	return divisors;
+}
+
+static size_t build_float_graph_find(const size_t *divisors, size_t nb_divisors, size_t length)
+{
+	size_t lo = 0, hi = nb_divisors;
+	while (hi - lo > 1) {
+		size_t mid = (lo + hi) / 2;
+		if (divisors[mid] > length)
+			hi = mid;
+		else
+			lo = mid;
+	}
+	assert(divisors[lo] == length);
+	return lo;
+}
+
+/* Finds the cheapest chain of passes for a transform of the given length.
+ * Returns an array describing the chain (the last entry is the pass where
+ * the length is equal to the radix) which must be freed by the caller or NULL
+ * if no chain exists or memory was exhausted. */
+static
+struct fft_graph_node *
 build_float_graph
-	(struct fft_graph_node   *best
-	,unsigned                 vec_width
-	,unsigned                 nb_fft
-	,unsigned                 length
+	(const struct fftset_kernels *kernels
+	,unsigned                     vec_width
+	,size_t                       nb_fft
+	,size_t                       length
 	)
 {
-	unsigned i;
+	unsigned                widths[FFT_GRAPH_MAX_WIDTHS];
+	struct fft_graph_node  *chain = NULL;
+	struct fft_graph_state *states;
+	size_t                 *divisors;
+	size_t                  nb_divisors;
+	size_t                  nb_chain;
+	size_t                  d, n;
+	unsigned                nb_widths;
+	unsigned                w, i;
 
 	assert(length > 1);
 
-	best->cost = 0;
-	best->vec_width = vec_width;
+	nb_widths = build_float_graph_widths(kernels, widths);
+	if (build_float_graph_width_index(widths, nb_widths, vec_width) == nb_widths)
+		return NULL;
 
-	for (i = 0; i < NB_PASSES; i++) {
-		if (vec_width != FFTSET_FLOAT_PASSES[i].fito_vec_len)
-			continue;
+	divisors = build_float_graph_divisors(length, &nb_divisors);
+	if (divisors == NULL)
+		return NULL;
+
+	states = malloc(sizeof(states[0]) * nb_divisors * nb_widths);
+	if (states == NULL) {
+		free(divisors);
+		return NULL;
+	}
+
+	for (d = 0; d < nb_divisors; d++) {
+		for (w = 0; w < nb_widths; w++) {
+			struct fft_graph_state *state = states + d * nb_widths + w;
+
+			state->cost = 0;
+			state->pass = 0;
+
+			for (i = 0; i < kernels->nb_passes; i++) {
+				const struct float_pass_radix *fp = kernels->passes + i;
+				unsigned cost;
+
+				if (widths[w] != fp->fito_vec_len)
+					continue;
+
+				cost = 100 + ((fp->radix + 2) * (fp->foti_vec_len + 3) * 10000) / (fp->radix * fp->foti_vec_len);
+
+				if (divisors[d] != fp->radix) {
+					const struct fft_graph_state *next;
+					unsigned next_width;
 
-		unsigned cost         = 100 + ((FFTSET_FLOAT_PASSES[i].radix + 2) * (FFTSET_FLOAT_PASSES[i].foti_vec_len + 3) * 10000) / (FFTSET_FLOAT_PASSES[i].radix * FFTSET_FLOAT_PASSES[i].foti_vec_len);
+					if (fp->dif == NULL || divisors[d] % fp->radix)
+						continue;
 
-		if (length == FFTSET_FLOAT_PASSES[i].radix) {
-			if (best->cost == 0 || best->cost > cost) {
-				best->cost   = cost;
-				best->nb_vec = nb_fft;
-				best->length = length;
-				best->pass   = FFTSET_FLOAT_PASSES + i;
+					next_width = build_float_graph_width_index(widths, nb_widths, fp->foti_vec_len);
+					next       = states + build_float_graph_find(divisors, d, divisors[d] / fp->radix) * nb_widths + next_width;
+					if (next->cost == 0)
+						continue;
+
+					cost += next->cost;
+				}
+
+				if (state->cost == 0 || state->cost > cost) {
+					state->cost = cost;
+					state->pass = i;
+				}
 			}
-			continue;
 		}
+	}
 
-		if ((FFTSET_FLOAT_PASSES[i].dif == NULL) || (length % FFTSET_FLOAT_PASSES[i].radix))
-			continue;
+	/* Walk the solution from the full length, once to size the chain and
+	 * once to fill it in. */
+	for (n = 0; n < 2; n++) {
+		const struct fft_graph_state *state;
 
-		unsigned next_length  = length / FFTSET_FLOAT_PASSES[i].radix;
-		unsigned next_vec_len = FFTSET_FLOAT_PASSES[i].foti_vec_len;
-		unsigned next_nb_fft  = nb_fft * (FFTSET_FLOAT_PASSES[i].radix * FFTSET_FLOAT_PASSES[i].fito_vec_len) / FFTSET_FLOAT_PASSES[i].foti_vec_len;
-		struct fft_graph_node nexts[32];
+		d        = nb_divisors - 1;
+		w        = build_float_graph_width_index(widths, nb_widths, vec_width);
+		state    = states + d * nb_widths + w;
+		nb_chain = 0;
+		if (state->cost == 0)
+			break;
 
-		if (!build_float_graph(nexts, next_vec_len, next_nb_fft, next_length))
-			continue;
+		for (;;) {
+			const struct float_pass_radix *fp = kernels->passes + state->pass;
 
-		if (best->cost == 0 || best->cost > nexts[0].cost + cost) {
-			unsigned j;
-			best->cost   = nexts[0].cost + cost;
-			best->nb_vec = nb_fft;
-			best->length = length;
-			best->pass   = FFTSET_FLOAT_PASSES + i;
-			
-			for (j = 0; j < 32; j++) {
-				best[j+1] = nexts[j];
-				if (nexts[j].length == nexts[j].pass->radix)
-					break;
+			if (chain != NULL) {
+				chain[nb_chain].cost      = state->cost;
+				chain[nb_chain].nb_vec    = nb_fft;
+				chain[nb_chain].vec_width = widths[w];
+				chain[nb_chain].length    = divisors[d];
+				chain[nb_chain].pass      = fp;
+				nb_fft = nb_fft * (fp->radix * fp->fito_vec_len) / fp->foti_vec_len;
 			}
+			nb_chain++;
+
+			if (divisors[d] == fp->radix)
+				break;
+
+			w     = build_float_graph_width_index(widths, nb_widths, fp->foti_vec_len);
+			d     = build_float_graph_find(divisors, d, divisors[d] / fp->radix);
+			state = states + d * nb_widths + w;
+		}
+
+		if (chain == NULL) {
+			chain = malloc(sizeof(chain[0]) * nb_chain);
+			if (chain == NULL)
+				break;
+		}
+	}
+
+	free(states);
+	free(divisors);
+	return chain;
+}
+
+/* The twiddles of a radix r pass of length L are W_L^{jk} for j in [0, L/r)
+ * and k in [1, r). These are stored as rows indexed by j. Given a table built
+ * for a length M which is a multiple of L, the twiddles for the pass are
+ * found at every (M/L)th row; so all passes of the same radix whose length
+ * divides M share the table.
+ *
+ * Passes are created from the longest down (the estimating planner builds a
+ * chain from its first pass) so the passes further down a chain usually find
+ * a table which already covers them. When no table covers a length, a new
+ * table is built for it. If the new length is a multiple of an existing
+ * table's length, the new table replaces that one as the table which later
+ * passes share; the old table is not freed as earlier passes still reference
+ * it. Otherwise the new table is kept alongside the others. */
+
+struct fftset_twiddle {
+	unsigned               radix;
+	size_t                 length;
+	const float           *table;
+	struct fftset_twiddle *next;
+};
+
+/* Number of floats in the twiddle table of a radix r pass of length L. */
+static size_t fastconv_twiddle_size(unsigned radix, size_t length)
+{
+	return 2 * (radix - 1) * (length / radix);
+}
+
+static void fastconv_fill_twiddle(float *table, unsigned radix, size_t length)
+{
+	size_t j;
+
+	/* Angles are reduced modulo the length and evaluated in double precision
+	 * so that large tables stay accurate. */
+	for (j = 0; j < length / radix; j++) {
+		unsigned k;
+		for (k = 1; k < radix; k++) {
+			double angle = (double)(((unsigned long long)j * k) % length) * (-M_PI * 2.0) / (double)length;
+			*table++ = (float)cos(angle);
+			*table++ = (float)sin(angle);
+		}
+	}
+}
+
+static const float *fastconv_get_twiddle(struct fftset *fc, unsigned radix, size_t length, size_t *row_stride)
+{
+	struct fftset_twiddle *tw;
+	struct fftset_twiddle *replace = NULL;
+	float                 *table;
+
+	for (tw = fc->twiddles; tw != NULL; tw = tw->next) {
+		if (tw->radix != radix)
+			continue;
+		if (tw->length % length == 0) {
+			*row_stride = tw->length / length;
+			return tw->table;
 		}
+		if (length % tw->length == 0 && replace == NULL)
+			replace = tw;
+	}
+
+	if (length / radix > ((size_t)-1) / (sizeof(float) * 2 * (radix - 1)))
+		return NULL;
+	table = fftset_alloc(fc, sizeof(float) * fastconv_twiddle_size(radix, length), 64, FFTSET_MEM_TWIDDLE);
+	if (table == NULL)
+		return NULL;
+	fastconv_fill_twiddle(table, radix, length);
+
+	if (replace == NULL) {
+		replace = fftset_alloc(fc, sizeof(*replace), 0, FFTSET_MEM_OVERHEAD);
+		if (replace == NULL)
+			return NULL;
+		replace->radix = radix;
+		replace->next  = fc->twiddles;
+		fc->twiddles   = replace;
+	}
+	replace->length = length;
+	replace->table  = table;
+
+	*row_stride = 1;
+	return table;
+}
+
+static struct fftset_vec *fastconv_insert_pass(struct fftset *fc, struct fftset_vec *pass)
+{
+	size_t              pass_length = pass->lfft_div_radix * pass->radix;
+	struct fftset_vec **list;
+
+	if (fftset_index_insert(&(fc->inner_index), fc, FASTCONV_PASS_KEY(pass->vec_width, pass->chain), pass_length, pass))
+		return NULL;
+
+	/* Insert into list. */
+	list = &(fc->first_inner);
+	while (*list != NULL && pass_length < (*list)->lfft_div_radix * (*list)->radix) {
+		list = &(*list)->next;
 	}
+	pass->next = *list;
+	*list = pass;
 
-	return best->cost != 0;
+	return pass;
 }
 
-static struct fftset_vec *fastconv_add_passes(struct fftset_vec **list, struct cop_salloc_iface *alloc, struct fft_graph_node *passes)
+static struct fftset_vec *fastconv_add_passes(struct fftset *fc, struct fft_graph_node *passes)
 {
 	unsigned            pass_radix  = passes->pass->radix;
-	unsigned            pass_length = passes->length;
+	size_t              pass_length = passes->length;
 	struct fftset_vec  *pass;
 
 	/* Create new inner pass. */
-	pass = cop_salloc(alloc, sizeof(*pass), 0);
+	pass = fftset_alloc(fc, sizeof(*pass), 0, FFTSET_MEM_PASS);
 	if (pass == NULL)
 		return NULL;
 
 	pass->cost           = passes->cost;
 	pass->vec_width      = passes->vec_width;
+	pass->chain          = FFTSET_VEC_CHAIN_ESTIMATE;
 
 	if (pass_length == pass_radix) {
 		pass->twiddle        = NULL;
+		pass->twiddle_stride = 0;
 		pass->lfft_div_radix = 1;
 		pass->radix          = pass_radix;
 		pass->dif            = passes->pass->inner;
 		pass->dit            = passes->pass->inner;
 		pass->dif_stockham   = passes->pass->inner_stock;
 		pass->mulconj        = passes->pass->mulconj;
+		pass->mulconj_f16    = passes->pass->mulconj_f16;
+		pass->mulconj_bf16   = passes->pass->mulconj_bf16;
 		pass->next_compat    = NULL;
 	} else {
-		unsigned j;
-		float *twid;
-		twid = cop_salloc(alloc, sizeof(float) * 2 * (pass_radix - 1) * pass_length / pass_radix, 64);
-		pass->twiddle        = twid;
+		size_t row_stride;
+		pass->twiddle        = fastconv_get_twiddle(fc, pass_radix, pass_length, &row_stride);
+		if (pass->twiddle == NULL)
+			return NULL;
+		pass->twiddle_stride = 2 * (pass_radix - 1) * row_stride;
 		pass->lfft_div_radix = pass_length / pass_radix;
 		pass->radix          = pass_radix;
 		pass->dif            = passes->pass->dif;
 		pass->dit            = passes->pass->dit;
 		pass->dif_stockham   = passes->pass->stock;
 		pass->mulconj        = passes->pass->mulconj;
-		pass->next_compat    = fastconv_find_pass(*list, pass->lfft_div_radix, pass->vec_width);
+		pass->mulconj_f16    = passes->pass->mulconj_f16;
+		pass->mulconj_bf16   = passes->pass->mulconj_bf16;
+		pass->next_compat    = fastconv_find_pass(fc, pass->lfft_div_radix, pass->vec_width, FFTSET_VEC_CHAIN_ESTIMATE);
 		if (pass->next_compat == NULL)
-			pass->next_compat = fastconv_add_passes(list, alloc, passes + 1);
+			pass->next_compat = fastconv_add_passes(fc, passes + 1);
 		if (pass->next_compat == NULL)
 			return NULL;
-		for (j = 0; j < pass_length / pass_radix; j++) {
-			unsigned k;
-			for (k = 1; k < pass_radix; k++) {
-				*twid++ = cosf(j * k * (-(float)M_PI * 2) / pass_length);
-				*twid++ = sinf(j * k * (-(float)M_PI * 2) / pass_length);
-			}
-		}
 	}
 
-	/* Insert into list. */
-	while (*list != NULL && pass_length < (*list)->lfft_div_radix * (*list)->radix) {
-		list = &(*list)->next;
-	}
-	pass->next = *list;
-	*list = pass;
-
-	return pass;
+	return fastconv_insert_pass(fc, pass);
 }
 
-const struct fftset_vec *
-fastconv_get_inner_pass
-	(struct fftset_vec       **list
-	,struct cop_salloc_iface  *alloc
-	,unsigned                  length
+static const struct fftset_vec *
+fastconv_get_estimated_pass
+	(struct fftset            *fc
+	,size_t                    length
 	,unsigned                  vec_width
 	)
 {
 	const struct fftset_vec *pass;
-	struct fft_graph_node    passes[32];
+	struct fft_graph_node   *passes;
 
 	/* Search for the pass. */
-	pass = fastconv_find_pass(*list, length, vec_width);
+	pass = fastconv_find_pass(fc, length, vec_width, FFTSET_VEC_CHAIN_ESTIMATE);
 	if (pass != NULL)
 		return pass;
 
-	build_float_graph(passes, vec_width, 1, length);
+	passes = build_float_graph(fc->kernels, vec_width, 1, length);
+	if (passes == NULL)
+		return NULL;
 
 #if 0
 	{
-		unsigned i;
-		for (i = 0; i < 32; i++) {
-			printf("pass %u: len=%u; cost=%u; nbfft=%u; radix=%u\n", i, passes[i].length, passes[i].cost, passes[i].nb_vec, passes[i].pass->radix);
+		size_t i;
+		for (i = 0; ; i++) {
+			printf("pass %u: len=%zu; cost=%u; nbfft=%zu; radix=%u\n", (unsigned)i, passes[i].length, passes[i].cost, passes[i].nb_vec, passes[i].pass->radix);
 			if (passes[i].length == passes[i].pass->radix)
 				break;
 		}
 	}
 #endif
 
-	return fastconv_add_passes(list, alloc, passes);
+	pass = fastconv_add_passes(fc, passes);
+	free(passes);
+	return pass;
 }
 
-#define FASTCONV_MAX_PASSES (24)
+/* Measuring planner
+ * ---------------------------------------------------------------------------
+ * Chains are built bottom up: the best chain for a given length is found by
+ * timing every pass which could begin it followed by the best (measured)
+ * chain for the remaining length. Stockham chains (used by the forward and
+ * inverse transforms) and DIF/DIT chains (used by convolution) are measured
+ * separately as the passes have different memory access patterns. The
+ * chosen passes are cached like any other pass so sub-chains are only ever
+ * measured once per fftset and are saved by fftset_export(). */
+
+/* Minimum duration of a batch of timed executions. */
+#define FASTCONV_MEASURE_MIN_TIME (0.0002)
+#define FASTCONV_MEASURE_BATCHES  (3)
+
+static void fastconv_run_chain(const struct fftset_vec *pass, unsigned chain, float *buf_a, float *buf_b)
+{
+	if (chain == FFTSET_VEC_CHAIN_STOCKHAM)
+		fftset_vec_stockham(pass, 1, buf_a, buf_b, FFTSET_VEC_NONZERO_ALL, 0, FFTSET_VEC_WINDOW_ALL, NULL);
+	else
+		fftset_vec_conv(pass, 1, buf_a, FFTSET_VEC_NONZERO_ALL, buf_b, FFTSET_KERNEL_FORMAT_F32, 0, FFTSET_VEC_WINDOW_ALL, NULL);
+}
 
-struct fftset_vec_stack {
-	const struct fftset_vec *pass;
-	unsigned                 nb_vec_fft;
+/* Returns the best time per execution of the chain in seconds. The buffers
+ * hold zeros which stay zero through any number of executions, so there is
+ * no risk of denormals or overflow affecting the timing. */
+static double fastconv_time_chain(const struct fftset_vec *pass, unsigned chain, float *buf_a, float *buf_b)
+{
+	double   best = -1.0;
+	unsigned reps = 1;
+	unsigned batch;
+
+	FFTSET_PROFILE_PAUSE(1);
+
+	fastconv_run_chain(pass, chain, buf_a, buf_b);
+
+	for (batch = 0; batch < FASTCONV_MEASURE_BATCHES; ) {
+		double   start = fftset_timer_now();
+		double   elapsed;
+		unsigned i;
+		for (i = 0; i < reps; i++)
+			fastconv_run_chain(pass, chain, buf_a, buf_b);
+		elapsed = fftset_timer_now() - start;
+		if (elapsed < FASTCONV_MEASURE_MIN_TIME && reps < 0x10000000u) {
+			reps *= 2;
+			continue;
+		}
+		elapsed /= reps;
+		if (best < 0.0 || elapsed < best)
+			best = elapsed;
+		batch++;
+	}
+
+	FFTSET_PROFILE_PAUSE(0);
+
+	return best;
+}
+
+static const struct fftset_vec *
+fastconv_get_measured_pass
+	(struct fftset            *fc
+	,size_t                    length
+	,unsigned                  vec_width
+	,unsigned                  chain
+	)
+{
+	const struct fftset_kernels *kernels = fc->kernels;
+	const struct fftset_vec     *next[FFTSET_KERNELS_MAX_PASSES];
+	unsigned                     valid[FFTSET_KERNELS_MAX_PASSES];
+	struct fftset_vec            candidate;
+	struct fftset_vec           *pass;
+	const float                 *twiddle;
+	size_t                       row_stride;
+	unsigned                     best = kernels->nb_passes;
+	double                       best_time = 0.0;
+	unsigned                     nb_valid = 0;
+	float                       *mem;
+	float                       *buf_a;
+	float                       *buf_b;
+	float                       *scratch_twiddle;
+	size_t                       buf_len;
+	unsigned                     i;
+
+	pass = fastconv_find_pass(fc, length, vec_width, chain);
+	if (pass != NULL)
+		return pass;
+
+	/* Find the best chains for the remaining lengths first. */
+	for (i = 0; i < kernels->nb_passes; i++) {
+		const struct float_pass_radix *def = kernels->passes + i;
+		valid[i] = 0;
+		next[i]  = NULL;
+		if (def->fito_vec_len != vec_width)
+			continue;
+		if (length != def->radix) {
+			if (def->dif == NULL || length % def->radix)
+				continue;
+			next[i] = fastconv_get_measured_pass(fc, length / def->radix, def->foti_vec_len, chain);
+			if (next[i] == NULL)
+				continue;
+		}
+		valid[i] = 1;
+		nb_valid++;
+	}
+
+	if (nb_valid == 0)
+		return NULL;
+
+	/* Buffers for the complex input of a single vector FFT. Stockham needs
+	 * an output buffer and convolution needs a kernel. The candidates are
+	 * timed using twiddles built in a scratch buffer (which is large enough
+	 * for any radix as a table has fewer than 2 * length floats) so only the
+	 * winner's table is added to the fftset. */
+	buf_len         = (size_t)2 * length * vec_width;
+	mem             = calloc(2 * buf_len + 2 * length + 64 / sizeof(float), sizeof(float));
+	if (mem == NULL)
+		return NULL;
+	buf_a           = (float *)(((uintptr_t)mem + 63) & ~(uintptr_t)63);
+	buf_b           = buf_a + buf_len;
+	scratch_twiddle = buf_b + buf_len;
+
+	for (i = 0; i < kernels->nb_passes; i++) {
+		const struct float_pass_radix *def = kernels->passes + i;
+		double                         t;
+
+		if (!valid[i])
+			continue;
+
+		memset(&candidate, 0, sizeof(candidate));
+		candidate.radix          = def->radix;
+		candidate.vec_width      = vec_width;
+		candidate.next_compat    = next[i];
+		candidate.mulconj        = def->mulconj;
+		candidate.mulconj_f16    = def->mulconj_f16;
+		candidate.mulconj_bf16   = def->mulconj_bf16;
+		if (length == def->radix) {
+			candidate.lfft_div_radix = 1;
+			candidate.twiddle        = NULL;
+			candidate.twiddle_stride = 0;
+			candidate.dif            = def->inner;
+			candidate.dit            = def->inner;
+			candidate.dif_stockham   = def->inner_stock;
+		} else {
+			fastconv_fill_twiddle(scratch_twiddle, def->radix, length);
+			candidate.lfft_div_radix = length / def->radix;
+			candidate.twiddle        = scratch_twiddle;
+			candidate.twiddle_stride = 2 * (def->radix - 1);
+			candidate.dif            = def->dif;
+			candidate.dit            = def->dit;
+			candidate.dif_stockham   = def->stock;
+		}
+
+		t = fastconv_time_chain(&candidate, chain, buf_a, buf_b);
+		if (best == kernels->nb_passes || t < best_time) {
+			best      = i;
+			best_time = t;
+		}
+	}
+
+	free(mem);
+
+	if (best == kernels->nb_passes)
+		return NULL;
+
+	twiddle    = NULL;
+	row_stride = 0;
+	if (length != kernels->passes[best].radix) {
+		twiddle = fastconv_get_twiddle(fc, kernels->passes[best].radix, length, &row_stride);
+		if (twiddle == NULL)
+			return NULL;
+	}
+
+	/* The cost is recorded in nanoseconds. */
+	return fftset_vec_restore
+		(fc
+		,length / kernels->passes[best].radix
+		,kernels->passes[best].radix
+		,vec_width
+		,chain
+		,(best_time * 1e9 < 4e9) ? (unsigned)(best_time * 1e9) + 1 : 0xFFFFFFFFu
+		,twiddle
+		,2 * (kernels->passes[best].radix - 1) * row_stride
+		,next[best]
+		);
+}
+
+const struct fftset_vec *
+fastconv_get_inner_pass
+	(struct fftset            *fc
+	,size_t                    length
+	,unsigned                  vec_width
+	,unsigned                  chain
+	)
+{
+	if (fc->planner == FFTSET_PLANNER_MEASURE && chain != FFTSET_VEC_CHAIN_ESTIMATE)
+		return fastconv_get_measured_pass(fc, length, vec_width, chain);
+	return fastconv_get_estimated_pass(fc, length, vec_width);
+}
+
+const struct fftset_vec *
+fftset_vec_find
+	(struct fftset            *fc
+	,size_t                    length
+	,unsigned                  vec_width
+	,unsigned                  chain
+	)
+{
+	return fastconv_find_pass(fc, length, vec_width, chain);
+}
+
+struct fftset_vec *
+fftset_vec_restore
+	(struct fftset            *fc
+	,size_t                    lfft_div_radix
+	,unsigned                  radix
+	,unsigned                  vec_width
+	,unsigned                  chain
+	,unsigned                  cost
+	,const float              *twiddle
+	,size_t                    twiddle_stride
+	,const struct fftset_vec  *next_compat
+	)
+{
+	const struct float_pass_radix *def = NULL;
+	struct fftset_vec             *pass;
+	unsigned                       i;
+
+	for (i = 0; i < fc->kernels->nb_passes; i++) {
+		if (fc->kernels->passes[i].radix == radix && fc->kernels->passes[i].fito_vec_len == vec_width) {
+			def = fc->kernels->passes + i;
+			break;
+		}
+	}
+
+	/* The pass must exist and its chain must be consistent. */
+	if (def == NULL || lfft_div_radix == 0 || lfft_div_radix > ((size_t)-1) / radix)
+		return NULL;
+	if (lfft_div_radix == 1 && (next_compat != NULL || twiddle != NULL))
+		return NULL;
+	if (lfft_div_radix > 1 && (def->dif == NULL || twiddle == NULL || twiddle_stride < 2 * (radix - 1) || next_compat == NULL))
+		return NULL;
+	if (next_compat != NULL && (next_compat->lfft_div_radix * next_compat->radix != lfft_div_radix || next_compat->vec_width != def->foti_vec_len || next_compat->chain != chain))
+		return NULL;
+	if (chain > FFTSET_VEC_CHAIN_CONV)
+		return NULL;
+
+	pass = fftset_alloc(fc, sizeof(*pass), 0, FFTSET_MEM_PASS);
+	if (pass == NULL)
+		return NULL;
+
+	pass->lfft_div_radix = lfft_div_radix;
+	pass->radix          = radix;
+	pass->cost           = cost;
+	pass->vec_width      = vec_width;
+	pass->chain          = chain;
+	pass->twiddle        = twiddle;
+	pass->twiddle_stride = twiddle_stride;
+	pass->next_compat    = next_compat;
+	pass->dif            = (lfft_div_radix == 1) ? def->inner : def->dif;
+	pass->dit            = (lfft_div_radix == 1) ? def->inner : def->dit;
+	pass->dif_stockham   = (lfft_div_radix == 1) ? def->inner_stock : def->stock;
+	pass->mulconj        = def->mulconj;
+	pass->mulconj_f16    = def->mulconj_f16;
+	pass->mulconj_bf16   = def->mulconj_bf16;
+
+	return fastconv_insert_pass(fc, pass);
+}
+
+int
+fftset_vec_add_twiddle
+	(struct fftset            *fc
+	,unsigned                  radix
+	,size_t                    length
+	,const float              *table
+	)
+{
+	struct fftset_twiddle *tw = fftset_alloc(fc, sizeof(*tw), 0, FFTSET_MEM_OVERHEAD);
+	if (tw == NULL)
+		return -1;
+	tw->radix    = radix;
+	tw->length   = length;
+	tw->table    = table;
+	tw->next     = fc->twiddles;
+	fc->twiddles = tw;
+	return 0;
+}
+
+/* Transforms with fewer complex values than this are not worth splitting
+ * between threads. */
+#define FFTSET_VEC_MT_MIN_VALUES ((size_t)1 << 14)
+
+enum fftset_vec_op {
+	FFTSET_VEC_OP_DIF,
+	FFTSET_VEC_OP_DIT,
+	FFTSET_VEC_OP_STOCKHAM,
+	FFTSET_VEC_OP_MULCONJ
 };
 
+/* One pass (or the spectral multiply) of a transform. nb_vec_fft is the
+ * number of rows given to the pass or, for FFTSET_VEC_OP_MULCONJ, the number
+ * of vectors to multiply. Only rows [first_row, first_row + nb_rows) and
+ * columns [first_col, first_col + nb_cols) of a pass are evaluated; the
+ * remaining columns either have zero inputs (see fftset_vec_stockham()) or
+ * produce outputs which are not needed (see fftset_vec_run_window()). */
+struct fftset_vec_job {
+	enum fftset_vec_op         op;
+	const struct fftset_vec   *pass;
+	size_t                     nb_vec_fft;
+	size_t                     first_row;
+	size_t                     nb_rows;
+	size_t                     first_col;
+	size_t                     nb_cols;
+	float                     *work_buf;
+	const float               *input_buf;
+	const void                *kernel_buf;
+	enum fftset_kernel_format  kernel_format;
+};
+
+/* Gives the part of [0, n) which belongs to part of nb_parts. */
+static void fftset_vec_split(size_t n, unsigned part, unsigned nb_parts, size_t *first, size_t *count)
+{
+	size_t q = n / nb_parts;
+	size_t r = n % nb_parts;
+	*first = part * q + ((part < r) ? part : r);
+	*count = q + (part < r);
+}
+
+/* Every row and every column of a pass is independent so a pass can be split
+ * along whichever of the two is larger. */
+static void fftset_vec_run_block(void *arg, unsigned part, unsigned nb_parts)
+{
+	const struct fftset_vec_job *job   = arg;
+	const struct fftset_vec     *pass  = job->pass;
+	const size_t                 vw2   = 2 * (size_t)pass->vec_width;
+	const size_t                 nrow  = job->nb_vec_fft;
+	const size_t                 ncol  = pass->lfft_div_radix;
+	size_t                       r0    = 0;
+	size_t                       c0    = 0;
+	size_t                       rc    = job->nb_rows;
+	size_t                       cc    = job->nb_cols;
+	const float                 *twid;
+
+	if (job->op == FFTSET_VEC_OP_MULCONJ) {
+		fftset_vec_split(nrow, part, nb_parts, &r0, &rc);
+		if (rc == 0)
+			return;
+		switch (job->kernel_format) {
+		case FFTSET_KERNEL_FORMAT_F16:
+			pass->mulconj_f16(job->work_buf + r0 * vw2, (const unsigned short *)job->kernel_buf + r0 * vw2, rc);
+			break;
+		case FFTSET_KERNEL_FORMAT_BF16:
+			pass->mulconj_bf16(job->work_buf + r0 * vw2, (const unsigned short *)job->kernel_buf + r0 * vw2, rc);
+			break;
+		default:
+			pass->mulconj(job->work_buf + r0 * vw2, (const float *)job->kernel_buf + r0 * vw2, rc);
+			break;
+		}
+		return;
+	}
+
+	if (job->nb_rows >= job->nb_cols)
+		fftset_vec_split(job->nb_rows, part, nb_parts, &r0, &rc);
+	else
+		fftset_vec_split(job->nb_cols, part, nb_parts, &c0, &cc);
+	if (rc == 0 || cc == 0)
+		return;
+	r0 += job->first_row;
+	c0 += job->first_col;
+
+	twid = (pass->twiddle != NULL) ? pass->twiddle + c0 * pass->twiddle_stride : NULL;
+
+	switch (job->op) {
+	case FFTSET_VEC_OP_DIF:
+		pass->dif(job->work_buf + (r0 * pass->radix * ncol + c0) * vw2, rc, ncol, twid, pass->twiddle_stride, cc);
+		break;
+	case FFTSET_VEC_OP_DIT:
+		pass->dit(job->work_buf + (r0 * pass->radix * ncol + c0) * vw2, rc, ncol, twid, pass->twiddle_stride, cc);
+		break;
+	default:
+		pass->dif_stockham(job->work_buf + (r0 * ncol + c0) * vw2, job->input_buf + (r0 * pass->radix * ncol + c0) * vw2, twid, pass->twiddle_stride, ncol, nrow, cc, rc);
+		break;
+	}
+}
+
+#if FFTSET_PROFILE
+static const enum fftset_profile_event FFTSET_VEC_OP_EVENTS[] =
+{FFTSET_PROFILE_DIF, FFTSET_PROFILE_DIT, FFTSET_PROFILE_STOCKHAM, FFTSET_PROFILE_MULCONJ};
+#endif
+
+static void fftset_vec_run(struct fftset_threads *threads, struct fftset_vec_job *job)
+{
+	const struct fftset_vec *pass = job->pass;
+	size_t nb_values = pass->vec_width;
+#if FFTSET_PROFILE
+	fftset_profile_ticks start = fftset_profile_now();
+#endif
+
+	if (job->op != FFTSET_VEC_OP_MULCONJ)
+		nb_values *= job->nb_rows * pass->radix * job->nb_cols;
+	else
+		nb_values *= job->nb_vec_fft;
+
+	if (threads != NULL && nb_values >= FFTSET_VEC_MT_MIN_VALUES)
+		fftset_threads_run(threads, fftset_vec_run_block, job);
+	else
+		fftset_vec_run_block(job, 0, 1);
+
+#if FFTSET_PROFILE
+	fftset_profile_pass(FFTSET_VEC_OP_EVENTS[job->op], pass->radix, pass->vec_width, pass->radix * pass->lfft_div_radix, job->nb_vec_fft, start);
+#endif
+}
+
+/* Returns the number of columns of the pass which have non-zero inputs when
+ * only the first nb_nonzero elements of every row may be non-zero. Column c
+ * of a pass reads elements c + j * ncol of a row so when nb_nonzero does not
+ * exceed ncol, the columns from nb_nonzero onwards only see zeros (and
+ * produce zeros). The rows given to the next pass are ncol long so the result
+ * is also the number of leading non-zero elements of each of the next rows. */
+static size_t fftset_vec_nonzero_cols(const struct fftset_vec *pass, size_t nb_nonzero)
+{
+	return (nb_nonzero < pass->lfft_div_radix) ? nb_nonzero : pass->lfft_div_radix;
+}
+
+void
+fftset_vec_window_cols
+	(size_t                    ncol
+	,size_t                    out_first
+	,size_t                    out_count
+	,size_t                   *col_first
+	,size_t                   *col_count
+	)
+{
+	if (out_count >= ncol) {
+		*col_first = 0;
+		*col_count = ncol;
+	} else {
+		*col_first = out_first % ncol;
+		*col_count = out_count;
+	}
+}
+
+void
+fftset_vec_window_mirrored
+	(size_t                    nb_elems
+	,size_t                    first
+	,size_t                    last
+	,size_t                   *out_first
+	,size_t                   *out_count
+	)
+{
+	const size_t m_first    = nb_elems - 1 - last;
+	const size_t m_last     = nb_elems - 1 - first;
+	const size_t span_first = (first < m_first) ? first : m_first;
+	const size_t span_end   = ((last > m_last) ? last : m_last) + 1;
+	const size_t wrap_first = (first > m_first) ? first : m_first;
+	const size_t wrap_end   = ((last < m_last) ? last : m_last) + 1 + nb_elems;
+
+	assert(first <= last && last < nb_elems);
+
+	if (wrap_end - wrap_first < span_end - span_first) {
+		*out_first = wrap_first;
+		*out_count = wrap_end - wrap_first;
+	} else {
+		*out_first = span_first;
+		*out_count = span_end - span_first;
+	}
+	if (*out_count >= nb_elems) {
+		*out_first = 0;
+		*out_count = FFTSET_VEC_WINDOW_ALL;
+	}
+}
+
+void
+fftset_vec_spectrum_bands
+	(float                     *output
+	,const float               *power
+	,size_t                    first_bin
+	,size_t                    nb_bins
+	,size_t                    band_size
+	)
+{
+	size_t band = first_bin / band_size;
+	size_t pos  = first_bin % band_size;
+	size_t i;
+	for (i = 0; i < nb_bins; i++) {
+		output[band] = (pos) ? output[band] + power[i] : power[i];
+		if (++pos == band_size) {
+			pos = 0;
+			band++;
+		}
+	}
+}
+
+void
+fftset_vec_spectrum_finish
+	(float                     *output
+	,size_t                    nb_values
+	,enum fftset_spectrum_format format
+	)
+{
+	size_t i;
+	switch (format) {
+	case FFTSET_SPECTRUM_MAGNITUDE:
+		for (i = 0; i < nb_values; i++)
+			output[i] = sqrtf(output[i]);
+		break;
+	case FFTSET_SPECTRUM_LOG_POWER:
+		for (i = 0; i < nb_values; i++)
+			output[i] = 10.0f * log10f(output[i]);
+		break;
+	default:
+		break;
+	}
+}
+
+/* Runs the job over the columns (or when by_rows is set, the rows) which
+ * wrap around from first. This takes two runs if the window wraps. */
+static void fftset_vec_run_window(struct fftset_threads *threads, struct fftset_vec_job *job, size_t first, size_t count, int by_rows)
+{
+	const size_t  n       = (by_rows) ? job->nb_vec_fft : job->pass->lfft_div_radix;
+	size_t       *first_p = (by_rows) ? &job->first_row : &job->first_col;
+	size_t       *count_p = (by_rows) ? &job->nb_rows : &job->nb_cols;
+
+	assert(first < n && count <= n);
+
+	*first_p = first;
+	*count_p = (count < n - first) ? count : n - first;
+	fftset_vec_run(threads, job);
+
+	if (*count_p < count) {
+		*count_p = count - *count_p;
+		*first_p = 0;
+		fftset_vec_run(threads, job);
+	}
+
+	*first_p = 0;
+	*count_p = n;
+}
+
+/* Runs the DIF passes of the chain, multiplies by the kernel (if one is
+ * given) and runs the DIT passes in reverse order. Recursion is used to find
+ * the DIT passes so that chains of any length may be executed; the depth is
+ * bounded by the number of passes (at most the log2 of the length). The DIF
+ * passes are in place so columns which are skipped because their inputs are
+ * zero are left holding zeros.
+ *
+ * Column c of a DIT pass writes elements c + j * ncol of a row, so only the
+ * columns of the pass which are needed for the output window are evaluated.
+ * These are the elements of the rows of the next pass which are needed. */
 static
 void
 fftset_vec_dif_passes
 	(const struct fftset_vec  *vec_pass
-	,unsigned                  nb_vec_fft
+	,size_t                    nb_vec_fft
 	,float                    *work_buf
-	,const float              *kernel_buf
+	,size_t                    nb_nonzero
+	,const void               *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,size_t                    out_first
+	,size_t                    out_count
+	,struct fftset_threads    *threads
 	)
 {
-	struct fftset_vec_stack pass_stack[FASTCONV_MAX_PASSES];
-	unsigned si = 0;
+	struct fftset_vec_job job;
+	size_t                col_first;
+	size_t                col_count;
 
 	assert(nb_vec_fft > 0);
 	assert(work_buf != NULL);
 	assert(vec_pass != NULL);
 
-	do {
-		vec_pass->dif(work_buf, nb_vec_fft, vec_pass->lfft_div_radix, vec_pass->twiddle);
-		if (kernel_buf != NULL) {
-			pass_stack[si].pass       = vec_pass;
-			pass_stack[si].nb_vec_fft = nb_vec_fft;
-		}
-		nb_vec_fft *= vec_pass->radix;
-		vec_pass    = vec_pass->next_compat;
-		si++;
-	} while (vec_pass != NULL);
+	fftset_vec_window_cols(vec_pass->lfft_div_radix, out_first, out_count, &col_first, &col_count);
+
+	job.op            = FFTSET_VEC_OP_DIF;
+	job.pass          = vec_pass;
+	job.nb_vec_fft    = nb_vec_fft;
+	job.first_row     = 0;
+	job.nb_rows       = nb_vec_fft;
+	job.first_col     = 0;
+	job.nb_cols       = fftset_vec_nonzero_cols(vec_pass, nb_nonzero);
+	job.work_buf      = work_buf;
+	job.input_buf     = NULL;
+	job.kernel_buf    = kernel_buf;
+	job.kernel_format = kernel_format;
+	fftset_vec_run(threads, &job);
+
+	if (vec_pass->next_compat != NULL) {
+		fftset_vec_dif_passes(vec_pass->next_compat, nb_vec_fft * vec_pass->radix, work_buf, job.nb_cols, kernel_buf, kernel_format, col_first, col_count, threads);
+	} else if (kernel_buf != NULL) {
+		job.op         = FFTSET_VEC_OP_MULCONJ;
+		job.nb_vec_fft = nb_vec_fft * vec_pass->radix;
+		fftset_vec_run(threads, &job);
+		job.nb_vec_fft = nb_vec_fft;
+	}
 
 	if (kernel_buf != NULL) {
-		const struct fftset_vec *vec_pass = pass_stack[--si].pass;
-		vec_pass->mulconj(work_buf, kernel_buf, nb_vec_fft);
-		vec_pass->dit(work_buf, pass_stack[si].nb_vec_fft, vec_pass->lfft_div_radix, vec_pass->twiddle);
-		while (si--) {
-			const struct fftset_vec *vec_pass = pass_stack[si].pass;
-			vec_pass->dit(work_buf, pass_stack[si].nb_vec_fft, vec_pass->lfft_div_radix, vec_pass->twiddle);
-		}
+		job.op = FFTSET_VEC_OP_DIT;
+		fftset_vec_run_window(threads, &job, col_first, col_count, 0);
 	}
 }
 
 void
 fftset_vec_kern
 	(const struct fftset_vec  *vec_pass
-	,unsigned                  nb_vec_fft
+	,size_t                    nb_vec_fft
 	,float                    *work_buf
+	,size_t                    nb_nonzero
 	)
 {
-	(void)fftset_vec_dif_passes(vec_pass, nb_vec_fft, work_buf, NULL);
+	(void)fftset_vec_dif_passes(vec_pass, nb_vec_fft, work_buf, nb_nonzero, NULL, FFTSET_KERNEL_FORMAT_F32, 0, FFTSET_VEC_WINDOW_ALL, NULL);
 }
 
 /* The output will be conjugated! */
 void
 fftset_vec_conv
-	(const struct fftset_vec *first_pass
-	,unsigned                 nb_vec_fft
-	,float                   *work_buf
-	,const float             *kernel_buf
+	(const struct fftset_vec  *first_pass
+	,size_t                    nb_vec_fft
+	,float                    *work_buf
+	,size_t                    nb_nonzero
+	,const void               *kernel_buf
+	,enum fftset_kernel_format kernel_format
+	,size_t                    out_first
+	,size_t                    out_count
+	,struct fftset_threads    *threads
 	)
 {
 	assert(kernel_buf != NULL);
-	fftset_vec_dif_passes(first_pass, nb_vec_fft, work_buf, kernel_buf);
+	fftset_vec_dif_passes(first_pass, nb_vec_fft, work_buf, nb_nonzero, kernel_buf, kernel_format, out_first, out_count, threads);
 }
 
-float *
+/* Zeroes columns [nb_cols, ncol) of nb_rows rows of length ncol. */
+static void fftset_vec_zero_cols(float *buf, size_t nb_rows, size_t ncol, size_t nb_cols, unsigned vec_width)
+{
+	const size_t vw2 = 2 * (size_t)vec_width;
+	size_t i;
+	for (i = 0; i < nb_rows; i++)
+		memset(buf + (i * ncol + nb_cols) * vw2, 0, sizeof(float) * (ncol - nb_cols) * vw2);
+}
+
+/* A Stockham pass given a single row reads and writes exactly the same
+ * elements as a DIF pass (with the same twiddles), so the first pass of a
+ * chain may be run in place. This is used to fix the parity of the chain so
+ * that the result always ends up back in input_buf without a copy.
+ *
+ * Columns with only zero inputs are skipped. As the Stockham passes are not
+ * in place, the outputs of the skipped columns are zeroed instead.
+ *
+ * Row r of the last pass writes elements (j * nrow + r) * ncol + c, so only
+ * the rows of the last pass which are needed for the output window are
+ * evaluated. */
+void
 fftset_vec_stockham
 	(const struct fftset_vec  *vec_pass
-	,unsigned                  nb_vec_fft
+	,size_t                    nb_vec_fft
 	,float                    *input_buf
 	,float                    *temp_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,struct fftset_threads    *threads
 	)
 {
+	const struct fftset_vec *p;
+	float                   *output_buf = input_buf;
+	unsigned                 nb_passes  = 0;
+	struct fftset_vec_job    job;
+	size_t                   win_first;
+	size_t                   win_count;
+
 	assert(vec_pass != NULL);
 	assert(input_buf != NULL);
 	assert(temp_buf != NULL);
 	assert(nb_vec_fft > 0);
 	assert(input_buf != temp_buf);
+	assert(nb_vec_fft == 1 || out_count == FFTSET_VEC_WINDOW_ALL);
+
+	for (p = vec_pass; p != NULL; p = p->next_compat)
+		nb_passes++;
+
+	job.kernel_buf    = NULL;
+	job.kernel_format = FFTSET_KERNEL_FORMAT_F32;
+	job.input_buf     = NULL;
+
+	if (nb_passes & 1) {
+		if (nb_vec_fft == 1) {
+			job.op         = FFTSET_VEC_OP_DIF;
+			job.pass       = vec_pass;
+			job.nb_vec_fft = 1;
+			job.first_row  = 0;
+			job.nb_rows    = 1;
+			job.first_col  = 0;
+			job.nb_cols    = fftset_vec_nonzero_cols(vec_pass, nb_nonzero);
+			job.work_buf   = input_buf;
+			if (vec_pass->next_compat == NULL && out_count < vec_pass->radix * vec_pass->lfft_div_radix) {
+				/* The only pass. Its columns write elements c + j * ncol. */
+				fftset_vec_window_cols(vec_pass->lfft_div_radix, out_first, out_count, &win_first, &win_count);
+				fftset_vec_run_window(threads, &job, win_first, win_count, 0);
+			} else {
+				fftset_vec_run(threads, &job);
+			}
 
-	do {
+			nb_nonzero = job.nb_cols;
+			nb_vec_fft = vec_pass->radix;
+			vec_pass   = vec_pass->next_compat;
+		} else {
+			/* Rows are not contiguous in this case. Start the chain from a
+			 * copy in temp_buf instead. This does not happen for any of
+			 * the modulations. */
+			memcpy(temp_buf, input_buf, sizeof(float) * 2 * nb_vec_fft * vec_pass->vec_width * vec_pass->radix * vec_pass->lfft_div_radix);
+			input_buf = temp_buf;
+			temp_buf  = output_buf;
+		}
+	}
+
+	job.op = FFTSET_VEC_OP_STOCKHAM;
+
+	while (vec_pass != NULL) {
 		float *tmp;
 
-		vec_pass->dif_stockham(temp_buf, input_buf, vec_pass->twiddle, vec_pass->lfft_div_radix, nb_vec_fft);
+		job.pass       = vec_pass;
+		job.nb_vec_fft = nb_vec_fft;
+		job.first_row  = 0;
+		job.nb_rows    = nb_vec_fft;
+		job.first_col  = 0;
+		job.nb_cols    = fftset_vec_nonzero_cols(vec_pass, nb_nonzero);
+		job.work_buf   = temp_buf;
+		job.input_buf  = input_buf;
+		if (vec_pass->next_compat == NULL && out_count < nb_vec_fft * vec_pass->radix * vec_pass->lfft_div_radix) {
+			const size_t ncol = vec_pass->lfft_div_radix;
+			const size_t u0   = out_first / ncol;
+			const size_t u1   = (out_first + out_count + ncol - 1) / ncol;
+			fftset_vec_window_cols(nb_vec_fft, u0, u1 - u0, &win_first, &win_count);
+			fftset_vec_run_window(threads, &job, win_first, win_count, 1);
+		} else {
+			fftset_vec_run(threads, &job);
+		}
 
 		nb_vec_fft *= vec_pass->radix;
+		nb_nonzero  = job.nb_cols;
+		if (nb_nonzero < vec_pass->lfft_div_radix)
+			fftset_vec_zero_cols(temp_buf, nb_vec_fft, vec_pass->lfft_div_radix, nb_nonzero, vec_pass->vec_width);
 		tmp         = input_buf;
 		input_buf   = temp_buf;
 		temp_buf    = tmp;
 		vec_pass    = vec_pass->next_compat;
-	} while (vec_pass != NULL);
+	}
 
-	return input_buf;
+	assert(input_buf == output_buf);
+	(void)output_buf;
 }
 
@@ -22,14 +22,28 @@
 #define FFTSET_VEC_H
 
 #include "cop/cop_alloc.h"
+#include "fftset/fftset.h"
+
+/* Passes form chains which are either chosen using the cost estimate (used
+ * for everything unless measuring is enabled) or by measuring the chain when
+ * used for a particular purpose. */
+enum fftset_vec_chain {
+	FFTSET_VEC_CHAIN_ESTIMATE = 0,
+	FFTSET_VEC_CHAIN_STOCKHAM = 1,
+	FFTSET_VEC_CHAIN_CONV     = 2
+};
 
 struct fftset_vec {
-	unsigned                    lfft_div_radix;
+	size_t                      lfft_div_radix;
 	unsigned                    radix;
 	unsigned                    cost;
 	unsigned                    vec_width;
+	unsigned                    chain;
 
+	/* Twiddles for this pass. twiddle_stride is the number of floats between
+	 * the twiddles for consecutive columns of the pass. */
 	const float                *twiddle;
+	size_t                      twiddle_stride;
 
 	/* The best next pass to use (this pass will have:
 	 *      next->lfft = this->lfft / this->radix */
@@ -37,11 +51,13 @@ struct fftset_vec {
 
 	/* If these are both null, this is the upload pass. Otherwise, these are
 	 * both non-null. */
-	void (*dit)(float *work_buf, unsigned nfft, unsigned lfft, const float *twid);
-	void (*dif)(float *work_buf, unsigned nfft, unsigned lfft, const float *twid);
-	void (*dif_stockham)(float *out, const float *in, const float *twid, unsigned ncol, unsigned nrow_div_radix);
+	void (*dit)(float *work_buf, size_t nfft, size_t lfft, const float *twid, size_t twid_stride, size_t col_count);
+	void (*dif)(float *work_buf, size_t nfft, size_t lfft, const float *twid, size_t twid_stride, size_t col_count);
+	void (*dif_stockham)(float *out, const float *in, const float *twid, size_t twid_stride, size_t ncol, size_t nrow_div_radix, size_t col_count, size_t row_count);
 
-	void (*mulconj)(float *work, const float *kern, unsigned nb_vec_fft);
+	void (*mulconj)(float *work, const float *kern, size_t nb_vec_fft);
+	void (*mulconj_f16)(float *work, const unsigned short *kern, size_t nb_vec_fft);
+	void (*mulconj_bf16)(float *work, const unsigned short *kern, size_t nb_vec_fft);
 
 	/* Position in list of all passes of this type (outer or inner pass). */
 	struct fftset_vec       *next;
@@ -49,34 +65,157 @@ struct fftset_vec {
 
 const struct fftset_vec *
 fastconv_get_inner_pass
-	(struct fftset_vec       **list
-	,struct cop_salloc_iface  *alloc
-	,unsigned                  length
+	(struct fftset            *fc
+	,size_t                    length
 	,unsigned                  vec_len
+	,unsigned                  chain
+	);
+
+/* Finds an existing inner pass. Returns NULL if it does not exist. */
+const struct fftset_vec *
+fftset_vec_find
+	(struct fftset            *fc
+	,size_t                    length
+	,unsigned                  vec_width
+	,unsigned                  chain
+	);
+
+/* Creates an inner pass from a previously exported description and adds it
+ * to the fftset. The twiddle table is referenced, not copied. Returns NULL if
+ * the description is invalid or memory is exhausted. */
+struct fftset_vec *
+fftset_vec_restore
+	(struct fftset            *fc
+	,size_t                    lfft_div_radix
+	,unsigned                  radix
+	,unsigned                  vec_width
+	,unsigned                  chain
+	,unsigned                  cost
+	,const float              *twiddle
+	,size_t                    twiddle_stride
+	,const struct fftset_vec  *next_compat
+	);
+
+/* Makes an existing twiddle table for a radix and length available to passes
+ * which are created later. The table must outlive the fftset. */
+int
+fftset_vec_add_twiddle
+	(struct fftset            *fc
+	,unsigned                  radix
+	,size_t                    length
+	,const float              *table
+	);
+
+/* The nb_nonzero arguments of the following functions give the number of
+ * leading vectors of every row of the input which may be non-zero; the rest
+ * must be zero. Passes skip the columns which can only see zeros. Pass
+ * FFTSET_VEC_NONZERO_ALL if nothing is known about the input. */
+#define FFTSET_VEC_NONZERO_ALL ((size_t)-1)
+
+/* The out_first and out_count arguments give the window of vectors of the
+ * output row which is needed. The window wraps around the end of the row.
+ * Passes skip the columns (or rows) which only produce vectors outside the
+ * window and the rest of the output is left undefined. Pass 0 and
+ * FFTSET_VEC_WINDOW_ALL if the whole output is needed. */
+#define FFTSET_VEC_WINDOW_ALL ((size_t)-1)
+
+/* Gives the columns of a pass with ncol columns which are needed for the
+ * given output window when column c of the pass produces elements
+ * c + j * ncol of the output. The result is again a window which wraps. */
+void
+fftset_vec_window_cols
+	(size_t                    ncol
+	,size_t                    out_first
+	,size_t                    out_count
+	,size_t                   *col_first
+	,size_t                   *col_count
+	);
+
+/* Gives the window of a chain output of nb_elems elements which covers
+ * elements [first, last] and their mirrors [nb_elems - 1 - last,
+ * nb_elems - 1 - first] (the real modulations build bins from an element
+ * and its mirror). The result is whichever of the window spanning both
+ * ranges and the window wrapping around the end of the output is shorter;
+ * out_count is FFTSET_VEC_WINDOW_ALL if that would cover everything. */
+void
+fftset_vec_window_mirrored
+	(size_t                    nb_elems
+	,size_t                    first
+	,size_t                    last
+	,size_t                   *out_first
+	,size_t                   *out_count
+	);
+
+/* Helpers for the spectrum outputs of the forward transforms (see
+ * fftset_fft_forward_spectrum()). fftset_vec_spectrum_bands() adds the
+ * powers of bins [first_bin, first_bin + nb_bins) into their bands of
+ * output; bins must be given in order starting from zero as the first bin of
+ * a band overwrites it. fftset_vec_spectrum_finish() converts nb_values
+ * powers into the given format in place. */
+void
+fftset_vec_spectrum_bands
+	(float                     *output
+	,const float               *power
+	,size_t                    first_bin
+	,size_t                    nb_bins
+	,size_t                    band_size
+	);
+
+void
+fftset_vec_spectrum_finish
+	(float                     *output
+	,size_t                    nb_values
+	,enum fftset_spectrum_format format
 	);
 
 void
 fftset_vec_kern
 	(const struct fftset_vec  *vec_pass
-	,unsigned                  nb_vec_fft
+	,size_t                    nb_vec_fft
 	,float                    *work_buf
+	,size_t                    nb_nonzero
 	);
 
-/* The final output will be conjugated! */
+/* The final output will be conjugated! kernel_buf must contain data of the
+ * given format. If threads is not NULL, the passes of large transforms are
+ * split between its threads. */
 void
 fftset_vec_conv
-	(const struct fftset_vec  *first_pass
-	,unsigned                  nb_vec_fft
-	,float                    *work_buf
-	,const float              *kernel_buf
+	(const struct fftset_vec   *first_pass
+	,size_t                     nb_vec_fft
+	,float                     *work_buf
+	,size_t                     nb_nonzero
+	,const void                *kernel_buf
+	,enum fftset_kernel_format  kernel_format
+	,size_t                     out_first
+	,size_t                     out_count
+	,struct fftset_threads     *threads
 	);
 
-float *
+/* Converts nb_values floats produced by fftset_vec_kern() into the given
+ * compact kernel format. */
+void
+fftset_vec_kern_compact
+	(void                      *output_buf
+	,const float               *input_buf
+	,size_t                     nb_values
+	,enum fftset_kernel_format  kernel_format
+	);
+
+/* Runs the passes of the chain ping-ponging between input_buf and temp_buf.
+ * The output is always left in input_buf. threads is as for
+ * fftset_vec_conv(). An output window may only be given when nb_vec_fft is
+ * 1. */
+void
 fftset_vec_stockham
 	(const struct fftset_vec  *vec_pass
-	,unsigned                  nb_vec_fft
+	,size_t                    nb_vec_fft
 	,float                    *input_buf
 	,float                    *temp_buf
+	,size_t                    nb_nonzero
+	,size_t                    out_first
+	,size_t                    out_count
+	,struct fftset_threads    *threads
 	);
 
 #endif /* FFTSET_VEC_H */
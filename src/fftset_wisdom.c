@@ -0,0 +1,580 @@
+/* Copyright (c) 2016 Nick Appleton
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE. */
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "fftset/fftset.h"
+#include "cop/cop_vec.h"
+#include "fftset_modulation.h"
+#include "fftset_alloc.h"
+#include "fftset_sync.h"
+#include "fftset_index.h"
+#include "fftset_wisdom.h"
+#include "fftset_kernels.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Plan files consist of a header followed by an array of inner pass records,
+ * an array of FFT records and a blob of twiddle coefficients. All references
+ * are indices or byte offsets so the file is position independent. Sections
+ * start on 64 byte boundaries so the twiddles are suitably aligned for vector
+ * loads when the file is mapped. Inner passes are sorted by increasing length
+ * so that a pass only ever references passes which precede it. */
+
+#define FFTSET_WISDOM_VERSION    (3)
+#define FFTSET_WISDOM_BYTE_ORDER (0x01020304u)
+#define FFTSET_WISDOM_NONE       (0xFFFFFFFFu)
+#define FFTSET_WISDOM_NONE64     (0xFFFFFFFFFFFFFFFFull)
+#define FFTSET_WISDOM_ALIGN      (64)
+
+#define FFTSET_WISDOM_CONFIG_V4F (1u)
+#define FFTSET_WISDOM_CONFIG_V8F (2u)
+
+static const char FFTSET_WISDOM_MAGIC[8] = {'F', 'F', 'T', 'S', 'E', 'T', 'W', 0};
+
+struct fftset_wisdom_header {
+	char     magic[8];
+	uint32_t byte_order;
+	uint32_t version;
+	uint32_t config;
+	uint32_t nb_passes;
+	uint32_t nb_ffts;
+	uint32_t reserved;
+	uint64_t passes_offset;
+	uint64_t ffts_offset;
+	uint64_t twiddle_offset;
+	uint64_t twiddle_size;
+	uint64_t file_size;
+};
+
+struct fftset_wisdom_pass {
+	uint64_t lfft_div_radix;
+	uint64_t twiddle_stride;
+	/* Byte offset of the twiddles within the twiddle blob. */
+	uint64_t twiddle;
+	uint32_t radix;
+	uint32_t vec_width;
+	uint32_t cost;
+	uint32_t next_compat;
+	/* enum fftset_vec_chain the pass belongs to. */
+	uint32_t chain;
+	uint32_t reserved;
+};
+
+struct fftset_wisdom_fft {
+	uint64_t lfft;
+	uint64_t main_twiddle;
+	uint64_t main_twiddle_len;
+	uint32_t modulation;
+	uint32_t variant;
+	uint32_t next_compat;
+	uint32_t next_stockham;
+};
+
+/* A file which has been mapped by fftset_import(). */
+struct fftset_mapping {
+	const void            *base;
+	size_t                 size;
+#ifdef _WIN32
+	HANDLE                 file;
+	HANDLE                 mapping;
+#endif
+	struct fftset_mapping *next;
+};
+
+/* The vector widths which the kernels of the fftset provide. Plans can only
+ * be shared between fftsets with the same widths. */
+static uint32_t fftset_wisdom_config(const struct fftset *fc)
+{
+	uint32_t config = 0;
+	unsigned i;
+	for (i = 0; i < fc->kernels->nb_passes; i++) {
+		if (fc->kernels->passes[i].fito_vec_len == 4)
+			config |= FFTSET_WISDOM_CONFIG_V4F;
+		if (fc->kernels->passes[i].fito_vec_len == 8)
+			config |= FFTSET_WISDOM_CONFIG_V8F;
+	}
+	return config;
+}
+
+static const struct fftset_modulation *fftset_wisdom_modulation(uint32_t id)
+{
+	if (id == FFTSET_MODULATION_ID_FREQ_OFFSET_REAL)
+		return FFTSET_MODULATION_FREQ_OFFSET_REAL;
+	if (id == FFTSET_MODULATION_ID_COMPLEX)
+		return FFTSET_MODULATION_COMPLEX;
+	return NULL;
+}
+
+static uint64_t fftset_wisdom_align(uint64_t offset)
+{
+	return (offset + FFTSET_WISDOM_ALIGN - 1) & ~(uint64_t)(FFTSET_WISDOM_ALIGN - 1);
+}
+
+/* Number of floats in the shared twiddle table referenced by a pass. See
+ * fastconv_get_twiddle(). Returns FFTSET_WISDOM_NONE64 if this overflows. */
+static uint64_t fftset_wisdom_pass_twiddle_len(uint64_t lfft_div_radix, uint32_t radix, uint64_t twiddle_stride)
+{
+	uint64_t row_stride = twiddle_stride / (2 * (radix - 1));
+	uint64_t row_len    = lfft_div_radix * 2 * (radix - 1);
+	if (row_stride != 0 && row_len > FFTSET_WISDOM_NONE64 / row_stride)
+		return FFTSET_WISDOM_NONE64;
+	return row_stride * row_len;
+}
+
+/* Export
+ * ------------------------------------------------------------------------ */
+
+struct fftset_wisdom_table {
+	const float *ptr;
+	uint64_t     nb_floats;
+	uint64_t     offset;
+};
+
+struct fftset_wisdom_writer {
+	struct fftset_wisdom_table *tables;
+	unsigned                    nb_tables;
+	uint64_t                    blob_size;
+};
+
+static uint64_t fftset_wisdom_add_table(struct fftset_wisdom_writer *w, const float *ptr, uint64_t nb_floats)
+{
+	unsigned i;
+	for (i = 0; i < w->nb_tables; i++) {
+		if (w->tables[i].ptr == ptr) {
+			if (w->tables[i].nb_floats < nb_floats)
+				return FFTSET_WISDOM_NONE64;
+			return w->tables[i].offset;
+		}
+	}
+	w->tables[w->nb_tables].ptr       = ptr;
+	w->tables[w->nb_tables].nb_floats = nb_floats;
+	w->tables[w->nb_tables].offset    = w->blob_size;
+	w->blob_size = fftset_wisdom_align(w->blob_size + nb_floats * sizeof(float));
+	return w->tables[w->nb_tables++].offset;
+}
+
+static int fftset_wisdom_pad(FILE *f, uint64_t *pos, uint64_t target)
+{
+	static const char zeros[FFTSET_WISDOM_ALIGN] = {0};
+	while (*pos < target) {
+		size_t n = (target - *pos > sizeof(zeros)) ? sizeof(zeros) : (size_t)(target - *pos);
+		if (fwrite(zeros, 1, n, f) != n)
+			return -1;
+		*pos += n;
+	}
+	return 0;
+}
+
+static int fftset_wisdom_write(FILE *f, uint64_t *pos, const void *data, size_t size)
+{
+	if (size && fwrite(data, 1, size, f) != size)
+		return -1;
+	*pos += size;
+	return 0;
+}
+
+static int fftset_export_locked(struct fftset *fc, FILE *f)
+{
+	struct fftset_wisdom_header  hdr;
+	struct fftset_wisdom_writer  w;
+	struct fftset_wisdom_pass   *passes = NULL;
+	struct fftset_wisdom_fft    *ffts   = NULL;
+	const struct fftset_vec    **order  = NULL;
+	const struct fftset_vec     *vec;
+	const struct fftset_fft     *fft;
+	unsigned                     nb_passes = 0;
+	unsigned                     nb_ffts   = 0;
+	unsigned                     i, j;
+	uint64_t                     pos = 0;
+	int                          err = -1;
+
+	for (vec = fc->first_inner; vec != NULL; vec = vec->next)
+		nb_passes++;
+	for (fft = fc->first_outer; fft != NULL; fft = fft->next)
+		nb_ffts++;
+
+	order    = malloc(sizeof(order[0]) * (nb_passes + 1));
+	passes   = malloc(sizeof(passes[0]) * (nb_passes + 1));
+	ffts     = malloc(sizeof(ffts[0]) * (nb_ffts + 1));
+	w.tables = malloc(sizeof(w.tables[0]) * (nb_passes + nb_ffts + 1));
+	w.nb_tables = 0;
+	w.blob_size = 0;
+	if (order == NULL || passes == NULL || ffts == NULL || w.tables == NULL)
+		goto out;
+
+	/* The list is sorted by decreasing length. */
+	for (i = nb_passes, vec = fc->first_inner; vec != NULL; vec = vec->next)
+		order[--i] = vec;
+
+	for (i = 0; i < nb_passes; i++) {
+		vec = order[i];
+		passes[i].lfft_div_radix = vec->lfft_div_radix;
+		passes[i].radix          = vec->radix;
+		passes[i].vec_width      = vec->vec_width;
+		passes[i].cost           = vec->cost;
+		passes[i].twiddle_stride = vec->twiddle_stride;
+		passes[i].chain          = vec->chain;
+		passes[i].reserved       = 0;
+		passes[i].next_compat    = FFTSET_WISDOM_NONE;
+		passes[i].twiddle        = FFTSET_WISDOM_NONE64;
+		for (j = 0; j < i && vec->next_compat != NULL; j++) {
+			if (order[j] == vec->next_compat) {
+				passes[i].next_compat = j;
+				break;
+			}
+		}
+		if (vec->twiddle != NULL) {
+			passes[i].twiddle = fftset_wisdom_add_table(&w, vec->twiddle, fftset_wisdom_pass_twiddle_len(vec->lfft_div_radix, vec->radix, vec->twiddle_stride));
+			if (passes[i].twiddle == FFTSET_WISDOM_NONE64)
+				goto out;
+		}
+	}
+
+	for (i = 0, fft = fc->first_outer; fft != NULL; fft = fft->next, i++) {
+		ffts[i].modulation       = fft->modulator->id;
+		ffts[i].lfft             = fft->lfft;
+		ffts[i].variant          = fft->variant;
+		ffts[i].next_compat      = FFTSET_WISDOM_NONE;
+		ffts[i].next_stockham    = FFTSET_WISDOM_NONE;
+		ffts[i].main_twiddle     = FFTSET_WISDOM_NONE64;
+		ffts[i].main_twiddle_len = fft->main_twiddle_len;
+		for (j = 0; j < nb_passes; j++) {
+			if (order[j] == fft->next_compat)
+				ffts[i].next_compat = j;
+			if (order[j] == fft->next_stockham)
+				ffts[i].next_stockham = j;
+		}
+		if (fft->main_twiddle != NULL) {
+			ffts[i].main_twiddle = fftset_wisdom_add_table(&w, fft->main_twiddle, fft->main_twiddle_len);
+			if (ffts[i].main_twiddle == FFTSET_WISDOM_NONE64)
+				goto out;
+		}
+	}
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, FFTSET_WISDOM_MAGIC, sizeof(hdr.magic));
+	hdr.byte_order     = FFTSET_WISDOM_BYTE_ORDER;
+	hdr.version        = FFTSET_WISDOM_VERSION;
+	hdr.config         = fftset_wisdom_config(fc);
+	hdr.nb_passes      = nb_passes;
+	hdr.nb_ffts        = nb_ffts;
+	hdr.passes_offset  = fftset_wisdom_align(sizeof(hdr));
+	hdr.ffts_offset    = fftset_wisdom_align(hdr.passes_offset + sizeof(passes[0]) * nb_passes);
+	hdr.twiddle_offset = fftset_wisdom_align(hdr.ffts_offset + sizeof(ffts[0]) * nb_ffts);
+	hdr.twiddle_size   = w.blob_size;
+	hdr.file_size      = hdr.twiddle_offset + w.blob_size;
+
+	if (fftset_wisdom_write(f, &pos, &hdr, sizeof(hdr)) ||
+	    fftset_wisdom_pad(f, &pos, hdr.passes_offset) ||
+	    fftset_wisdom_write(f, &pos, passes, sizeof(passes[0]) * nb_passes) ||
+	    fftset_wisdom_pad(f, &pos, hdr.ffts_offset) ||
+	    fftset_wisdom_write(f, &pos, ffts, sizeof(ffts[0]) * nb_ffts) ||
+	    fftset_wisdom_pad(f, &pos, hdr.twiddle_offset))
+		goto out;
+
+	for (i = 0; i < w.nb_tables; i++) {
+		if (fftset_wisdom_pad(f, &pos, hdr.twiddle_offset + w.tables[i].offset) ||
+		    fftset_wisdom_write(f, &pos, w.tables[i].ptr, sizeof(float) * w.tables[i].nb_floats))
+			goto out;
+	}
+
+	if (fftset_wisdom_pad(f, &pos, hdr.file_size))
+		goto out;
+
+	err = 0;
+out:
+	free(w.tables);
+	free(ffts);
+	free(passes);
+	free(order);
+	return err;
+}
+
+int fftset_export(struct fftset *fc, const char *filename)
+{
+	FILE *f;
+	int   err;
+
+	f = fopen(filename, "wb");
+	if (f == NULL)
+		return -1;
+
+	fftset_lock(&(fc->create_lock));
+	err = fftset_export_locked(fc, f);
+	fftset_unlock(&(fc->create_lock));
+
+	if (fclose(f))
+		err = -1;
+	if (err)
+		remove(filename);
+
+	return err;
+}
+
+/* Import
+ * ------------------------------------------------------------------------ */
+
+static int fftset_wisdom_map(struct fftset_mapping *m, const char *filename)
+{
+#ifdef _WIN32
+	LARGE_INTEGER size;
+	m->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m->file == INVALID_HANDLE_VALUE)
+		return -1;
+	if (!GetFileSizeEx(m->file, &size) || size.QuadPart == 0 || (unsigned long long)size.QuadPart > (size_t)-1) {
+		CloseHandle(m->file);
+		return -1;
+	}
+	m->size    = (size_t)size.QuadPart;
+	m->mapping = CreateFileMappingA(m->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m->mapping == NULL) {
+		CloseHandle(m->file);
+		return -1;
+	}
+	m->base = MapViewOfFile(m->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m->base == NULL) {
+		CloseHandle(m->mapping);
+		CloseHandle(m->file);
+		return -1;
+	}
+	return 0;
+#else
+	struct stat st;
+	void       *base;
+	int         fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	if (fstat(fd, &st) || st.st_size <= 0 || (unsigned long long)st.st_size > (size_t)-1) {
+		close(fd);
+		return -1;
+	}
+	base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return -1;
+	m->base = base;
+	m->size = (size_t)st.st_size;
+	return 0;
+#endif
+}
+
+static void fftset_wisdom_unmap(struct fftset_mapping *m)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(m->base);
+	CloseHandle(m->mapping);
+	CloseHandle(m->file);
+#else
+	munmap((void *)m->base, m->size);
+#endif
+}
+
+/* Checks that everything in the file is in range and consistent so that no
+ * further checks are required while the FFTs are being created. */
+static int fftset_wisdom_validate(const struct fftset *fc, const struct fftset_mapping *m)
+{
+	const struct fftset_wisdom_header *hdr = m->base;
+	const struct fftset_wisdom_pass   *passes;
+	const struct fftset_wisdom_fft    *ffts;
+	uint32_t                           i;
+
+	if (m->size < sizeof(*hdr) ||
+	    memcmp(hdr->magic, FFTSET_WISDOM_MAGIC, sizeof(hdr->magic)) ||
+	    hdr->byte_order != FFTSET_WISDOM_BYTE_ORDER ||
+	    hdr->version != FFTSET_WISDOM_VERSION ||
+	    hdr->config != fftset_wisdom_config(fc) ||
+	    hdr->file_size != m->size)
+		return -1;
+
+	if (hdr->passes_offset % FFTSET_WISDOM_ALIGN || hdr->ffts_offset % FFTSET_WISDOM_ALIGN || hdr->twiddle_offset % FFTSET_WISDOM_ALIGN ||
+	    hdr->passes_offset < sizeof(*hdr) ||
+	    hdr->passes_offset > m->size || (m->size - hdr->passes_offset) / sizeof(passes[0]) < hdr->nb_passes ||
+	    hdr->ffts_offset > m->size || (m->size - hdr->ffts_offset) / sizeof(ffts[0]) < hdr->nb_ffts ||
+	    hdr->twiddle_offset > m->size || m->size - hdr->twiddle_offset < hdr->twiddle_size)
+		return -1;
+
+	passes = (const struct fftset_wisdom_pass *)((const char *)m->base + hdr->passes_offset);
+	ffts   = (const struct fftset_wisdom_fft *)((const char *)m->base + hdr->ffts_offset);
+
+	for (i = 0; i < hdr->nb_passes; i++) {
+		const struct fftset_wisdom_pass *p = passes + i;
+		if (p->radix < 2 || p->radix > 64 || p->lfft_div_radix == 0 || p->lfft_div_radix > ((size_t)-1) / p->radix || p->twiddle_stride > (size_t)-1)
+			return -1;
+		if (p->twiddle_stride % (2 * (p->radix - 1)))
+			return -1;
+		if (p->chain > FFTSET_VEC_CHAIN_CONV)
+			return -1;
+		if (p->next_compat != FFTSET_WISDOM_NONE && (p->next_compat >= i || passes[p->next_compat].chain != p->chain))
+			return -1;
+		if (p->twiddle != FFTSET_WISDOM_NONE64) {
+			uint64_t len = fftset_wisdom_pass_twiddle_len(p->lfft_div_radix, p->radix, p->twiddle_stride);
+			if (len == FFTSET_WISDOM_NONE64 || p->twiddle % FFTSET_WISDOM_ALIGN || p->twiddle > hdr->twiddle_size || (hdr->twiddle_size - p->twiddle) / sizeof(float) < len)
+				return -1;
+		}
+	}
+
+	for (i = 0; i < hdr->nb_ffts; i++) {
+		const struct fftset_wisdom_fft *f = ffts + i;
+		if (fftset_wisdom_modulation(f->modulation) == NULL || f->next_compat >= hdr->nb_passes || f->next_stockham >= hdr->nb_passes || f->lfft < 2 || f->lfft > (size_t)-1)
+			return -1;
+		if (f->main_twiddle != FFTSET_WISDOM_NONE64) {
+			if (f->main_twiddle % FFTSET_WISDOM_ALIGN || f->main_twiddle > hdr->twiddle_size || (hdr->twiddle_size - f->main_twiddle) / sizeof(float) < f->main_twiddle_len)
+				return -1;
+		} else if (f->main_twiddle_len != 0) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int fftset_import_locked(struct fftset *fc, const struct fftset_mapping *m)
+{
+	const struct fftset_wisdom_header  *hdr     = m->base;
+	const struct fftset_wisdom_pass    *passes  = (const struct fftset_wisdom_pass *)((const char *)m->base + hdr->passes_offset);
+	const struct fftset_wisdom_fft     *ffts    = (const struct fftset_wisdom_fft *)((const char *)m->base + hdr->ffts_offset);
+	const float                        *twiddle = (const float *)((const char *)m->base + hdr->twiddle_offset);
+	const struct fftset_vec           **nodes;
+	uint32_t                            i;
+	int                                 err = -1;
+
+	nodes = malloc(sizeof(nodes[0]) * (hdr->nb_passes + 1));
+	if (nodes == NULL)
+		return -1;
+
+	for (i = 0; i < hdr->nb_passes; i++) {
+		const struct fftset_wisdom_pass *p     = passes + i;
+		const float                     *ptwid = (p->twiddle == FFTSET_WISDOM_NONE64) ? NULL : twiddle + p->twiddle / sizeof(float);
+
+		/* Passes which already exist in the same chain are used in place of
+		 * the ones in the file (any valid sequence will do). */
+		nodes[i] = fftset_vec_find(fc, (size_t)(p->lfft_div_radix * p->radix), p->vec_width, p->chain);
+		if (nodes[i] == NULL) {
+			nodes[i] = fftset_vec_restore
+				(fc
+				,(size_t)p->lfft_div_radix
+				,p->radix
+				,p->vec_width
+				,p->chain
+				,p->cost
+				,ptwid
+				,(size_t)p->twiddle_stride
+				,(p->next_compat == FFTSET_WISDOM_NONE) ? NULL : nodes[p->next_compat]
+				);
+			if (nodes[i] == NULL)
+				goto out;
+			if (ptwid != NULL && fftset_vec_add_twiddle(fc, p->radix, (size_t)((p->twiddle_stride / (2 * (p->radix - 1))) * p->lfft_div_radix * p->radix), ptwid))
+				goto out;
+		}
+	}
+
+	for (i = 0; i < hdr->nb_ffts; i++) {
+		const struct fftset_wisdom_fft *f          = ffts + i;
+		const struct fftset_modulation *modulation = fftset_wisdom_modulation(f->modulation);
+		struct fftset_fft              *fft;
+		struct fftset_fft             **ipos;
+
+		if (fftset_index_find(&(fc->outer_index), (uintptr_t)modulation, (size_t)f->lfft) != NULL)
+			continue;
+
+		fft = fftset_alloc(fc, sizeof(*fft), 0, FFTSET_MEM_PASS);
+		if (fft == NULL)
+			goto out;
+
+		fft->lfft             = (size_t)f->lfft;
+		fft->modulator        = modulation;
+		fft->next_compat      = nodes[f->next_compat];
+		fft->next_stockham    = nodes[f->next_stockham];
+		fft->main_twiddle     = (f->main_twiddle == FFTSET_WISDOM_NONE64) ? NULL : twiddle + f->main_twiddle / sizeof(float);
+		fft->main_twiddle_len = (size_t)f->main_twiddle_len;
+		fft->variant          = f->variant;
+		if (modulation->restore(fft, fc))
+			goto out;
+
+		if (fftset_index_insert(&(fc->outer_index), fc, (uintptr_t)modulation, fft->lfft, fft))
+			goto out;
+
+		ipos = &(fc->first_outer);
+		while (*ipos != NULL && fft->lfft < (*ipos)->lfft)
+			ipos = &(*ipos)->next;
+		fft->next = *ipos;
+		*ipos     = fft;
+	}
+
+	err = 0;
+out:
+	free(nodes);
+	return err;
+}
+
+int fftset_import(struct fftset *fc, const char *filename)
+{
+	struct fftset_mapping  map;
+	struct fftset_mapping *rec;
+	int                    err;
+
+	if (fftset_wisdom_map(&map, filename))
+		return -1;
+
+	if (fftset_wisdom_validate(fc, &map)) {
+		fftset_wisdom_unmap(&map);
+		return -1;
+	}
+
+	fftset_lock(&(fc->create_lock));
+
+	/* The mapping must stay alive for as long as the fftset as passes will
+	 * reference the twiddles in it. */
+	rec = fftset_alloc(fc, sizeof(*rec), 0, FFTSET_MEM_OVERHEAD);
+	if (rec == NULL) {
+		fftset_unlock(&(fc->create_lock));
+		fftset_wisdom_unmap(&map);
+		return -1;
+	}
+	*rec             = map;
+	rec->next        = fc->mappings;
+	fc->mappings     = rec;
+	fc->mapped_bytes += map.size;
+
+	err = fftset_import_locked(fc, rec);
+
+	fftset_unlock(&(fc->create_lock));
+	return err;
+}
+
+void fftset_wisdom_unmap_all(struct fftset *fc)
+{
+	struct fftset_mapping *m;
+	for (m = fc->mappings; m != NULL; m = m->next)
+		fftset_wisdom_unmap(m);
+	fc->mappings     = NULL;
+	fc->mapped_bytes = 0;
+}